@@ -25,6 +25,7 @@
 #include <QComboBox>
 #include <QSpinBox>
 #include <QLineEdit>
+#include <QCheckBox>
 
 #include "panels/project.h"
 #include "project/media.h"
@@ -43,6 +44,7 @@ public:
 private slots:
 	void create();
 	void preset_changed(int index);
+	void run_benchmark();
 
 private:
     SequencePtr existing_sequence;
@@ -57,6 +59,7 @@ private:
 	QComboBox* interlacing_combobox;
 	QComboBox* frame_rate_combobox;
 	QComboBox* audio_frequency_combobox;
+	QCheckBox* half_float_checkbox;
     QLineEdit* sequence_name_edit;
 };
 
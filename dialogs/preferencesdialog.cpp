@@ -24,6 +24,8 @@
 #include "io/config.h"
 #include "io/path.h"
 #include "rendering/audio.h"
+#include "rendering/rendercache.h"
+#include "rendering/ociolutcache.h"
 #include "mainwindow.h"
 
 #include <QMenuBar>
@@ -48,6 +50,7 @@
 #include <QAudioDeviceInfo>
 #include <QApplication>
 #include <QProcess>
+#include <QThread>
 #include <QDebug>
 
 KeySequenceEditor::KeySequenceEditor(QWidget* parent, QAction* a)
@@ -119,8 +122,10 @@ void PreferencesDialog::delete_previews(char type) {
   QDir preview_path(get_data_path() + "/previews");
 
   if (type == 1) {
-    // indiscriminately delete everything
+    // indiscriminately delete everything (including frames rendered with "Render Work Area")
     preview_path.removeRecursively();
+    olive::render_cache.Clear();
+    olive::ocio_lut_cache.Clear();
   } else {
     QStringList preview_file_list = preview_path.entryList(QDir::Files | QDir::NoDotAndDotDot);
     for (int i=0;i<preview_file_list.size();i++) {
@@ -238,7 +243,19 @@ void PreferencesDialog::save() {
   olive::CurrentConfig.upcoming_queue_type = upcoming_queue_type->currentIndex();
   olive::CurrentConfig.previous_queue_size = previous_queue_spinbox->value();
   olive::CurrentConfig.previous_queue_type = previous_queue_type->currentIndex();
+  olive::CurrentConfig.proxy_switching = proxy_switching_combobox->currentIndex();
   olive::CurrentConfig.add_default_effects_to_clips = add_default_effects_to_clips->isChecked();
+  olive::CurrentConfig.proxy_job_limit = proxy_job_limit_spinbox->value();
+  olive::CurrentConfig.undo_memory_limit = undo_memory_limit_spinbox->value();
+  olive::CurrentConfig.render_cache_size = render_cache_size_spinbox->value();
+  olive::CurrentConfig.effect_cache_size = effect_cache_size_spinbox->value();
+  olive::CurrentConfig.ram_preview_size = ram_preview_size_spinbox->value();
+  olive::CurrentConfig.ram_preview_divider = ram_preview_resolution_combobox->currentData().toInt();
+  olive::CurrentConfig.enable_color_management = color_management_group->isChecked();
+  olive::CurrentConfig.ocio_config_path = ocio_config_edit->text();
+  olive::CurrentConfig.ocio_input_space = ocio_input_space_edit->text();
+  olive::CurrentConfig.ocio_display = ocio_display_edit->text();
+  olive::CurrentConfig.ocio_view = ocio_view_edit->text();
 
   olive::CurrentConfig.preferred_audio_output = audio_output_devices->currentData().toString();
   olive::CurrentConfig.preferred_audio_input = audio_input_devices->currentData().toString();
@@ -422,6 +439,13 @@ void PreferencesDialog::save_shortcut_file() {
   }
 }
 
+void PreferencesDialog::browse_ocio_config() {
+  QString fn = QFileDialog::getOpenFileName(this, tr("Browse for OpenColorIO config"), QString(), tr("OpenColorIO Config (*.ocio)"));
+  if (!fn.isEmpty()) {
+    ocio_config_edit->setText(fn);
+  }
+}
+
 void PreferencesDialog::browse_css_file() {
   QString fn = QFileDialog::getOpenFileName(this, tr("Browse for CSS file"));
   if (!fn.isEmpty()) {
@@ -555,6 +579,75 @@ void PreferencesDialog::setup_ui() {
 
   row++;
 
+  // General -> Concurrent Proxy Jobs
+  general_layout->addWidget(new QLabel(tr("Concurrent Proxy Jobs:"), this), row, 0);
+
+  proxy_job_limit_spinbox = new QSpinBox(general_tab);
+  proxy_job_limit_spinbox->setMinimum(1);
+  proxy_job_limit_spinbox->setMaximum(QThread::idealThreadCount());
+  proxy_job_limit_spinbox->setValue(olive::CurrentConfig.proxy_job_limit);
+  general_layout->addWidget(proxy_job_limit_spinbox, row, 1, 1, 4);
+
+  row++;
+
+  // General -> Undo History Memory Limit
+  general_layout->addWidget(new QLabel(tr("Undo History Memory Limit (MB):"), this), row, 0);
+
+  undo_memory_limit_spinbox = new QSpinBox(general_tab);
+  undo_memory_limit_spinbox->setMinimum(0);
+  undo_memory_limit_spinbox->setMaximum(65536);
+  undo_memory_limit_spinbox->setSpecialValueText(tr("Unlimited"));
+  undo_memory_limit_spinbox->setValue(olive::CurrentConfig.undo_memory_limit);
+  general_layout->addWidget(undo_memory_limit_spinbox, row, 1, 1, 4);
+
+  row++;
+
+  // General -> Render Cache Size
+  general_layout->addWidget(new QLabel(tr("Render Cache Size (MB):"), this), row, 0);
+
+  render_cache_size_spinbox = new QSpinBox(general_tab);
+  render_cache_size_spinbox->setMinimum(256);
+  render_cache_size_spinbox->setMaximum(1048576);
+  render_cache_size_spinbox->setValue(olive::CurrentConfig.render_cache_size);
+  general_layout->addWidget(render_cache_size_spinbox, row, 1, 1, 4);
+
+  row++;
+
+  // General -> Effect Cache Size
+  general_layout->addWidget(new QLabel(tr("Effect Cache Size (MB):"), this), row, 0);
+
+  effect_cache_size_spinbox = new QSpinBox(general_tab);
+  effect_cache_size_spinbox->setMinimum(0);
+  effect_cache_size_spinbox->setMaximum(65536);
+  effect_cache_size_spinbox->setSpecialValueText(tr("Disabled"));
+  effect_cache_size_spinbox->setValue(olive::CurrentConfig.effect_cache_size);
+  general_layout->addWidget(effect_cache_size_spinbox, row, 1, 1, 4);
+
+  row++;
+
+  // General -> RAM Preview Size
+  general_layout->addWidget(new QLabel(tr("RAM Preview Size (MB):"), this), row, 0);
+
+  ram_preview_size_spinbox = new QSpinBox(general_tab);
+  ram_preview_size_spinbox->setMinimum(64);
+  ram_preview_size_spinbox->setMaximum(262144);
+  ram_preview_size_spinbox->setValue(olive::CurrentConfig.ram_preview_size);
+  general_layout->addWidget(ram_preview_size_spinbox, row, 1, 1, 4);
+
+  row++;
+
+  // General -> RAM Preview Resolution
+  general_layout->addWidget(new QLabel(tr("RAM Preview Resolution:"), this), row, 0);
+
+  ram_preview_resolution_combobox = new QComboBox(general_tab);
+  ram_preview_resolution_combobox->addItem(tr("Full"), 1);
+  ram_preview_resolution_combobox->addItem(tr("Half"), 2);
+  ram_preview_resolution_combobox->addItem(tr("Quarter"), 4);
+  ram_preview_resolution_combobox->setCurrentIndex(qMax(0, ram_preview_resolution_combobox->findData(olive::CurrentConfig.ram_preview_divider)));
+  general_layout->addWidget(ram_preview_resolution_combobox, row, 1, 1, 4);
+
+  row++;
+
   // General -> Use Software Fallbacks When Possible
   use_software_fallbacks_checkbox = new QCheckBox(general_tab);
   use_software_fallbacks_checkbox->setText(tr("Use Software Fallbacks When Possible"));
@@ -613,6 +706,54 @@ void PreferencesDialog::setup_ui() {
   memory_usage_layout->addWidget(previous_queue_type, 1, 2);
   playback_tab_layout->addWidget(memory_usage_group);
 
+  // Playback -> Proxies
+  QGroupBox* proxy_group = new QGroupBox(playback_tab);
+  proxy_group->setTitle(tr("Proxies"));
+  QGridLayout* proxy_layout = new QGridLayout(proxy_group);
+  proxy_layout->addWidget(new QLabel(tr("Use Proxies:"), playback_tab), 0, 0);
+  proxy_switching_combobox = new QComboBox(playback_tab);
+  proxy_switching_combobox->addItem(tr("Always"));
+  proxy_switching_combobox->addItem(tr("While Playing/Scrubbing"));
+  proxy_switching_combobox->addItem(tr("While Playing/Scrubbing Slow Footage"));
+  proxy_switching_combobox->setCurrentIndex(olive::CurrentConfig.proxy_switching);
+  proxy_layout->addWidget(proxy_switching_combobox, 0, 1);
+  playback_tab_layout->addWidget(proxy_group);
+
+  // Playback -> Color Management
+  color_management_group = new QGroupBox(playback_tab);
+  color_management_group->setTitle(tr("Color Management (OpenColorIO)"));
+  color_management_group->setCheckable(true);
+  color_management_group->setChecked(olive::CurrentConfig.enable_color_management);
+  QGridLayout* color_management_layout = new QGridLayout(color_management_group);
+  color_management_layout->addWidget(new QLabel(tr("Config:"), playback_tab), 0, 0);
+  ocio_config_edit = new QLineEdit(playback_tab);
+  ocio_config_edit->setPlaceholderText(tr("From OCIO environment variable"));
+  ocio_config_edit->setText(olive::CurrentConfig.ocio_config_path);
+  color_management_layout->addWidget(ocio_config_edit, 0, 1);
+  QPushButton* ocio_config_browse = new QPushButton(tr("Browse"), playback_tab);
+  connect(ocio_config_browse, SIGNAL(clicked(bool)), this, SLOT(browse_ocio_config()));
+  color_management_layout->addWidget(ocio_config_browse, 0, 2);
+  color_management_layout->addWidget(new QLabel(tr("Input Color Space:"), playback_tab), 1, 0);
+  ocio_input_space_edit = new QLineEdit(playback_tab);
+  ocio_input_space_edit->setPlaceholderText(tr("scene_linear"));
+  ocio_input_space_edit->setText(olive::CurrentConfig.ocio_input_space);
+  color_management_layout->addWidget(ocio_input_space_edit, 1, 1, 1, 2);
+  color_management_layout->addWidget(new QLabel(tr("Display:"), playback_tab), 2, 0);
+  ocio_display_edit = new QLineEdit(playback_tab);
+  ocio_display_edit->setPlaceholderText(tr("Default"));
+  ocio_display_edit->setText(olive::CurrentConfig.ocio_display);
+  color_management_layout->addWidget(ocio_display_edit, 2, 1, 1, 2);
+  color_management_layout->addWidget(new QLabel(tr("View:"), playback_tab), 3, 0);
+  ocio_view_edit = new QLineEdit(playback_tab);
+  ocio_view_edit->setPlaceholderText(tr("Default"));
+  ocio_view_edit->setText(olive::CurrentConfig.ocio_view);
+  color_management_layout->addWidget(ocio_view_edit, 3, 1, 1, 2);
+#ifndef OLIVE_OCIO
+  color_management_group->setEnabled(false);
+  color_management_group->setToolTip(tr("This build of Olive doesn't include OpenColorIO."));
+#endif
+  playback_tab_layout->addWidget(color_management_group);
+
   tabWidget->addTab(playback_tab, tr("Playback"));
 
   // Audio
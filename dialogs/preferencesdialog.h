@@ -33,6 +33,7 @@
 #include <QCheckBox>
 #include <QDoubleSpinBox>
 #include <QSpinBox>
+#include <QGroupBox>
 
 class KeySequenceEditor : public QKeySequenceEdit {
   Q_OBJECT
@@ -64,6 +65,7 @@ private slots:
   void load_shortcut_file();
   void save_shortcut_file();
   void browse_css_file();
+  void browse_ocio_config();
   void delete_all_previews();
 
 private:
@@ -84,6 +86,7 @@ private:
   QComboBox* upcoming_queue_type;
   QDoubleSpinBox* previous_queue_spinbox;
   QComboBox* previous_queue_type;
+  QComboBox* proxy_switching_combobox;
   QSpinBox* effect_textbox_lines_field;
   QCheckBox* use_software_fallbacks_checkbox;
   QComboBox* audio_output_devices;
@@ -93,6 +96,17 @@ private:
   QSpinBox* thumbnail_res_spinbox;
   QSpinBox* waveform_res_spinbox;
   QCheckBox* add_default_effects_to_clips;
+  QSpinBox* proxy_job_limit_spinbox;
+  QSpinBox* undo_memory_limit_spinbox;
+  QSpinBox* render_cache_size_spinbox;
+  QSpinBox* effect_cache_size_spinbox;
+  QSpinBox* ram_preview_size_spinbox;
+  QComboBox* ram_preview_resolution_combobox;
+  QGroupBox* color_management_group;
+  QLineEdit* ocio_config_edit;
+  QLineEdit* ocio_input_space_edit;
+  QLineEdit* ocio_display_edit;
+  QLineEdit* ocio_view_edit;
 
   QVector<QAction*> key_shortcut_actions;
   QVector<QTreeWidgetItem*> key_shortcut_items;
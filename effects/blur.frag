@@ -0,0 +1,21 @@
+#version 110
+
+// one pass of a blur planned by rendering/blurkernel.cpp, array sizes must match kBlurMaxTaps
+
+uniform sampler2D image;
+uniform vec2 resolution;
+
+uniform vec2 blur_direction;
+uniform int blur_taps;
+uniform float blur_offsets[16];
+uniform float blur_weights[16];
+
+void main(void) {
+	vec4 color = vec4(0.0);
+	for (int i=0;i<16;i++) {
+		if (i < blur_taps) {
+			color += texture2D(image, (gl_FragCoord.xy + blur_direction*blur_offsets[i])/resolution)*blur_weights[i];
+		}
+	}
+	gl_FragColor = color;
+}
\ No newline at end of file
@@ -30,15 +30,13 @@
 typedef f0r_instance_t (*f0rConstructFunc)(unsigned int width, unsigned int height);
 typedef int (*f0rInitFunc) ();
 typedef void (*f0rDeinitFunc) ();
-typedef void (*f0rUpdateFunc) (f0r_instance_t instance,
-						double time, const uint32_t* inframe, uint32_t* outframe);
 typedef void (*f0rDestructFunc)(f0r_instance_t instance);
 typedef void (*f0rGetPluginInfo)(f0r_plugin_info_t* info);
-typedef void (*f0rSetParamValue) (f0r_instance_t instance,
-				f0r_param_t param, int param_index);
 
 Frei0rEffect::Frei0rEffect(Clip* c, const EffectMeta *em) :
 	Effect(c, em),
+	update_func(nullptr),
+	set_param_func(nullptr),
 	open(false)
 {
 	enable_image = true;
@@ -86,11 +84,16 @@ Frei0rEffect::Frei0rEffect(Clip* c, const EffectMeta *em) :
 
 	param_count = info.num_params;
 
+	update_func = reinterpret_cast<f0rUpdateFunc>(LibAddress(handle, "f0r_update"));
+	set_param_func = reinterpret_cast<f0rSetParamValue>(LibAddress(handle, "f0r_set_param_value"));
+
 	get_param_info = reinterpret_cast<f0rGetParamInfo>(LibAddress(handle, "f0r_get_param_info"));
 	for (int i=0;i<param_count;i++) {
 		f0r_param_info_t param_info;
 		get_param_info(&param_info, i);
 
+		param_types.append(param_info.type);
+
 		if (param_info.type >= 0 && param_info.type <= F0R_PARAM_STRING) {
 			EffectRow* row = add_row(param_info.name);
 			switch (param_info.type) {
@@ -134,27 +137,27 @@ Frei0rEffect::~Frei0rEffect() {
 	}
 }
 
-void Frei0rEffect::process_image(double timecode, uint8_t *input, uint8_t *output, int) {
-	f0rUpdateFunc update_func = reinterpret_cast<f0rUpdateFunc>(LibAddress(handle, "f0r_update"));
+void Frei0rEffect::process_image(double timecode, uint8_t *input, uint8_t *output, int size) {
+	if (update_func == nullptr) {
+		// plugin failed to load, pass the frame through
+		memcpy(output, input, size_t(size));
+		return;
+	}
 
 	for (int i=0;i<param_count;i++) {
 		EffectRow* param_row = row(i);
 
-		f0r_param_info_t param_info;
-		get_param_info(&param_info, i);
-
-		f0rSetParamValue set_param = reinterpret_cast<f0rSetParamValue>(LibAddress(handle, "f0r_set_param_value"));
-		switch (param_info.type) {
+		switch (param_types.at(i)) {
 		case F0R_PARAM_BOOL:
 		{
 			double b = param_row->field(0)->get_bool_value(timecode);
-			set_param(instance, &b, i);
+			set_param_func(instance, &b, i);
 		}
 			break;
 		case F0R_PARAM_DOUBLE:
 		{
 			double d = param_row->field(0)->get_double_value(timecode)*0.01;
-			set_param(instance, &d, i);
+			set_param_func(instance, &d, i);
 		}
 			break;
 		case F0R_PARAM_COLOR:
@@ -166,7 +169,7 @@ void Frei0rEffect::process_image(double timecode, uint8_t *input, uint8_t *outpu
 			fcolor.g = float(qcolor.greenF());
 			fcolor.b = float(qcolor.blueF());
 
-			set_param(instance, &fcolor, i);
+			set_param_func(instance, &fcolor, i);
 		}
 			break;
 		case F0R_PARAM_POSITION:
@@ -174,14 +177,14 @@ void Frei0rEffect::process_image(double timecode, uint8_t *input, uint8_t *outpu
 			f0r_param_position pos;
 			pos.x = param_row->field(0)->get_double_value(timecode);
 			pos.y = param_row->field(1)->get_double_value(timecode);
-			set_param(instance, &pos, i);
+			set_param_func(instance, &pos, i);
 		}
 			break;
 		case F0R_PARAM_STRING:
 		{
 			QByteArray bytes = param_row->field(0)->get_string_value(timecode).toUtf8();
 			char* byte_data = bytes.data();
-			set_param(instance, &byte_data, i);
+			set_param_func(instance, &byte_data, i);
 		}
 			break;
 		}
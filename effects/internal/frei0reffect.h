@@ -31,6 +31,10 @@
 
 typedef void (*f0rGetParamInfo)(f0r_param_info_t * info,
 								int param_index );
+typedef void (*f0rUpdateFunc) (f0r_instance_t instance,
+						double time, const uint32_t* inframe, uint32_t* outframe);
+typedef void (*f0rSetParamValue) (f0r_instance_t instance,
+				f0r_param_t param, int param_index);
 
 class Frei0rEffect : public Effect {
 	Q_OBJECT
@@ -46,6 +50,11 @@ private:
 	f0r_instance_t instance;
 	int param_count;
 	f0rGetParamInfo get_param_info;
+
+	// resolved once when the plugin is loaded rather than for every frame
+	f0rUpdateFunc update_func;
+	f0rSetParamValue set_param_func;
+	QVector<int> param_types;
 	void destruct_module();
 	void construct_module();
 	bool open;
@@ -2,9 +2,21 @@
 
 uniform sampler2D tex1;
 uniform sampler3D tex2;
+varying vec2 vTexCoord;
+
+// OCIODisplay() is inserted after the #version line by RenderThread::set_up_ocio()
 
 void main()
 {
-    vec4 col = texture2D(tex1, gl_TexCoord[0].st);
-    gl_FragColor = OCIODisplay(col, tex2);
-}
\ No newline at end of file
+    vec4 col = texture2D(tex1, vTexCoord);
+
+    // the display transform works on straight color, the composition is premultiplied
+    if (col.a > 0.0) {
+        col.rgb /= col.a;
+    }
+
+    col = OCIODisplay(col, tex2);
+    col.rgb *= col.a;
+
+    gl_FragColor = col;
+}
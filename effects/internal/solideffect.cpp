@@ -58,10 +58,7 @@ SolidEffect::SolidEffect(Clip* c, const EffectMeta* em) : Effect(c, em) {
 	checkerboard_size_field->set_double_minimum_value(1);
 	checkerboard_size_field->set_double_default_value(10);
 
-	// hacky but eh
-	QComboBox* solid_type_combo = static_cast<QComboBox*>(solid_type->get_ui_element());
-	connect(solid_type_combo, SIGNAL(currentIndexChanged(int)), this, SLOT(ui_update(int)));
-	ui_update(solid_type_combo->currentIndex());
+	ui_update(solid_type->get_current_data().toInt());
 
 	/*vertPath = ":/shaders/common.vert";
 	fragPath = ":/shaders/solideffect.frag";*/
@@ -191,6 +188,13 @@ void SolidEffect::redraw(double timecode) {
 	}
 }
 
+void SolidEffect::custom_create_ui() {
+	// hacky but eh
+	QComboBox* solid_type_combo = static_cast<QComboBox*>(solid_type->get_ui_element());
+	connect(solid_type_combo, SIGNAL(currentIndexChanged(int)), this, SLOT(ui_update(int)));
+	ui_update(solid_type_combo->currentIndex());
+}
+
 void SolidEffect::ui_update(int i) {
 	solid_color_field->set_enabled(i == SOLID_TYPE_COLOR || i == SOLID_TYPE_CHECKERBOARD);
 	checkerboard_size_field->set_enabled(i == SOLID_TYPE_CHECKERBOARD);
@@ -30,6 +30,8 @@ class SolidEffect : public Effect {
 public:
     SolidEffect(Clip* c, const EffectMeta *em);
 	void redraw(double timecode);
+protected:
+	virtual void custom_create_ui() override;
 private slots:
     void ui_update(int);
 private:
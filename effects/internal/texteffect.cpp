@@ -45,14 +45,13 @@
 #include "mainwindow.h"
 
 TextEffect::TextEffect(Clip* c, const EffectMeta* em) :
-	Effect(c, em)
+	Effect(c, em),
+	layout_width(0),
+	layout_height(0)
 {
 	enable_superimpose = true;
 
 	text_val = add_row(tr("Text"))->add_field(EFFECT_FIELD_STRING, "text", 2);
-	QTextEdit* text_widget = static_cast<QTextEdit*>(text_val->ui_element);
-	text_widget->setContextMenuPolicy(Qt::CustomContextMenu);
-	connect(text_widget, SIGNAL(customContextMenuRequested(const QPoint&)), this, SLOT(text_edit_menu()));
 
 	set_font_combobox = add_row(tr("Font"))->add_field(EFFECT_FIELD_FONT, "font", 2);
 
@@ -115,87 +114,58 @@ TextEffect::TextEffect(Clip* c, const EffectMeta* em) :
 	fragPath = "dropshadow.frag";
 }
 
-void blurred2(QImage& result, const QRect& rect, int radius, bool alphaOnly = false) {
-	int tab[] = { 14, 10, 8, 6, 5, 5, 4, 3, 3, 3, 3, 2, 2, 2, 2, 2, 2 };
-	int alpha = (radius < 1)  ? 16 : (radius > 17) ? 1 : tab[radius-1];
-
-	int r1 = rect.top();
-	int r2 = rect.bottom();
-	int c1 = rect.left();
-	int c2 = rect.right();
-
-	int bpl = result.bytesPerLine();
-	int rgba[4];
-	unsigned char* p;
+GLuint TextEffect::process_superimpose(double timecode) {
+	int width = parent_clip->media_width();
+	int height = parent_clip->media_height();
 
-	int i1 = 0;
-	int i2 = 3;
-
-	if (alphaOnly)
-		i1 = i2 = (QSysInfo::ByteOrder == QSysInfo::BigEndian ? 0 : 3);
-
-	for (int col = c1; col <= c2; col++) {
-		p = result.scanLine(r1) + col * 4;
-		for (int i = i1; i <= i2; i++)
-			rgba[i] = p[i] << 4;
-
-		p += bpl;
-		for (int j = r1; j < r2; j++, p += bpl)
-			for (int i = i1; i <= i2; i++)
-				p[i] = (rgba[i] += ((p[i] << 4) - rgba[i]) * alpha / 16) >> 4;
+	if (valueHasChanged(timecode) || width != layout_width || height != layout_height) {
+		layout_text(timecode, width, height);
 	}
 
-	for (int row = r1; row <= r2; row++) {
-		p = result.scanLine(row) + c1 * 4;
-		for (int i = i1; i <= i2; i++)
-			rgba[i] = p[i] << 4;
+	TextRenderer::Style style;
+	style.color = set_color_button->get_color_value(timecode);
 
-		p += 4;
-		for (int j = c1; j < c2; j++, p += 4)
-			for (int i = i1; i <= i2; i++)
-				p[i] = (rgba[i] += ((p[i] << 4) - rgba[i]) * alpha / 16) >> 4;
-	}
+	style.outline = outline_bool->get_bool_value(timecode);
+	style.outline_width = int(outline_width->get_double_value(timecode));
+	style.outline_color = outline_color->get_color_value(timecode);
 
-	for (int col = c1; col <= c2; col++) {
-		p = result.scanLine(r2) + col * 4;
-		for (int i = i1; i <= i2; i++)
-			rgba[i] = p[i] << 4;
+	style.shadow = shadow_bool->get_bool_value(timecode);
+	if (style.shadow) {
+		// calculate offset using distance and angle
+		double angle = shadow_angle->get_double_value(timecode) * M_PI / 180.0;
+		double distance = qFloor(shadow_distance->get_double_value(timecode));
+		style.shadow_offset = QPointF(qRound(qCos(angle) * distance), qRound(qSin(angle) * distance));
 
-		p -= bpl;
-		for (int j = r1; j < r2; j++, p -= bpl)
-			for (int i = i1; i <= i2; i++)
-				p[i] = (rgba[i] += ((p[i] << 4) - rgba[i]) * alpha / 16) >> 4;
-	}
-
-	for (int row = r1; row <= r2; row++) {
-		p = result.scanLine(row) + c2 * 4;
-		for (int i = i1; i <= i2; i++)
-			rgba[i] = p[i] << 4;
+		style.shadow_color = shadow_color->get_color_value(timecode);
+		style.shadow_color.setAlphaF(shadow_opacity->get_double_value(timecode)*0.01);
 
-		p -= 4;
-		for (int j = c1; j < c2; j++, p -= 4)
-			for (int i = i1; i <= i2; i++)
-				p[i] = (rgba[i] += ((p[i] << 4) - rgba[i]) * alpha / 16) >> 4;
+		// roughly the spread of the box blur softness used to mean
+		style.shadow_softness = qFloor(shadow_softness->get_double_value(timecode)) * 0.5;
 	}
+
+	GLuint tex = text_renderer.Render(QOpenGLContext::currentContext(), width, height, style);
+	superimpose_rect = text_renderer.GetRect();
+	return tex;
 }
 
-void TextEffect::redraw(double timecode) {
-	QColor bkg = set_color_button->get_color_value(timecode);
-	bkg.setAlpha(0);
-	img.fill(bkg);
+void TextEffect::delete_texture() {
+	Effect::delete_texture();
+	text_renderer.Release();
+}
 
-	QPainter p(&img);
-	p.setRenderHint(QPainter::Antialiasing);
-	int width = img.width();
-	int height = img.height();
+void TextEffect::layout_text(double timecode, int width, int height) {
+	layout_width = width;
+	layout_height = height;
 
 	// set font
 	font.setStyleHint(QFont::Helvetica, QFont::PreferAntialias);
 	font.setFamily(set_font_combobox->get_font_name(timecode));
 	font.setPointSize(size_val->get_double_value(timecode));
-	p.setFont(font);
 	QFontMetrics fm(font);
 
+	text_renderer.SetFont(font);
+	text_renderer.Clear();
+
 	QStringList lines = text_val->get_string_value(timecode).split('\n');
 
 	// word wrap function
@@ -221,8 +191,6 @@ void TextEffect::redraw(double timecode) {
 		}
 	}
 
-	QPainterPath path;
-
 	int text_height = fm.height()*lines.size();
 
 	for (int i=0;i<lines.size();i++) {
@@ -273,50 +241,8 @@ void TextEffect::redraw(double timecode) {
 			break;
 		}
 
-		path.addText(text_x, text_y, font, lines.at(i));
+		text_renderer.AddLine(lines.at(i), text_x, text_y);
 	}
-
-	// draw software shadow
-	if (shadow_bool->get_bool_value(timecode)) {
-		p.setPen(Qt::NoPen);
-
-    // calculate offset using distance and angle
-    double angle = shadow_angle->get_double_value(timecode) * M_PI / 180.0;
-    double distance = qFloor(shadow_distance->get_double_value(timecode));
-    int shadow_x_offset = qRound(qCos(angle) * distance);
-    int shadow_y_offset = qRound(qSin(angle) * distance);
-
-		QPainterPath shadow_path(path);
-    shadow_path.translate(shadow_x_offset, shadow_y_offset);
-
-		QColor col = shadow_color->get_color_value(timecode);
-		col.setAlpha(0);
-		img.fill(col);
-
-		col.setAlphaF(shadow_opacity->get_double_value(timecode)*0.01);
-		p.setBrush(col);
-		p.drawPath(shadow_path);
-
-    int blurSoftness = qFloor(shadow_softness->get_double_value(timecode));
-    if (blurSoftness > 0) blurred2(img, img.rect(), blurSoftness, true);
-	}
-
-	// draw outline
-	int outline_width_val = outline_width->get_double_value(timecode);
-	if (outline_bool->get_bool_value(timecode) && outline_width_val > 0) {
-		QPen outline(outline_color->get_color_value(timecode));
-		outline.setWidth(outline_width_val);
-		p.setPen(outline);
-		p.setBrush(Qt::NoBrush);
-		p.drawPath(path);
-	}
-
-	// draw "master" text
-	p.setPen(Qt::NoPen);
-	p.setBrush(set_color_button->get_color_value(timecode));
-	p.drawPath(path);
-
-	p.end();
 }
 
 void TextEffect::shadow_enable(bool e) {
@@ -329,6 +255,12 @@ void TextEffect::shadow_enable(bool e) {
 	shadow_opacity->set_enabled(e);
 }
 
+void TextEffect::custom_create_ui() {
+	QTextEdit* text_widget = static_cast<QTextEdit*>(text_val->get_ui_element());
+	text_widget->setContextMenuPolicy(Qt::CustomContextMenu);
+	connect(text_widget, SIGNAL(customContextMenuRequested(const QPoint&)), this, SLOT(text_edit_menu()));
+}
+
 void TextEffect::text_edit_menu() {
 	QMenu menu;
 
@@ -22,6 +22,7 @@
 #define TEXTEFFECT_H
 
 #include "project/effect.h"
+#include "rendering/textrenderer.h"
 
 #include <QFont>
 #include <QImage>
@@ -30,7 +31,7 @@ class TextEffect : public Effect {
 	Q_OBJECT
 public:
     TextEffect(Clip* c, const EffectMeta *em);
-	void redraw(double timecode);
+	virtual GLuint process_superimpose(double timecode) override;
 
 	EffectField* text_val;
 	EffectField* size_val;
@@ -50,13 +51,22 @@ public:
 	EffectField* shadow_color;
 	EffectField* shadow_softness;
 	EffectField* shadow_opacity;
+protected:
+	virtual void custom_create_ui() override;
+	virtual void delete_texture() override;
 private slots:
 	void outline_enable(bool);
 	void shadow_enable(bool);
 	void text_edit_menu();
 	void open_text_edit();
 private:
+	// lay the text out again, only needed when fields or the frame size change
+	void layout_text(double timecode, int width, int height);
+
 	QFont font;
+	TextRenderer text_renderer;
+	int layout_width;
+	int layout_height;
 };
 
 #endif // TEXTEFFECT_H
@@ -44,7 +44,9 @@
 #include "io/config.h"
 
 TimecodeEffect::TimecodeEffect(Clip* c, const EffectMeta* em) :
-  Effect(c, em)
+  Effect(c, em),
+  layout_width(0),
+  layout_height(0)
 {
   enable_always_update = true;
   enable_superimpose = true;
@@ -79,47 +81,60 @@ TimecodeEffect::TimecodeEffect(Clip* c, const EffectMeta* em) :
 }
 
 
-void TimecodeEffect::redraw(double timecode) {
+GLuint TimecodeEffect::process_superimpose(double timecode) {
+  QString new_timecode;
   if (tc_select->get_combo_data(timecode).toBool()){
-    display_timecode = prepend_text->get_string_value(timecode) + frame_to_timecode(olive::ActiveSequence->playhead, olive::CurrentConfig.timecode_view, olive::ActiveSequence->frame_rate);}
+    new_timecode = prepend_text->get_string_value(timecode) + frame_to_timecode(olive::ActiveSequence->playhead, olive::CurrentConfig.timecode_view, olive::ActiveSequence->frame_rate);}
   else {
     double media_rate = parent_clip->media_frame_rate();
-    display_timecode = prepend_text->get_string_value(timecode) + frame_to_timecode(timecode * media_rate, olive::CurrentConfig.timecode_view, media_rate);}
-  img.fill(Qt::transparent);
-
-  QPainter p(&img);
-  p.setRenderHint(QPainter::Antialiasing);
-  int width = img.width();
-  int height = img.height();
-
-  // set font
-  font.setStyleHint(QFont::Helvetica, QFont::PreferAntialias);
-  font.setFamily("Helvetica");
-  font.setPixelSize(qCeil(scale_val->get_double_value(timecode)*.01*(height/10)));
-  p.setFont(font);
-  QFontMetrics fm(font);
-
-  QPainterPath path;
-
-  int text_x, text_y, rect_y, offset_x, offset_y;
-  int text_height = fm.height();
-  int text_width = fm.width(display_timecode);
-  QColor background_color = color_bg_val->get_color_value(timecode);
-  int alpha_val = bg_alpha->get_double_value(timecode)*2.55;
-  background_color.setAlpha(alpha_val);
-
-  offset_x = int(offset_x_val->get_double_value(timecode));
-  offset_y = int(offset_y_val->get_double_value(timecode));
-
-  text_x = offset_x + (width/2) - (text_width/2);
-  text_y = offset_y + height - height/10;
-  rect_y = text_y + fm.descent() - text_height;
-
-  path.addText(text_x, text_y, font, display_timecode);
-
-  p.setPen(Qt::NoPen);
-  p.setBrush(background_color);
-  p.drawRect(QRect(text_x-fm.descent(), rect_y, text_width+fm.descent()*2, text_height));
-  p.setBrush(color_val->get_color_value(timecode));
-  p.drawPath(path);
+    new_timecode = prepend_text->get_string_value(timecode) + frame_to_timecode(timecode * media_rate, olive::CurrentConfig.timecode_view, media_rate);}
+
+  int width = parent_clip->media_width();
+  int height = parent_clip->media_height();
+
+  // glyphs stay in the renderer's atlas, so a new timecode every frame only rebuilds a few quads
+  if (valueHasChanged(timecode)
+      || new_timecode != display_timecode
+      || width != layout_width
+      || height != layout_height) {
+    display_timecode = new_timecode;
+    layout_width = width;
+    layout_height = height;
+
+    // set font
+    font.setStyleHint(QFont::Helvetica, QFont::PreferAntialias);
+    font.setFamily("Helvetica");
+    font.setPixelSize(qCeil(scale_val->get_double_value(timecode)*.01*(height/10)));
+    QFontMetrics fm(font);
+
+    int text_x, text_y, rect_y, offset_x, offset_y;
+    int text_height = fm.height();
+    int text_width = fm.width(display_timecode);
+
+    offset_x = int(offset_x_val->get_double_value(timecode));
+    offset_y = int(offset_y_val->get_double_value(timecode));
+
+    text_x = offset_x + (width/2) - (text_width/2);
+    text_y = offset_y + height - height/10;
+    rect_y = text_y + fm.descent() - text_height;
+
+    text_renderer.SetFont(font);
+    text_renderer.Clear();
+    text_renderer.SetBackground(QRect(text_x-fm.descent(), rect_y, text_width+fm.descent()*2, text_height));
+    text_renderer.AddLine(display_timecode, text_x, text_y);
+  }
+
+  TextRenderer::Style style;
+  style.color = color_val->get_color_value(timecode);
+  style.background_color = color_bg_val->get_color_value(timecode);
+  style.background_color.setAlpha(int(bg_alpha->get_double_value(timecode)*2.55));
+
+  GLuint tex = text_renderer.Render(QOpenGLContext::currentContext(), width, height, style);
+  superimpose_rect = text_renderer.GetRect();
+  return tex;
+}
+
+void TimecodeEffect::delete_texture() {
+  Effect::delete_texture();
+  text_renderer.Release();
 }
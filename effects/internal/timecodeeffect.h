@@ -22,6 +22,7 @@
 #define TIMECODEEFFECT_H
 
 #include "project/effect.h"
+#include "rendering/textrenderer.h"
 
 #include <QFont>
 #include <QImage>
@@ -30,7 +31,7 @@ class TimecodeEffect : public Effect {
 	Q_OBJECT
 public:
     TimecodeEffect(Clip* c, const EffectMeta *em);
-    void redraw(double timecode);
+    virtual GLuint process_superimpose(double timecode) override;
     EffectField * scale_val;
     EffectField * color_val;
     EffectField * color_bg_val;
@@ -40,9 +41,14 @@ public:
     EffectField * prepend_text;
     EffectField * tc_select;
 
+protected:
+    virtual void delete_texture() override;
 private:
     QFont font;
     QString display_timecode;
+    TextRenderer text_renderer;
+    int layout_width;
+    int layout_height;
 };
 
 #endif // TIMECODEEFFECT_H
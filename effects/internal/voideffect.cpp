@@ -24,7 +24,8 @@
 #include <QLabel>
 #include <QFile>
 
-#include "ui/collapsiblewidget.h"
+#include "io/binaryproject.h"
+#include "io/projectsnapshot.h"
 #include "debug.h"
 
 VoidEffect::VoidEffect(Clip* c, const QString& n) : Effect(c, nullptr) {
@@ -37,8 +38,9 @@ VoidEffect::VoidEffect(Clip* c, const QString& n) : Effect(c, nullptr) {
 	}
 	EffectRow* row = add_row(tr("Missing Effect"), false, false);
 	row->add_widget(new QLabel(display_name));
-	container->setText(display_name);
 
+	// shown as the title of the effect's UI
+	void_meta.name = display_name;
 	void_meta.type = EFFECT_TYPE_EFFECT;
 	meta = &void_meta;
 }
@@ -74,19 +76,17 @@ void VoidEffect::load(QXmlStreamReader &stream) {
     }
 }
 
-void VoidEffect::save(QXmlStreamWriter &stream) {
-	if (!name.isEmpty()) {
-		stream.writeAttribute("name", name);
-		stream.writeAttribute("enabled", QString::number(is_enabled()));
-
-		// force xml writer to expand <effect> tag, ignored when loading
-		stream.writeStartElement("void");
-		stream.writeEndElement();
+void VoidEffect::load_binary(BinaryReader &stream) {
+	// binary projects store the missing effect's data as an opaque blob
+	stream >> bytes;
+}
 
-		if (!bytes.isEmpty()) {
-			// write stored data
-			QIODevice* device = stream.device();
-			device->write(bytes);
-		}
-	}
+EffectSnapshot VoidEffect::snapshot() {
+	// the stored data is written back verbatim
+	EffectSnapshot s;
+	s.type = kEffectSnapshotOpaque;
+	s.name = name;
+	s.enabled = is_enabled();
+	s.data = bytes;
+	return s;
 }
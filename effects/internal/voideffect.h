@@ -36,7 +36,8 @@ public:
 
     virtual EffectPtr copy(Clip* c) override;
 	virtual void load(QXmlStreamReader &stream) override;
-	virtual void save(QXmlStreamWriter &stream) override;
+	virtual void load_binary(BinaryReader &stream) override;
+	virtual EffectSnapshot snapshot() override;
 private:
 	QByteArray bytes;
 	EffectMeta void_meta;
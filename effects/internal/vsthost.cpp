@@ -32,6 +32,8 @@
 #include <QWindow>
 
 #include "rendering/audio.h"
+#include "io/binaryproject.h"
+#include "io/projectsnapshot.h"
 #include "mainwindow.h"
 #include "debug.h"
 
@@ -343,15 +345,23 @@ void VSTHost::custom_load(QXmlStreamReader &stream) {
   }
 }
 
-void VSTHost::save(QXmlStreamWriter &stream) {
-  Effect::save(stream);
+EffectSnapshot VSTHost::snapshot() {
+  EffectSnapshot s = Effect::snapshot();
   if (plugin != nullptr) {
     char* p = nullptr;
     int32_t length = int32_t(dispatcher(plugin, effGetChunk, 0, 0, &p, 0));
     data_cache = QByteArray(p, length);
   }
-  if (data_cache.size() > 0) {
-    stream.writeTextElement("plugindata", data_cache.toBase64());
+  s.type = kEffectSnapshotPlugin;
+  s.data = data_cache;
+  return s;
+}
+
+void VSTHost::load_binary(BinaryReader &stream) {
+  Effect::load_binary(stream);
+  stream >> data_cache;
+  if (plugin != nullptr && data_cache.size() > 0) {
+    dispatcher(plugin, effSetChunk, 0, int32_t(data_cache.size()), static_cast<void*>(data_cache.data()), 0);
   }
 }
 
@@ -42,7 +42,8 @@ public:
 	void process_audio(double timecode_start, double timecode_end, quint8* samples, int nb_bytes, int channel_count);
 
 	void custom_load(QXmlStreamReader& stream);
-	void save(QXmlStreamWriter& stream);
+	void load_binary(BinaryReader& stream);
+	EffectSnapshot snapshot();
 private slots:
 	void show_interface(bool show);
 	void uncheck_show_button();
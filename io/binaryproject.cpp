@@ -0,0 +1,276 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "binaryproject.h"
+
+#include <QSaveFile>
+#include <QDebug>
+
+#include "io/config.h"
+#include "io/projectsnapshot.h"
+
+// size of the magic number, save version and section count at the start of the file
+const qint64 kBinaryHeaderSize = 12;
+
+// size of one section index entry (type, ID, offset and size)
+const qint64 kBinaryIndexEntrySize = 24;
+
+quint32 BinaryStringTable::index(const QString &s) {
+  QHash<QString, quint32>::const_iterator it = lookup_.constFind(s);
+  if (it != lookup_.constEnd()) {
+    return it.value();
+  }
+
+  quint32 i = quint32(strings_.size());
+  strings_.append(s);
+  lookup_.insert(s, i);
+  return i;
+}
+
+QString BinaryStringTable::string(quint32 i) const {
+  if (i < quint32(strings_.size())) {
+    return strings_.at(int(i));
+  }
+  return QString();
+}
+
+QByteArray BinaryStringTable::save() const {
+  QByteArray data;
+  QDataStream stream(&data, QIODevice::WriteOnly);
+  stream.setVersion(kBinaryStreamVersion);
+  stream << strings_;
+  return data;
+}
+
+void BinaryStringTable::load(const QByteArray &data) {
+  QDataStream stream(data);
+  stream.setVersion(kBinaryStreamVersion);
+  stream >> strings_;
+
+  // lookup is only needed when writing
+  lookup_.clear();
+}
+
+BinaryWriter::BinaryWriter(QByteArray *data, BinaryStringTable *strings) :
+  QDataStream(data, QIODevice::WriteOnly),
+  strings_(strings)
+{
+  setVersion(kBinaryStreamVersion);
+}
+
+void BinaryWriter::write_string(const QString &s) {
+  *this << strings_->index(s);
+}
+
+BinaryReader::BinaryReader(const QByteArray &data, const BinaryStringTable *strings) :
+  QDataStream(data),
+  strings_(strings)
+{
+  setVersion(kBinaryStreamVersion);
+}
+
+BinaryReader::BinaryReader(QIODevice *device, const BinaryStringTable *strings) :
+  QDataStream(device),
+  strings_(strings)
+{
+  setVersion(kBinaryStreamVersion);
+}
+
+QString BinaryReader::read_string() {
+  quint32 i;
+  *this >> i;
+  return strings_->string(i);
+}
+
+BinaryProjectFile::BinaryProjectFile() :
+  version_(0)
+{}
+
+bool BinaryProjectFile::open(const QString &filename) {
+  file_.setFileName(filename);
+  if (!file_.open(QIODevice::ReadOnly)) {
+    qCritical() << "Could not open file" << filename;
+    return false;
+  }
+
+  QDataStream stream(&file_);
+  stream.setVersion(kBinaryStreamVersion);
+
+  quint32 magic;
+  qint32 version;
+  quint32 section_count;
+  stream >> magic >> version >> section_count;
+
+  if (stream.status() != QDataStream::Ok || magic != kBinaryProjectMagic) {
+    qCritical() << filename << "is not a binary Olive project";
+    return false;
+  }
+
+  version_ = version;
+
+  // don't trust the count until it's known the index actually fits in the file
+  if (section_count > quint64(file_.size() - kBinaryHeaderSize) / kBinaryIndexEntrySize) {
+    qCritical() << "Binary project" << filename << "has a truncated section index";
+    return false;
+  }
+
+  sections_.resize(int(section_count));
+  for (int i=0;i<sections_.size();i++) {
+    BinarySection& s = sections_[i];
+    qint32 type;
+    qint32 id;
+    stream >> type >> id >> s.offset >> s.size;
+    s.type = type;
+    s.id = id;
+
+    if (stream.status() != QDataStream::Ok) {
+      qCritical() << "Binary project" << filename << "has a truncated section index";
+      return false;
+    }
+
+    if (s.offset < 0 || s.size < 0 || s.offset > file_.size() || s.size > file_.size() - s.offset) {
+      qCritical() << "Binary project" << filename << "has an invalid section index";
+      return false;
+    }
+  }
+
+  const BinarySection* string_section = find_section(kBinarySectionStrings);
+  if (string_section == nullptr) {
+    qCritical() << "Binary project" << filename << "has no string table";
+    return false;
+  }
+  strings_.load(read_section(string_section));
+
+  return true;
+}
+
+void BinaryProjectFile::close() {
+  file_.close();
+}
+
+int BinaryProjectFile::version() {
+  return version_;
+}
+
+const QVector<BinarySection> &BinaryProjectFile::sections() {
+  return sections_;
+}
+
+const BinaryStringTable &BinaryProjectFile::strings() {
+  return strings_;
+}
+
+const BinarySection *BinaryProjectFile::find_section(int type, int id) {
+  for (int i=0;i<sections_.size();i++) {
+    if (sections_.at(i).type == type && sections_.at(i).id == id) {
+      return &sections_.at(i);
+    }
+  }
+  return nullptr;
+}
+
+QByteArray BinaryProjectFile::read_section(const BinarySection *section) {
+  if (!file_.seek(section->offset)) {
+    return QByteArray();
+  }
+  return file_.read(section->size);
+}
+
+QIODevice *BinaryProjectFile::seek_section(const BinarySection *section) {
+  if (!file_.seek(section->offset)) {
+    return nullptr;
+  }
+  return &file_;
+}
+
+bool olive::is_binary_project_filename(const QString &filename) {
+  return filename.endsWith(kBinaryProjectExtension, Qt::CaseInsensitive);
+}
+
+bool olive::is_binary_project_file(const QString &filename) {
+  QFile file(filename);
+  if (!file.open(QIODevice::ReadOnly)) {
+    return false;
+  }
+
+  QDataStream stream(&file);
+  stream.setVersion(kBinaryStreamVersion);
+  quint32 magic = 0;
+  stream >> magic;
+  return (magic == kBinaryProjectMagic);
+}
+
+bool olive::write_binary_project_file(const SerializedProject &project, const QString &filename) {
+  // gather sections in the order they'll be written
+  QVector<BinarySection> sections;
+  QVector<const QByteArray*> section_data;
+
+  sections.append({kBinarySectionStrings, 0, 0, 0});
+  section_data.append(&project.strings);
+
+  sections.append({kBinarySectionHeader, 0, 0, 0});
+  section_data.append(&project.header);
+
+  sections.append({kBinarySectionFolders, 0, 0, 0});
+  section_data.append(&project.folders);
+
+  sections.append({kBinarySectionMedia, 0, 0, 0});
+  section_data.append(&project.media);
+
+  for (int i=0;i<project.sequences.size();i++) {
+    sections.append({kBinarySectionSequence, project.sequence_ids.at(i), 0, 0});
+    section_data.append(&project.sequences.at(i));
+
+    sections.append({kBinarySectionSequenceSettings, project.sequence_ids.at(i), 0, 0});
+    section_data.append(&project.sequence_settings.at(i));
+  }
+
+  // sections are laid out back to back after the index
+  qint64 offset = kBinaryHeaderSize + kBinaryIndexEntrySize * sections.size();
+  for (int i=0;i<sections.size();i++) {
+    sections[i].offset = offset;
+    sections[i].size = section_data.at(i)->size();
+    offset += sections.at(i).size;
+  }
+
+  QSaveFile file(filename);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qCritical() << "Could not open file" << filename;
+    return false;
+  }
+
+  QDataStream stream(&file);
+  stream.setVersion(kBinaryStreamVersion);
+  stream << kBinaryProjectMagic << qint32(olive::kSaveVersion) << quint32(sections.size());
+  for (int i=0;i<sections.size();i++) {
+    const BinarySection& s = sections.at(i);
+    stream << qint32(s.type) << qint32(s.id) << s.offset << s.size;
+  }
+  for (int i=0;i<section_data.size();i++) {
+    stream.writeRawData(section_data.at(i)->constData(), section_data.at(i)->size());
+  }
+
+  if (!file.commit()) {
+    qCritical() << "Could not write file" << filename << "-" << file.errorString();
+    return false;
+  }
+
+  return true;
+}
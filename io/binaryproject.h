@@ -0,0 +1,208 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef BINARYPROJECT_H
+#define BINARYPROJECT_H
+
+#include <QDataStream>
+#include <QFile>
+#include <QHash>
+#include <QStringList>
+#include <QVector>
+
+struct SerializedProject;
+
+/**
+ * Olive's binary project format
+ *
+ * A compact alternative to the XML project format (which remains the interchange format). A binary project file
+ * consists of:
+ *
+ * * A fixed header (magic number, save version and section count)
+ * * An index listing the type, ID, offset and size of every section
+ * * The sections themselves
+ *
+ * Sections are typed (see BinarySectionType). Every sequence is stored in its own section keyed by its save ID, so a
+ * loader can read the index and then only pull in the sections it actually needs. All strings (names, URLs, effect
+ * and field IDs) are stored once in a shared string table section and referenced by index everywhere else.
+ */
+
+/**
+ * @brief Identifies a file as a binary Olive project
+ */
+const quint32 kBinaryProjectMagic = 0x4F564542; // "OVEB"
+
+/**
+ * @brief QDataStream version used for binary projects and the autorecovery journal
+ *
+ * Pinned so the files don't change with the version of Qt Olive happens to be built against.
+ */
+const int kBinaryStreamVersion = QDataStream::Qt_5_6;
+
+/**
+ * @brief File extension used for binary projects
+ */
+const char* const kBinaryProjectExtension = ".ovb";
+
+enum BinarySectionType {
+  kBinarySectionStrings,
+  kBinarySectionHeader,
+  kBinarySectionFolders,
+  kBinarySectionMedia,
+  kBinarySectionSequence,
+
+  // sequence settings added after the format was introduced, keyed like kBinarySectionSequence. Optional, so files
+  // without it load with default settings and versions that don't know about it skip it.
+  kBinarySectionSequenceSettings
+};
+
+/**
+ * @brief An entry in the binary project's section index
+ */
+struct BinarySection {
+  int type;
+
+  /**
+   * @brief Save ID for sequence sections, 0 for anything else
+   */
+  int id;
+
+  qint64 offset;
+  qint64 size;
+};
+
+/**
+ * @brief The BinaryStringTable class
+ *
+ * Deduplicated list of strings shared by all sections of a binary project.
+ */
+class BinaryStringTable {
+public:
+  /**
+   * @brief Get the index of a string, adding it to the table if it isn't there yet
+   */
+  quint32 index(const QString& s);
+
+  /**
+   * @brief Get the string at an index, or an empty string if the index is out of range
+   */
+  QString string(quint32 i) const;
+
+  QByteArray save() const;
+  void load(const QByteArray& data);
+
+private:
+  QStringList strings_;
+  QHash<QString, quint32> lookup_;
+};
+
+/**
+ * @brief The BinaryWriter class
+ *
+ * QDataStream writing one section of a binary project, with strings written as indices into the string table.
+ */
+class BinaryWriter : public QDataStream {
+public:
+  BinaryWriter(QByteArray* data, BinaryStringTable* strings);
+  void write_string(const QString& s);
+private:
+  BinaryStringTable* strings_;
+};
+
+/**
+ * @brief The BinaryReader class
+ *
+ * QDataStream reading one section of a binary project, resolving strings through the string table.
+ */
+class BinaryReader : public QDataStream {
+public:
+  BinaryReader(const QByteArray& data, const BinaryStringTable* strings);
+  BinaryReader(QIODevice* device, const BinaryStringTable* strings);
+  QString read_string();
+private:
+  const BinaryStringTable* strings_;
+};
+
+/**
+ * @brief The BinaryProjectFile class
+ *
+ * Reads the header and index of a binary project so individual sections can be read on demand. The file stays open
+ * until the object is destroyed, so it's shared (see BinarySequenceLoader) for as long as sections may still be needed.
+ */
+class BinaryProjectFile {
+public:
+  BinaryProjectFile();
+
+  /**
+   * @brief Open a binary project and read its index and string table
+   *
+   * @return **TRUE** if the file is a valid binary project
+   */
+  bool open(const QString& filename);
+  void close();
+
+  int version();
+  const QVector<BinarySection>& sections();
+  const BinaryStringTable& strings();
+
+  /**
+   * @brief Find the first section of a type (and ID for sequences)
+   *
+   * @return Pointer to the index entry or nullptr if the project doesn't have such a section
+   */
+  const BinarySection* find_section(int type, int id = 0);
+
+  /**
+   * @brief Read the raw data of a section
+   */
+  QByteArray read_section(const BinarySection* section);
+
+  /**
+   * @brief Seek to the start of a section to read it straight from the file
+   *
+   * @return The file, or nullptr if seeking failed
+   */
+  QIODevice* seek_section(const BinarySection* section);
+
+private:
+  QFile file_;
+  int version_;
+  QVector<BinarySection> sections_;
+  BinaryStringTable strings_;
+};
+
+namespace olive {
+  /**
+   * @brief Returns **TRUE** if this filename should be saved in the binary project format
+   */
+  bool is_binary_project_filename(const QString& filename);
+
+  /**
+   * @brief Returns **TRUE** if the file starts with a binary project's magic number
+   */
+  bool is_binary_project_file(const QString& filename);
+
+  /**
+   * @brief Write binary project data (see SerializedProject::binary) to a binary project file
+   */
+  bool write_binary_project_file(const SerializedProject& project, const QString& filename);
+}
+
+#endif // BINARYPROJECT_H
@@ -0,0 +1,499 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "binarysequenceloader.h"
+
+#include "io/loadthread.h"
+#include "panels/panels.h"
+#include "effects/internal/voideffect.h"
+#include "debug.h"
+
+BinarySequenceLoader::BinarySequenceLoader(std::shared_ptr<BinaryProjectContext> context,
+                                           std::shared_ptr<BinaryProjectFile> file,
+                                           const BinarySection &section,
+                                           qint64 clip_offset) :
+  context_(context),
+  file_(file),
+  section_(section),
+  clip_offset_(clip_offset),
+  media_found_(false)
+{}
+
+/**
+ * @brief Clips of a BinarySequenceLoader that are saved without loading them
+ */
+class BinaryDeferredClips : public DeferredClips {
+public:
+  BinaryDeferredClips(std::shared_ptr<BinaryProjectContext> context,
+                      const QByteArray& data,
+                      qint64 clip_offset,
+                      const QHash<int, int>& footage_ids,
+                      const QHash<int, int>& sequence_ids) :
+    context_(context),
+    data_(data),
+    clip_offset_(clip_offset),
+    footage_ids_(footage_ids),
+    sequence_ids_(sequence_ids)
+  {}
+
+  virtual QVector<ClipSnapshot> decode() const override {
+    QVector<ClipSnapshot> clips = BinarySequenceLoader::decode_clips(data_, clip_offset_, context_->strings);
+
+    // map media from the IDs in the file it was loaded from to the IDs it's being saved with
+    for (int i=0;i<clips.size();i++) {
+      ClipSnapshot& c = clips[i];
+      const QHash<int, int>* ids = nullptr;
+      switch (c.media_type) {
+      case MEDIA_TYPE_FOOTAGE:
+        ids = &footage_ids_;
+        break;
+      case MEDIA_TYPE_SEQUENCE:
+        ids = &sequence_ids_;
+        break;
+      }
+      if (ids != nullptr && ids->contains(c.media_id)) {
+        c.media_id = ids->value(c.media_id);
+      } else {
+        // loading would have left this clip without media too
+        c.media_type = -1;
+        c.media_id = 0;
+        c.media_stream = 0;
+      }
+    }
+
+    return clips;
+  }
+
+private:
+  std::shared_ptr<BinaryProjectContext> context_;
+  QByteArray data_;
+  qint64 clip_offset_;
+  QHash<int, int> footage_ids_;
+  QHash<int, int> sequence_ids_;
+};
+
+void BinarySequenceLoader::read_data() {
+  if (file_ != nullptr) {
+    data_ = file_->read_section(&section_);
+    if (data_.size() != section_.size) {
+      qWarning() << "Failed to read sequence from" << section_.offset << "in binary project, its clips will be missing";
+    }
+
+    // this sequence no longer needs the file, it's closed once no other sequence does either
+    file_.reset();
+  }
+}
+
+void BinarySequenceLoader::find_media() {
+  if (media_found_) {
+    return;
+  }
+
+  read_data();
+
+  QVector<ClipSnapshot> clips = decode_clips(data_, clip_offset_, context_->strings);
+  for (int i=0;i<clips.size();i++) {
+    const ClipSnapshot& c = clips.at(i);
+    if (c.media_type == MEDIA_TYPE_FOOTAGE && !footage_ids_.contains(c.media_id)) {
+      footage_ids_.append(c.media_id);
+    } else if (c.media_type == MEDIA_TYPE_SEQUENCE && !sequence_ids_.contains(c.media_id)) {
+      sequence_ids_.append(c.media_id);
+    }
+  }
+
+  media_found_ = true;
+}
+
+bool BinarySequenceLoader::uses_media(Media *m) {
+  find_media();
+
+  for (int i=0;i<footage_ids_.size();i++) {
+    if (context_->footage.value(footage_ids_.at(i)) == m) {
+      return true;
+    }
+  }
+  for (int i=0;i<sequence_ids_.size();i++) {
+    if (context_->sequences.value(sequence_ids_.at(i)) == m) {
+      return true;
+    }
+  }
+  return false;
+}
+
+std::shared_ptr<DeferredClips> BinarySequenceLoader::snapshot() {
+  find_media();
+
+  QHash<int, int> footage_ids;
+  for (int i=0;i<footage_ids_.size();i++) {
+    Media* m = context_->footage.value(footage_ids_.at(i));
+    if (m != nullptr) {
+      footage_ids.insert(footage_ids_.at(i), m->to_footage()->save_id);
+    }
+  }
+
+  QHash<int, int> sequence_ids;
+  for (int i=0;i<sequence_ids_.size();i++) {
+    Media* m = context_->sequences.value(sequence_ids_.at(i));
+    if (m != nullptr) {
+      sequence_ids.insert(sequence_ids_.at(i), m->to_sequence()->save_id);
+    }
+  }
+
+  return std::make_shared<BinaryDeferredClips>(context_, data_, clip_offset_, footage_ids, sequence_ids);
+}
+
+static void decode_effect(BinaryReader& stream, EffectSnapshot& effect, bool transition) {
+  effect.name = stream.read_string();
+  stream >> effect.enabled;
+
+  // mirrors load_effect(), which decides how to read the effect by whether it's available
+  if (!transition) {
+    const EffectMeta* meta = nullptr;
+    if (!effect.name.isEmpty()) {
+      panel_effect_controls->effects_loaded.lock();
+      meta = get_meta_from_name(effect.name);
+      panel_effect_controls->effects_loaded.unlock();
+    }
+
+    if (meta == nullptr) {
+      effect.type = kEffectSnapshotOpaque;
+      stream >> effect.data;
+      return;
+    } else if (meta->internal == EFFECT_INTERNAL_VST) {
+      effect.type = kEffectSnapshotPlugin;
+    }
+  }
+
+  quint32 row_count;
+  stream >> row_count;
+  for (quint32 i=0;i<row_count && stream.status() == QDataStream::Ok;i++) {
+    QVector<FieldSnapshot> row;
+
+    quint32 field_count;
+    stream >> field_count;
+    for (quint32 j=0;j<field_count && stream.status() == QDataStream::Ok;j++) {
+      FieldSnapshot field;
+      qint32 field_type;
+      field.id = stream.read_string();
+      stream >> field_type;
+      field.type = field_type;
+      field.value = load_data_from_stream(field.type, stream);
+
+      quint32 key_count;
+      stream >> key_count;
+      for (quint32 k=0;k<key_count && stream.status() == QDataStream::Ok;k++) {
+        EffectKeyframe key;
+        qint64 time;
+        qint32 key_type;
+        key.data = load_data_from_stream(field.type, stream);
+        stream >> time >> key_type >> key.pre_handle_x >> key.pre_handle_y >> key.post_handle_x >> key.post_handle_y;
+        key.time = long(time);
+        key.type = key_type;
+        field.keyframes.append(key);
+      }
+
+      row.append(field);
+    }
+
+    effect.rows.append(row);
+  }
+
+  if (effect.type == kEffectSnapshotPlugin) {
+    stream >> effect.data;
+  }
+}
+
+QVector<ClipSnapshot> BinarySequenceLoader::decode_clips(const QByteArray &data,
+                                                         qint64 clip_offset,
+                                                         const BinaryStringTable &strings) {
+  QVector<ClipSnapshot> clips;
+
+  BinaryReader stream(data, &strings);
+  stream.device()->seek(clip_offset);
+
+  quint32 clip_count;
+  stream >> clip_count;
+
+  for (quint32 i=0;i<clip_count && stream.status() == QDataStream::Ok;i++) {
+    ClipSnapshot c;
+
+    qint32 index, track, media_type, media_id, media_stream;
+    qint64 clip_in, timeline_in, timeline_out;
+    quint32 color;
+
+    stream >> index >> c.enabled;
+    c.index = index;
+    c.name = stream.read_string();
+    stream >> clip_in
+           >> timeline_in
+           >> timeline_out
+           >> track
+           >> color
+           >> c.autoscaled
+           >> c.speed
+           >> c.maintain_audio_pitch
+           >> c.reversed
+           >> media_type
+           >> media_id
+           >> media_stream;
+    c.clip_in = long(clip_in);
+    c.timeline_in = long(timeline_in);
+    c.timeline_out = long(timeline_out);
+    c.track = track;
+    c.color = QColor(QRgb(color));
+    c.media_type = media_type;
+    c.media_id = media_id;
+    c.media_stream = media_stream;
+
+    olive::load_binary_markers(stream, c.markers);
+
+    quint32 link_count;
+    stream >> link_count;
+    for (quint32 j=0;j<link_count && stream.status() == QDataStream::Ok;j++) {
+      qint32 link;
+      stream >> link;
+      c.linked.append(link);
+    }
+
+    for (int t=kTransitionOpening;t<=kTransitionClosing;t++) {
+      TransitionSnapshot& transition = c.transitions[t - kTransitionOpening];
+      stream >> transition.present;
+      if (transition.present) {
+        qint32 shared;
+        stream >> shared;
+
+        if (shared > -1) {
+          // this transition is shared with another clip that was already decoded
+          transition.shared = shared;
+        } else {
+          qint64 length;
+          stream >> length;
+          transition.effect.length = long(length);
+          decode_effect(stream, transition.effect, true);
+        }
+      }
+    }
+
+    quint32 effect_count;
+    stream >> effect_count;
+    for (quint32 j=0;j<effect_count && stream.status() == QDataStream::Ok;j++) {
+      EffectSnapshot effect;
+      decode_effect(stream, effect, false);
+      c.effects.append(effect);
+    }
+
+    if (stream.status() == QDataStream::Ok) {
+      clips.append(c);
+    }
+  }
+
+  return clips;
+}
+
+void BinarySequenceLoader::load(SequencePtr s) {
+  read_data();
+
+  BinaryReader stream(data_, &context_->strings);
+  stream.device()->seek(clip_offset_);
+
+  quint32 clip_count;
+  stream >> clip_count;
+
+  for (quint32 i=0;i<clip_count && stream.status() == QDataStream::Ok;i++) {
+    ClipPtr c = std::make_shared<Clip>(s);
+
+    qint32 load_id, track;
+    qint64 clip_in, timeline_in, timeline_out;
+    quint32 color;
+    bool enabled, autoscaled, reversed;
+    ClipSpeed speed_info;
+
+    stream >> load_id >> enabled;
+    c->load_id = load_id;
+    c->set_enabled(enabled);
+    c->set_name(stream.read_string());
+    stream >> clip_in
+           >> timeline_in
+           >> timeline_out
+           >> track
+           >> color
+           >> autoscaled
+           >> speed_info.value
+           >> speed_info.maintain_audio_pitch
+           >> reversed;
+    c->set_clip_in(long(clip_in));
+    c->set_timeline_in(long(timeline_in));
+    c->set_timeline_out(long(timeline_out));
+    c->set_track(track);
+    c->set_color(QColor(QRgb(color)));
+    c->set_autoscaled(autoscaled);
+    c->set_speed(speed_info);
+    c->set_reversed(reversed);
+
+    qint32 media_type, media_id, stream_id;
+    stream >> media_type >> media_id >> stream_id;
+
+    // set media and media stream
+    switch (media_type) {
+    case MEDIA_TYPE_FOOTAGE:
+    {
+      Media* footage = context_->footage.value(media_id);
+      if (footage != nullptr) {
+        c->set_media(footage, stream_id);
+      }
+    }
+      break;
+    case MEDIA_TYPE_SEQUENCE:
+      // all sequences already exist as media, so nested sequences can be linked right away
+      c->set_media(context_->sequences.value(media_id), media_id);
+      break;
+    }
+
+    olive::load_binary_markers(stream, c->get_markers());
+
+    quint32 link_count;
+    stream >> link_count;
+    for (quint32 j=0;j<link_count && stream.status() == QDataStream::Ok;j++) {
+      qint32 link;
+      stream >> link;
+      c->linked.append(link);
+    }
+
+    for (int t=kTransitionOpening;t<=kTransitionClosing;t++) {
+      bool has_transition;
+      stream >> has_transition;
+      if (has_transition) {
+        load_effect(stream, c.get(), t);
+      }
+    }
+
+    quint32 effect_count;
+    stream >> effect_count;
+    for (quint32 j=0;j<effect_count && stream.status() == QDataStream::Ok;j++) {
+      load_effect(stream, c.get(), kTransitionNone);
+    }
+
+    s->clips.append(c);
+  }
+
+  if (stream.status() != QDataStream::Ok) {
+    qWarning() << "Sequence" << s->name << "is corrupt or truncated, some clips may be missing";
+  }
+
+  // correct links from load IDs to clip indices
+  for (int i=0;i<s->clips.size();i++) {
+    Clip* correct_clip = s->clips.at(i).get();
+    for (int j=0;j<correct_clip->linked.size();j++) {
+      bool found = false;
+      for (int k=0;k<s->clips.size();k++) {
+        if (s->clips.at(k)->load_id == correct_clip->linked.at(j)) {
+          correct_clip->linked[j] = k;
+          found = true;
+          break;
+        }
+      }
+      if (!found) {
+        // this usually happens long after loading, so rather than asking whether to continue, just drop the link
+        qWarning() << "Removed invalid clip link in sequence" << s->name;
+        correct_clip->linked.removeAt(j);
+        j--;
+      }
+    }
+  }
+
+  for (int i=0;i<s->clips.size();i++) {
+    const ClipPtr& c = s->clips.at(i);
+    if (c->media() != nullptr && c->media()->get_type() == MEDIA_TYPE_SEQUENCE) {
+      c->refresh();
+    }
+  }
+
+  // the serialized data is no longer needed
+  data_.clear();
+}
+
+void BinarySequenceLoader::load_effect(BinaryReader &stream, Clip *c, int type) {
+  long effect_length = -1;
+
+  if (type != kTransitionNone) {
+    qint32 shared;
+    stream >> shared;
+
+    if (shared > -1) {
+      // this transition is shared with another clip that was already loaded
+      LoadThread::link_shared_transition(c, shared, type);
+      return;
+    }
+
+    qint64 length;
+    stream >> length;
+    effect_length = long(length);
+  }
+
+  QString effect_name = stream.read_string();
+  bool effect_enabled;
+  stream >> effect_enabled;
+
+  const EffectMeta* meta = nullptr;
+
+  // find effect with this name
+  if (!effect_name.isEmpty()) {
+    panel_effect_controls->effects_loaded.lock();
+    meta = get_meta_from_name(effect_name);
+    panel_effect_controls->effects_loaded.unlock();
+  }
+
+  // effects only hold data until they're shown, so unlike LoadThread this can create them directly
+  if (type == kTransitionNone) {
+    EffectPtr e;
+    if (meta == nullptr) {
+      e = EffectPtr(new VoidEffect(c, effect_name));
+    } else {
+      e = Effect::Create(c, meta);
+    }
+    e->set_enabled(effect_enabled);
+    e->load_binary(stream);
+    c->effects.append(e);
+  } else {
+    TransitionPtr t = Transition::Create(c, nullptr, meta);
+    if (effect_length > -1) t->set_length(effect_length);
+    t->set_enabled(effect_enabled);
+    t->load_binary(stream);
+
+    if (type == kTransitionOpening) {
+      c->opening_transition = t;
+    } else {
+      c->closing_transition = t;
+    }
+  }
+}
+
+void olive::load_binary_markers(BinaryReader &stream, QVector<Marker> &markers) {
+  quint32 marker_count;
+  stream >> marker_count;
+  for (quint32 i=0;i<marker_count && stream.status() == QDataStream::Ok;i++) {
+    Marker m;
+    qint64 frame;
+    stream >> frame;
+    m.frame = long(frame);
+    m.name = stream.read_string();
+    markers.append(m);
+  }
+}
@@ -0,0 +1,128 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef BINARYSEQUENCELOADER_H
+#define BINARYSEQUENCELOADER_H
+
+#include <QHash>
+#include <QByteArray>
+
+#include "project/sequence.h"
+#include "io/binaryproject.h"
+#include "io/projectsnapshot.h"
+
+/**
+ * @brief Data from a binary project that its sequences need to build their clips
+ *
+ * Shared by every BinarySequenceLoader created when loading one project. Media is keyed by the save IDs used in the
+ * project file, since save IDs of the live project are reassigned whenever it's saved.
+ */
+struct BinaryProjectContext {
+  BinaryStringTable strings;
+  QHash<int, Media*> footage;
+  QHash<int, Media*> sequences;
+};
+
+/**
+ * @brief The BinarySequenceLoader class
+ *
+ * Remembers where the clips of a sequence loaded from a binary project are so they only get read and built (along
+ * with all of their effects) when the sequence is first used. See Sequence::load_deferred().
+ *
+ * The project file is kept open until every sequence loaded from it has been built or its data was needed for
+ * anything else (see uses_media() and snapshot()), in which case the section is kept in memory instead.
+ */
+class BinarySequenceLoader : public SequenceLoader {
+public:
+  /**
+   * @brief BinarySequenceLoader Constructor
+   *
+   * @param context
+   *
+   * Shared data of the project the sequence was loaded from
+   *
+   * @param file
+   *
+   * The project file the sequence was loaded from
+   *
+   * @param section
+   *
+   * The sequence's section in `file`
+   *
+   * @param clip_offset
+   *
+   * Position in the section where the sequence's clips start
+   */
+  BinarySequenceLoader(std::shared_ptr<BinaryProjectContext> context,
+                       std::shared_ptr<BinaryProjectFile> file,
+                       const BinarySection& section,
+                       qint64 clip_offset);
+
+  virtual void load(SequencePtr s) override;
+  virtual bool uses_media(Media* m) override;
+
+  /**
+   * @brief Get the unloaded clips for saving
+   *
+   * Media the clips use is mapped to its current save ID. The delete media path loads sequences using anything being
+   * deleted, so everything the clips refer to is still in the project.
+   */
+  virtual std::shared_ptr<DeferredClips> snapshot() override;
+
+  /**
+   * @brief Decode serialized clips into snapshots without building them
+   *
+   * Media IDs are left as they are in the project file. Safe to call from any thread.
+   */
+  static QVector<ClipSnapshot> decode_clips(const QByteArray& data, qint64 clip_offset, const BinaryStringTable& strings);
+private:
+  void load_effect(BinaryReader& stream, Clip* c, int type);
+
+  /**
+   * @brief Read the sequence's section from the file if that hasn't happened yet, and release the file
+   */
+  void read_data();
+
+  /**
+   * @brief Fill footage_ids_ and sequence_ids_ if that hasn't happened yet
+   */
+  void find_media();
+
+  std::shared_ptr<BinaryProjectContext> context_;
+  std::shared_ptr<BinaryProjectFile> file_;
+  BinarySection section_;
+  qint64 clip_offset_;
+
+  QByteArray data_;
+
+  // IDs (in the project file) of the footage and sequences used by the clips
+  bool media_found_;
+  QVector<int> footage_ids_;
+  QVector<int> sequence_ids_;
+};
+
+namespace olive {
+  /**
+   * @brief Read markers of a binary project
+   */
+  void load_binary_markers(BinaryReader& stream, QVector<Marker>& markers);
+}
+
+#endif // BINARYSEQUENCELOADER_H
@@ -71,7 +71,15 @@ Config::Config()
     waveform_resolution(64),
     thumbnail_resolution(120),
     add_default_effects_to_clips(true),
-    invert_timeline_scroll_axes(true)
+    invert_timeline_scroll_axes(true),
+    proxy_job_limit(2),
+    proxy_switching(olive::PROXY_SWITCH_AUTOMATIC),
+    undo_memory_limit(512),
+    render_cache_size(4096),
+    effect_cache_size(512),
+    ram_preview_size(2048),
+    ram_preview_divider(1),
+    enable_color_management(false)
 {}
 
 void Config::load(QString path) {
@@ -211,6 +219,42 @@ void Config::load(QString path) {
         } else if (stream.name() == "AddDefaultEffectsToClips") {
           stream.readNext();
           add_default_effects_to_clips = (stream.text() == "1");
+        } else if (stream.name() == "ProxyJobLimit") {
+          stream.readNext();
+          proxy_job_limit = stream.text().toInt();
+        } else if (stream.name() == "ProxySwitching") {
+          stream.readNext();
+          proxy_switching = stream.text().toInt();
+        } else if (stream.name() == "UndoMemoryLimit") {
+          stream.readNext();
+          undo_memory_limit = stream.text().toInt();
+        } else if (stream.name() == "RenderCacheSize") {
+          stream.readNext();
+          render_cache_size = stream.text().toInt();
+        } else if (stream.name() == "EffectCacheSize") {
+          stream.readNext();
+          effect_cache_size = stream.text().toInt();
+        } else if (stream.name() == "RamPreviewSize") {
+          stream.readNext();
+          ram_preview_size = stream.text().toInt();
+        } else if (stream.name() == "RamPreviewDivider") {
+          stream.readNext();
+          ram_preview_divider = stream.text().toInt();
+        } else if (stream.name() == "EnableColorManagement") {
+          stream.readNext();
+          enable_color_management = (stream.text() == "1");
+        } else if (stream.name() == "OCIOConfig") {
+          stream.readNext();
+          ocio_config_path = stream.text().toString();
+        } else if (stream.name() == "OCIOInputSpace") {
+          stream.readNext();
+          ocio_input_space = stream.text().toString();
+        } else if (stream.name() == "OCIODisplay") {
+          stream.readNext();
+          ocio_display = stream.text().toString();
+        } else if (stream.name() == "OCIOView") {
+          stream.readNext();
+          ocio_view = stream.text().toString();
         }
       }
     }
@@ -278,6 +322,18 @@ void Config::save(QString path) {
   stream.writeTextElement("ThumbnailResolution", QString::number(thumbnail_resolution));
   stream.writeTextElement("WaveformResolution", QString::number(waveform_resolution));
   stream.writeTextElement("AddDefaultEffectsToClips", QString::number(add_default_effects_to_clips));
+  stream.writeTextElement("ProxyJobLimit", QString::number(proxy_job_limit));
+  stream.writeTextElement("ProxySwitching", QString::number(proxy_switching));
+  stream.writeTextElement("UndoMemoryLimit", QString::number(undo_memory_limit));
+  stream.writeTextElement("RenderCacheSize", QString::number(render_cache_size));
+  stream.writeTextElement("EffectCacheSize", QString::number(effect_cache_size));
+  stream.writeTextElement("RamPreviewSize", QString::number(ram_preview_size));
+  stream.writeTextElement("RamPreviewDivider", QString::number(ram_preview_divider));
+  stream.writeTextElement("EnableColorManagement", QString::number(enable_color_management));
+  stream.writeTextElement("OCIOConfig", ocio_config_path);
+  stream.writeTextElement("OCIOInputSpace", ocio_input_space);
+  stream.writeTextElement("OCIODisplay", ocio_display);
+  stream.writeTextElement("OCIOView", ocio_view);
 
   stream.writeEndElement(); // configuration
   stream.writeEndDocument(); // doc
@@ -138,6 +138,24 @@ namespace olive {
     /** Queue size value is in seconds */
     FRAME_QUEUE_TYPE_SECONDS
   };
+
+  /**
+   * @brief The ProxySwitchingMode enum
+   *
+   * Footage with a proxy can be decoded from either the proxy or its original source file. The default ProxyPolicy
+   * (rendering/proxypolicy.h) responds to Config::proxy_switching set to a value from this enum.
+   */
+  enum ProxySwitchingMode {
+    /** Always use the proxy if one is available */
+    PROXY_SWITCH_ALWAYS,
+
+    /** Use the proxy while playing or scrubbing, and the source for paused frames and export */
+    PROXY_SWITCH_PLAYBACK,
+
+    /** Same as PROXY_SWITCH_PLAYBACK, but only for footage whose measured decode time is too slow to play the
+     * source in real time (default) */
+    PROXY_SWITCH_AUTOMATIC
+  };
 }
 
 /**
@@ -517,6 +535,107 @@ struct Config {
    */
   bool invert_timeline_scroll_axes;
 
+  /**
+   * @brief Concurrent proxy jobs
+   *
+   * The maximum number of footage files that the ProxyGenerator will generate proxies for at the same time. The
+   * available CPU cores are split between running jobs, which use them to transcode long files in parallel
+   * segments.
+   *
+   * Set to a value >= 1
+   */
+  int proxy_job_limit;
+
+  /**
+   * @brief Proxy switching
+   *
+   * Controls when the playback engine decodes footage from its proxy rather than the original source file.
+   *
+   * Set to a member of enum ProxySwitchingMode.
+   */
+  int proxy_switching;
+
+  /**
+   * @brief Undo history memory limit
+   *
+   * The approximate amount of memory in megabytes that the undo history may use. Once it's exceeded, the oldest undo
+   * steps are discarded.
+   *
+   * Set to 0 for no limit.
+   */
+  int undo_memory_limit;
+
+  /**
+   * @brief Render cache size
+   *
+   * The amount of disk space in megabytes that frames rendered with "Render Work Area" may use. Once it's exceeded,
+   * the oldest frames are deleted.
+   */
+  int render_cache_size;
+
+  /**
+   * @brief Effect cache size
+   *
+   * The amount of video memory in megabytes that clip outputs kept by EffectStageCache may use to skip redrawing
+   * clips whose effects haven't changed. Once it's exceeded, the least recently used outputs are discarded.
+   *
+   * Set to 0 to disable the effect cache.
+   */
+  int effect_cache_size;
+
+  /**
+   * @brief RAM preview size
+   *
+   * The amount of memory in megabytes that RAM preview frames may use. Work areas that need more than this are only
+   * partially cached.
+   */
+  int ram_preview_size;
+
+  /**
+   * @brief RAM preview resolution divider
+   *
+   * RAM preview frames are stored at the sequence's resolution divided by this (1, 2 or 4) so more of them fit in
+   * memory. They're scaled back up when they're drawn.
+   */
+  int ram_preview_divider;
+
+  /**
+   * @brief Enable color management
+   *
+   * Set to **TRUE** to run rendered frames through an OpenColorIO display transform (see OCIOLutCache). Only has an
+   * effect if Olive was built with OpenColorIO.
+   */
+  bool enable_color_management;
+
+  /**
+   * @brief OpenColorIO config file
+   *
+   * Path to the config.ocio file to take color spaces from. Leave empty to use the config set in the OCIO environment
+   * variable.
+   */
+  QString ocio_config_path;
+
+  /**
+   * @brief OpenColorIO input color space
+   *
+   * Color space rendered frames are in. Leave empty to use the config's scene_linear role.
+   */
+  QString ocio_input_space;
+
+  /**
+   * @brief OpenColorIO display
+   *
+   * Display device to transform rendered frames for. Leave empty to use the config's default display.
+   */
+  QString ocio_display;
+
+  /**
+   * @brief OpenColorIO view
+   *
+   * View of `ocio_display` to transform rendered frames to. Leave empty to use the display's default view.
+   */
+  QString ocio_view;
+
   /**
    * @brief Load config from file
    *
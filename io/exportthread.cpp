@@ -382,7 +382,7 @@ void ExportThread::run() {
     if (params.video_enabled) {
       do {
         // TODO optimize by rendering the next frame while encoding the last
-        renderer->start_render(nullptr, olive::ActiveSequence, nullptr, video_frame->data[0], video_frame->linesize[0]/4);
+        renderer->start_render(nullptr, olive::ActiveSequence, olive::kPlaybackExporting, nullptr, video_frame->data[0], video_frame->linesize[0]/4);
         waitCond.wait(&mutex);
         if (!continueEncode) break;
       } while (renderer->did_texture_fail());
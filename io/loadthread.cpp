@@ -31,6 +31,8 @@
 #include "io/config.h"
 #include "rendering/renderfunctions.h"
 #include "io/previewgenerator.h"
+#include "io/binaryproject.h"
+#include "io/binarysequenceloader.h"
 #include "effects/internal/voideffect.h"
 #include "debug.h"
 
@@ -62,6 +64,15 @@ LoadThread::LoadThread(const QString& filename, bool autorecovery, bool clear) :
 void LoadThread::load_effect(QXmlStreamReader& stream, Clip* c) {
   QString tag = stream.name().toString();
 
+  int type;
+  if (tag == "opening") {
+    type = kTransitionOpening;
+  } else if (tag == "closing") {
+    type = kTransitionClosing;
+  } else {
+    type = kTransitionNone;
+  }
+
   // variables to store effect metadata in
   int effect_id = -1;
   QString effect_name;
@@ -81,38 +92,49 @@ void LoadThread::load_effect(QXmlStreamReader& stream, Clip* c) {
       effect_length = attr.value().toLong();
     } else if (attr.name() == "shared") {
       // if a transition has this tag, it's sharing a transition with another clip so we don't have to do any processing
+      link_shared_transition(c, attr.value().toInt(), type);
+      return;
+    }
+  }
 
-      Clip* sharing_clip = nullptr;
+  create_effect(stream, c, type, effect_name, effect_length, effect_enabled);
+}
 
-      // Find the clip with the ID referenced in the transition
-      int clip_id = attr.value().toInt();
-      for (int i=0;i<c->sequence->clips.size();i++) {
-        Clip* test_clip = c->sequence->clips.at(i).get();
-        if (test_clip->load_id == clip_id) {
-          sharing_clip = test_clip;
-          break;
-        }
-      }
+void LoadThread::link_shared_transition(Clip* c, int clip_id, int type) {
+  Clip* sharing_clip = nullptr;
 
-      if (sharing_clip == nullptr) {
-        qWarning() << "Failed to link shared transition. Project may be corrupt.";
-      } else if (tag == "opening") {
-        c->opening_transition = (sharing_clip->closing_transition);
+  // Find the clip with the ID referenced in the transition
+  for (int i=0;i<c->sequence->clips.size();i++) {
+    Clip* test_clip = c->sequence->clips.at(i).get();
+    if (test_clip->load_id == clip_id) {
+      sharing_clip = test_clip;
+      break;
+    }
+  }
 
-        // since this is the opened clip, switch secondaries and primaries
-        c->opening_transition->secondary_clip = c->opening_transition->parent_clip;
-        c->opening_transition->parent_clip = c;
-        c->opening_transition->refresh();
-      } else if (tag == "closing") {
-        c->closing_transition = (sharing_clip->opening_transition);
+  if (sharing_clip == nullptr) {
+    qWarning() << "Failed to link shared transition. Project may be corrupt.";
+  } else if (type == kTransitionOpening) {
+    c->opening_transition = (sharing_clip->closing_transition);
 
-        // since this is the closed clip, make this clip the secondary
-        c->opening_transition->secondary_clip = c;
-      }
-      return;
-    }
+    // since this is the opened clip, switch secondaries and primaries
+    c->opening_transition->secondary_clip = c->opening_transition->parent_clip;
+    c->opening_transition->parent_clip = c;
+    c->opening_transition->refresh();
+  } else if (type == kTransitionClosing) {
+    c->closing_transition = (sharing_clip->opening_transition);
+
+    // since this is the closed clip, make this clip the secondary
+    c->closing_transition->secondary_clip = c;
   }
+}
 
+void LoadThread::create_effect(QXmlStreamReader& stream,
+                               Clip* c,
+                               int type,
+                               const QString& effect_name,
+                               long effect_length,
+                               bool effect_enabled) {
   // Effect loading occurs in another thread, and while it's usually very quick, just for safety we wait here
   // for all the effects to finish loading
   panel_effect_controls->effects_loaded.lock();
@@ -126,15 +148,6 @@ void LoadThread::load_effect(QXmlStreamReader& stream, Clip* c) {
 
   panel_effect_controls->effects_loaded.unlock();
 
-  int type;
-  if (tag == "opening") {
-    type = kTransitionOpening;
-  } else if (tag == "closing") {
-    type = kTransitionClosing;
-  } else {
-    type = kTransitionNone;
-  }
-
   // effect UI creation has to occur in the main thread, see an explanation in create_effect_ui()
   emit start_create_effect_ui(&stream, c, type, &effect_name, meta, effect_length, effect_enabled);
   waitCond.wait(&mutex);
@@ -203,17 +216,8 @@ bool LoadThread::load_worker(QFile& f, QXmlStreamReader& stream, int type) {
     if (stream.name() == root_search) {
       if (type == LOAD_TYPE_VERSION) {
         proj_version = stream.readElementText().toInt();
-        if (proj_version < olive::kMinimumSaveVersion || proj_version > olive::kSaveVersion) {
-          emit start_question(
-                tr("Version Mismatch"),
-                tr("This project was saved in a different version of Olive and may not be fully compatible with this version. Would you like to attempt loading it anyway?"),
-                QMessageBox::Yes | QMessageBox::No
-                );
-          waitCond.wait(&mutex);
-          if (question_btn == QMessageBox::No) {
-            show_err = false;
-            return false;
-          }
+        if (!check_version(proj_version)) {
+          return false;
         }
       } else if (type == LOAD_TYPE_URL) {
         internal_proj_url = stream.readElementText();
@@ -258,49 +262,7 @@ bool LoadThread::load_worker(QFile& f, QXmlStreamReader& stream, int type) {
                 } else if (attr.name() == "name") {
                   f->name = attr.value().toString();
                 } else if (attr.name() == "url") {
-                  f->url = attr.value().toString();
-
-                  if (!QFileInfo::exists(f->url)) { // if path is not absolute
-                    // tries to locate file using a file path relative to the project's current folder
-                    QString proj_dir_test = proj_dir.absoluteFilePath(f->url);
-
-                    // tries to locate file using a file path relative to the folder the project was saved in
-                    // (unaffected by moving the project file)
-                    QString internal_proj_dir_test = internal_proj_dir.absoluteFilePath(f->url);
-
-                    // tries to locate file using the file name directly in the project's current folder
-                    QString proj_dir_direct_test = proj_dir.filePath(QFileInfo(f->url).fileName());
-
-                    if (QFileInfo::exists(proj_dir_test)) {
-
-                      f->url = proj_dir_test;
-                      qInfo() << "Matched" << attr.value().toString() << "relative to project's current directory";
-
-                    } else if (QFileInfo::exists(internal_proj_dir_test)) {
-
-                      f->url = internal_proj_dir_test;
-                      qInfo() << "Matched" << attr.value().toString() << "relative to project's internal directory";
-
-                    } else if (QFileInfo::exists(proj_dir_direct_test)) {
-
-                      f->url = proj_dir_direct_test;
-                      qInfo() << "Matched" << attr.value().toString() << "directly to project's current directory";
-
-                    } else if (f->url.contains('%')) {
-
-                      // hack for image sequences (qt won't be able to find the URL with %, but ffmpeg may)
-                      f->url = internal_proj_dir_test;
-                      qInfo() << "Guess image sequence" << attr.value().toString() << "path to project's internal directory";
-
-                    } else {
-
-                      qInfo() << "Failed to match" << attr.value().toString() << "to file";
-
-                    }
-                  } else {
-                    f->url = QFileInfo(f->url).absoluteFilePath();
-                    qInfo() << "Matched" << attr.value().toString() << "with absolute path";
-                  }
+                  f->url = resolve_footage_url(attr.value().toString());
                 } else if (attr.name() == "duration") {
                   f->length = attr.value().toLongLong();
                 } else if (attr.name() == "using_inout") {
@@ -371,6 +333,8 @@ bool LoadThread::load_worker(QFile& f, QXmlStreamReader& stream, int type) {
                   s->audio_frequency = attr.value().toInt();
                 } else if (attr.name() == "alayout") {
                   s->audio_layout = attr.value().toInt();
+                } else if (attr.name() == "halffloat") {
+                  s->half_float = (attr.value() == "1");
                 } else if (attr.name() == "open") {
                   open_seq = s;
                 } else if (attr.name() == "workarea") {
@@ -511,40 +475,9 @@ bool LoadThread::load_worker(QFile& f, QXmlStreamReader& stream, int type) {
               }
               if (cancelled_) return false;
 
-              // correct links, clip IDs, transitions
-              for (int i=0;i<s->clips.size();i++) {
-                // correct links
-                Clip* correct_clip = s->clips.at(i).get();
-                for (int j=0;j<correct_clip->linked.size();j++) {
-                  bool found = false;
-                  for (int k=0;k<s->clips.size();k++) {
-                    if (s->clips.at(k)->load_id == correct_clip->linked.at(j)) {
-                      correct_clip->linked[j] = k;
-                      found = true;
-                      break;
-                    }
-                  }
-                  if (!found) {
-                    correct_clip->linked.removeAt(j);
-                    j--;
-
-                    emit start_question(
-                          tr("Invalid Clip Link"),
-                          tr("This project contains an invalid clip link. It may be corrupt. Would you like to continue loading it?"),
-                          QMessageBox::Yes | QMessageBox::No
-                          );
-                    waitCond.wait(&mutex);
-                    if (question_btn == QMessageBox::No) {
-                      s.reset();
-                      return false;
-                    }
-                  }
-                }
+              if (!finish_sequence(s, parent)) {
+                return false;
               }
-
-              Media* m = panel_project->create_sequence_internal(nullptr, s, false, parent);
-
-              loaded_sequences.append(m);
             }
               break;
             }
@@ -569,6 +502,313 @@ Media* LoadThread::find_loaded_folder_by_id(int id) {
   return nullptr;
 }
 
+bool LoadThread::check_version(int proj_version) {
+  if (proj_version < olive::kMinimumSaveVersion || proj_version > olive::kSaveVersion) {
+    emit start_question(
+          tr("Version Mismatch"),
+          tr("This project was saved in a different version of Olive and may not be fully compatible with this version. Would you like to attempt loading it anyway?"),
+          QMessageBox::Yes | QMessageBox::No
+          );
+    waitCond.wait(&mutex);
+    if (question_btn == QMessageBox::No) {
+      show_err = false;
+      return false;
+    }
+  }
+  return true;
+}
+
+QString LoadThread::resolve_footage_url(const QString &url) {
+  if (QFileInfo::exists(url)) {
+    qInfo() << "Matched" << url << "with absolute path";
+    return QFileInfo(url).absoluteFilePath();
+  }
+
+  // if path is not absolute
+
+  // tries to locate file using a file path relative to the project's current folder
+  QString proj_dir_test = proj_dir.absoluteFilePath(url);
+
+  // tries to locate file using a file path relative to the folder the project was saved in
+  // (unaffected by moving the project file)
+  QString internal_proj_dir_test = internal_proj_dir.absoluteFilePath(url);
+
+  // tries to locate file using the file name directly in the project's current folder
+  QString proj_dir_direct_test = proj_dir.filePath(QFileInfo(url).fileName());
+
+  if (QFileInfo::exists(proj_dir_test)) {
+
+    qInfo() << "Matched" << url << "relative to project's current directory";
+    return proj_dir_test;
+
+  } else if (QFileInfo::exists(internal_proj_dir_test)) {
+
+    qInfo() << "Matched" << url << "relative to project's internal directory";
+    return internal_proj_dir_test;
+
+  } else if (QFileInfo::exists(proj_dir_direct_test)) {
+
+    qInfo() << "Matched" << url << "directly to project's current directory";
+    return proj_dir_direct_test;
+
+  } else if (url.contains('%')) {
+
+    // hack for image sequences (qt won't be able to find the URL with %, but ffmpeg may)
+    qInfo() << "Guess image sequence" << url << "path to project's internal directory";
+    return internal_proj_dir_test;
+
+  }
+
+  qInfo() << "Failed to match" << url << "to file";
+  return url;
+}
+
+bool LoadThread::finish_sequence(SequencePtr s, Media* parent) {
+  // correct links, clip IDs, transitions
+  for (int i=0;i<s->clips.size();i++) {
+    // correct links
+    Clip* correct_clip = s->clips.at(i).get();
+    for (int j=0;j<correct_clip->linked.size();j++) {
+      bool found = false;
+      for (int k=0;k<s->clips.size();k++) {
+        if (s->clips.at(k)->load_id == correct_clip->linked.at(j)) {
+          correct_clip->linked[j] = k;
+          found = true;
+          break;
+        }
+      }
+      if (!found) {
+        correct_clip->linked.removeAt(j);
+        j--;
+
+        emit start_question(
+              tr("Invalid Clip Link"),
+              tr("This project contains an invalid clip link. It may be corrupt. Would you like to continue loading it?"),
+              QMessageBox::Yes | QMessageBox::No
+              );
+        waitCond.wait(&mutex);
+        if (question_btn == QMessageBox::No) {
+          s.reset();
+          return false;
+        }
+      }
+    }
+  }
+
+  Media* m = panel_project->create_sequence_internal(nullptr, s, false, parent);
+
+  loaded_sequences.append(m);
+
+  return true;
+}
+
+bool LoadThread::load_binary_folders(BinaryReader &stream) {
+  quint32 folder_count;
+  stream >> folder_count;
+
+  for (quint32 i=0;i<folder_count && stream.status() == QDataStream::Ok;i++) {
+    Media* folder = panel_project->create_folder_internal(nullptr);
+    folder->set_name(stream.read_string());
+
+    qint32 id, parent;
+    stream >> id >> parent;
+    folder->temp_id = id;
+    folder->temp_id2 = parent;
+
+    loaded_folders.append(folder);
+  }
+
+  return (stream.status() == QDataStream::Ok);
+}
+
+bool LoadThread::load_binary_media(BinaryReader &stream) {
+  quint32 footage_count;
+  stream >> footage_count;
+
+  for (quint32 i=0;i<footage_count && !cancelled_ && stream.status() == QDataStream::Ok;i++) {
+    Media* item = new Media(nullptr);
+    FootagePtr f(new Footage());
+
+    qint32 save_id, folder, start_number;
+    qint64 length, in, out;
+
+    stream >> save_id >> folder;
+    f->save_id = save_id;
+    f->name = stream.read_string();
+    f->url = resolve_footage_url(stream.read_string());
+    stream >> length
+           >> f->using_inout
+           >> in
+           >> out
+           >> f->speed
+           >> f->alpha_is_premultiplied
+           >> start_number
+           >> f->proxy;
+    f->length = length;
+    f->in = long(in);
+    f->out = long(out);
+    f->start_number = start_number;
+    f->proxy_path = stream.read_string();
+
+    olive::load_binary_markers(stream, f->markers);
+
+    item->set_footage(f);
+
+    olive::project_model.appendChild(find_loaded_folder_by_id(folder), item);
+
+    // analyze media to see if it's the same
+    loaded_media_items.append(item);
+  }
+
+  return !cancelled_ && (stream.status() == QDataStream::Ok);
+}
+
+bool LoadThread::load_binary_sequence(std::shared_ptr<BinaryProjectFile> project,
+                                      const BinarySection& section,
+                                      std::shared_ptr<BinaryProjectContext> context) {
+  // only the sequence's attributes are read here, straight from the file rather than reading in the whole section
+  QIODevice* device = project->seek_section(&section);
+  if (device == nullptr) {
+    return false;
+  }
+
+  BinaryReader stream(device, &context->strings);
+
+  Media* parent = nullptr;
+  SequencePtr s = std::make_shared<Sequence>();
+
+  qint32 save_id, folder, width, height, audio_frequency, audio_layout;
+  qint64 workarea_in, workarea_out, end_frame;
+  bool open;
+
+  stream >> save_id >> folder;
+  s->save_id = save_id;
+  if (folder > 0) parent = find_loaded_folder_by_id(folder);
+  s->name = stream.read_string();
+  stream >> width
+         >> height
+         >> s->frame_rate
+         >> audio_frequency
+         >> audio_layout
+         >> open
+         >> s->using_workarea
+         >> workarea_in
+         >> workarea_out
+         >> end_frame;
+  s->width = width;
+  s->height = height;
+  s->audio_frequency = audio_frequency;
+  s->audio_layout = audio_layout;
+  s->workarea_in = long(workarea_in);
+  s->workarea_out = long(workarea_out);
+  if (open) {
+    open_seq = s;
+  }
+
+  olive::load_binary_markers(stream, s->markers);
+
+  qint64 clip_offset = device->pos() - section.offset;
+
+  if (cancelled_ || stream.status() != QDataStream::Ok || clip_offset > section.size) {
+    return false;
+  }
+
+  // settings that were added later are in a section of their own, sequences without one keep their defaults
+  const BinarySection* settings_section = project->find_section(kBinarySectionSequenceSettings, save_id);
+  if (settings_section != nullptr) {
+    BinaryReader settings_stream(project->read_section(settings_section), &context->strings);
+    settings_stream >> s->half_float;
+  }
+
+  // Clips (and their effects) aren't read or built here. The sequence only remembers where its clips are until it's
+  // first used, which for the open sequence is right after loading when it's set as the active sequence.
+  s->deferred_loader = std::make_shared<BinarySequenceLoader>(context, project, section, clip_offset);
+  s->deferred_end_frame = long(end_frame);
+
+  if (!finish_sequence(s, parent)) {
+    return false;
+  }
+
+  context->sequences.insert(save_id, loaded_sequences.last());
+
+  return true;
+}
+
+bool LoadThread::load_binary() {
+  // shared with the sequences' loaders, which read their clips from it later
+  std::shared_ptr<BinaryProjectFile> project = std::make_shared<BinaryProjectFile>();
+  if (!project->open(filename_)) {
+    error_str = tr("'%1' is not a valid binary project file").arg(filename_);
+    return false;
+  }
+
+  // shared with the sequences' loaders, which outlive this thread
+  std::shared_ptr<BinaryProjectContext> context = std::make_shared<BinaryProjectContext>();
+  context->strings = project->strings();
+  const BinaryStringTable& strings = context->strings;
+
+  if (!check_version(project->version())) {
+    return false;
+  }
+
+  // progress is reported per section
+  current_element_count = 0;
+  total_element_count = project->sections().size();
+
+  const BinarySection* header_section = project->find_section(kBinarySectionHeader);
+  if (header_section != nullptr) {
+    BinaryReader stream(project->read_section(header_section), &strings);
+    internal_proj_url = stream.read_string();
+    internal_proj_dir = QFileInfo(internal_proj_url).absoluteDir();
+  }
+
+  bool cont = true;
+
+  // load folders first
+  const BinarySection* folder_section = project->find_section(kBinarySectionFolders);
+  if (folder_section != nullptr) {
+    BinaryReader stream(project->read_section(folder_section), &strings);
+    cont = load_binary_folders(stream);
+  }
+
+  // since folders loaded correctly, organize them appropriately
+  if (cont) {
+    for (int i=0;i<loaded_folders.size();i++) {
+      Media* folder = loaded_folders.at(i);
+      int parent = folder->temp_id2;
+      olive::project_model.appendChild(find_loaded_folder_by_id(parent), folder);
+    }
+  }
+
+  // load media
+  const BinarySection* media_section = project->find_section(kBinarySectionMedia);
+  if (cont && media_section != nullptr) {
+    BinaryReader stream(project->read_section(media_section), &strings);
+    cont = load_binary_media(stream);
+
+    for (int i=0;i<loaded_media_items.size();i++) {
+      context->footage.insert(loaded_media_items.at(i)->to_footage()->save_id, loaded_media_items.at(i));
+    }
+  }
+
+  // load sequences, each is in its own section so they're found straight from the index
+  for (int i=0;cont && i<project->sections().size();i++) {
+    const BinarySection& section = project->sections().at(i);
+    if (section.type == kBinarySectionSequence) {
+      cont = load_binary_sequence(project, section, context);
+    }
+
+    current_element_count++;
+    report_progress((current_element_count * 100) / total_element_count);
+  }
+
+  if (!cont && !cancelled_ && show_err && error_str.isEmpty()) {
+    error_str = tr("'%1' is corrupt or truncated").arg(filename_);
+  }
+
+  return cont && !cancelled_;
+}
+
 void LoadThread::run() {
   mutex.lock();
 
@@ -600,47 +840,52 @@ void LoadThread::run() {
   loaded_clips.clear();
   loaded_sequences.clear();
 
-  // get "element" count
-  current_element_count = 0;
-  total_element_count = 0;
-  while (!cancelled_ && !stream.atEnd()) {
-    stream.readNextStartElement();
-    if (is_element(stream)) {
-      total_element_count++;
+  if (olive::is_binary_project_file(filename_)) {
+    // binary projects are read through their section index rather than in several passes
+    cont = load_binary();
+  } else {
+    // get "element" count
+    current_element_count = 0;
+    total_element_count = 0;
+    while (!cancelled_ && !stream.atEnd()) {
+      stream.readNextStartElement();
+      if (is_element(stream)) {
+        total_element_count++;
+      }
     }
-  }
-  cont = !cancelled_;
+    cont = !cancelled_;
 
-  // find project file version
-  if (cont) {
-    cont = load_worker(file, stream, LOAD_TYPE_VERSION);
-  }
-
-  // find project's internal URL
-  if (cont) {
-    cont = load_worker(file, stream, LOAD_TYPE_URL);
-  }
+    // find project file version
+    if (cont) {
+      cont = load_worker(file, stream, LOAD_TYPE_VERSION);
+    }
 
-  // load folders first
-  if (cont) {
-    cont = load_worker(file, stream, MEDIA_TYPE_FOLDER);
-  }
+    // find project's internal URL
+    if (cont) {
+      cont = load_worker(file, stream, LOAD_TYPE_URL);
+    }
 
-  // load media
-  if (cont) {
-    // since folders loaded correctly, organize them appropriately
-    for (int i=0;i<loaded_folders.size();i++) {
-      Media* folder = loaded_folders.at(i);
-      int parent = folder->temp_id2;
-      olive::project_model.appendChild(find_loaded_folder_by_id(parent), folder);
+    // load folders first
+    if (cont) {
+      cont = load_worker(file, stream, MEDIA_TYPE_FOLDER);
     }
 
-    cont = load_worker(file, stream, MEDIA_TYPE_FOOTAGE);
-  }
+    // load media
+    if (cont) {
+      // since folders loaded correctly, organize them appropriately
+      for (int i=0;i<loaded_folders.size();i++) {
+        Media* folder = loaded_folders.at(i);
+        int parent = folder->temp_id2;
+        olive::project_model.appendChild(find_loaded_folder_by_id(parent), folder);
+      }
 
-  // load sequences
-  if (cont) {
-    cont = load_worker(file, stream, MEDIA_TYPE_SEQUENCE);
+      cont = load_worker(file, stream, MEDIA_TYPE_FOOTAGE);
+    }
+
+    // load sequences
+    if (cont) {
+      cont = load_worker(file, stream, MEDIA_TYPE_SEQUENCE);
+    }
   }
 
   if (!cancelled_) {
@@ -721,6 +966,7 @@ void LoadThread::success_func() {
   if (autorecovery_) {
     QString orig_filename = internal_proj_url;
     int insert_index = internal_proj_url.lastIndexOf(".ove", -1, Qt::CaseInsensitive);
+    if (insert_index == -1) insert_index = internal_proj_url.lastIndexOf(kBinaryProjectExtension, -1, Qt::CaseInsensitive);
     if (insert_index == -1) insert_index = internal_proj_url.length();
     int counter = 1;
     while (QFileInfo::exists(orig_filename)) {
@@ -773,6 +1019,13 @@ void LoadThread::create_effect_ui(
    * the LoadThread has to wait for the effect to finish before it can
    * continue.
    *
+   * Effects no longer create their UI until they're shown in EffectControls,
+   * but they're still QObjects that have to live in the main thread (and a
+   * few, like VST and missing effects, still create widgets), so creation
+   * stays here. Binary projects don't come through here at all, their
+   * sequences build their effects in the main thread when first used (see
+   * BinarySequenceLoader).
+   *
    * Sorry. I'll fix it one day.
    */
 
@@ -30,6 +30,11 @@
 
 #include "project/projectelements.h"
 
+class BinaryReader;
+class BinaryProjectFile;
+struct BinarySection;
+struct BinaryProjectContext;
+
 class LoadThread : public QThread
 {
   Q_OBJECT
@@ -37,6 +42,9 @@ public:
   LoadThread(const QString& filename, bool autorecovery, bool clear);
   void run();
   void cancel();
+
+  // link a transition shared with a clip that was loaded before this one (`clip_id` is that clip's load ID)
+  static void link_shared_transition(Clip* c, int clip_id, int type);
 signals:
   void start_question(const QString &title, const QString &text, int buttons);
   void success();
@@ -68,6 +76,23 @@ private:
   bool load_worker(QFile& f, QXmlStreamReader& stream, int type);
   void load_effect(QXmlStreamReader& stream, Clip* c);
 
+  bool load_binary();
+  bool load_binary_folders(BinaryReader& stream);
+  bool load_binary_media(BinaryReader& stream);
+  bool load_binary_sequence(std::shared_ptr<BinaryProjectFile> project,
+                            const BinarySection& section,
+                            std::shared_ptr<BinaryProjectContext> context);
+
+  bool check_version(int proj_version);
+  QString resolve_footage_url(const QString& url);
+  bool finish_sequence(SequencePtr s, Media* parent);
+  void create_effect(QXmlStreamReader& stream,
+                     Clip* c,
+                     int type,
+                     const QString& effect_name,
+                     long effect_length,
+                     bool effect_enabled);
+
   void read_next(QXmlStreamReader& stream);
   void read_next_start_element(QXmlStreamReader& stream);
   void update_current_element_count(QXmlStreamReader& stream);
@@ -73,6 +73,7 @@ void PreviewGenerator::parse_media() {
     } else {
       FootageStream ms;
       ms.preview_done = false;
+      ms.audio_preview_generation = 0;
       ms.file_index = i;
       ms.enabled = true;
       ms.infinite_length = false;
@@ -174,6 +175,7 @@ bool PreviewGenerator::retrieve_preview(const QString& hash) {
         // faster way?
         ms.audio_preview[j] = data.at(j);
       }
+      ms.audio_preview_changed();
       ms.preview_done = true;
       f.close();
     } else {
@@ -189,6 +191,7 @@ bool PreviewGenerator::retrieve_preview(const QString& hash) {
     for (int i=0;i<footage_->audio_tracks.size();i++) {
       FootageStream& ms = footage_->audio_tracks[i];
       ms.audio_preview.clear();
+      ms.audio_preview_changed();
       ms.preview_done = false;
     }
   }
@@ -505,6 +508,7 @@ void PreviewGenerator::generate_waveform() {
 
     // by this point, we'll have made all audio waveform previews
     for (int i=0;i<footage_->audio_tracks.size();i++) {
+      footage_->audio_tracks[i].audio_preview_changed();
       footage_->audio_tracks[i].preview_done = true;
     }
   }
@@ -0,0 +1,365 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "projectsaver.h"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QDataStream>
+#include <QDebug>
+
+#include "mainwindow.h"
+#include "io/config.h"
+#include "io/binaryproject.h"
+
+ProjectSaver olive::project_saver;
+
+// identifies a file as an autorecovery journal
+const quint32 kJournalMagic = 0x4F56454A; // "OVEJ"
+
+// once the journal is this many times larger than the project it describes, it's rewritten from scratch
+const int kJournalCompactRatio = 4;
+
+// size of the magic number and version at the start of the journal
+const int kJournalFileHeaderSize = 8;
+
+// size of the length and checksum preceding every journal record
+const int kJournalRecordHeaderSize = 6;
+
+enum JournalRecordType {
+  kJournalHeader,
+  kJournalFolders,
+  kJournalMedia,
+  kJournalSequence,
+  kJournalSequenceCount,
+
+  // marks the end of a snapshot's records, anything after the last commit is an incomplete snapshot and is ignored
+  kJournalCommit
+};
+
+static void append_journal_record(QByteArray& records, int type, int index, const QByteArray& data) {
+  QByteArray payload;
+  QDataStream payload_stream(&payload, QIODevice::WriteOnly);
+  payload_stream.setVersion(kBinaryStreamVersion);
+  payload_stream << quint8(type) << qint32(index) << data;
+
+  // every record is prefixed with its length and checksum so a record torn by a crash can be detected and ignored
+  QDataStream record_stream(&records, QIODevice::WriteOnly | QIODevice::Append);
+  record_stream.setVersion(kBinaryStreamVersion);
+  record_stream << quint32(payload.size()) << qChecksum(payload.constData(), uint(payload.size()));
+  record_stream.writeRawData(payload.constData(), payload.size());
+}
+
+static qint64 get_project_size(const SerializedProject& project) {
+  qint64 size = project.header.size() + project.folders.size() + project.media.size();
+  for (int i=0;i<project.sequences.size();i++) {
+    size += project.sequences.at(i).size();
+  }
+  return size;
+}
+
+static bool write_project_file(const SerializedProject& project, const QString& filename) {
+  // QSaveFile writes to a temporary file and only replaces the destination once everything was written successfully
+  QSaveFile file(filename);
+  if (!file.open(QIODevice::WriteOnly)) {
+    qCritical() << "Could not open file" << filename;
+    return false;
+  }
+
+  file.write("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n<project>\n");
+  file.write(project.header);
+  file.write("\n<folders>\n");
+  file.write(project.folders);
+  file.write("\n</folders>\n<media>\n");
+  file.write(project.media);
+  file.write("\n</media>\n<sequences>\n");
+  for (int i=0;i<project.sequences.size();i++) {
+    file.write(project.sequences.at(i));
+  }
+  file.write("\n</sequences>\n</project>\n");
+
+  if (!file.commit()) {
+    qCritical() << "Could not write file" << filename << "-" << file.errorString();
+    return false;
+  }
+
+  return true;
+}
+
+ProjectSaver::ProjectSaver() :
+  busy(false),
+  cancelled(false),
+  journal_size(0)
+{}
+
+void ProjectSaver::run() {
+  mutex.lock();
+
+  while (true) {
+    if (snapshot_queue.isEmpty()) {
+      if (cancelled) {
+        break;
+      }
+
+      // let flush() know everything has been written
+      idleCond.wakeAll();
+
+      waitCond.wait(&mutex);
+      continue;
+    }
+
+    ProjectSnapshot snapshot = snapshot_queue.takeFirst();
+    busy = true;
+
+    mutex.unlock();
+
+    SerializedProject project = olive::serialize_project(snapshot);
+
+    if (snapshot.autorecovery) {
+      write_journal(project, snapshot.filename);
+    } else if (!write_project(project, snapshot.filename)) {
+      // the main thread marked the project as saved when it took the snapshot, so we revert that here
+      QMetaObject::invokeMethod(olive::MainWindow, "setWindowModified", Qt::QueuedConnection, Q_ARG(bool, true));
+    }
+
+    mutex.lock();
+
+    busy = false;
+  }
+
+  idleCond.wakeAll();
+
+  mutex.unlock();
+}
+
+void ProjectSaver::queue(const ProjectSnapshot &snapshot) {
+  mutex.lock();
+
+  // remove any older snapshot still waiting to be written to the same file
+  for (int i=snapshot_queue.size()-1;i>=0;i--) {
+    if (snapshot_queue.at(i).autorecovery == snapshot.autorecovery
+        && snapshot_queue.at(i).filename == snapshot.filename) {
+      snapshot_queue.removeAt(i);
+    }
+  }
+
+  snapshot_queue.append(snapshot);
+
+  waitCond.wakeAll();
+  mutex.unlock();
+}
+
+void ProjectSaver::flush() {
+  mutex.lock();
+  while (isRunning() && (busy || !snapshot_queue.isEmpty())) {
+    idleCond.wait(&mutex);
+  }
+  mutex.unlock();
+}
+
+void ProjectSaver::cancel() {
+  mutex.lock();
+  cancelled = true;
+  waitCond.wakeAll();
+  mutex.unlock();
+
+  wait();
+}
+
+bool ProjectSaver::write_project(const SerializedProject &project, const QString &filename) {
+  if (project.binary) {
+    return olive::write_binary_project_file(project, filename);
+  }
+  return write_project_file(project, filename);
+}
+
+bool ProjectSaver::write_journal(const SerializedProject &project, const QString &filename) {
+  qint64 project_size = get_project_size(project);
+
+  // start a new journal if this is the first snapshot written to it this session, or if it's grown so much that
+  // replaying it would take significantly longer than loading the project itself
+  bool rewrite = (journal_filename != filename
+                  || journal_size > project_size * kJournalCompactRatio);
+
+  // collect records for every fragment that changed since the last snapshot in the journal
+  QByteArray records;
+
+  if (rewrite || project.header != journal_project.header) {
+    append_journal_record(records, kJournalHeader, 0, project.header);
+  }
+
+  if (rewrite || project.folders != journal_project.folders) {
+    append_journal_record(records, kJournalFolders, 0, project.folders);
+  }
+
+  if (rewrite || project.media != journal_project.media) {
+    append_journal_record(records, kJournalMedia, 0, project.media);
+  }
+
+  for (int i=0;i<project.sequences.size();i++) {
+    if (rewrite
+        || i >= journal_project.sequences.size()
+        || project.sequences.at(i) != journal_project.sequences.at(i)) {
+      append_journal_record(records, kJournalSequence, i, project.sequences.at(i));
+    }
+  }
+
+  if (rewrite || project.sequences.size() != journal_project.sequences.size()) {
+    append_journal_record(records, kJournalSequenceCount, project.sequences.size(), QByteArray());
+  }
+
+  if (records.isEmpty()) {
+    // nothing changed since the last snapshot
+    return true;
+  }
+
+  append_journal_record(records, kJournalCommit, 0, QByteArray());
+
+  if (rewrite) {
+    QSaveFile file(filename);
+    if (!file.open(QIODevice::WriteOnly)) {
+      qCritical() << "Could not open autorecovery journal" << filename;
+      return false;
+    }
+
+    QDataStream stream(&file);
+    stream.setVersion(kBinaryStreamVersion);
+    stream << kJournalMagic << qint32(olive::kSaveVersion);
+    stream.writeRawData(records.constData(), records.size());
+
+    if (!file.commit()) {
+      qCritical() << "Could not write autorecovery journal" << filename << "-" << file.errorString();
+      return false;
+    }
+
+    journal_size = kJournalFileHeaderSize + records.size();
+    journal_filename = filename;
+  } else {
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append)) {
+      qCritical() << "Could not open autorecovery journal" << filename;
+      return false;
+    }
+
+    qint64 written = file.write(records);
+    file.close();
+
+    if (written != records.size()) {
+      qCritical() << "Could not write autorecovery journal" << filename;
+
+      // the journal may end with a partial record now, start a new one next time
+      journal_filename.clear();
+      return false;
+    }
+
+    journal_size += written;
+  }
+
+  journal_project = project;
+
+  qInfo() << "Wrote" << records.size() << "bytes to autorecovery journal";
+
+  return true;
+}
+
+bool olive::rebuild_autorecovery_journal(const QString &journal_filename, const QString &project_filename) {
+  QFile file(journal_filename);
+  if (!file.open(QIODevice::ReadOnly)) {
+    qCritical() << "Could not open autorecovery journal" << journal_filename;
+    return false;
+  }
+
+  QByteArray journal = file.readAll();
+  file.close();
+
+  QDataStream stream(journal);
+  stream.setVersion(kBinaryStreamVersion);
+
+  quint32 magic;
+  qint32 version;
+  stream >> magic >> version;
+  if (stream.status() != QDataStream::Ok || magic != kJournalMagic) {
+    qCritical() << "Invalid autorecovery journal" << journal_filename;
+    return false;
+  }
+
+  // last complete snapshot, and the one currently being replayed
+  SerializedProject committed;
+  SerializedProject pending;
+  bool found_commit = false;
+
+  while (stream.device()->bytesAvailable() >= kJournalRecordHeaderSize) {
+    quint32 payload_size;
+    quint16 checksum;
+    stream >> payload_size >> checksum;
+
+    if (stream.device()->bytesAvailable() < payload_size) {
+      // record was torn by a crash while it was being written
+      break;
+    }
+
+    QByteArray payload(int(payload_size), Qt::Uninitialized);
+    stream.readRawData(payload.data(), payload.size());
+
+    if (qChecksum(payload.constData(), uint(payload.size())) != checksum) {
+      qWarning() << "Autorecovery journal has a corrupt record, ignoring the rest of it";
+      break;
+    }
+
+    QDataStream payload_stream(payload);
+    payload_stream.setVersion(kBinaryStreamVersion);
+    quint8 type;
+    qint32 index;
+    QByteArray data;
+    payload_stream >> type >> index >> data;
+
+    switch (type) {
+    case kJournalHeader:
+      pending.header = data;
+      break;
+    case kJournalFolders:
+      pending.folders = data;
+      break;
+    case kJournalMedia:
+      pending.media = data;
+      break;
+    case kJournalSequence:
+      if (index >= pending.sequences.size()) {
+        pending.sequences.resize(index + 1);
+      }
+      pending.sequences[index] = data;
+      break;
+    case kJournalSequenceCount:
+      pending.sequences.resize(index);
+      break;
+    case kJournalCommit:
+      committed = pending;
+      found_commit = true;
+      break;
+    }
+  }
+
+  if (!found_commit) {
+    qCritical() << "Autorecovery journal" << journal_filename << "doesn't contain a complete project";
+    return false;
+  }
+
+  return write_project_file(committed, project_filename);
+}
@@ -0,0 +1,107 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef PROJECTSAVER_H
+#define PROJECTSAVER_H
+
+#include <QThread>
+#include <QVector>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QByteArray>
+#include <QString>
+
+#include "io/projectsnapshot.h"
+
+/**
+ * @brief The ProjectSaver class
+ *
+ * Background thread that turns ProjectSnapshot objects into project data and writes them to disk, so that saving never
+ * blocks the main thread on serialization or file I/O.
+ *
+ * Project files (XML or binary) are written to a temporary file that atomically replaces the old one once it's
+ * complete (see QSaveFile), so a crash or full disk mid-save never leaves a truncated project behind.
+ *
+ * Autorecovery snapshots are written to an append-only journal instead. Only the fragments that changed since the
+ * previous autorecovery snapshot are appended, so autosaving a large project where one sequence was edited only
+ * writes that one sequence. The journal is rewritten from scratch once it grows too large compared to the project
+ * itself. Use olive::rebuild_autorecovery_journal() to turn it back into a regular project file.
+ */
+class ProjectSaver : public QThread {
+  Q_OBJECT
+public:
+  ProjectSaver();
+  void run();
+
+  /**
+   * @brief Queue a snapshot to be written in the background
+   *
+   * Any snapshot still waiting to be written to the same destination is replaced, since only the latest state matters.
+   */
+  void queue(const ProjectSnapshot& snapshot);
+
+  /**
+   * @brief Block until every queued snapshot has been written
+   */
+  void flush();
+
+  /**
+   * @brief Write any queued snapshots and permanently stop the thread
+   */
+  void cancel();
+
+private:
+  bool write_project(const SerializedProject& project, const QString& filename);
+  bool write_journal(const SerializedProject& project, const QString& filename);
+
+  // queue of snapshots waiting to be written
+  QVector<ProjectSnapshot> snapshot_queue;
+
+  // threading objects
+  QWaitCondition waitCond;
+  QWaitCondition idleCond;
+  QMutex mutex;
+
+  // set to true if a snapshot is being written right now
+  bool busy;
+
+  // set to true if you want to permanently close ProjectSaver
+  bool cancelled;
+
+  // autorecovery journal state, only accessed from the saver thread. journal_project is the state the journal
+  // currently replays to, which new snapshots are compared against.
+  QString journal_filename;
+  qint64 journal_size;
+  SerializedProject journal_project;
+};
+
+namespace olive {
+  // project saver is a global omnipotent entity
+  extern ProjectSaver project_saver;
+
+  /**
+   * @brief Replay an autorecovery journal into a regular project file
+   *
+   * @return **TRUE** if the journal contained at least one complete snapshot and the project file was written
+   */
+  bool rebuild_autorecovery_journal(const QString& journal_filename, const QString& project_filename);
+}
+
+#endif // PROJECTSAVER_H
@@ -0,0 +1,663 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "projectsnapshot.h"
+
+#include <QDir>
+#include <QFileInfo>
+
+#include "project/media.h"
+#include "project/footage.h"
+#include "project/sequence.h"
+#include "project/clip.h"
+#include "project/effect.h"
+#include "project/transition.h"
+#include "io/binaryproject.h"
+#include "io/config.h"
+
+EffectSnapshot::EffectSnapshot() :
+  type(kEffectSnapshotRows),
+  enabled(true),
+  length(-1)
+{}
+
+TransitionSnapshot::TransitionSnapshot() :
+  present(false),
+  shared(-1)
+{}
+
+SerializedProject::SerializedProject() :
+  binary(false)
+{}
+
+FolderSnapshot olive::snapshot_folder(Media *m) {
+  FolderSnapshot f;
+  f.name = m->get_name();
+  f.id = m->temp_id;
+  f.parent = m->parentItem()->temp_id;
+  return f;
+}
+
+static void snapshot_streams(const QVector<FootageStream>& streams, QVector<StreamSnapshot>& snapshots) {
+  snapshots.resize(streams.size());
+  for (int i=0;i<streams.size();i++) {
+    const FootageStream& ms = streams.at(i);
+    StreamSnapshot& ss = snapshots[i];
+    ss.file_index = ms.file_index;
+    ss.video_width = ms.video_width;
+    ss.video_height = ms.video_height;
+    ss.video_frame_rate = ms.video_frame_rate;
+    ss.infinite_length = ms.infinite_length;
+    ss.audio_channels = ms.audio_channels;
+    ss.audio_layout = ms.audio_layout;
+    ss.audio_frequency = ms.audio_frequency;
+  }
+}
+
+FootageSnapshot olive::snapshot_footage(Media *m) {
+  FootagePtr f = m->to_footage();
+
+  FootageSnapshot fs;
+  fs.id = f->save_id;
+  fs.folder = m->parentItem()->temp_id;
+  fs.name = f->name;
+  fs.url = f->url;
+  fs.length = f->length;
+  fs.using_inout = f->using_inout;
+  fs.in = f->in;
+  fs.out = f->out;
+  fs.speed = f->speed;
+  fs.alpha_is_premultiplied = f->alpha_is_premultiplied;
+  fs.start_number = f->start_number;
+  fs.proxy = f->proxy;
+  fs.proxy_path = f->proxy_path;
+  snapshot_streams(f->video_tracks, fs.video_tracks);
+  snapshot_streams(f->audio_tracks, fs.audio_tracks);
+  fs.markers = f->markers;
+  return fs;
+}
+
+SequenceSnapshot olive::snapshot_sequence(Media *m) {
+  SequencePtr s = m->to_sequence();
+
+  SequenceSnapshot ss;
+  ss.id = s->save_id;
+  ss.folder = m->parentItem()->temp_id;
+  ss.name = s->name;
+  ss.width = s->width;
+  ss.height = s->height;
+  ss.frame_rate = s->frame_rate;
+  ss.audio_frequency = s->audio_frequency;
+  ss.audio_layout = s->audio_layout;
+  ss.half_float = s->half_float;
+  ss.open = (s == olive::ActiveSequence);
+  ss.using_workarea = s->using_workarea;
+  ss.workarea_in = s->workarea_in;
+  ss.workarea_out = s->workarea_out;
+  ss.end_frame = s->getEndFrame();
+  ss.markers = s->markers;
+
+  // unloaded sequences are saved from the data they were loaded from rather than being loaded just to save them
+  if (s->is_deferred()) {
+    ss.deferred = s->deferred_loader->snapshot();
+    return ss;
+  }
+
+  // shared transitions are only saved with the first clip using them
+  QVector<Transition*> transition_save_cache;
+  QVector<int> transition_clip_save_cache;
+
+  for (int j=0;j<s->clips.size();j++) {
+    const ClipPtr& c = s->clips.at(j);
+    if (c == nullptr) {
+      continue;
+    }
+
+    ClipSnapshot cs;
+    cs.index = j;
+    cs.enabled = c->enabled();
+    cs.name = c->name();
+    cs.clip_in = c->clip_in();
+    cs.timeline_in = c->timeline_in();
+    cs.timeline_out = c->timeline_out();
+    cs.track = c->track();
+    cs.color = c->color();
+    cs.autoscaled = c->autoscaled();
+    cs.speed = c->speed().value;
+    cs.maintain_audio_pitch = c->speed().maintain_audio_pitch;
+    cs.reversed = c->reversed();
+
+    cs.media_type = -1;
+    cs.media_id = 0;
+    cs.media_stream = 0;
+    if (c->media() != nullptr) {
+      cs.media_type = c->media()->get_type();
+      switch (cs.media_type) {
+      case MEDIA_TYPE_FOOTAGE:
+        cs.media_id = c->media()->to_footage()->save_id;
+        cs.media_stream = c->media_stream_index();
+        break;
+      case MEDIA_TYPE_SEQUENCE:
+        cs.media_id = c->media()->to_sequence()->save_id;
+        break;
+      }
+    } else {
+      cs.markers = c->get_markers();
+    }
+
+    cs.linked = c->linked;
+
+    for (int t=kTransitionOpening;t<=kTransitionClosing;t++) {
+      Transition* transition = (t == kTransitionOpening) ? c->opening_transition.get() : c->closing_transition.get();
+      TransitionSnapshot& ts = cs.transitions[t - kTransitionOpening];
+
+      if (transition != nullptr) {
+        ts.present = true;
+
+        int transition_cache_index = transition_save_cache.indexOf(transition);
+        if (transition_cache_index > -1) {
+          ts.shared = transition_clip_save_cache.at(transition_cache_index);
+        } else {
+          ts.effect = transition->snapshot();
+          transition_save_cache.append(transition);
+          transition_clip_save_cache.append(j);
+        }
+      }
+    }
+
+    cs.effects.resize(c->effects.size());
+    for (int k=0;k<c->effects.size();k++) {
+      cs.effects[k] = c->effects.at(k)->snapshot();
+    }
+
+    ss.clips.append(cs);
+  }
+
+  return ss;
+}
+
+static QString save_data_to_string(int type, const QVariant& data) {
+  switch (type) {
+  case EFFECT_FIELD_DOUBLE: return QString::number(data.toDouble());
+  case EFFECT_FIELD_COLOR: return data.value<QColor>().name();
+  case EFFECT_FIELD_BOOL: return QString::number(data.toBool());
+  case EFFECT_FIELD_COMBO: return QString::number(data.toInt());
+  case EFFECT_FIELD_STRING:
+  case EFFECT_FIELD_FONT:
+  case EFFECT_FIELD_FILE:
+    return data.toString();
+  }
+  return QString();
+}
+
+static void save_data_to_stream(int type, const QVariant& data, BinaryWriter& stream) {
+  switch (type) {
+  case EFFECT_FIELD_DOUBLE:
+    stream << data.toDouble();
+    break;
+  case EFFECT_FIELD_COLOR:
+    stream << quint32(data.value<QColor>().rgba());
+    break;
+  case EFFECT_FIELD_BOOL:
+    stream << data.toBool();
+    break;
+  case EFFECT_FIELD_COMBO:
+    stream << qint32(data.toInt());
+    break;
+  case EFFECT_FIELD_STRING:
+  case EFFECT_FIELD_FONT:
+  case EFFECT_FIELD_FILE:
+    stream.write_string(data.toString());
+    break;
+  }
+}
+
+void olive::write_effect(QXmlStreamWriter &stream, const EffectSnapshot &effect) {
+  if (effect.type == kEffectSnapshotOpaque) {
+    if (!effect.name.isEmpty()) {
+      stream.writeAttribute("name", effect.name);
+      stream.writeAttribute("enabled", QString::number(effect.enabled));
+
+      // force xml writer to expand <effect> tag, ignored when loading
+      stream.writeStartElement("void");
+      stream.writeEndElement();
+
+      if (!effect.data.isEmpty()) {
+        // write stored data
+        stream.device()->write(effect.data);
+      }
+    }
+    return;
+  }
+
+  if (effect.length > -1) {
+    stream.writeAttribute("length", QString::number(effect.length));
+  }
+  stream.writeAttribute("name", effect.name);
+  stream.writeAttribute("enabled", QString::number(effect.enabled));
+
+  for (int i=0;i<effect.rows.size();i++) {
+    const QVector<FieldSnapshot>& row = effect.rows.at(i);
+    stream.writeStartElement("row"); // row
+    for (int j=0;j<row.size();j++) {
+      const FieldSnapshot& field = row.at(j);
+      stream.writeStartElement("field"); // field
+      stream.writeAttribute("id", field.id);
+      stream.writeAttribute("value", save_data_to_string(field.type, field.value));
+      for (int k=0;k<field.keyframes.size();k++) {
+        const EffectKeyframe& key = field.keyframes.at(k);
+        stream.writeStartElement("key");
+        stream.writeAttribute("value", save_data_to_string(field.type, key.data));
+        stream.writeAttribute("frame", QString::number(key.time));
+        stream.writeAttribute("type", QString::number(key.type));
+        stream.writeAttribute("prehx", QString::number(key.pre_handle_x));
+        stream.writeAttribute("prehy", QString::number(key.pre_handle_y));
+        stream.writeAttribute("posthx", QString::number(key.post_handle_x));
+        stream.writeAttribute("posthy", QString::number(key.post_handle_y));
+        stream.writeEndElement(); // key
+      }
+      stream.writeEndElement(); // field
+    }
+    stream.writeEndElement(); // row
+  }
+
+  if (effect.type == kEffectSnapshotPlugin && !effect.data.isEmpty()) {
+    stream.writeTextElement("plugindata", effect.data.toBase64());
+  }
+}
+
+void olive::write_effect(BinaryWriter &stream, const EffectSnapshot &effect) {
+  stream.write_string(effect.name);
+  stream << effect.enabled;
+
+  if (effect.type == kEffectSnapshotOpaque) {
+    stream << effect.data;
+    return;
+  }
+
+  stream << quint32(effect.rows.size());
+  for (int i=0;i<effect.rows.size();i++) {
+    const QVector<FieldSnapshot>& row = effect.rows.at(i);
+    stream << quint32(row.size());
+    for (int j=0;j<row.size();j++) {
+      const FieldSnapshot& field = row.at(j);
+
+      // the type is stored so the value can be skipped if the field no longer matches
+      stream.write_string(field.id);
+      stream << qint32(field.type);
+      save_data_to_stream(field.type, field.value, stream);
+
+      stream << quint32(field.keyframes.size());
+      for (int k=0;k<field.keyframes.size();k++) {
+        const EffectKeyframe& key = field.keyframes.at(k);
+        save_data_to_stream(field.type, key.data, stream);
+        stream << qint64(key.time)
+               << qint32(key.type)
+               << key.pre_handle_x
+               << key.pre_handle_y
+               << key.post_handle_x
+               << key.post_handle_y;
+      }
+    }
+  }
+
+  if (effect.type == kEffectSnapshotPlugin) {
+    stream << effect.data;
+  }
+}
+
+static void write_marker(QXmlStreamWriter& stream, const Marker& m) {
+  stream.writeStartElement("marker");
+  stream.writeAttribute("frame", QString::number(m.frame));
+  stream.writeAttribute("name", m.name);
+  stream.writeEndElement();
+}
+
+static void write_folder(QXmlStreamWriter& stream, const FolderSnapshot& f) {
+  stream.writeStartElement("folder");
+  stream.writeAttribute("name", f.name);
+  stream.writeAttribute("id", QString::number(f.id));
+  stream.writeAttribute("parent", QString::number(f.parent));
+  stream.writeEndElement();
+}
+
+static void write_footage(QXmlStreamWriter& stream, const FootageSnapshot& f, const QDir& proj_dir) {
+  stream.writeStartElement("footage");
+  stream.writeAttribute("id", QString::number(f.id));
+  stream.writeAttribute("folder", QString::number(f.folder));
+  stream.writeAttribute("name", f.name);
+  stream.writeAttribute("url", proj_dir.relativeFilePath(f.url));
+  stream.writeAttribute("duration", QString::number(f.length));
+  stream.writeAttribute("using_inout", QString::number(f.using_inout));
+  stream.writeAttribute("in", QString::number(f.in));
+  stream.writeAttribute("out", QString::number(f.out));
+  stream.writeAttribute("speed", QString::number(f.speed));
+  stream.writeAttribute("alphapremul", QString::number(f.alpha_is_premultiplied));
+  stream.writeAttribute("startnumber", QString::number(f.start_number));
+
+  stream.writeAttribute("proxy", QString::number(f.proxy));
+  stream.writeAttribute("proxypath", f.proxy_path);
+
+  // save video stream metadata
+  for (int j=0;j<f.video_tracks.size();j++) {
+    const StreamSnapshot& ms = f.video_tracks.at(j);
+    stream.writeStartElement("video");
+    stream.writeAttribute("id", QString::number(ms.file_index));
+    stream.writeAttribute("width", QString::number(ms.video_width));
+    stream.writeAttribute("height", QString::number(ms.video_height));
+    stream.writeAttribute("framerate", QString::number(ms.video_frame_rate, 'f', 10));
+    stream.writeAttribute("infinite", QString::number(ms.infinite_length));
+    stream.writeEndElement(); // video
+  }
+
+  // save audio stream metadata
+  for (int j=0;j<f.audio_tracks.size();j++) {
+    const StreamSnapshot& ms = f.audio_tracks.at(j);
+    stream.writeStartElement("audio");
+    stream.writeAttribute("id", QString::number(ms.file_index));
+    stream.writeAttribute("channels", QString::number(ms.audio_channels));
+    stream.writeAttribute("layout", QString::number(ms.audio_layout));
+    stream.writeAttribute("frequency", QString::number(ms.audio_frequency));
+    stream.writeEndElement(); // audio
+  }
+
+  // save footage markers
+  for (int j=0;j<f.markers.size();j++) {
+    write_marker(stream, f.markers.at(j));
+  }
+
+  stream.writeEndElement(); // footage
+}
+
+static QVector<ClipSnapshot> get_clips(const SequenceSnapshot& s) {
+  if (s.deferred != nullptr) {
+    return s.deferred->decode();
+  }
+  return s.clips;
+}
+
+static void write_sequence(QXmlStreamWriter& stream, const SequenceSnapshot& s) {
+  stream.writeStartElement("sequence");
+  stream.writeAttribute("id", QString::number(s.id));
+  stream.writeAttribute("folder", QString::number(s.folder));
+  stream.writeAttribute("name", s.name);
+  stream.writeAttribute("width", QString::number(s.width));
+  stream.writeAttribute("height", QString::number(s.height));
+  stream.writeAttribute("framerate", QString::number(s.frame_rate, 'f', 10));
+  stream.writeAttribute("afreq", QString::number(s.audio_frequency));
+  stream.writeAttribute("alayout", QString::number(s.audio_layout));
+  stream.writeAttribute("halffloat", QString::number(s.half_float));
+  if (s.open) {
+    stream.writeAttribute("open", "1");
+  }
+  stream.writeAttribute("workarea", QString::number(s.using_workarea));
+  stream.writeAttribute("workareaIn", QString::number(s.workarea_in));
+  stream.writeAttribute("workareaOut", QString::number(s.workarea_out));
+
+  QVector<ClipSnapshot> clips = get_clips(s);
+
+  for (int j=0;j<clips.size();j++) {
+    const ClipSnapshot& c = clips.at(j);
+
+    stream.writeStartElement("clip"); // clip
+    stream.writeAttribute("id", QString::number(c.index));
+    stream.writeAttribute("enabled", QString::number(c.enabled));
+    stream.writeAttribute("name", c.name);
+    stream.writeAttribute("clipin", QString::number(c.clip_in));
+    stream.writeAttribute("in", QString::number(c.timeline_in));
+    stream.writeAttribute("out", QString::number(c.timeline_out));
+    stream.writeAttribute("track", QString::number(c.track));
+
+    stream.writeAttribute("r", QString::number(c.color.red()));
+    stream.writeAttribute("g", QString::number(c.color.green()));
+    stream.writeAttribute("b", QString::number(c.color.blue()));
+
+    stream.writeAttribute("autoscale", QString::number(c.autoscaled));
+    stream.writeAttribute("speed", QString::number(c.speed, 'f', 10));
+    stream.writeAttribute("maintainpitch", QString::number(c.maintain_audio_pitch));
+    stream.writeAttribute("reverse", QString::number(c.reversed));
+
+    if (c.media_type > -1) {
+      stream.writeAttribute("type", QString::number(c.media_type));
+      switch (c.media_type) {
+      case MEDIA_TYPE_FOOTAGE:
+        stream.writeAttribute("media", QString::number(c.media_id));
+        stream.writeAttribute("stream", QString::number(c.media_stream));
+        break;
+      case MEDIA_TYPE_SEQUENCE:
+        stream.writeAttribute("sequence", QString::number(c.media_id));
+        break;
+      }
+    }
+
+    // save markers
+    for (int k=0;k<c.markers.size();k++) {
+      write_marker(stream, c.markers.at(k));
+    }
+
+    // save clip links
+    stream.writeStartElement("linked"); // linked
+    for (int k=0;k<c.linked.size();k++) {
+      stream.writeStartElement("link"); // link
+      stream.writeAttribute("id", QString::number(c.linked.at(k)));
+      stream.writeEndElement(); // link
+    }
+    stream.writeEndElement(); // linked
+
+    // save opening and closing transitions
+    for (int t=kTransitionOpening;t<=kTransitionClosing;t++) {
+      const TransitionSnapshot& transition = c.transitions[t - kTransitionOpening];
+
+      if (transition.present) {
+        stream.writeStartElement((t == kTransitionOpening) ? "opening" : "closing");
+
+        if (transition.shared > -1) {
+          // shared transitions are saved as a reference to the other clip
+          stream.writeAttribute("shared", QString::number(transition.shared));
+        } else {
+          olive::write_effect(stream, transition.effect);
+        }
+
+        stream.writeEndElement(); // opening
+      }
+    }
+
+    for (int k=0;k<c.effects.size();k++) {
+      stream.writeStartElement("effect"); // effect
+      olive::write_effect(stream, c.effects.at(k));
+      stream.writeEndElement(); // effect
+    }
+
+    stream.writeEndElement(); // clip
+  }
+  for (int j=0;j<s.markers.size();j++) {
+    write_marker(stream, s.markers.at(j));
+  }
+  stream.writeEndElement();
+}
+
+static void write_markers(BinaryWriter& stream, const QVector<Marker>& markers) {
+  stream << quint32(markers.size());
+  for (int i=0;i<markers.size();i++) {
+    stream << qint64(markers.at(i).frame);
+    stream.write_string(markers.at(i).name);
+  }
+}
+
+static void write_folder(BinaryWriter& stream, const FolderSnapshot& f) {
+  stream.write_string(f.name);
+  stream << qint32(f.id) << qint32(f.parent);
+}
+
+static void write_footage(BinaryWriter& stream, const FootageSnapshot& f, const QDir& proj_dir) {
+  stream << qint32(f.id) << qint32(f.folder);
+  stream.write_string(f.name);
+  stream.write_string(proj_dir.relativeFilePath(f.url));
+  stream << qint64(f.length)
+         << f.using_inout
+         << qint64(f.in)
+         << qint64(f.out)
+         << f.speed
+         << f.alpha_is_premultiplied
+         << qint32(f.start_number)
+         << f.proxy;
+  stream.write_string(f.proxy_path);
+
+  // stream metadata isn't saved, it's regenerated when the footage is analyzed on load
+  write_markers(stream, f.markers);
+}
+
+static void write_sequence_settings(BinaryWriter& stream, const SequenceSnapshot& s) {
+  // new settings go on the end so files with fewer of them still load
+  stream << s.half_float;
+}
+
+static void write_sequence(BinaryWriter& stream, const SequenceSnapshot& s) {
+  // sequence attributes (including the end frame, shown as the sequence's duration) come first so they can be read
+  // without parsing any clips
+  stream << qint32(s.id) << qint32(s.folder);
+  stream.write_string(s.name);
+  stream << qint32(s.width)
+         << qint32(s.height)
+         << s.frame_rate
+         << qint32(s.audio_frequency)
+         << qint32(s.audio_layout)
+         << s.open
+         << s.using_workarea
+         << qint64(s.workarea_in)
+         << qint64(s.workarea_out)
+         << qint64(s.end_frame);
+  write_markers(stream, s.markers);
+
+  QVector<ClipSnapshot> clips = get_clips(s);
+  stream << quint32(clips.size());
+
+  for (int j=0;j<clips.size();j++) {
+    const ClipSnapshot& c = clips.at(j);
+
+    stream << qint32(c.index) << c.enabled;
+    stream.write_string(c.name);
+    stream << qint64(c.clip_in)
+           << qint64(c.timeline_in)
+           << qint64(c.timeline_out)
+           << qint32(c.track)
+           << quint32(c.color.rgb())
+           << c.autoscaled
+           << c.speed
+           << c.maintain_audio_pitch
+           << c.reversed;
+
+    stream << qint32(c.media_type) << qint32(c.media_id) << qint32(c.media_stream);
+
+    write_markers(stream, c.markers);
+
+    stream << quint32(c.linked.size());
+    for (int k=0;k<c.linked.size();k++) {
+      stream << qint32(c.linked.at(k));
+    }
+
+    for (int t=kTransitionOpening;t<=kTransitionClosing;t++) {
+      const TransitionSnapshot& transition = c.transitions[t - kTransitionOpening];
+
+      stream << transition.present;
+
+      if (transition.present) {
+        if (transition.shared > -1) {
+          // shared transitions are saved as a reference to the other clip
+          stream << qint32(transition.shared);
+        } else {
+          stream << qint32(-1) << qint64(transition.effect.length);
+          olive::write_effect(stream, transition.effect);
+        }
+      }
+    }
+
+    stream << quint32(c.effects.size());
+    for (int k=0;k<c.effects.size();k++) {
+      olive::write_effect(stream, c.effects.at(k));
+    }
+  }
+}
+
+SerializedProject olive::serialize_project(const ProjectSnapshot &snapshot) {
+  QDir proj_dir = QFileInfo(snapshot.project_url).absoluteDir();
+
+  SerializedProject project;
+  project.binary = snapshot.binary;
+
+  if (snapshot.binary) {
+    BinaryStringTable strings;
+
+    BinaryWriter header_stream(&project.header, &strings);
+    header_stream.write_string(snapshot.project_url);
+
+    BinaryWriter folder_stream(&project.folders, &strings);
+    folder_stream << quint32(snapshot.folders.size());
+    for (int i=0;i<snapshot.folders.size();i++) {
+      write_folder(folder_stream, snapshot.folders.at(i));
+    }
+
+    BinaryWriter media_stream(&project.media, &strings);
+    media_stream << quint32(snapshot.footage.size());
+    for (int i=0;i<snapshot.footage.size();i++) {
+      write_footage(media_stream, snapshot.footage.at(i), proj_dir);
+    }
+
+    // every sequence gets its own section so it can be loaded on its own
+    project.sequences.resize(snapshot.sequences.size());
+    project.sequence_settings.resize(snapshot.sequences.size());
+    for (int i=0;i<snapshot.sequences.size();i++) {
+      BinaryWriter sequence_stream(&project.sequences[i], &strings);
+      write_sequence(sequence_stream, snapshot.sequences.at(i));
+      project.sequence_ids.append(snapshot.sequences.at(i).id);
+
+      BinaryWriter settings_stream(&project.sequence_settings[i], &strings);
+      write_sequence_settings(settings_stream, snapshot.sequences.at(i));
+    }
+
+    project.strings = strings.save();
+  } else {
+    QXmlStreamWriter header_stream(&project.header);
+    header_stream.setAutoFormatting(true);
+    header_stream.writeTextElement("version", QString::number(olive::kSaveVersion));
+    header_stream.writeTextElement("url", snapshot.project_url);
+
+    QXmlStreamWriter folder_stream(&project.folders);
+    folder_stream.setAutoFormatting(true);
+    for (int i=0;i<snapshot.folders.size();i++) {
+      write_folder(folder_stream, snapshot.folders.at(i));
+    }
+
+    QXmlStreamWriter media_stream(&project.media);
+    media_stream.setAutoFormatting(true);
+    for (int i=0;i<snapshot.footage.size();i++) {
+      write_footage(media_stream, snapshot.footage.at(i), proj_dir);
+    }
+
+    // sequences are stored separately so autorecovery can tell which ones changed
+    project.sequences.resize(snapshot.sequences.size());
+    for (int i=0;i<snapshot.sequences.size();i++) {
+      QXmlStreamWriter sequence_stream(&project.sequences[i]);
+      sequence_stream.setAutoFormatting(true);
+      write_sequence(sequence_stream, snapshot.sequences.at(i));
+    }
+  }
+
+  return project;
+}
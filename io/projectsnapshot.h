@@ -0,0 +1,342 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef PROJECTSNAPSHOT_H
+#define PROJECTSNAPSHOT_H
+
+#include <memory>
+#include <QString>
+#include <QVector>
+#include <QVariant>
+#include <QColor>
+#include <QByteArray>
+#include <QXmlStreamWriter>
+
+#include "project/marker.h"
+#include "project/keyframe.h"
+
+class Media;
+class Effect;
+class BinaryWriter;
+
+/**
+ * Project snapshots
+ *
+ * Saving is split in two. On the main thread, Project::save_project() copies everything that gets saved out of the
+ * live project into the plain data structures below. This only copies values (strings, vectors and variants are
+ * implicitly shared, so most copies are just a reference count) and never formats anything. ProjectSaver then turns
+ * the snapshot into XML or binary project data in the background, where the project can keep changing underneath it.
+ */
+
+/**
+ * @brief Saved state of one effect field
+ */
+struct FieldSnapshot {
+  QString id;
+  int type;
+  QVariant value;
+  QVector<EffectKeyframe> keyframes;
+};
+
+enum EffectSnapshotType {
+  // regular effect, fully described by its rows
+  kEffectSnapshotRows,
+
+  // VST plugin, rows followed by the plugin's own state in `data`
+  kEffectSnapshotPlugin,
+
+  // effect that couldn't be found when the project was loaded (see VoidEffect), `data` is written back as it was read
+  kEffectSnapshotOpaque
+};
+
+/**
+ * @brief Saved state of one effect or transition, see Effect::snapshot()
+ */
+struct EffectSnapshot {
+  EffectSnapshot();
+
+  int type;
+  QString name;
+  bool enabled;
+
+  /**
+   * @brief Transitions only: length in frames, -1 for effects
+   */
+  long length;
+
+  /**
+   * @brief Fields of every savable row
+   */
+  QVector< QVector<FieldSnapshot> > rows;
+
+  QByteArray data;
+};
+
+/**
+ * @brief An opening or closing transition of a ClipSnapshot
+ */
+struct TransitionSnapshot {
+  TransitionSnapshot();
+
+  bool present;
+
+  /**
+   * @brief Index of the clip this transition was already saved with if it's shared, -1 if it's saved here
+   */
+  int shared;
+
+  EffectSnapshot effect;
+};
+
+struct ClipSnapshot {
+  int index;
+  bool enabled;
+  QString name;
+  long clip_in;
+  long timeline_in;
+  long timeline_out;
+  int track;
+  QColor color;
+  bool autoscaled;
+  double speed;
+  bool maintain_audio_pitch;
+  bool reversed;
+
+  /**
+   * @brief MEDIA_TYPE_* of the clip's media or -1 if it has none
+   */
+  int media_type;
+
+  /**
+   * @brief Save ID of the clip's footage or sequence
+   */
+  int media_id;
+
+  int media_stream;
+
+  /**
+   * @brief Only saved for clips without media, since media has its own markers
+   */
+  QVector<Marker> markers;
+
+  QVector<int> linked;
+
+  /**
+   * @brief Opening and closing transition, indexed by TransitionType minus kTransitionOpening
+   */
+  TransitionSnapshot transitions[2];
+
+  QVector<EffectSnapshot> effects;
+};
+
+/**
+ * @brief The DeferredClips class
+ *
+ * Clips of a sequence that hasn't been loaded yet (see Sequence::load_deferred()), kept in the form they were loaded
+ * from. They're only decoded into ClipSnapshot objects when the snapshot is serialized, so saving never has to build
+ * them. Implementations must be safe to decode from any thread.
+ */
+class DeferredClips {
+public:
+  virtual ~DeferredClips() {}
+  virtual QVector<ClipSnapshot> decode() const = 0;
+};
+
+struct SequenceSnapshot {
+  int id;
+  int folder;
+  QString name;
+  int width;
+  int height;
+  double frame_rate;
+  int audio_frequency;
+  int audio_layout;
+  bool half_float;
+  bool open;
+  bool using_workarea;
+  long workarea_in;
+  long workarea_out;
+  long end_frame;
+  QVector<Marker> markers;
+  QVector<ClipSnapshot> clips;
+
+  /**
+   * @brief Set instead of `clips` if the sequence hasn't been loaded yet
+   */
+  std::shared_ptr<DeferredClips> deferred;
+};
+
+/**
+ * @brief Stream metadata of a FootageSnapshot
+ *
+ * Separate from FootageStream, which also holds the stream's preview images that shouldn't leave the main thread.
+ */
+struct StreamSnapshot {
+  int file_index;
+  int video_width;
+  int video_height;
+  double video_frame_rate;
+  bool infinite_length;
+  int audio_channels;
+  int audio_layout;
+  int audio_frequency;
+};
+
+struct FootageSnapshot {
+  int id;
+  int folder;
+  QString name;
+  QString url;
+  qint64 length;
+  bool using_inout;
+  long in;
+  long out;
+  double speed;
+  bool alpha_is_premultiplied;
+  int start_number;
+  bool proxy;
+  QString proxy_path;
+  QVector<StreamSnapshot> video_tracks;
+  QVector<StreamSnapshot> audio_tracks;
+  QVector<Marker> markers;
+};
+
+struct FolderSnapshot {
+  QString name;
+  int id;
+  int parent;
+};
+
+/**
+ * @brief The ProjectSnapshot struct
+ *
+ * Everything Project::save_project() needs to save, taken on the main thread and handed to ProjectSaver.
+ */
+struct ProjectSnapshot {
+  /**
+   * @brief File to write to. For autorecovery snapshots, this is the autorecovery journal.
+   */
+  QString filename;
+
+  /**
+   * @brief **TRUE** if this snapshot should be appended to the autorecovery journal
+   */
+  bool autorecovery;
+
+  /**
+   * @brief **TRUE** if this snapshot should be saved in the binary project format (see binaryproject.h)
+   *
+   * Autorecovery snapshots are always XML.
+   */
+  bool binary;
+
+  /**
+   * @brief The project's own filename, saved in the project and used to make footage URLs relative
+   */
+  QString project_url;
+
+  QVector<FolderSnapshot> folders;
+  QVector<FootageSnapshot> footage;
+  QVector<SequenceSnapshot> sequences;
+};
+
+/**
+ * @brief The SerializedProject struct
+ *
+ * A ProjectSnapshot turned into project file data by olive::serialize_project(). The project is split into
+ * independent fragments so ProjectSaver can assemble them into a project file and tell which parts changed between
+ * autorecovery snapshots.
+ */
+struct SerializedProject {
+  SerializedProject();
+
+  /**
+   * @brief **TRUE** if the fragments below are binary project sections rather than XML
+   */
+  bool binary;
+
+  /**
+   * @brief `<version>` and `<url>` elements, or the header section of a binary project
+   */
+  QByteArray header;
+
+  /**
+   * @brief Contents of the `<folders>` element, or the folders section of a binary project
+   */
+  QByteArray folders;
+
+  /**
+   * @brief Contents of the `<media>` element, or the media section of a binary project
+   */
+  QByteArray media;
+
+  /**
+   * @brief One `<sequence>` element (or binary section) per sequence, in project order
+   */
+  QVector<QByteArray> sequences;
+
+  /**
+   * @brief Binary projects only: save ID of each sequence in `sequences`, used to index the sections
+   */
+  QVector<int> sequence_ids;
+
+  /**
+   * @brief Binary projects only: settings section of each sequence in `sequences` (see kBinarySectionSequenceSettings)
+   */
+  QVector<QByteArray> sequence_settings;
+
+  /**
+   * @brief Binary projects only: the string table shared by all sections
+   */
+  QByteArray strings;
+};
+
+namespace olive {
+  /**
+   * @brief Snapshot a folder, its temp_id and its parent's must already be assigned
+   */
+  FolderSnapshot snapshot_folder(Media* m);
+
+  /**
+   * @brief Snapshot footage, its save_id and its folder's temp_id must already be assigned
+   */
+  FootageSnapshot snapshot_footage(Media* m);
+
+  /**
+   * @brief Snapshot a sequence and its clips, save IDs of all media must already be assigned
+   */
+  SequenceSnapshot snapshot_sequence(Media* m);
+
+  /**
+   * @brief Turn a snapshot into project data, safe to call from any thread
+   */
+  SerializedProject serialize_project(const ProjectSnapshot& snapshot);
+
+  /**
+   * @brief Write the contents of an effect's XML element
+   */
+  void write_effect(QXmlStreamWriter& stream, const EffectSnapshot& effect);
+
+  /**
+   * @brief Write an effect in the binary project format
+   */
+  void write_effect(BinaryWriter& stream, const EffectSnapshot& effect);
+}
+
+#endif // PROJECTSNAPSHOT_H
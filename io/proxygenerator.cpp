@@ -20,11 +20,13 @@
 
 #include "proxygenerator.h"
 
+#include "io/config.h"
 #include "io/path.h"
 #include "io/previewgenerator.h"
 #include "mainwindow.h"
 
 #include <QDir>
+#include <QFile>
 #include <QFileInfo>
 #include <QtMath>
 #include <QStatusBar>
@@ -39,13 +41,65 @@ extern "C" {
 
 enum AVCodecID temp_enc_codec = AV_CODEC_ID_PRORES;
 
-ProxyGenerator::ProxyGenerator() : cancelled(false) {}
+// files shorter than this (in seconds) per segment aren't worth splitting
+const int64_t kMinimumSegmentLength = 30;
+
+// after every transcoded stream has passed the end of a segment, keep reading this long (in seconds) to pick up any
+// passthrough packets that were interleaved after them
+const int64_t kSegmentInterleaveMargin = 2;
+
+// converts a timestamp in `time_base` units to AV_TIME_BASE units, preserving AV_NOPTS_VALUE
+static int64_t timestamp_to_av_time(int64_t ts, AVRational time_base) {
+  if (ts == AV_NOPTS_VALUE) {
+    return AV_NOPTS_VALUE;
+  }
+  return av_rescale_q(ts, time_base, AV_TIME_BASE_Q);
+}
+
+// sends a frame (or nullptr to flush) to an encoder and writes every packet it returns to the output file
+static void encode_and_write_frame(AVFormatContext* output_fmt_ctx, AVCodecContext* enc_ctx, int stream_index, AVFrame* frame) {
+  avcodec_send_frame(enc_ctx, frame);
 
-void ProxyGenerator::transcode(const ProxyInfo& info) {
-  FootagePtr footage = info.media->to_footage();
+  AVPacket packet;
+  av_init_packet(&packet);
+  packet.data = nullptr;
+  packet.size = 0;
+
+  while (avcodec_receive_packet(enc_ctx, &packet) >= 0) {
+    // set packet stream index to current stream index
+    packet.stream_index = stream_index;
+
+    // encoder timestamps are in the encoder's time base, convert them to the output stream's
+    av_packet_rescale_ts(&packet, enc_ctx->time_base, output_fmt_ctx->streams[stream_index]->time_base);
+
+    // write frame to file
+    av_interleaved_write_frame(output_fmt_ctx, &packet);
+
+    // unref old packet
+    av_packet_unref(&packet);
+  }
+}
+
+ProxyTranscoder::ProxyTranscoder(const ProxyInfo &info,
+                                 const QString &output_path,
+                                 int64_t start,
+                                 int64_t end,
+                                 const std::atomic<bool> &skip) :
+  info_(info),
+  output_path_(output_path),
+  start_(start),
+  end_(end),
+  skip_(skip),
+  progress_(0.0),
+  succeeded_(false)
+{}
+
+void ProxyTranscoder::run() {
+  FootagePtr footage = info_.media->to_footage();
 
   // set progress to 0
-  current_progress = 0.0;
+  progress_ = 0.0;
+  succeeded_ = false;
 
   // for image sequences that don't start at 0, set the index where it does start
   AVDictionary* format_opts = nullptr;
@@ -55,14 +109,22 @@ void ProxyGenerator::transcode(const ProxyInfo& info) {
 
   // open input file
   AVFormatContext* input_fmt_ctx = nullptr;
-  avformat_open_input(&input_fmt_ctx, footage->url.toUtf8(), nullptr, &format_opts);
+  int open_ret = avformat_open_input(&input_fmt_ctx, footage->url.toUtf8(), nullptr, &format_opts);
+  av_dict_free(&format_opts);
+  if (open_ret < 0) {
+    qWarning() << "Proxy generation could not open" << footage->url;
+    return;
+  }
 
-  // open output file
+  // open output file - segments always use the final proxy's container so they can be joined by remuxing
   AVFormatContext* output_fmt_ctx = nullptr;
-  avformat_alloc_output_context2(&output_fmt_ctx, nullptr, nullptr, info.path.toUtf8());
+  avformat_alloc_output_context2(&output_fmt_ctx,
+                                 av_guess_format(nullptr, info_.path.toUtf8(), nullptr),
+                                 nullptr,
+                                 output_path_.toUtf8());
 
   // open output file writing handle
-  avio_open(&output_fmt_ctx->pb, info.path.toUtf8(), AVIO_FLAG_WRITE);
+  avio_open(&output_fmt_ctx->pb, output_path_.toUtf8(), AVIO_FLAG_WRITE);
 
   // get stream info from input file
   avformat_find_stream_info(input_fmt_ctx, nullptr);
@@ -82,6 +144,14 @@ void ProxyGenerator::transcode(const ProxyInfo& info) {
   sws_contexts.resize(input_fmt_ctx->nb_streams);
   sws_contexts.fill(nullptr);
 
+  // set for each transcoded stream once the decoder has passed the end of this segment
+  QVector<bool> stream_finished;
+  stream_finished.resize(input_fmt_ctx->nb_streams);
+  stream_finished.fill(false);
+
+  int transcoded_stream_count = 0;
+  int finished_stream_count = 0;
+
   // loop through file to find compatible video streams
   for (int i=0;i<int(input_fmt_ctx->nb_streams);i++) {
     AVStream* in_stream = input_fmt_ctx->streams[i];
@@ -120,8 +190,8 @@ void ProxyGenerator::transcode(const ProxyInfo& info) {
       // copy properties from decoding context to encoding context
       enc_ctx->codec_id = temp_enc_codec;
       enc_ctx->codec_type = AVMEDIA_TYPE_VIDEO;
-      enc_ctx->width = qFloor(dec_ctx->width*info.size_multiplier);
-      enc_ctx->height = qFloor(dec_ctx->height*info.size_multiplier);
+      enc_ctx->width = qFloor(dec_ctx->width*info_.size_multiplier);
+      enc_ctx->height = qFloor(dec_ctx->height*info_.size_multiplier);
       enc_ctx->sample_aspect_ratio = dec_ctx->sample_aspect_ratio;
       enc_ctx->pix_fmt = enc_codec->pix_fmts[0];
       enc_ctx->framerate = dec_ctx->framerate;
@@ -139,6 +209,7 @@ void ProxyGenerator::transcode(const ProxyInfo& info) {
 
       // open encoder
       avcodec_open2(enc_ctx, enc_codec, &opts);
+      av_dict_free(&opts);
 
       // copy parameters from encoding context to stream
       avcodec_parameters_from_context(out_stream->codecpar, enc_ctx);
@@ -161,133 +232,204 @@ void ProxyGenerator::transcode(const ProxyInfo& info) {
             );
 
       sws_contexts[i] = sws_ctx;
+
+      transcoded_stream_count++;
     } else {
       avcodec_parameters_copy(out_stream->codecpar, in_stream->codecpar);
     }
   }
 
+  // the range we cover, used for progress reporting if our start/end are unbounded
+  int64_t range_start = start_;
+  if (range_start == AV_NOPTS_VALUE) {
+    range_start = (input_fmt_ctx->start_time == AV_NOPTS_VALUE) ? 0 : input_fmt_ctx->start_time;
+  }
+  int64_t range_end = end_;
+  if (range_end == AV_NOPTS_VALUE) {
+    range_end = range_start + qMax(int64_t(1), input_fmt_ctx->duration);
+  }
+
+  // timestamps in the output are written relative to the start of this segment (ProxyJob adds it back when joining)
+  int64_t ts_offset = (start_ == AV_NOPTS_VALUE) ? 0 : start_;
+
+  // seek to the keyframe at or before the start of this segment
+  if (start_ != AV_NOPTS_VALUE) {
+    av_seek_frame(input_fmt_ctx, -1, start_, AVSEEK_FLAG_BACKWARD);
+  }
+
   // write video header
   avformat_write_header(output_fmt_ctx, nullptr);
 
   // packet that av_read_frame will dump file packets into
   AVPacket packet;
   av_init_packet(&packet);
+  packet.data = nullptr;
+  packet.size = 0;
 
   // frame that decoder will decode into
   AVFrame* dec_frame = av_frame_alloc();
 
+  bool reached_eof = false;
+  bool read_error = false;
+
   // main transcoding loop
-  while (!skip) {
+  while (!skip_) {
+
+    // read from input file
+    int read_ret = av_read_frame(input_fmt_ctx, &packet);
+
+    // handle errors
+    if (read_ret < 0) {
+
+      // AVERROR_EOF means we've simply reached the end of the file, otherwise this is an error
+      if (read_ret == AVERROR_EOF) {
+        reached_eof = true;
+      } else {
+        qWarning() << "Proxy generation for file" << footage->url << "ended prematurely";
+        read_error = true;
+      }
+
+      // either way, we shall abort reading
+      break;
+    }
 
-    // cache stream index
     int stream_index = packet.stream_index;
+    AVStream* in_stream = input_fmt_ctx->streams[stream_index];
 
-    // retrieve frame from decoder (this will clear the last frame so we don't have to do that)
-    int read_ret = -1;
-    int recfr_ret = -1;
-    do {
-      // read from input file
-      read_ret = av_read_frame(input_fmt_ctx, &packet);
+    int64_t packet_time = timestamp_to_av_time((packet.pts == AV_NOPTS_VALUE) ? packet.dts : packet.pts,
+                                               in_stream->time_base);
 
-      // handle errors
-      if (read_ret < 0) {
+    // once every transcoded stream has passed the end of this segment, we're done
+    if (end_ != AV_NOPTS_VALUE
+        && finished_stream_count == transcoded_stream_count
+        && packet_time != AV_NOPTS_VALUE
+        && packet_time >= end_ + kSegmentInterleaveMargin*AV_TIME_BASE) {
+      av_packet_unref(&packet);
+      break;
+    }
 
-        // AVERROR_EOF means we've simply reached the end of the file, otherwise this is an error
-        if (read_ret != AVERROR_EOF) {
-          qWarning() << "Proxy generation for file" << footage->url << "ended prematurely";
-        }
+    // determine whether this frame is from a stream we're transcoding
+    if (input_streams.at(stream_index) == nullptr) {
+      // if we didn't allocate a decoder for this earlier, we just pass it through (as long as it's in our range)
 
-        // either way, we shall abort reading
-        break;
+      bool in_range;
+      if (packet_time == AV_NOPTS_VALUE) {
+        // packets without timestamps can't be split, so they all go into the first segment
+        in_range = (start_ == AV_NOPTS_VALUE);
+      } else {
+        in_range = (start_ == AV_NOPTS_VALUE || packet_time >= start_)
+            && (end_ == AV_NOPTS_VALUE || packet_time < end_);
       }
 
-      stream_index = packet.stream_index;
-
-      // determine whether this frame is from a stream we're transcoding
-      if (input_streams.at(stream_index) == nullptr) {
-        // if we didn't allocate a decoder for this earlier, we just pass it through
+      if (in_range) {
+        int64_t stream_offset = av_rescale_q(ts_offset, AV_TIME_BASE_Q, in_stream->time_base);
+        if (packet.pts != AV_NOPTS_VALUE) packet.pts -= stream_offset;
+        if (packet.dts != AV_NOPTS_VALUE) packet.dts -= stream_offset;
 
-        av_packet_rescale_ts(&packet, input_fmt_ctx->streams[stream_index]->time_base, output_fmt_ctx->streams[stream_index]->time_base);
+        av_packet_rescale_ts(&packet, in_stream->time_base, output_fmt_ctx->streams[stream_index]->time_base);
 
         // write packet to output
         av_interleaved_write_frame(output_fmt_ctx, &packet);
+      }
 
-      } else {
-        // we're going to transcode this packet.
+    } else if (!stream_finished.at(stream_index)) {
+      // we're going to transcode this packet.
 
-        // send packet to decoder
-        avcodec_send_packet(input_streams.at(stream_index), &packet);
+      // send packet to decoder
+      avcodec_send_packet(input_streams.at(stream_index), &packet);
 
-        // use timestamp and stream duration to create a rough estimation of the progress through this file
-        current_progress = qCeil((double(packet.pts)/double(input_fmt_ctx->streams[packet.stream_index]->duration))*100);
+      // receive every frame the decoder can give us
+      while (avcodec_receive_frame(input_streams.at(stream_index), dec_frame) >= 0) {
 
-      }
+        int64_t frame_time = timestamp_to_av_time(dec_frame->best_effort_timestamp, in_stream->time_base);
 
-      // free packet allocated by av_read_frame
-      av_packet_unref(&packet);
-    } while ((recfr_ret = avcodec_receive_frame(input_streams.at(packet.stream_index), dec_frame)) == AVERROR(EAGAIN) && !skip);
+        if (frame_time != AV_NOPTS_VALUE) {
+          // the decoder outputs in presentation order, so once we've passed our end we're finished with this stream
+          if (end_ != AV_NOPTS_VALUE && frame_time >= end_) {
+            stream_finished[stream_index] = true;
+            finished_stream_count++;
+            break;
+          }
 
-    // error/eof handling - cancel while loop
-    if (read_ret < 0 || skip) {
-      break;
-    }
+          // frames before our start belong to the previous segment
+          if (start_ != AV_NOPTS_VALUE && frame_time < start_) {
+            continue;
+          }
 
-    // free packet as we're about to use it for encoding
-    av_packet_unref(&packet);
+          // use timestamp and range to create a rough estimation of the progress through this segment
+          progress_ = qMin(100.0, double(qCeil((double(frame_time - range_start)/double(range_end - range_start))*100)));
+        }
 
-    // rescale input frame timestamp to output timestamp
-    dec_frame->pts = av_rescale_q(dec_frame->pts,
-                                  input_fmt_ctx->streams[stream_index]->time_base,
-                                  output_fmt_ctx->streams[stream_index]->time_base);
+        AVCodecContext* enc_ctx = output_streams.at(stream_index);
 
-    // determine if the pix_fmt, width, and/or height is different, so if we need to convert
-    bool convert_pix_fmt = (output_streams.at(stream_index)->pix_fmt != input_streams.at(stream_index)->pix_fmt
-        || output_streams.at(stream_index)->width != input_streams.at(stream_index)->width
-        || output_streams.at(stream_index)->height != input_streams.at(stream_index)->height);
+        // determine if the pix_fmt, width, and/or height is different, so if we need to convert
+        bool convert_pix_fmt = (enc_ctx->pix_fmt != dec_frame->format
+            || enc_ctx->width != dec_frame->width
+            || enc_ctx->height != dec_frame->height);
 
-    // create reference to the frame to be sent to the encoder
-    AVFrame* enc_frame = dec_frame;
+        // create reference to the frame to be sent to the encoder
+        AVFrame* enc_frame = dec_frame;
 
-    if (convert_pix_fmt) {
-      // create sws frame for pixel format conversion
-      enc_frame = av_frame_alloc();
-      enc_frame->width = output_streams.at(stream_index)->width;
-      enc_frame->height = output_streams.at(stream_index)->height;
-      enc_frame->format = output_streams.at(stream_index)->pix_fmt;
-      av_frame_get_buffer(enc_frame, 0);
+        if (convert_pix_fmt) {
+          // create sws frame for pixel format conversion
+          enc_frame = av_frame_alloc();
+          enc_frame->width = enc_ctx->width;
+          enc_frame->height = enc_ctx->height;
+          enc_frame->format = enc_ctx->pix_fmt;
+          av_frame_get_buffer(enc_frame, 0);
 
-      // convert pixel format to format expected by the encoder
-      sws_scale(sws_contexts.at(stream_index), dec_frame->data, dec_frame->linesize, 0, dec_frame->height, enc_frame->data, enc_frame->linesize);
+          // convert pixel format to format expected by the encoder
+          sws_scale(sws_contexts.at(stream_index), dec_frame->data, dec_frame->linesize, 0, dec_frame->height, enc_frame->data, enc_frame->linesize);
+        }
 
-      // set same pts as dec_frame
-      enc_frame->pts = dec_frame->pts;
-    }
+        // encoder shares the input stream's time base, so we only need to make the timestamp segment-relative
+        enc_frame->pts = dec_frame->best_effort_timestamp - av_rescale_q(ts_offset, AV_TIME_BASE_Q, in_stream->time_base);
 
-    // send frame to encoder
-    avcodec_send_frame(output_streams.at(stream_index), enc_frame);
+        // send frame to encoder and write the resulting packets
+        encode_and_write_frame(output_fmt_ctx, enc_ctx, stream_index, enc_frame);
+
+        if (convert_pix_fmt) {
+          // free sws frame since we made one before
+          av_frame_free(&enc_frame);
+        }
+
+      }
 
-    if (convert_pix_fmt) {
-      // free sws frame since we made one before
-      av_frame_free(&enc_frame);
     }
 
-    // return value for packet receiving
-    int recret;
+    // free packet allocated by av_read_frame
+    av_packet_unref(&packet);
+  }
 
-    // loop through receiving packets
-    while ((recret = avcodec_receive_packet(output_streams.at(stream_index), &packet)) >= 0 && !skip) {
+  for (int i=0;i<int(input_fmt_ctx->nb_streams);i++) {
+    if (input_streams[i] != nullptr) {
 
-      // set packet stream index to current stream index
-      packet.stream_index = stream_index;
+      if (reached_eof && !skip_ && !stream_finished.at(i)) {
+        // drain any frames the decoder is still holding at the end of the file
+        avcodec_send_packet(input_streams[i], nullptr);
 
-      // write frame to file
-      av_interleaved_write_frame(output_fmt_ctx, &packet);
+        while (avcodec_receive_frame(input_streams[i], dec_frame) >= 0) {
+          AVFrame* enc_frame = av_frame_alloc();
+          enc_frame->width = output_streams[i]->width;
+          enc_frame->height = output_streams[i]->height;
+          enc_frame->format = output_streams[i]->pix_fmt;
+          av_frame_get_buffer(enc_frame, 0);
 
-      // unref old packet
-      av_packet_unref(&packet);
+          sws_scale(sws_contexts.at(i), dec_frame->data, dec_frame->linesize, 0, dec_frame->height, enc_frame->data, enc_frame->linesize);
 
-    }
+          enc_frame->pts = dec_frame->best_effort_timestamp
+              - av_rescale_q(ts_offset, AV_TIME_BASE_Q, input_fmt_ctx->streams[i]->time_base);
+
+          encode_and_write_frame(output_fmt_ctx, output_streams[i], i, enc_frame);
 
+          av_frame_free(&enc_frame);
+        }
+      }
+
+      // flush encoder
+      encode_and_write_frame(output_fmt_ctx, output_streams[i], i, nullptr);
+
+    }
   }
 
   // free dec_frame
@@ -321,67 +463,401 @@ void ProxyGenerator::transcode(const ProxyInfo& info) {
   // close input file
   avformat_close_input(&input_fmt_ctx);
 
-  // set footage to use newly generated proxy
-  footage->proxy = true;
-  footage->proxy_path = info.path;
+  succeeded_ = (!skip_ && !read_error);
+
+  if (succeeded_) {
+    progress_ = 100.0;
+  }
+}
+
+double ProxyTranscoder::progress() {
+  return progress_;
+}
+
+bool ProxyTranscoder::succeeded() {
+  return succeeded_;
+}
+
+int64_t ProxyTranscoder::start_time() {
+  return start_;
+}
 
-  qInfo() << "Finished creating proxy for" << footage->url;
-  QMetaObject::invokeMethod(olive::MainWindow->statusBar(),
-                            "showMessage",
-                            Qt::QueuedConnection,
-                            Q_ARG(QString, tr("Finished generating proxy for \"%1\"").arg(footage->url)));
+const QString &ProxyTranscoder::output_path() {
+  return output_path_;
 }
 
-// main proxy generating loop
+ProxyJob::ProxyJob(const ProxyInfo &info, int max_segments) :
+  info_(info),
+  max_segments_(max_segments),
+  skip_(false),
+  succeeded_(false)
+{}
+
+void ProxyJob::run() {
+  FootagePtr footage = info_.media->to_footage();
+
+  // create directory for info
+  QFileInfo(info_.path).dir().mkpath(".");
+
+  // segment boundaries in AV_TIME_BASE units, every segment starts at one boundary and ends at the next
+  QVector<int64_t> boundaries;
+  boundaries.append(AV_NOPTS_VALUE);
+
+  // still images can't be split, everything else is split if it's long enough to be worth it
+  bool can_split = (max_segments_ > 1);
+  for (int i=0;i<footage->video_tracks.size();i++) {
+    if (footage->video_tracks.at(i).infinite_length) {
+      can_split = false;
+    }
+  }
+
+  if (can_split) {
+    AVDictionary* format_opts = nullptr;
+    if (footage->start_number > 0) {
+      av_dict_set(&format_opts, "start_number", QString::number(footage->start_number).toUtf8(), 0);
+    }
+
+    AVFormatContext* fmt_ctx = nullptr;
+    if (avformat_open_input(&fmt_ctx, footage->url.toUtf8(), nullptr, &format_opts) == 0) {
+      avformat_find_stream_info(fmt_ctx, nullptr);
+
+      int video_stream_index = av_find_best_stream(fmt_ctx, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+
+      if (video_stream_index >= 0
+          && fmt_ctx->duration != AV_NOPTS_VALUE
+          && fmt_ctx->duration > 0) {
+        AVStream* video_stream = fmt_ctx->streams[video_stream_index];
+
+        int64_t file_start = (fmt_ctx->start_time == AV_NOPTS_VALUE) ? 0 : fmt_ctx->start_time;
+
+        int segment_count = int(qMin(int64_t(max_segments_), fmt_ctx->duration / (kMinimumSegmentLength*AV_TIME_BASE)));
+
+        for (int i=1;i<segment_count;i++) {
+          int64_t boundary = file_start + fmt_ctx->duration * i / segment_count;
+
+          // snap the boundary back to the nearest keyframe so no segment has to decode frames it won't use
+          int64_t stream_ts = av_rescale_q(boundary, AV_TIME_BASE_Q, video_stream->time_base);
+          int keyframe_index = av_index_search_timestamp(video_stream, stream_ts, AVSEEK_FLAG_BACKWARD);
+          if (keyframe_index >= 0) {
+            boundary = av_rescale_q(video_stream->index_entries[keyframe_index].timestamp,
+                                    video_stream->time_base,
+                                    AV_TIME_BASE_Q);
+          }
+
+          // keyframes may be sparse, don't add the same boundary twice
+          if (boundary > file_start && (boundaries.size() == 1 || boundary > boundaries.last())) {
+            boundaries.append(boundary);
+          }
+        }
+      }
+
+      avformat_close_input(&fmt_ctx);
+    }
+
+    av_dict_free(&format_opts);
+  }
+
+  boundaries.append(AV_NOPTS_VALUE);
+
+  int segment_count = boundaries.size() - 1;
+
+  // create a transcoder for each segment
+  segments_lock_.lock();
+  for (int i=0;i<segment_count;i++) {
+    QString segment_path = (segment_count == 1) ? info_.path : QString("%1.part%2").arg(info_.path, QString::number(i));
+
+    segments_.append(new ProxyTranscoder(info_, segment_path, boundaries.at(i), boundaries.at(i+1), skip_));
+  }
+  segments_lock_.unlock();
+
+  if (segment_count > 1) {
+    qInfo() << "Splitting proxy for" << footage->url << "into" << segment_count << "segments";
+  }
+
+  // run all segments in parallel and wait for them to finish
+  for (int i=0;i<segments_.size();i++) {
+    segments_.at(i)->start(QThread::LowPriority);
+  }
+
+  bool segments_succeeded = true;
+  for (int i=0;i<segments_.size();i++) {
+    segments_.at(i)->wait();
+
+    if (!segments_.at(i)->succeeded()) {
+      segments_succeeded = false;
+    }
+  }
+
+  if (segments_succeeded && !skip_) {
+    succeeded_ = (segment_count == 1) ? true : concatenate_segments();
+  }
+
+  // clean up temporary segment files and any incomplete output
+  segments_lock_.lock();
+  for (int i=0;i<segments_.size();i++) {
+    if (segments_.at(i)->output_path() != info_.path) {
+      QFile::remove(segments_.at(i)->output_path());
+    }
+    delete segments_.at(i);
+  }
+  segments_.clear();
+  segments_lock_.unlock();
+
+  if (!succeeded_) {
+    QFile::remove(info_.path);
+  }
+
+  olive::proxy_generator.job_finished(this);
+}
+
+bool ProxyJob::concatenate_segments() {
+  AVFormatContext* output_fmt_ctx = nullptr;
+  avformat_alloc_output_context2(&output_fmt_ctx, nullptr, nullptr, info_.path.toUtf8());
+
+  if (avio_open(&output_fmt_ctx->pb, info_.path.toUtf8(), AVIO_FLAG_WRITE) < 0) {
+    qWarning() << "Failed to open" << info_.path << "for writing";
+    avformat_free_context(output_fmt_ctx);
+    return false;
+  }
+
+  bool ok = true;
+  bool wrote_header = false;
+
+  AVPacket packet;
+  av_init_packet(&packet);
+  packet.data = nullptr;
+  packet.size = 0;
+
+  for (int i=0;i<segments_.size() && ok && !skip_;i++) {
+    AVFormatContext* segment_fmt_ctx = nullptr;
+
+    if (avformat_open_input(&segment_fmt_ctx, segments_.at(i)->output_path().toUtf8(), nullptr, nullptr) < 0) {
+      qWarning() << "Failed to open proxy segment" << segments_.at(i)->output_path();
+      ok = false;
+      break;
+    }
+
+    avformat_find_stream_info(segment_fmt_ctx, nullptr);
+
+    if (!wrote_header) {
+      // all segments were written with identical streams, so we set up the output from the first one
+      for (int j=0;j<int(segment_fmt_ctx->nb_streams);j++) {
+        AVStream* in_stream = segment_fmt_ctx->streams[j];
+        AVStream* out_stream = avformat_new_stream(output_fmt_ctx, nullptr);
+        avcodec_parameters_copy(out_stream->codecpar, in_stream->codecpar);
+        out_stream->time_base = in_stream->time_base;
+      }
+
+      avformat_write_header(output_fmt_ctx, nullptr);
+      wrote_header = true;
+    } else if (segment_fmt_ctx->nb_streams != output_fmt_ctx->nb_streams) {
+      qWarning() << "Proxy segment" << segments_.at(i)->output_path() << "has a different stream layout";
+      ok = false;
+    }
+
+    // segments are written relative to their start time, so we add it back here
+    int64_t segment_start = segments_.at(i)->start_time();
+    if (segment_start == AV_NOPTS_VALUE) {
+      segment_start = 0;
+    }
+
+    while (ok && !skip_ && av_read_frame(segment_fmt_ctx, &packet) >= 0) {
+      AVStream* in_stream = segment_fmt_ctx->streams[packet.stream_index];
+
+      int64_t stream_offset = av_rescale_q(segment_start, AV_TIME_BASE_Q, in_stream->time_base);
+      if (packet.pts != AV_NOPTS_VALUE) packet.pts += stream_offset;
+      if (packet.dts != AV_NOPTS_VALUE) packet.dts += stream_offset;
+
+      av_packet_rescale_ts(&packet, in_stream->time_base, output_fmt_ctx->streams[packet.stream_index]->time_base);
+
+      av_interleaved_write_frame(output_fmt_ctx, &packet);
+
+      av_packet_unref(&packet);
+    }
+
+    avformat_close_input(&segment_fmt_ctx);
+  }
+
+  if (wrote_header) {
+    av_write_trailer(output_fmt_ctx);
+  }
+
+  avio_closep(&output_fmt_ctx->pb);
+  avformat_free_context(output_fmt_ctx);
+
+  return ok && wrote_header && !skip_;
+}
+
+void ProxyJob::abort() {
+  skip_ = true;
+}
+
+double ProxyJob::progress() {
+  double total = 0.0;
+
+  segments_lock_.lock();
+
+  if (segments_.isEmpty()) {
+    total = succeeded_ ? 100.0 : 0.0;
+  } else {
+    for (int i=0;i<segments_.size();i++) {
+      total += segments_.at(i)->progress();
+    }
+    total /= segments_.size();
+  }
+
+  segments_lock_.unlock();
+
+  return total;
+}
+
+bool ProxyJob::succeeded() {
+  return succeeded_;
+}
+
+bool ProxyJob::aborted() {
+  return skip_;
+}
+
+const ProxyInfo &ProxyJob::info() {
+  return info_;
+}
+
+ProxyGenerator::ProxyGenerator() : cancelled(false) {}
+
+// main proxy scheduling loop
 void ProxyGenerator::run() {
   // mutex used for thread safe signalling
   mutex.lock();
 
   while (!cancelled) {
-    // wait for queue() to be called
+    // clean up any proxies that finished since we last woke up
+    collect_finished_jobs();
+
+    // fill any free job slots from the queue
+    start_queued_jobs();
+
+    // wait for queue(), cancel() or a job finishing
     waitCond.wait(&mutex);
+  }
+
+  // abort anything still running
+  for (int i=0;i<active_jobs.size();i++) {
+    active_jobs.at(i)->abort();
+  }
+
+  // jobs call job_finished() on exit which needs the mutex, so we release it while waiting for them
+  QVector<ProxyJob*> jobs_to_wait_for = active_jobs;
 
-    // quit thread if cancel() was called
-    if (cancelled) break;
+  mutex.unlock();
+
+  for (int i=0;i<jobs_to_wait_for.size();i++) {
+    jobs_to_wait_for.at(i)->wait();
+    delete jobs_to_wait_for.at(i);
+  }
+
+  mutex.lock();
+  active_jobs.clear();
+  finished_jobs.clear();
+  proxy_queue.clear();
+  mutex.unlock();
+}
 
-    // loop through queue until the queue is empty
-    while (proxy_queue.size() > 0) {
+void ProxyGenerator::start_queued_jobs() {
+  int job_limit = qMax(1, olive::CurrentConfig.proxy_job_limit);
 
-      // grab proxy info
-      const ProxyInfo& info = proxy_queue.first();
+  // split the available cores between the jobs that can run at once, jobs use them for segments
+  int max_segments = qMax(1, QThread::idealThreadCount() / job_limit);
 
-      // create directory for info
-      QFileInfo(info.path).dir().mkpath(".");
+  for (int i=0;i<proxy_queue.size() && active_jobs.size() < job_limit;i++) {
 
-      // set skip to false
-      skip = false;
+    // if this footage is still being processed by an aborted job, wait for it to clear before starting another
+    bool media_busy = false;
+    for (int j=0;j<active_jobs.size();j++) {
+      if (active_jobs.at(j)->info().media == proxy_queue.at(i).media) {
+        media_busy = true;
+        break;
+      }
+    }
 
-      // transcode proxy
-      transcode(info);
+    if (!media_busy) {
+      ProxyJob* job = new ProxyJob(proxy_queue.at(i), max_segments);
+      active_jobs.append(job);
+      job->start(QThread::LowPriority);
 
       // we're finished with this proxy, remove it
-      proxy_queue.removeFirst();
+      proxy_queue.removeAt(i);
+      i--;
+    }
+  }
+}
+
+void ProxyGenerator::collect_finished_jobs() {
+  for (int i=0;i<finished_jobs.size();i++) {
+    ProxyJob* job = finished_jobs.at(i);
+
+    // job has called job_finished() as its last action, so this will return almost immediately
+    job->wait();
+
+    FootagePtr footage = job->info().media->to_footage();
 
-      // quit loop if cancel() was called
-      if (cancelled) break;
+    if (job->succeeded()) {
+      // set footage to use newly generated proxy
+      footage->proxy = true;
+      footage->proxy_path = job->info().path;
+
+      // the new proxy may decode at a different speed than the old one, measure both files again
+      footage->reset_decode_times();
+
+      qInfo() << "Finished creating proxy for" << footage->url;
+      QMetaObject::invokeMethod(olive::MainWindow->statusBar(),
+                                "showMessage",
+                                Qt::QueuedConnection,
+                                Q_ARG(QString, tr("Finished generating proxy for \"%1\"").arg(footage->url)));
+    } else {
+      // if this footage has been re-queued, the newer proxy will take over, otherwise we mark it as having no proxy
+      bool requeued = false;
+      for (int j=0;j<proxy_queue.size();j++) {
+        if (proxy_queue.at(j).media == job->info().media) {
+          requeued = true;
+          break;
+        }
+      }
 
+      if (!requeued) {
+        qWarning() << "Failed to create proxy for" << footage->url;
+        footage->proxy = false;
+        footage->proxy_path.clear();
+      }
     }
+
+    active_jobs.removeAll(job);
+    delete job;
   }
 
+  finished_jobs.clear();
+}
+
+void ProxyGenerator::job_finished(ProxyJob *job) {
+  mutex.lock();
+  finished_jobs.append(job);
+  waitCond.wakeAll();
   mutex.unlock();
 }
 
 // called to add footage to generate proxies for
 void ProxyGenerator::queue(const ProxyInfo &info) {
-  // remove any queued proxies with the same footage
-  if (!proxy_queue.isEmpty()
-      && proxy_queue.first().media == info.media) {
-    // if the thread is currently processing a proxy with the same footage, abort it
-    skip = true;
+  mutex.lock();
+
+  // if a job is currently processing a proxy with the same footage, abort it
+  for (int i=0;i<active_jobs.size();i++) {
+    if (active_jobs.at(i)->info().media == info.media) {
+      active_jobs.at(i)->abort();
+    }
   }
 
-  // scan through the rest of the queue for another proxy with the same footage (start with 1 since we already processed first())
-  for (int i=1;i<proxy_queue.size();i++) {
+  // scan through the queue for another proxy with the same footage
+  for (int i=0;i<proxy_queue.size();i++) {
     if (proxy_queue.at(i).media == info.media) {
       // found a duplicate, assume the one we're queuing now overrides and delete it
       proxy_queue.removeAt(i);
@@ -394,26 +870,37 @@ void ProxyGenerator::queue(const ProxyInfo &info) {
 
   // wake proxy thread loop if sleeping
   waitCond.wakeAll();
+
+  mutex.unlock();
 }
 
 // to be called from another thread to terminate the proxy generator thread and free it
 void ProxyGenerator::cancel() {
   // signal to thread to cancel
+  mutex.lock();
   cancelled = true;
-  skip = true;
 
   // if signal is sleeping, wake it to cancel correctly
   waitCond.wakeAll();
+  mutex.unlock();
 
   // wait for thread to finish
   wait();
 }
 
 double ProxyGenerator::get_proxy_progress(Media* m) {
-  if (proxy_queue.first().media == m) {
-    return current_progress;
+  double progress = 0.0;
+
+  mutex.lock();
+  for (int i=0;i<active_jobs.size();i++) {
+    if (active_jobs.at(i)->info().media == m && !active_jobs.at(i)->aborted()) {
+      progress = active_jobs.at(i)->progress();
+      break;
+    }
   }
-  return 0.0;
+  mutex.unlock();
+
+  return progress;
 }
 
 // proxy generator is a global omnipotent entity
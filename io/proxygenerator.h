@@ -25,6 +25,7 @@
 #include <QVector>
 #include <QMutex>
 #include <QWaitCondition>
+#include <atomic>
 
 #include "project/media.h"
 
@@ -35,6 +36,144 @@ struct ProxyInfo {
   QString path;
 };
 
+/**
+ * @brief The ProxyTranscoder class
+ *
+ * Transcodes one time range of a footage file into a proxy file. A ProxyTranscoder covering the whole file writes
+ * straight to the final proxy path. Long files are split into several segments, each with its own ProxyTranscoder
+ * running in parallel, which are concatenated into the final proxy by ProxyJob once they've all finished.
+ *
+ * Segment boundaries are in AV_TIME_BASE units. Every frame and passthrough packet belongs to exactly one segment
+ * (the one whose [start, end) range contains its presentation time) so segments can be joined losslessly.
+ */
+class ProxyTranscoder : public QThread {
+public:
+  /**
+   * @brief ProxyTranscoder Constructor
+   *
+   * @param info
+   *
+   * Proxy parameters (source media, size and codec)
+   *
+   * @param output_path
+   *
+   * File to write to. Either the final proxy path or a temporary segment path.
+   *
+   * @param start
+   *
+   * Start of the range to transcode in AV_TIME_BASE units, or AV_NOPTS_VALUE for the start of the file.
+   *
+   * @param end
+   *
+   * End (exclusive) of the range to transcode in AV_TIME_BASE units, or AV_NOPTS_VALUE for the end of the file.
+   *
+   * @param skip
+   *
+   * Reference to the owning job's abort flag. The transcoder checks it regularly and stops if it's **TRUE**.
+   */
+  ProxyTranscoder(const ProxyInfo& info,
+                  const QString& output_path,
+                  int64_t start,
+                  int64_t end,
+                  const std::atomic<bool>& skip);
+
+  virtual void run() override;
+
+  /**
+   * @brief Get progress through this transcoder's range in percent
+   */
+  double progress();
+
+  /**
+   * @brief Returns **TRUE** if the range was transcoded completely and without errors
+   */
+  bool succeeded();
+
+  /**
+   * @brief Returns the start of this transcoder's range (AV_TIME_BASE units or AV_NOPTS_VALUE)
+   *
+   * Timestamps in the output file are written relative to this value so that segments start at zero.
+   */
+  int64_t start_time();
+
+  /**
+   * @brief Returns the path this transcoder writes to
+   */
+  const QString& output_path();
+
+private:
+  ProxyInfo info_;
+  QString output_path_;
+  int64_t start_;
+  int64_t end_;
+  // written by the owning job's thread and read here, or written here and read by the GUI thread
+  const std::atomic<bool>& skip_;
+  std::atomic<double> progress_;
+  bool succeeded_;
+};
+
+/**
+ * @brief The ProxyJob class
+ *
+ * Generates one proxy file. Decides whether the footage is long enough to be split into segments, runs a
+ * ProxyTranscoder per segment in parallel and losslessly concatenates their output into the final proxy file.
+ */
+class ProxyJob : public QThread {
+public:
+  /**
+   * @brief ProxyJob Constructor
+   *
+   * @param info
+   *
+   * Proxy to generate
+   *
+   * @param max_segments
+   *
+   * Maximum number of segments (and therefore threads) this job is allowed to split the footage into
+   */
+  ProxyJob(const ProxyInfo& info, int max_segments);
+
+  virtual void run() override;
+
+  /**
+   * @brief Abort this job
+   *
+   * Signals any running transcoders to stop. The job thread will still finish on its own and should be waited for.
+   */
+  void abort();
+
+  /**
+   * @brief Get progress of this job in percent, averaged over all of its segments
+   */
+  double progress();
+
+  /**
+   * @brief Returns **TRUE** if the proxy was written successfully and wasn't aborted
+   */
+  bool succeeded();
+
+  /**
+   * @brief Returns **TRUE** if abort() was called on this job
+   */
+  bool aborted();
+
+  const ProxyInfo& info();
+
+private:
+  /**
+   * @brief Join segment files in order into the final proxy without re-encoding
+   */
+  bool concatenate_segments();
+
+  ProxyInfo info_;
+  int max_segments_;
+  std::atomic<bool> skip_;
+  bool succeeded_;
+
+  QVector<ProxyTranscoder*> segments_;
+  QMutex segments_lock_;
+};
+
 class ProxyGenerator : public QThread {
   Q_OBJECT
 public:
@@ -43,10 +182,21 @@ public:
   void queue(const ProxyInfo& info);
   void cancel();
   double get_proxy_progress(Media *f);
+
+  /**
+   * @brief Called by ProxyJob when it finishes to wake up the scheduling loop
+   */
+  void job_finished(ProxyJob* job);
 private:
   // queue of footage to process proxies for
   QVector<ProxyInfo> proxy_queue;
 
+  // proxies currently being processed
+  QVector<ProxyJob*> active_jobs;
+
+  // jobs that have finished and are waiting to be cleaned up by the scheduling loop
+  QVector<ProxyJob*> finished_jobs;
+
   // threading objects
   QWaitCondition waitCond;
   QMutex mutex;
@@ -54,14 +204,11 @@ private:
   // set to true if you want to permanently close ProxyGenerator
   bool cancelled;
 
-  // set to true if you want to abort the footage currently being processed
-  bool skip;
-
-  // stores progress in percent of proxy currently being processed
-  double current_progress;
+  // start as many queued proxies as Config::proxy_job_limit allows
+  void start_queued_jobs();
 
-  // function that performs the actual transcode
-  void transcode(const ProxyInfo& info);
+  // finalize any jobs that have finished
+  void collect_finished_jobs();
 };
 
 namespace olive {
@@ -29,6 +29,7 @@
 #include "io/config.h"
 #include "io/path.h"
 #include "io/proxygenerator.h"
+#include "io/projectsaver.h"
 
 #include "project/projectfilter.h"
 
@@ -320,6 +321,9 @@ MainWindow::MainWindow(QWidget *parent) :
   // start omnipotent proxy generator process
   olive::proxy_generator.start();
 
+  // start background project saving thread
+  olive::project_saver.start();
+
   // load preferred language from file
   olive::Global->load_translation_from_config();
 
@@ -612,6 +616,12 @@ void MainWindow::setup_menus() {
   loop_action_->setCheckable(true);
   loop_action_->setData(reinterpret_cast<quintptr>(&olive::CurrentConfig.loop));
 
+  playback_menu->addSeparator();
+
+  render_work_area_ = MenuHelper::create_menu_action(playback_menu, "renderworkarea", olive::Global.get(), SLOT(render_work_area()));
+  cancel_render_work_area_ = MenuHelper::create_menu_action(playback_menu, "cancelrenderworkarea", olive::Global.get(), SLOT(cancel_work_area_render()));
+  ram_preview_ = MenuHelper::create_menu_action(playback_menu, "rampreview", olive::Global.get(), SLOT(ram_preview()), QKeySequence("Ctrl+0"));
+
   // INITIALIZE WINDOW MENU
 
   window_menu = MenuHelper::create_submenu(menuBar, this, SLOT(windowMenu_About_To_Be_Shown()));
@@ -859,6 +869,10 @@ void MainWindow::Retranslate()
 
   loop_action_->setText(tr("Loop"));
 
+  render_work_area_->setText(tr("Render Work Area"));
+  cancel_render_work_area_->setText(tr("Cancel Work Area Render"));
+  ram_preview_->setText(tr("RAM Preview"));
+
   window_menu->setTitle(tr("&Window"));
 
   window_project_action->setText(tr("Project"));
@@ -939,6 +953,12 @@ void MainWindow::closeEvent(QCloseEvent *e) {
     // stop proxy generator thread
     olive::proxy_generator.cancel();
 
+    // finish any pending saves and stop project saver thread
+    olive::project_saver.cancel();
+
+    // stop rendering the work area, it uses the sequence viewer's renderer
+    olive::Global->cancel_work_area_render();
+
     panel_effect_controls->clear_effects(true);
 
     olive::Global->set_sequence(nullptr);
@@ -951,6 +971,10 @@ void MainWindow::closeEvent(QCloseEvent *e) {
     QString data_dir = get_data_path();
     QString config_path = get_config_path();
     if (!data_dir.isEmpty() && !autorecovery_filename.isEmpty()) {
+      if (QFile::exists(autorecovery_journal_filename)
+          && olive::rebuild_autorecovery_journal(autorecovery_journal_filename, autorecovery_filename)) {
+        QFile::remove(autorecovery_journal_filename);
+      }
       if (QFile::exists(autorecovery_filename)) {
         QFile::rename(autorecovery_filename, autorecovery_filename + "." + QDateTime::currentDateTimeUtc().toString("yyyyMMddHHmmss"));
       }
@@ -1098,6 +1122,7 @@ void MainWindow::windowMenu_About_To_Be_Shown() {
 
 void MainWindow::playbackMenu_About_To_Be_Shown() {
   olive::MenuHelper.set_bool_action_checked(loop_action_);
+  cancel_render_work_area_->setEnabled(olive::Global->is_rendering_work_area());
 }
 
 void MainWindow::viewMenu_About_To_Be_Shown() {
@@ -292,6 +292,9 @@ private:
   QAction* shuttle_stop_;
   QAction* shuttle_right_;
   QAction* loop_action_;
+  QAction* render_work_area_;
+  QAction* cancel_render_work_area_;
+  QAction* ram_preview_;
 
   // window menu
 
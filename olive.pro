@@ -66,6 +66,7 @@ SOURCES += \
     project/footage.cpp \
     project/sequence.cpp \
     project/clip.cpp \
+    project/clipindex.cpp \
     io/config.cpp \
     dialogs/newsequencedialog.cpp \
     ui/viewerwidget.cpp \
@@ -80,6 +81,7 @@ SOURCES += \
     dialogs/preferencesdialog.cpp \
     ui/audiomonitor.cpp \
     project/undo.cpp \
+    project/invalidation.cpp \
     ui/scrollarea.cpp \
     ui/comboboxex.cpp \
     ui/colorbutton.cpp \
@@ -140,11 +142,16 @@ SOURCES += \
     project/projectfilter.cpp \
     effects/internal/frei0reffect.cpp \
     project/effectloaders.cpp \
+    project/effectregistrycache.cpp \
     io/crossplatformlib.cpp \
     effects/internal/vsthost.cpp \
     ui/flowlayout.cpp \
     dialogs/proxydialog.cpp \
     io/proxygenerator.cpp \
+    io/projectsaver.cpp \
+    io/binaryproject.cpp \
+    io/projectsnapshot.cpp \
+    io/binarysequenceloader.cpp \
     dialogs/advancedvideodialog.cpp \
     ui/cursors.cpp \
     ui/menuhelper.cpp \
@@ -156,11 +163,25 @@ SOURCES += \
     effects/internal/dropshadoweffect.cpp \
     rendering/renderfunctions.cpp \
     rendering/renderthread.cpp \
+    rendering/rendercache.cpp \
+    rendering/rangerenderthread.cpp \
+    rendering/rampreview.cpp \
+    rendering/playbackclock.cpp \
     rendering/cacher.cpp \
     rendering/clipqueue.cpp \
     rendering/audio.cpp \
     dialogs/clippropertiesdialog.cpp \
     rendering/framebufferobject.cpp \
+    rendering/framebufferpool.cpp \
+    rendering/shaderprogramcache.cpp \
+    rendering/imageeffectstage.cpp \
+    rendering/blurkernel.cpp \
+    rendering/textrenderer.cpp \
+    rendering/shaderfusion.cpp \
+    rendering/effectstagecache.cpp \
+    rendering/compositingbenchmark.cpp \
+    rendering/ociolutcache.cpp \
+    rendering/proxypolicy.cpp \
     ui/updatenotification.cpp \
     ui/icons.cpp
 
@@ -177,6 +198,7 @@ HEADERS += \
     project/footage.h \
     project/sequence.h \
     project/clip.h \
+    project/clipindex.h \
     io/config.h \
     dialogs/newsequencedialog.h \
     ui/viewerwidget.h \
@@ -192,6 +214,7 @@ HEADERS += \
     dialogs/preferencesdialog.h \
     ui/audiomonitor.h \
     project/undo.h \
+    project/invalidation.h \
     ui/scrollarea.h \
     ui/comboboxex.h \
     ui/colorbutton.h \
@@ -253,11 +276,16 @@ HEADERS += \
     project/projectfilter.h \
     effects/internal/frei0reffect.h \
     project/effectloaders.h \
+    project/effectregistrycache.h \
     io/crossplatformlib.h \
     effects/internal/vsthost.h \
     ui/flowlayout.h \
     dialogs/proxydialog.h \
     io/proxygenerator.h \
+    io/projectsaver.h \
+    io/binaryproject.h \
+    io/projectsnapshot.h \
+    io/binarysequenceloader.h \
     dialogs/advancedvideodialog.h \
     ui/cursors.h \
     ui/menuhelper.h \
@@ -270,11 +298,25 @@ HEADERS += \
     effects/internal/dropshadoweffect.h \
     rendering/renderfunctions.h \
     rendering/renderthread.h \
+    rendering/rendercache.h \
+    rendering/rangerenderthread.h \
+    rendering/rampreview.h \
+    rendering/playbackclock.h \
     rendering/clipqueue.h \
     rendering/cacher.h \
     rendering/audio.h \
     dialogs/clippropertiesdialog.h \
     rendering/framebufferobject.h \
+    rendering/framebufferpool.h \
+    rendering/shaderprogramcache.h \
+    rendering/imageeffectstage.h \
+    rendering/blurkernel.h \
+    rendering/textrenderer.h \
+    rendering/shaderfusion.h \
+    rendering/effectstagecache.h \
+    rendering/compositingbenchmark.h \
+    rendering/ociolutcache.h \
+    rendering/proxypolicy.h \
     ui/updatenotification.h \
     ui/icons.h
 
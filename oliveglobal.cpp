@@ -26,10 +26,15 @@
 
 #include "io/path.h"
 #include "io/config.h"
+#include "io/projectsaver.h"
+#include "io/binaryproject.h"
 
 #include "ui/mediaiconservice.h"
 
 #include "rendering/audio.h"
+#include "rendering/rendercache.h"
+#include "rendering/rampreview.h"
+#include "rendering/renderfunctions.h"
 
 #include "dialogs/demonotice.h"
 #include "dialogs/preferencesdialog.h"
@@ -48,6 +53,8 @@
 #include <QAction>
 #include <QApplication>
 #include <QDebug>
+#include <QProgressDialog>
+#include <QStatusBar>
 
 std::unique_ptr<OliveGlobal> olive::Global;
 QString olive::ActiveProjectFilename;
@@ -62,11 +69,17 @@ OliveGlobal::OliveGlobal() {
   olive::AppName = QString("Olive (March 2019 | Alpha%1)").arg(version_id);
 
   // set the file filter used in all file dialogs pertaining to Olive project files.
-  project_file_filter = tr("Olive Project %1").arg("(*.ove)");
+  project_file_filter = tr("Olive Project %1").arg("(*.ove *.ovb)");
+
+  // set the file filters used when saving, which also determine the project format
+  xml_project_file_filter = tr("Olive Project %1").arg("(*.ove)");
+  binary_project_file_filter = tr("Olive Binary Project %1").arg("(*.ovb)");
 
   // set default value
   enable_load_project_on_init = false;
 
+  work_area_render = nullptr;
+
   // alloc QTranslator
   translator = std::unique_ptr<QTranslator>(new QTranslator());
 }
@@ -88,6 +101,17 @@ void OliveGlobal::check_for_autorecovery_file() {
   if (!data_dir.isEmpty()) {
     // detect auto-recovery file
     autorecovery_filename = data_dir + "/autorecovery.ove";
+    autorecovery_journal_filename = data_dir + "/autorecovery.journal";
+
+    // a leftover journal holds the most recent auto-recovery state, replay it into a regular project file first
+    if (QFile::exists(autorecovery_journal_filename)) {
+      if (olive::rebuild_autorecovery_journal(autorecovery_journal_filename, autorecovery_filename)) {
+        QFile::remove(autorecovery_journal_filename);
+      } else {
+        qWarning() << "Failed to rebuild project from auto-recovery journal" << autorecovery_journal_filename;
+      }
+    }
+
     if (QFile::exists(autorecovery_filename)) {
       if (QMessageBox::question(nullptr, tr("Auto-recovery"), tr("Olive didn't close properly and an autorecovery file was detected. Would you like to open it?"), QMessageBox::Yes, QMessageBox::No) == QMessageBox::Yes) {
         enable_load_project_on_init = false;
@@ -109,6 +133,10 @@ void OliveGlobal::set_rendering_state(bool rendering) {
   }
 }
 
+bool OliveGlobal::is_rendering_work_area() {
+  return work_area_render != nullptr;
+}
+
 void OliveGlobal::load_project_on_launch(const QString& s) {
   olive::ActiveProjectFilename = s;
   enable_load_project_on_init = true;
@@ -187,10 +215,15 @@ void OliveGlobal::open_recent(int index) {
 }
 
 bool OliveGlobal::save_project_as() {
-  QString fn = QFileDialog::getSaveFileName(olive::MainWindow, tr("Save Project As..."), "", project_file_filter);
+  QString selected_filter;
+  QString fn = QFileDialog::getSaveFileName(olive::MainWindow,
+                                            tr("Save Project As..."),
+                                            "",
+                                            xml_project_file_filter + ";;" + binary_project_file_filter,
+                                            &selected_filter);
   if (!fn.isEmpty()) {
-    if (!fn.endsWith(".ove", Qt::CaseInsensitive)) {
-      fn += ".ove";
+    if (!fn.endsWith(".ove", Qt::CaseInsensitive) && !olive::is_binary_project_filename(fn)) {
+      fn += (selected_filter == binary_project_file_filter) ? kBinaryProjectExtension : ".ove";
     }
     update_project_filename(fn);
     panel_project->save_project(false);
@@ -241,6 +274,128 @@ void OliveGlobal::open_export_dialog() {
   }
 }
 
+void OliveGlobal::render_work_area() {
+  long start, end;
+  if (!get_render_range(&start, &end)) {
+    return;
+  }
+
+  cancel_work_area_render();
+
+  work_area_render = new RenderCacheThread(olive::ActiveSequence, start, end);
+  connect(work_area_render, SIGNAL(progress_changed(int)), this, SLOT(work_area_render_progress(int)));
+  connect(work_area_render, SIGNAL(render_finished()), this, SLOT(work_area_render_finished()));
+  work_area_render->start();
+}
+
+void OliveGlobal::cancel_work_area_render() {
+  if (work_area_render == nullptr) {
+    return;
+  }
+
+  disconnect(work_area_render, SIGNAL(render_finished()), this, SLOT(work_area_render_finished()));
+
+  work_area_render->cancel();
+  work_area_render->wait();
+
+  // mark the frames that were written last as rendered before the thread is gone
+  QCoreApplication::sendPostedEvents(work_area_render, QEvent::MetaCall);
+
+  delete work_area_render;
+  work_area_render = nullptr;
+
+  olive::MainWindow->statusBar()->showMessage(tr("Work area render cancelled"));
+}
+
+void OliveGlobal::work_area_render_progress(int value) {
+  olive::MainWindow->statusBar()->showMessage(tr("Rendering work area... %1%").arg(value));
+}
+
+void OliveGlobal::work_area_render_finished() {
+  // called from the thread's own slot, so it can't be deleted right away
+  work_area_render->deleteLater();
+  work_area_render = nullptr;
+
+  olive::MainWindow->statusBar()->showMessage(tr("Finished rendering work area"));
+}
+
+void OliveGlobal::ram_preview() {
+  long start, end;
+  if (!get_render_range(&start, &end)) {
+    return;
+  }
+
+  SequencePtr s = olive::ActiveSequence;
+
+  long cached_end = olive::ram_preview.Begin(s, start, end);
+  if (cached_end <= start) {
+    return;
+  }
+
+  RamPreviewThread thread(s, start, cached_end);
+  QString label = (cached_end < end)
+      ? tr("Caching %1 of %2 frames (limited by the RAM preview size)...").arg(cached_end - start).arg(end - start)
+      : tr("Caching %1 frames...").arg(end - start);
+  run_range_render(&thread, tr("RAM Preview"), label);
+
+  // only play if the preview wasn't cancelled
+  if (olive::ram_preview.HasFrame(s.get(), cached_end - 1)) {
+    panel_sequence_viewer->play(true);
+  }
+}
+
+bool OliveGlobal::get_render_range(long *start, long *end) {
+  SequencePtr s = olive::ActiveSequence;
+
+  if (s == nullptr) {
+    QMessageBox::information(olive::MainWindow,
+                             tr("No active sequence"),
+                             tr("Please open the sequence you wish to render."),
+                             QMessageBox::Ok);
+    return false;
+  }
+
+  *start = 0;
+  *end = s->getEndFrame();
+  if (s->using_workarea) {
+    *start = qMax(s->workarea_in, *start);
+    *end = qMin(s->workarea_out, *end);
+  }
+
+  return (*end > *start);
+}
+
+void OliveGlobal::run_range_render(RangeRenderThread *thread, const QString &title, const QString &label) {
+  SequencePtr s = olive::ActiveSequence;
+
+  panel_sequence_viewer->pause();
+
+  long old_playhead = s->playhead;
+
+  close_active_clips(s);
+
+  set_rendering_state(true);
+
+  QProgressDialog progress(label, tr("Cancel"), 0, 100, olive::MainWindow);
+  progress.setWindowTitle(title);
+  progress.setWindowModality(Qt::WindowModal);
+  progress.setMinimumDuration(0);
+
+  connect(thread, SIGNAL(progress_changed(int)), &progress, SLOT(setValue(int)));
+  connect(thread, SIGNAL(finished()), &progress, SLOT(reset()));
+  connect(&progress, SIGNAL(canceled()), thread, SLOT(cancel()), Qt::DirectConnection);
+
+  thread->start();
+  progress.exec();
+  thread->wait();
+
+  set_rendering_state(false);
+
+  s->playhead = old_playhead;
+
+  update_ui(false);
+}
+
 void OliveGlobal::finished_initialize() {
   if (enable_load_project_on_init) {
 
@@ -288,6 +443,10 @@ void OliveGlobal::open_preferences() {
 
 void OliveGlobal::set_sequence(SequencePtr s)
 {
+  if (s != nullptr) {
+    s->load_deferred();
+  }
+
   panel_effect_controls->clear_effects(true);
 
   olive::ActiveSequence = s;
@@ -28,6 +28,9 @@
 #include <QFile>
 #include <QTranslator>
 
+class RangeRenderThread;
+class RenderCacheThread;
+
 /**
  * @brief The Olive Global class
  *
@@ -46,7 +49,7 @@ public:
     /**
      * @brief Returns the file dialog filter used when interfacing with Olive project files.
      *
-     * @return The file filter string used by QFileDialog to limit the files shown to Olive (*.ove) files.
+     * @return The file filter string used by QFileDialog to limit the files shown to Olive (*.ove and *.ovb) files.
      */
     const QString& get_project_file_filter();
 
@@ -92,6 +95,11 @@ public:
      */
     void set_rendering_state(bool rendering);
 
+    /**
+     * @brief Returns **TRUE** if render_work_area() is still rendering in the background
+     */
+    bool is_rendering_work_area();
+
     /**
      * @brief Set a project to load just after launching
      *
@@ -215,6 +223,29 @@ public slots:
      */
     void open_export_dialog();
 
+    /**
+     * @brief Render the active sequence's work area (or the whole sequence if there isn't one) into the render cache
+     *
+     * Renders in the background (see RenderCacheThread) and shows its progress in the status bar, the sequence can be
+     * played and edited in the meantime. Frames that are already cached are skipped. Replaces a render that's still
+     * running.
+     */
+    void render_work_area();
+
+    /**
+     * @brief Stop a render started by render_work_area()
+     *
+     * Waits for the frames that have already been rendered to be written to the cache.
+     */
+    void cancel_work_area_render();
+
+    /**
+     * @brief Fill the RAM preview with the active sequence's work area (or as much of it as fits) and play it
+     *
+     * Shows a progress dialog while rendering. Frames that are already buffered are skipped.
+     */
+    void ram_preview();
+
     /**
      * @brief Open the About Olive dialog.
      */
@@ -295,11 +326,31 @@ private:
      */
     void open_project_worker(const QString& fn, bool autorecovery);
 
+    /**
+     * @brief Get the range of the active sequence to render for render_work_area() and ram_preview()
+     *
+     * Shows a message and returns **FALSE** if there's no active sequence or nothing to render.
+     */
+    bool get_render_range(long* start, long* end);
+
+    /**
+     * @brief Run a RangeRenderThread on the active sequence behind a modal progress dialog
+     *
+     * Pauses playback and restores the playhead afterwards.
+     */
+    void run_range_render(RangeRenderThread* thread, const QString& title, const QString& label);
+
     /**
      * @brief File filter used for any file dialogs relating to Olive project files.
      */
     QString project_file_filter;
 
+    /**
+     * @brief File filters offered when saving a project, one per project format.
+     */
+    QString xml_project_file_filter;
+    QString binary_project_file_filter;
+
     /**
      * @brief Regular interval to save an auto-recovery project.
      */
@@ -315,7 +366,14 @@ private:
      */
     std::unique_ptr<QTranslator> translator;
 
+    /**
+     * @brief Background render started by render_work_area(), or nullptr if there isn't one
+     */
+    RenderCacheThread* work_area_render;
+
 private slots:
+    void work_area_render_progress(int value);
+    void work_area_render_finished();
 
 };
 
@@ -150,7 +150,7 @@ void EffectControls::copy(bool del) {
       Clip* c = olive::ActiveSequence->clips.at(selected_clips.at(i)).get();
       for (int j=0;j<c->effects.size();j++) {
         EffectPtr effect = c->effects.at(j);
-        if (effect->container->selected) {
+        if (effect->container != nullptr && effect->container->selected) {
           if (!cleared) {
             clear_clipboard();
             cleared = true;
@@ -291,7 +291,7 @@ void EffectControls::deselect_all_effects(QWidget* sender) {
   for (int i=0;i<selected_clips.size();i++) {
     const ClipPtr& c = olive::ActiveSequence->clips.at(selected_clips.at(i));
     for (int j=0;j<c->effects.size();j++) {
-      if (c->effects.at(j)->container != sender) {
+      if (c->effects.at(j)->container != nullptr && c->effects.at(j)->container != sender) {
         c->effects.at(j)->container->header_click(false, false);
       }
     }
@@ -300,6 +300,7 @@ void EffectControls::deselect_all_effects(QWidget* sender) {
 }
 
 void EffectControls::open_effect(QVBoxLayout* layout, EffectPtr e) {
+  e->create_ui();
   CollapsibleWidget* container = e->container;
   layout->addWidget(container);
   connect(container, SIGNAL(deselect_others(QWidget*)), this, SLOT(deselect_all_effects(QWidget*)));
@@ -578,7 +579,7 @@ void EffectControls::delete_effects() {
       Clip* c = olive::ActiveSequence->clips.at(selected_clips.at(i)).get();
       for (int j=0;j<c->effects.size();j++) {
         EffectPtr effect = c->effects.at(j);
-        if (effect->container->selected) {
+        if (effect->container != nullptr && effect->container->selected) {
           command->clips.append(c);
           command->fx.append(j);
         }
@@ -634,7 +635,7 @@ bool EffectControls::is_focused() {
     ClipPtr c = olive::ActiveSequence->clips.at(selected_clips.at(i));
     if (c != nullptr) {
       for (int j=0;j<c->effects.size();j++) {
-        if (c->effects.at(j)->container->is_focused()) {
+        if (c->effects.at(j)->container != nullptr && c->effects.at(j)->container->is_focused()) {
           return true;
         }
       }
@@ -127,9 +127,23 @@ void update_effect_controls() {
 void update_ui(bool modified) {
   if (modified) {
     update_effect_controls();
+
+    // the timeline and viewer redraw what an edit changed once olive::Invalidation reports it, so only refresh what
+    // isn't covered by the reported regions here
+    panel_timeline->repaint_after_edit();
+    panel_sequence_viewer->update_after_edit();
+  } else {
+    panel_timeline->repaint_timeline();
+    panel_sequence_viewer->update_viewer();
   }
   panel_effect_controls->update_keyframes();
-  panel_timeline->repaint_timeline();
+  panel_graph_editor->update_panel();
+}
+
+// same as update_ui(false) for when only the playhead of the active sequence has moved (e.g. during playback)
+void update_ui_playhead(long previous_playhead) {
+  panel_effect_controls->update_keyframes();
+  panel_timeline->repaint_playhead(previous_playhead);
   panel_sequence_viewer->update_viewer();
   panel_graph_editor->update_panel();
 }
@@ -35,6 +35,7 @@ extern Timeline* panel_timeline;
 extern GraphEditor* panel_graph_editor;
 
 void update_ui(bool modified);
+void update_ui_playhead(long previous_playhead);
 QDockWidget* get_focused_panel(bool force_hover = false);
 void alloc_panels(QWidget *parent);
 void free_panels();
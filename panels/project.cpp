@@ -29,12 +29,15 @@
 #include "mainwindow.h"
 #include "io/config.h"
 #include "rendering/cacher.h"
+#include "rendering/rampreview.h"
 #include "dialogs/replaceclipmediadialog.h"
 #include "panels/effectcontrols.h"
 #include "dialogs/newsequencedialog.h"
 #include "dialogs/mediapropertiesdialog.h"
 #include "dialogs/loaddialog.h"
 #include "io/clipboard.h"
+#include "io/projectsaver.h"
+#include "io/binaryproject.h"
 #include "ui/sourcetable.h"
 #include "ui/sourceiconview.h"
 #include "ui/icons.h"
@@ -75,6 +78,7 @@ const int kDefaultSequenceChannelLayout = 3;
 #define MAXIMUM_RECENT_PROJECTS 10 // FIXME: should be configurable
 
 QString autorecovery_filename;
+QString autorecovery_journal_filename;
 QStringList recent_projects;
 
 Project::Project(QWidget *parent) :
@@ -525,6 +529,19 @@ void Project::delete_selected_media() {
     all_top_level_items.append(olive::project_model.child(i));
   }
   get_all_media_from_table(all_top_level_items, sequence_items, MEDIA_TYPE_SEQUENCE); // find all sequences in project
+
+  // every sequence's clips need to be checked, but unloaded sequences only need to be loaded if they actually use
+  // something being deleted
+  QList<Media*> deleted_items;
+  get_all_media_from_table(items, deleted_items, -1);
+  for (int i=0;i<sequence_items.size();i++) {
+    SequencePtr s = sequence_items.at(i)->to_sequence();
+    for (int j=0;s->is_deferred() && j<deleted_items.size();j++) {
+      if (s->deferred_loader->uses_media(deleted_items.at(j))) {
+        s->load_deferred();
+      }
+    }
+  }
   if (sequence_items.size() > 0) {
     QList<Media*> media_items;
     get_all_media_from_table(items, media_items, MEDIA_TYPE_FOOTAGE);
@@ -700,7 +717,7 @@ void Project::process_file_list(QStringList& files, bool recursive, Media* repla
       QString file = files.at(i);
 
       // Check if the user is importing an Olive project file
-      if (file.endsWith(".ove", Qt::CaseInsensitive)) {
+      if (file.endsWith(".ove", Qt::CaseInsensitive) || olive::is_binary_project_filename(file)) {
 
         // This file is an Olive project file. Ask the user if they really want to import it.
         if (QMessageBox::question(this,
@@ -1018,6 +1035,9 @@ void Project::clear() {
     sequences.at(i)->set_sequence(nullptr);
   }
 
+  // free RAM preview frames of the old project
+  olive::ram_preview.Clear();
+
   // delete everything else
   olive::project_model.clear();
 
@@ -1042,259 +1062,55 @@ void Project::load_project(const QString& filename, bool autorecovery, bool clea
     new_project();
   }
 
+  // make sure any save still being written in the background has finished before reading project files
+  olive::project_saver.flush();
+
   LoadDialog ld(this, filename, autorecovery, clear);
   ld.exec();
 }
 
-void save_marker(QXmlStreamWriter& stream, const Marker& m) {
-  stream.writeStartElement("marker");
-  stream.writeAttribute("frame", QString::number(m.frame));
-  stream.writeAttribute("name", m.name);
-  stream.writeEndElement();
-}
-
-void Project::save_folder(QXmlStreamWriter& stream, int type, bool set_ids_only, const QModelIndex& parent) {
-  for (int i=0;i<olive::project_model.rowCount(parent);i++) {
-    const QModelIndex& item = olive::project_model.index(i, 0, parent);
-    Media* m = olive::project_model.getItem(item);
-
-    if (type == m->get_type()) {
-      if (m->get_type() == MEDIA_TYPE_FOLDER) {
-        if (set_ids_only) {
-          m->temp_id = folder_id; // saves a temporary ID for matching in the project file
-          folder_id++;
-        } else {
-          // if we're saving folders, save the folder
-          stream.writeStartElement("folder");
-          stream.writeAttribute("name", m->get_name());
-          stream.writeAttribute("id", QString::number(m->temp_id));
-          if (!item.parent().isValid()) {
-            stream.writeAttribute("parent", "0");
-          } else {
-            stream.writeAttribute("parent", QString::number(olive::project_model.getItem(item.parent())->temp_id));
-          }
-          stream.writeEndElement();
-        }
-        // save_folder(stream, item, type, set_ids_only);
-      } else {
-        int folder = m->parentItem()->temp_id;
-        if (type == MEDIA_TYPE_FOOTAGE) {
-          FootagePtr f = m->to_footage();
-          f->save_id = media_id;
-          stream.writeStartElement("footage");
-          stream.writeAttribute("id", QString::number(media_id));
-          stream.writeAttribute("folder", QString::number(folder));
-          stream.writeAttribute("name", f->name);
-          stream.writeAttribute("url", proj_dir.relativeFilePath(f->url));
-          stream.writeAttribute("duration", QString::number(f->length));
-          stream.writeAttribute("using_inout", QString::number(f->using_inout));
-          stream.writeAttribute("in", QString::number(f->in));
-          stream.writeAttribute("out", QString::number(f->out));
-          stream.writeAttribute("speed", QString::number(f->speed));
-          stream.writeAttribute("alphapremul", QString::number(f->alpha_is_premultiplied));
-          stream.writeAttribute("startnumber", QString::number(f->start_number));
-
-          stream.writeAttribute("proxy", QString::number(f->proxy));
-          stream.writeAttribute("proxypath", f->proxy_path);
-
-          // save video stream metadata
-          for (int j=0;j<f->video_tracks.size();j++) {
-            const FootageStream& ms = f->video_tracks.at(j);
-            stream.writeStartElement("video");
-            stream.writeAttribute("id", QString::number(ms.file_index));
-            stream.writeAttribute("width", QString::number(ms.video_width));
-            stream.writeAttribute("height", QString::number(ms.video_height));
-            stream.writeAttribute("framerate", QString::number(ms.video_frame_rate, 'f', 10));
-            stream.writeAttribute("infinite", QString::number(ms.infinite_length));
-            stream.writeEndElement(); // video
-          }
-
-          // save audio stream metadata
-          for (int j=0;j<f->audio_tracks.size();j++) {
-            const FootageStream& ms = f->audio_tracks.at(j);
-            stream.writeStartElement("audio");
-            stream.writeAttribute("id", QString::number(ms.file_index));
-            stream.writeAttribute("channels", QString::number(ms.audio_channels));
-            stream.writeAttribute("layout", QString::number(ms.audio_layout));
-            stream.writeAttribute("frequency", QString::number(ms.audio_frequency));
-            stream.writeEndElement(); // audio
-          }
-
-          // save footage markers
-          for (int j=0;j<f->markers.size();j++) {
-            save_marker(stream, f->markers.at(j));
-          }
-
-          stream.writeEndElement(); // footage
-          media_id++;
-        } else if (type == MEDIA_TYPE_SEQUENCE) {
-          SequencePtr s = m->to_sequence();
-          if (set_ids_only) {
-            s->save_id = sequence_id;
-            sequence_id++;
-          } else {
-            stream.writeStartElement("sequence");
-            stream.writeAttribute("id", QString::number(s->save_id));
-            stream.writeAttribute("folder", QString::number(folder));
-            stream.writeAttribute("name", s->name);
-            stream.writeAttribute("width", QString::number(s->width));
-            stream.writeAttribute("height", QString::number(s->height));
-            stream.writeAttribute("framerate", QString::number(s->frame_rate, 'f', 10));
-            stream.writeAttribute("afreq", QString::number(s->audio_frequency));
-            stream.writeAttribute("alayout", QString::number(s->audio_layout));
-            if (s == olive::ActiveSequence) {
-              stream.writeAttribute("open", "1");
-            }
-            stream.writeAttribute("workarea", QString::number(s->using_workarea));
-            stream.writeAttribute("workareaIn", QString::number(s->workarea_in));
-            stream.writeAttribute("workareaOut", QString::number(s->workarea_out));
-
-            QVector<TransitionPtr> transition_save_cache;
-            QVector<int> transition_clip_save_cache;
-
-            for (int j=0;j<s->clips.size();j++) {
-              const ClipPtr& c = s->clips.at(j);
-              if (c != nullptr) {
-                stream.writeStartElement("clip"); // clip
-                stream.writeAttribute("id", QString::number(j));
-                stream.writeAttribute("enabled", QString::number(c->enabled()));
-                stream.writeAttribute("name", c->name());
-                stream.writeAttribute("clipin", QString::number(c->clip_in()));
-                stream.writeAttribute("in", QString::number(c->timeline_in()));
-                stream.writeAttribute("out", QString::number(c->timeline_out()));
-                stream.writeAttribute("track", QString::number(c->track()));
-
-                stream.writeAttribute("r", QString::number(c->color().red()));
-                stream.writeAttribute("g", QString::number(c->color().green()));
-                stream.writeAttribute("b", QString::number(c->color().blue()));
-
-                stream.writeAttribute("autoscale", QString::number(c->autoscaled()));
-                stream.writeAttribute("speed", QString::number(c->speed().value, 'f', 10));
-                stream.writeAttribute("maintainpitch", QString::number(c->speed().maintain_audio_pitch));
-                stream.writeAttribute("reverse", QString::number(c->reversed()));
-
-                if (c->media() != nullptr) {
-                  stream.writeAttribute("type", QString::number(c->media()->get_type()));
-                  switch (c->media()->get_type()) {
-                  case MEDIA_TYPE_FOOTAGE:
-                    stream.writeAttribute("media", QString::number(c->media()->to_footage()->save_id));
-                    stream.writeAttribute("stream", QString::number(c->media_stream_index()));
-                    break;
-                  case MEDIA_TYPE_SEQUENCE:
-                    stream.writeAttribute("sequence", QString::number(c->media()->to_sequence()->save_id));
-                    break;
-                  }
-                }
-
-                // save markers
-                // only necessary for null media clips, since media has its own markers
-                if (c->media() == nullptr) {
-                  for (int k=0;k<c->get_markers().size();k++) {
-                    save_marker(stream, c->get_markers().at(k));
-                  }
-                }
-
-                // save clip links
-                stream.writeStartElement("linked"); // linked
-                for (int k=0;k<c->linked.size();k++) {
-                  stream.writeStartElement("link"); // link
-                  stream.writeAttribute("id", QString::number(c->linked.at(k)));
-                  stream.writeEndElement(); // link
-                }
-                stream.writeEndElement(); // linked
-
-                // save opening and closing transitions
-                for (int t=kTransitionOpening;t<=kTransitionClosing;t++) {
-                  TransitionPtr transition = (t == kTransitionOpening) ? c->opening_transition : c->closing_transition;
-
-                  if (transition != nullptr) {
-                    stream.writeStartElement((t == kTransitionOpening) ? "opening" : "closing");
-
-                    // check if this is a shared transition and the transition has already been saved
-                    int transition_cache_index = transition_save_cache.indexOf(transition);
-
-                    if (transition_cache_index > -1) {
-                      // if so, just save a reference to the other clip
-                      stream.writeAttribute("shared",
-                                            QString::number(transition_clip_save_cache.at(transition_cache_index)));
-                    } else {
-                      // otherwise save the whole transition
-                      transition->save(stream);
-                      transition_save_cache.append(transition);
-                      transition_clip_save_cache.append(j);
-                    }
-
-                    stream.writeEndElement(); // opening
-                  }
-                }
-
-                for (int k=0;k<c->effects.size();k++) {
-                  stream.writeStartElement("effect"); // effect
-                  c->effects.at(k)->save(stream);
-                  stream.writeEndElement(); // effect
-                }
-
-                stream.writeEndElement(); // clip
-              }
-            }
-            for (int j=0;j<s->markers.size();j++) {
-              save_marker(stream, s->markers.at(j));
-            }
-            stream.writeEndElement();
-          }
-        }
-      }
-    }
-
-    if (m->get_type() == MEDIA_TYPE_FOLDER) {
-      save_folder(stream, type, set_ids_only, item);
-    }
-  }
-}
-
 void Project::save_project(bool autorecovery) {
-  folder_id = 1;
-  media_id = 1;
-  sequence_id = 1;
-
-  QFile file(autorecovery ? autorecovery_filename : olive::ActiveProjectFilename);
-  if (!file.open(QIODevice::WriteOnly)) {
-    qCritical() << "Could not open file";
-    return;
+  // gather all project items in one pass, in the same order they appear in the project
+  QVector<Media*> folders;
+  QVector<Media*> footage;
+  QVector<Media*> sequences;
+  list_all_media_worker(&folders, &footage, &sequences, nullptr);
+
+  // assign IDs used to cross-reference items in the project file (0 is the root folder)
+  for (int i=0;i<folders.size();i++) {
+    folders.at(i)->temp_id = i + 1;
+  }
+  for (int i=0;i<footage.size();i++) {
+    footage.at(i)->to_footage()->save_id = i + 1;
+  }
+  for (int i=0;i<sequences.size();i++) {
+    sequences.at(i)->to_sequence()->save_id = i + 1;
   }
 
-  QXmlStreamWriter stream(&file);
-  stream.setAutoFormatting(true);
-  stream.writeStartDocument(); // doc
-
-  stream.writeStartElement("project"); // project
-
-  stream.writeTextElement("version", QString::number(olive::kSaveVersion));
-
-  stream.writeTextElement("url", olive::ActiveProjectFilename);
-  proj_dir = QFileInfo(olive::ActiveProjectFilename).absoluteDir();
-
-  save_folder(stream, MEDIA_TYPE_FOLDER, true);
-
-  stream.writeStartElement("folders"); // folders
-  save_folder(stream, MEDIA_TYPE_FOLDER, false);
-  stream.writeEndElement(); // folders
-
-  stream.writeStartElement("media"); // media
-  save_folder(stream, MEDIA_TYPE_FOOTAGE, false);
-  stream.writeEndElement(); // media
-
-  save_folder(stream, MEDIA_TYPE_SEQUENCE, true);
-
-  stream.writeStartElement("sequences"); // sequences
-  save_folder(stream, MEDIA_TYPE_SEQUENCE, false);
-  stream.writeEndElement();// sequences
+  // Copy the project into plain data. This is the only part of saving that needs the live project, so it's the only
+  // part done on the main thread. Serializing and writing to disk is handled by ProjectSaver in the background.
+  ProjectSnapshot snapshot;
+  snapshot.filename = autorecovery ? autorecovery_journal_filename : olive::ActiveProjectFilename;
+  snapshot.autorecovery = autorecovery;
+  snapshot.binary = !autorecovery && olive::is_binary_project_filename(olive::ActiveProjectFilename);
+  snapshot.project_url = olive::ActiveProjectFilename;
+
+  snapshot.folders.resize(folders.size());
+  for (int i=0;i<folders.size();i++) {
+    snapshot.folders[i] = olive::snapshot_folder(folders.at(i));
+  }
 
-  stream.writeEndElement(); // project
+  snapshot.footage.resize(footage.size());
+  for (int i=0;i<footage.size();i++) {
+    snapshot.footage[i] = olive::snapshot_footage(footage.at(i));
+  }
 
-  stream.writeEndDocument(); // doc
+  snapshot.sequences.resize(sequences.size());
+  for (int i=0;i<sequences.size();i++) {
+    snapshot.sequences[i] = olive::snapshot_sequence(sequences.at(i));
+  }
 
-  file.close();
+  olive::project_saver.queue(snapshot);
 
   if (!autorecovery) {
     add_recent_project(olive::ActiveProjectFilename);
@@ -1399,6 +1215,27 @@ void Project::list_all_sequences_worker(QVector<Media*>* list, Media* parent) {
   }
 }
 
+void Project::list_all_media_worker(QVector<Media*>* folders,
+                                    QVector<Media*>* footage,
+                                    QVector<Media*>* sequences,
+                                    Media* parent) {
+  for (int i=0;i<olive::project_model.childCount(parent);i++) {
+    Media* item = olive::project_model.child(i, parent);
+    switch (item->get_type()) {
+    case MEDIA_TYPE_FOLDER:
+      folders->append(item);
+      list_all_media_worker(folders, footage, sequences, item);
+      break;
+    case MEDIA_TYPE_FOOTAGE:
+      footage->append(item);
+      break;
+    case MEDIA_TYPE_SEQUENCE:
+      sequences->append(item);
+      break;
+    }
+  }
+}
+
 QVector<Media*> Project::list_all_project_sequences() {
   QVector<Media*> list;
   list_all_sequences_worker(&list, nullptr);
@@ -43,6 +43,7 @@
 #define LOAD_TYPE_URL 70
 
 extern QString autorecovery_filename;
+extern QString autorecovery_journal_filename;
 extern QStringList recent_projects;
 
 SequencePtr create_sequence_from_media(QVector<Media *> &media_list);
@@ -104,13 +105,9 @@ public slots:
   void new_folder();
   void new_sequence();
 private:
-  void save_folder(QXmlStreamWriter& stream, int type, bool set_ids_only, const QModelIndex &parent = QModelIndex());
-  int folder_id;
-  int media_id;
-  int sequence_id;
   void list_all_sequences_worker(QVector<Media *> *list, Media* parent);
+  void list_all_media_worker(QVector<Media*>* folders, QVector<Media*>* footage, QVector<Media*>* sequences, Media* parent);
   QString get_file_name_from_path(const QString &path);
-  QDir proj_dir;
   QWidget* icon_view_container;
   QPushButton* directory_up;
   QLineEdit* toolbar_search;
@@ -55,6 +55,7 @@
 #include <QHBoxLayout>
 #include <QSplitter>
 #include <QStatusBar>
+#include <algorithm>
 
 int olive::timeline::kTrackDefaultHeight = 40;
 int olive::timeline::kTrackMinHeight = 30;
@@ -113,6 +114,10 @@ Timeline::Timeline(QWidget *parent) :
   connect(videoScrollbar, SIGNAL(valueChanged(int)), video_area, SLOT(setScroll(int)));
   connect(audioScrollbar, SIGNAL(valueChanged(int)), audio_area, SLOT(setScroll(int)));
   connect(horizontalScrollBar, SIGNAL(resize_move(double)), this, SLOT(resize_move(double)));
+  connect(&olive::Invalidation,
+          SIGNAL(regions_invalidated(const QVector<InvalidatedRegion>&)),
+          this,
+          SLOT(regions_invalidated(const QVector<InvalidatedRegion>&)));
 
   update_sequence();
 
@@ -142,38 +147,15 @@ void Timeline::Retranslate() {
 void Timeline::previous_cut() {
   if (olive::ActiveSequence != nullptr
       && olive::ActiveSequence->playhead > 0) {
-    long p_cut = 0;
-    for (int i=0;i<olive::ActiveSequence->clips.size();i++) {
-      ClipPtr c = olive::ActiveSequence->clips.at(i);
-      if (c != nullptr) {
-        if (c->timeline_out() > p_cut && c->timeline_out() < olive::ActiveSequence->playhead) {
-          p_cut = c->timeline_out();
-        } else if (c->timeline_in() > p_cut && c->timeline_in() < olive::ActiveSequence->playhead) {
-          p_cut = c->timeline_in();
-        }
-      }
-    }
+    long p_cut = qMax(0L, olive::ActiveSequence->clip_index.PreviousEditPoint(olive::ActiveSequence->playhead));
     panel_sequence_viewer->seek(p_cut);
   }
 }
 
 void Timeline::next_cut() {
   if (olive::ActiveSequence != nullptr) {
-    bool seek_enabled = false;
-    long n_cut = LONG_MAX;
-    for (int i=0;i<olive::ActiveSequence->clips.size();i++) {
-      ClipPtr c = olive::ActiveSequence->clips.at(i);
-      if (c != nullptr) {
-        if (c->timeline_in() < n_cut && c->timeline_in() > olive::ActiveSequence->playhead) {
-          n_cut = c->timeline_in();
-          seek_enabled = true;
-        } else if (c->timeline_out() < n_cut && c->timeline_out() > olive::ActiveSequence->playhead) {
-          n_cut = c->timeline_out();
-          seek_enabled = true;
-        }
-      }
-    }
-    if (seek_enabled) panel_sequence_viewer->seek(n_cut);
+    long n_cut = olive::ActiveSequence->clip_index.NextEditPoint(olive::ActiveSequence->playhead);
+    if (n_cut > -1) panel_sequence_viewer->seek(n_cut);
   }
 }
 
@@ -487,34 +469,55 @@ bool Timeline::focused() {
   return (olive::ActiveSequence != nullptr && (headers->hasFocus() || video_area->hasFocus() || audio_area->hasFocus()));
 }
 
-void Timeline::repaint_timeline() {
-  if (!block_repaints) {
-    bool draw = true;
-
-    if (olive::ActiveSequence != nullptr
-        && !horizontalScrollBar->isSliderDown()
-        && !horizontalScrollBar->is_resizing()
-        && panel_sequence_viewer->playing
-        && !zoom_just_changed) {
-      // auto scroll
-      if (olive::CurrentConfig.autoscroll == olive::AUTOSCROLL_PAGE_SCROLL) {
-        int playhead_x = getTimelineScreenPointFromFrame(olive::ActiveSequence->playhead);
-        if (playhead_x < 0 || playhead_x > (editAreas->width() - videoScrollbar->width())) {
-          horizontalScrollBar->setValue(getScreenPointFromFrame(zoom, olive::ActiveSequence->playhead));
-          draw = false;
-        }
-      } else if (olive::CurrentConfig.autoscroll == olive::AUTOSCROLL_SMOOTH_SCROLL) {
-        if (center_scroll_to_playhead(horizontalScrollBar, zoom, olive::ActiveSequence->playhead)) {
-          draw = false;
-        }
+bool Timeline::autoscroll_to_playhead() {
+  if (olive::ActiveSequence != nullptr
+      && !horizontalScrollBar->isSliderDown()
+      && !horizontalScrollBar->is_resizing()
+      && panel_sequence_viewer->playing
+      && !zoom_just_changed) {
+    // auto scroll
+    if (olive::CurrentConfig.autoscroll == olive::AUTOSCROLL_PAGE_SCROLL) {
+      int playhead_x = getTimelineScreenPointFromFrame(olive::ActiveSequence->playhead);
+      if (playhead_x < 0 || playhead_x > (editAreas->width() - videoScrollbar->width())) {
+        horizontalScrollBar->setValue(getScreenPointFromFrame(zoom, olive::ActiveSequence->playhead));
+        return true;
+      }
+    } else if (olive::CurrentConfig.autoscroll == olive::AUTOSCROLL_SMOOTH_SCROLL) {
+      if (center_scroll_to_playhead(horizontalScrollBar, zoom, olive::ActiveSequence->playhead)) {
+        return true;
       }
     }
+  }
+  return false;
+}
+
+static bool selections_equal(const QVector<Selection>& a, const QVector<Selection>& b) {
+  if (a.size() != b.size()) {
+    return false;
+  }
+  for (int i=0;i<a.size();i++) {
+    if (a.at(i).in != b.at(i).in
+        || a.at(i).out != b.at(i).out
+        || a.at(i).track != b.at(i).track) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void Timeline::repaint_timeline() {
+  if (!block_repaints) {
+    bool draw = !autoscroll_to_playhead();
 
     if (draw) {
       headers->update();
       video_area->update();
       audio_area->update();
 
+      if (olive::ActiveSequence != nullptr) {
+        repainted_selections = olive::ActiveSequence->selections;
+      }
+
       if (olive::ActiveSequence != nullptr
           && !zoom_just_changed) {
         set_sb_max();
@@ -525,6 +528,84 @@ void Timeline::repaint_timeline() {
   }
 }
 
+void Timeline::repaint_playhead(long previous_playhead) {
+  // the recording clip grows with the playhead, and zoom changes need set_sb_max(), so those need a full repaint
+  if (olive::ActiveSequence == nullptr
+      || panel_sequence_viewer->is_recording_cued()
+      || zoom_just_changed) {
+    repaint_timeline();
+    return;
+  }
+
+  // scrolling repaints everything anyway
+  if (!block_repaints && !autoscroll_to_playhead()) {
+    headers->update();
+
+    // cover the playhead line and its single frame highlight at both positions
+    long playhead = olive::ActiveSequence->playhead;
+    int left = getTimelineScreenPointFromFrame(qMin(previous_playhead, playhead)) - 1;
+    int right = getTimelineScreenPointFromFrame(qMax(previous_playhead, playhead) + 1) + 1;
+
+    video_area->update(left, 0, right - left + 1, video_area->height());
+    audio_area->update(left, 0, right - left + 1, audio_area->height());
+  }
+}
+
+void Timeline::repaint_after_edit() {
+  if (block_repaints) {
+    return;
+  }
+
+  if (olive::ActiveSequence == nullptr) {
+    repaint_timeline();
+    return;
+  }
+
+  // selections are drawn over the whole timeline but aren't part of what olive::Invalidation reports
+  if (!selections_equal(olive::ActiveSequence->selections, repainted_selections)) {
+    repaint_timeline();
+    return;
+  }
+
+  // the edit may have changed the sequence's length or track count
+  headers->update();
+  set_sb_max();
+}
+
+void Timeline::regions_invalidated(const QVector<InvalidatedRegion> &regions) {
+  if (olive::ActiveSequence == nullptr || block_repaints) {
+    return;
+  }
+
+  // clamp regions to the visible frames so open-ended ones don't overflow screen coordinates
+  long first_visible = getFrameFromScreenPoint(zoom, scroll);
+  long last_visible = getFrameFromScreenPoint(zoom, scroll + video_area->width()) + 1;
+
+  for (int i=0;i<regions.size();i++) {
+    const InvalidatedRegion& r = regions.at(i);
+
+    if (r.sequence != olive::ActiveSequence.get()) {
+      continue;
+    }
+
+    long in = qMax(r.in, first_visible);
+    long out = qMin(r.out, last_visible);
+    if (in > out) {
+      continue;
+    }
+
+    int left = getTimelineScreenPointFromFrame(in) - 1;
+    int right = getTimelineScreenPointFromFrame(out) + 1;
+
+    if (r.track == olive::kAllTracks || r.track < 0) {
+      video_area->update(left, 0, right - left + 1, video_area->height());
+    }
+    if (r.track == olive::kAllTracks || r.track >= 0) {
+      audio_area->update(left, 0, right - left + 1, audio_area->height());
+    }
+  }
+}
+
 void Timeline::select_all() {
   if (olive::ActiveSequence != nullptr) {
     olive::ActiveSequence->selections.clear();
@@ -1592,27 +1673,26 @@ bool Timeline::snap_to_timeline(long* l, bool use_playhead, bool use_markers, bo
       if (snap_to_point(olive::ActiveSequence->workarea_out, l)) return true;
     }
 
-    // snap to clip/transition
-    for (int i=0;i<olive::ActiveSequence->clips.size();i++) {
-      ClipPtr c = olive::ActiveSequence->clips.at(i);
-      if (c != nullptr) {
-        if (snap_to_point(c->timeline_in(), l)) {
-          return true;
-        } else if (snap_to_point(c->timeline_out(), l)) {
-          return true;
-        } else if (c->opening_transition != nullptr
-                   && snap_to_point(c->timeline_in() + c->opening_transition->get_true_length(), l)) {
-          return true;
-        } else if (c->closing_transition != nullptr
-                   && snap_to_point(c->timeline_out() - c->closing_transition->get_true_length(), l)) {
+    int limit = get_snap_range();
+
+    // snap to the closest clip in/out point or transition
+    long clip_point;
+    if (olive::ActiveSequence->clip_index.GetSnapPoint(*l, limit, &clip_point)
+        && snap_to_point(clip_point, l)) {
+      return true;
+    }
+
+    // snap to clip markers, only clips within snapping range of this point can have visible markers there
+    QVector<int> candidates = olive::ActiveSequence->clip_index.ClipsInRange(*l - limit - 1, *l + limit + 1);
+
+    // keep the same priority as the order of the sequence's clips
+    std::sort(candidates.begin(), candidates.end());
+
+    for (int i=0;i<candidates.size();i++) {
+      ClipPtr c = olive::ActiveSequence->clips.at(candidates.at(i));
+      for (int j=0;j<c->get_markers().size();j++) {
+        if (snap_to_point(c->get_markers().at(j).frame + c->timeline_in() - c->clip_in(), l)) {
           return true;
-        } else {
-          // try to snap to clip markers
-          for (int j=0;j<c->get_markers().size();j++) {
-            if (snap_to_point(c->get_markers().at(j).frame + c->timeline_in() - c->clip_in(), l)) {
-              return true;
-            }
-          }
         }
       }
     }
@@ -30,6 +30,7 @@
 #include "project/selection.h"
 #include "project/clip.h"
 #include "project/undo.h"
+#include "project/invalidation.h"
 #include "ui/timelineheader.h"
 #include "ui/resizablescrollbar.h"
 #include "ui/audiomonitor.h"
@@ -225,6 +226,14 @@ public:
   void scroll_to_frame(long frame);
   void select_from_playhead();
 
+  // cheaper alternative to repaint_timeline() for when nothing but the playhead moved (e.g. during playback), only
+  // redraws the area between the previous and current playhead
+  void repaint_playhead(long previous_playhead);
+
+  // alternative to repaint_timeline() after an edit, the clips that changed are redrawn through regions_invalidated()
+  // so this only updates the headers and scrollbars, and redraws everything only if the selections changed
+  void repaint_after_edit();
+
   bool can_ripple_empty_space(long frame, int track);
 
   virtual void Retranslate() override;
@@ -272,8 +281,12 @@ private slots:
   void transition_menu_select(QAction*);
   void resize_move(double d);
   void set_tool();
+  void regions_invalidated(const QVector<InvalidatedRegion>& regions);
 
 private:
+  // scrolls to follow the playhead during playback, returns true if the timeline was scrolled
+  bool autoscroll_to_playhead();
+
   void ChangeTrackHeightUniformly(int diff);
   void set_zoom_value(double v);
   QVector<QPushButton*> tool_buttons;
@@ -283,6 +296,9 @@ private:
   void set_sb_max();
   void UpdateTitle();
 
+  // selections as of the last full repaint, used by repaint_after_edit() to tell whether they need to be redrawn
+  QVector<Selection> repainted_selections;
+
   void setup_ui();
 
   // ripple delete empty space variables
@@ -33,12 +33,14 @@
 #include "project/undo.h"
 #include "ui/audiomonitor.h"
 #include "rendering/renderfunctions.h"
+#include "rendering/rendercache.h"
 #include "ui/viewercontainer.h"
 #include "ui/labelslider.h"
 #include "ui/timelineheader.h"
 #include "ui/resizablescrollbar.h"
 #include "ui/icons.h"
 #include "oliveglobal.h"
+#include "mainwindow.h"
 #include "debug.h"
 
 #define FRAMES_IN_ONE_MINUTE 1798 // 1800 - 2
@@ -56,6 +58,7 @@ extern "C" {
 #include <QTimer>
 #include <QHBoxLayout>
 #include <QPushButton>
+#include <QStatusBar>
 
 Viewer::Viewer(QWidget *parent) :
   Panel(parent),
@@ -66,7 +69,11 @@ Viewer::Viewer(QWidget *parent) :
   created_sequence(false),
   minimum_zoom(1.0),
   cue_recording_internal(false),
-  playback_speed(0)
+  scrubbing_(false),
+  playback_speed(0),
+  last_presented_frame_(-1),
+  dropped_frames_(0),
+  repeated_frames_(0)
 {
   setup_ui();
 
@@ -87,8 +94,19 @@ Viewer::Viewer(QWidget *parent) :
 
   recording_flasher.setInterval(500);
 
+  scrub_timer.setSingleShot(true);
+  scrub_timer.setInterval(250);
+
+  // RAM preview frames are shown as soon as the playhead moves, so a coarse timer would show up as uneven frame pacing
+  playback_updater.setTimerType(Qt::PreciseTimer);
+
   connect(&playback_updater, SIGNAL(timeout()), this, SLOT(timer_update()));
   connect(&recording_flasher, SIGNAL(timeout()), this, SLOT(recording_flasher_update()));
+  connect(&scrub_timer, SIGNAL(timeout()), this, SLOT(scrub_timer_update()));
+  connect(&olive::Invalidation,
+          SIGNAL(regions_invalidated(const QVector<InvalidatedRegion>&)),
+          this,
+          SLOT(regions_invalidated(const QVector<InvalidatedRegion>&)));
   connect(horizontal_bar, SIGNAL(valueChanged(int)), headers, SLOT(set_scroll(int)));
   connect(horizontal_bar, SIGNAL(valueChanged(int)), viewer_widget, SLOT(set_waveform_scroll(int)));
   connect(horizontal_bar, SIGNAL(resize_move(double)), this, SLOT(resize_move(double)));
@@ -272,6 +290,12 @@ bool frame_rate_is_droppable(double rate) {
 
 void Viewer::seek(long p) {
   pause();
+
+  // seeks arriving in quick succession (e.g. dragging the playhead or holding a frame step key) are treated as
+  // scrubbing, which lets the proxy policy favor speed until they stop
+  scrubbing_ = scrub_timer.isActive();
+  scrub_timer.start();
+
   if (main_sequence) {
     seq->playhead = p;
   } else {
@@ -415,7 +439,11 @@ void Viewer::play(bool in_to_out) {
     playing = true;
     just_played_ = true;
     set_playpause_icon(false);
-    start_msecs = QDateTime::currentMSecsSinceEpoch();
+    playback_clock.Start(playhead_start, seq->frame_rate, playback_speed);
+    last_presented_frame_ = -1;
+
+    // frames are rendered ahead of the playhead and shown by ViewerWidget when they're due
+    viewer_widget->get_renderer()->set_deferred_present(true);
 
     timer_update();
   }
@@ -423,7 +451,7 @@ void Viewer::play(bool in_to_out) {
 
 void Viewer::play_wake() {
   if (just_played_) {
-    start_msecs = QDateTime::currentMSecsSinceEpoch();
+    playback_clock.Start(playhead_start, seq->frame_rate, playback_speed);
     playback_updater.start();
     if (audio_thread != nullptr) audio_thread->notifyReceiver();
     just_played_ = false;
@@ -431,6 +459,20 @@ void Viewer::play_wake() {
 }
 
 void Viewer::pause() {
+  if (playing) {
+    viewer_widget->get_renderer()->set_deferred_present(false);
+    viewer_widget->update();
+
+    if (dropped_frames_ > 0 || repeated_frames_ > 0) {
+      qInfo() << "Playback dropped" << dropped_frames_ << "frames and repeated" << repeated_frames_;
+      olive::MainWindow->statusBar()->showMessage(tr("Playback dropped %1 frame(s) and repeated %2 frame(s)")
+                                                  .arg(dropped_frames_)
+                                                  .arg(repeated_frames_), 5000);
+    }
+    dropped_frames_ = 0;
+    repeated_frames_ = 0;
+  }
+
   playing = false;
   just_played_ = false;
   set_playpause_icon(true);
@@ -473,11 +515,43 @@ void Viewer::pause() {
   }
 }
 
+void Viewer::frame_presented(long frame) {
+  if (last_presented_frame_ >= 0 && playback_speed != 0) {
+    long skipped = (frame - last_presented_frame_) / playback_speed - 1;
+    if (skipped > 0) {
+      dropped_frames_ += int(skipped);
+    }
+  }
+  last_presented_frame_ = frame;
+}
+
+long Viewer::last_presented_frame() {
+  return last_presented_frame_;
+}
+
+int Viewer::dropped_frames() {
+  return dropped_frames_;
+}
+
+int Viewer::repeated_frames() {
+  return repeated_frames_;
+}
+
 bool Viewer::WaitingForPlayWake()
 {
   return just_played_;
 }
 
+olive::PlaybackState Viewer::playback_state()
+{
+  if (playing) {
+    return olive::kPlaybackPlaying;
+  } else if (scrubbing_) {
+    return olive::kPlaybackScrubbing;
+  }
+  return olive::kPlaybackPaused;
+}
+
 void Viewer::update_playhead_timecode(long p) {
   current_timecode_slider->set_value(p, false);
 }
@@ -503,6 +577,12 @@ void Viewer::update_header_zoom() {
 void Viewer::update_parents(bool reload_fx) {
   if (main_sequence) {
     update_ui(reload_fx);
+
+    // moving the playhead isn't an edit, so no invalidated region will redraw the frame or mix audio for it -
+    // update_ui(true) only reloads the effect controls and selections here
+    if (reload_fx) {
+      viewer_widget->frame_update();
+    }
   } else {
     update_viewer();
     panel_timeline->repaint_timeline();
@@ -526,14 +606,94 @@ void Viewer::resizeEvent(QResizeEvent *e) {
 }
 
 void Viewer::update_viewer() {
-  update_header_zoom();
   viewer_widget->frame_update();
+  update_after_edit();
+}
+
+void Viewer::update_after_edit() {
+  update_header_zoom();
   if (seq != nullptr) {
     update_playhead_timecode(seq->playhead);
   }
   update_end_timecode();
 }
 
+void Viewer::regions_invalidated(const QVector<InvalidatedRegion>& regions) {
+  if (seq == nullptr) {
+    return;
+  }
+
+  // while playing, the audio buffer holds mixed audio from the playhead up to the end of the buffer
+  long audio_buffer_end = seq->playhead;
+  if (playing) {
+    int bytes_per_sample = av_get_bytes_per_sample(AV_SAMPLE_FMT_S16)*av_get_channel_layout_nb_channels(AV_CH_LAYOUT_STEREO);
+    double bytes_per_frame = double(current_audio_freq()) * bytes_per_sample / seq->frame_rate;
+    audio_buffer_end += qCeil(double(audio_ibuffer_size) / bytes_per_frame);
+  }
+
+  bool frame_changed = false;
+  bool audio_changed = false;
+
+  // clips that are visible or buffered, in case a region is in a sequence they nest
+  QVector<int> current_clips;
+  bool current_clips_found = false;
+
+  for (int i=0;i<regions.size();i++) {
+    const InvalidatedRegion& r = regions.at(i);
+
+    if (r.sequence == seq.get()) {
+
+      if (r.contains(seq.get(), seq->playhead, true, false)) {
+        frame_changed = true;
+      }
+
+      if (playing && r.overlaps(seq.get(), seq->playhead, audio_buffer_end, false, true)) {
+        audio_changed = true;
+      }
+
+    } else {
+
+      if (!current_clips_found) {
+        current_clips = seq->clip_index.ClipsInRange(seq->playhead, qMax(seq->playhead + 1, audio_buffer_end));
+        current_clips_found = true;
+      }
+
+      // the nesting clip's whole range counts as changed, same as RenderCache does
+      for (int j=0;j<current_clips.size();j++) {
+        if (current_clips.at(j) >= seq->clips.size()) {
+          continue;
+        }
+
+        Clip* c = seq->clips.at(current_clips.at(j)).get();
+
+        if (c == nullptr || !RenderCache::clip_nests_sequence(c, r.sequence, 0)) {
+          continue;
+        }
+
+        if (c->track() < 0) {
+          if ((r.track == olive::kAllTracks || r.track < 0)
+              && seq->playhead >= c->timeline_in(true)
+              && seq->playhead < c->timeline_out(true)) {
+            frame_changed = true;
+          }
+        } else if (playing && (r.track == olive::kAllTracks || r.track >= 0)) {
+          audio_changed = true;
+        }
+      }
+
+    }
+  }
+
+  // only throw away audio that's already been mixed if the edit actually touched it
+  if (audio_changed) {
+    reset_all_audio();
+  }
+
+  if (frame_changed) {
+    viewer_widget->frame_update();
+  }
+}
+
 void Viewer::clear_in() {
   if (seq != nullptr
       && seq->using_workarea) {
@@ -804,11 +964,23 @@ void Viewer::update_playhead() {
 void Viewer::timer_update() {
   previous_playhead = seq->playhead;
 
-  seq->playhead = qMax(0, qRound(playhead_start + ((QDateTime::currentMSecsSinceEpoch()-start_msecs) * 0.001 * seq->frame_rate * playback_speed)));
-  if (olive::CurrentConfig.seek_also_selects) panel_timeline->select_from_playhead();
-  update_parents(olive::CurrentConfig.seek_also_selects);
+  seq->playhead = qMax(0L, playback_clock.GetFrame());
+  if (olive::CurrentConfig.seek_also_selects) {
+    panel_timeline->select_from_playhead();
+    update_parents(true);
+  } else if (main_sequence) {
+    // only the playhead moved, so the timeline doesn't need to redraw every clip
+    update_ui_playhead(previous_playhead);
+  } else {
+    update_parents();
+  }
 
   if (playing) {
+    // a new frame is due but the one on screen couldn't be replaced in time
+    if (!just_played_ && seq->playhead != previous_playhead && last_presented_frame_ != seq->playhead) {
+      repeated_frames_++;
+    }
+
     if (playback_speed < 0 && seq->playhead == 0) {
       pause();
     } else if (recording) {
@@ -843,6 +1015,14 @@ void Viewer::resize_move(double d) {
   set_zoom_value(headers->get_zoom()*d);
 }
 
+void Viewer::scrub_timer_update() {
+  if (scrubbing_) {
+    // scrubbing has stopped, redraw the current frame at full quality
+    scrubbing_ = false;
+    update_viewer();
+  }
+}
+
 void Viewer::clean_created_seq() {
   viewer_widget->waveform = false;
 
@@ -869,6 +1049,10 @@ void Viewer::set_sequence(bool main, SequencePtr s) {
   main_sequence = main;
   seq = (main) ? olive::ActiveSequence : s;
 
+  if (seq != nullptr) {
+    seq->load_deferred();
+  }
+
   bool null_sequence = (seq == nullptr);
 
   headers->setEnabled(!null_sequence);
@@ -35,6 +35,9 @@
 #include "ui/timelineheader.h"
 #include "ui/labelslider.h"
 #include "ui/resizablescrollbar.h"
+#include "rendering/proxypolicy.h"
+#include "rendering/playbackclock.h"
+#include "project/invalidation.h"
 
 bool frame_rate_is_droppable(double rate);
 long timecode_to_frame(const QString& s, int view, double frame_rate);
@@ -70,11 +73,32 @@ public:
   void play(bool in_to_out = false);
   void pause();
   bool WaitingForPlayWake();
+  olive::PlaybackState playback_state();
   bool playing;
   long playhead_start;
-  qint64 start_msecs;
+  PlaybackClock playback_clock;
   QTimer playback_updater;
 
+  /**
+   * @brief Called by ViewerWidget when a frame is shown during playback, to keep track of dropped frames
+   */
+  void frame_presented(long frame);
+
+  /**
+   * @brief Get the last frame shown during playback, or -1 if none has been shown yet
+   */
+  long last_presented_frame();
+
+  /**
+   * @brief Get the number of frames that were never shown because rendering fell behind since playback started
+   */
+  int dropped_frames();
+
+  /**
+   * @brief Get the number of times a frame stayed on screen past its time since playback started
+   */
+  int repeated_frames();
+
 
   void cue_recording(long start, long end, int track);
   void uncue_recording();
@@ -116,11 +140,17 @@ public slots:
   void close_media();
   void update_viewer();
 
+  // alternative to update_viewer() after an edit, leaves redrawing the frame to regions_invalidated() and only updates
+  // the header and timecodes
+  void update_after_edit();
+
 private slots:
   void update_playhead();
   void timer_update();
   void recording_flasher_update();
   void resize_move(double d);
+  void scrub_timer_update();
+  void regions_invalidated(const QVector<InvalidatedRegion>& regions);
 
 private:
 
@@ -158,8 +188,17 @@ private:
   bool cue_recording_internal;
   QTimer recording_flasher;
 
+  // seeks in quick succession count as scrubbing until this timer runs out
+  QTimer scrub_timer;
+  bool scrubbing_;
+
   long previous_playhead;
   int playback_speed;
+
+  // playback statistics, see frame_presented()
+  long last_presented_frame_;
+  int dropped_frames_;
+  int repeated_frames_;
 };
 
 #endif // VIEWER_H
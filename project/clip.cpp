@@ -40,7 +40,9 @@ const int kRGBAComponentCount = 4;
 
 Clip::Clip(SequencePtr s) :
   sequence(s),
-  cacher(this)
+  cacher(this),
+  image_effects(this),
+  last_retrieved_frame(-1)
 {
   enabled_ = true;
   clip_in_ = 0;
@@ -57,7 +59,10 @@ Clip::Clip(SequencePtr s) :
   undeletable = false;
   replaced = false;
   fbo = nullptr;
+  texture_frame = -1;
+  nest_cache_valid = false;
   open_ = false;
+  use_proxy_ = false;
 
   reset();
 }
@@ -143,6 +148,11 @@ void Clip::set_media(Media *m, int s)
 {
   media_ = m;
   media_stream_ = s;
+
+  // a nested sequence needs its clips to be rendered
+  if (media_ != nullptr && media_->get_type() == MEDIA_TYPE_SEQUENCE) {
+    media_->to_sequence()->load_deferred();
+  }
 }
 
 bool Clip::enabled()
@@ -236,6 +246,8 @@ Clip::~Clip() {
     Close(true);
   }
 
+  image_effects.Reset();
+
   effects.clear();
 }
 
@@ -263,6 +275,7 @@ long Clip::timeline_in(bool with_transition) {
 void Clip::set_timeline_in(long t)
 {
   timeline_in_ = t;
+  invalidate_index();
 }
 
 long Clip::timeline_out(bool with_transitions) {
@@ -277,6 +290,7 @@ long Clip::timeline_out(bool with_transitions) {
 void Clip::set_timeline_out(long t)
 {
   timeline_out_ = t;
+  invalidate_index();
 }
 
 bool Clip::reversed()
@@ -342,6 +356,13 @@ int Clip::track()
 void Clip::set_track(int t)
 {
   track_ = t;
+  invalidate_index();
+}
+
+void Clip::invalidate_index() {
+  if (sequence != nullptr) {
+    sequence->clip_index.invalidate_clip(this);
+  }
 }
 
 // timeline functions
@@ -486,6 +507,9 @@ void Clip::Close(bool wait) {
     delete texture;
     texture = nullptr;
 
+    // make sure no image effects are running on another thread before closing them
+    image_effects.Reset();
+
     // close all effects
     for (int i=0;i<effects.size();i++) {
       if (effects.at(i)->is_open()) {
@@ -495,8 +519,9 @@ void Clip::Close(bool wait) {
 
     // delete framebuffers
     if (fbo != nullptr) {
-      // delete 3 fbos for nested sequences, 2 for most clips
-      int fbo_count = (media() != nullptr && media()->get_type() == MEDIA_TYPE_SEQUENCE) ? 3 : 2;
+      // 4 fbos for nested sequences, 2 for most clips. Working fbos are returned to the render thread's pool after
+      // every frame so usually only the nest cache is left here.
+      int fbo_count = (media() != nullptr && media()->get_type() == MEDIA_TYPE_SEQUENCE) ? 4 : 2;
 
       for (int j=0;j<fbo_count;j++) {
         delete fbo[j];
@@ -504,6 +529,8 @@ void Clip::Close(bool wait) {
 
       delete [] fbo;
 
+      nest_cache_valid = false;
+
       fbo = nullptr;
     }
 
@@ -520,6 +547,43 @@ bool Clip::IsOpen()
   return open_;
 }
 
+bool Clip::UsingProxy()
+{
+  return use_proxy_;
+}
+
+void Clip::SetUseProxy(bool use_proxy)
+{
+  if (use_proxy_ == use_proxy) {
+    return;
+  }
+
+  if (!open_ || !UsesCacher()) {
+    // the cacher will pick this up the next time it opens
+    use_proxy_ = use_proxy;
+    return;
+  }
+
+  // the clip is already open, so reopen the cacher on the other file. Unlike Close()/Open(), this leaves effects and
+  // framebuffers alone since they don't depend on which file is being decoded.
+  if (state_change_lock.tryLock()) {
+    use_proxy_ = use_proxy;
+
+    // the texture is sized to the decoded frames, which may differ between the proxy and the source
+    delete texture;
+    texture = nullptr;
+    texture_frame = -1;
+
+    // cacher will unlock state_change_lock once it's finished closing
+    cacher.Close(true);
+
+    state_change_lock.lock();
+
+    // cacher will unlock state_change_lock once it's finished opening
+    cacher.Open();
+  }
+}
+
 void Clip::Cache(long playhead, bool scrubbing, QVector<Clip*>& nests, int playback_speed) {
   cacher.Cache(playhead, scrubbing, nests, playback_speed);
   cacher_frame = playhead;
@@ -549,6 +613,15 @@ bool Clip::Retrieve()
 
     if (frame != nullptr && cacher.queue()->contains(frame)) {
 
+      // deep frames are uploaded to a 16-bit texture so none of their precision is lost before compositing
+      bool deep = (frame->format == AV_PIX_FMT_RGBA64);
+      QOpenGLTexture::TextureFormat texture_format = deep ? QOpenGLTexture::RGBA16_UNorm : QOpenGLTexture::RGBA8_UNorm;
+
+      if (texture != nullptr && texture->format() != texture_format) {
+        delete texture;
+        texture = nullptr;
+      }
+
       // check if the opengl texture exists yet, create it if not
       if (texture == nullptr) {
         texture = new QOpenGLTexture(QOpenGLTexture::Target2D);
@@ -558,55 +631,44 @@ bool Clip::Retrieve()
         // composition
         texture->setSize(cacher.media_width(), cacher.media_height());
 
-        texture->setFormat(QOpenGLTexture::RGBA8_UNorm);
+        texture->setFormat(texture_format);
         texture->setMipLevels(texture->maximumMipLevels());
         texture->setMinMagFilters(QOpenGLTexture::Linear, QOpenGLTexture::Linear);
-        texture->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+        texture->allocateStorage(QOpenGLTexture::RGBA, deep ? QOpenGLTexture::UInt16 : QOpenGLTexture::UInt8);
       }
 
-      glPixelStorei(GL_UNPACK_ROW_LENGTH, frame->linesize[0]/kRGBAComponentCount);
-
-      // 2 data buffers to ping-pong between
-      bool using_db_1 = true;
-      uint8_t* data_buffer_1 = frame->data[0];
-      uint8_t* data_buffer_2 = nullptr;
+      int bytes_per_pixel = deep ? kRGBAComponentCount*2 : kRGBAComponentCount;
+      glPixelStorei(GL_UNPACK_ROW_LENGTH, frame->linesize[0]/bytes_per_pixel);
 
-      int frame_size = frame->linesize[0]*frame->height;
+      const uint8_t* pixels = frame->data[0];
+      QOpenGLTexture::PixelType pixel_type = deep ? QOpenGLTexture::UInt16 : QOpenGLTexture::UInt8;
 
-      for (int i=0;i<effects.size();i++) {
-        EffectPtr e = effects.at(i);
-        if (e->enable_image && e->is_enabled()) {
-          if (data_buffer_1 == frame->data[0]) {
-            data_buffer_1 = new uint8_t[frame_size];
-            data_buffer_2 = new uint8_t[frame_size];
+      if (image_effects.IsActive()) {
+        // image effects always output 8 bits per component, see ImageEffectStage::load()
+        pixels = image_effects.Process(frame, get_timecode(this, cacher_frame));
+        pixel_type = QOpenGLTexture::UInt8;
 
-            memcpy(data_buffer_1, frame->data[0], frame_size);
+        // if playback is moving forward, get the image effects going on the next frame while this one is composited
+        if (cacher_frame == last_retrieved_frame + 1) {
+          AVFrame* next_frame = find_queued_frame(cacher_frame + 1);
+          if (next_frame != nullptr) {
+            image_effects.Prepare(next_frame, get_timecode(this, cacher_frame + 1));
           }
-
-          e->process_image(get_timecode(this, cacher_frame),
-                           using_db_1 ? data_buffer_1 : data_buffer_2,
-                           using_db_1 ? data_buffer_2 : data_buffer_1,
-                           frame_size
-                           );
-
-          using_db_1 = !using_db_1;
         }
       }
 
-      texture->setData(QOpenGLTexture::RGBA,
-                          QOpenGLTexture::UInt8,
-                          const_cast<const uint8_t*>(using_db_1 ? data_buffer_1 : data_buffer_2));
+      last_retrieved_frame = cacher_frame;
+      texture_frame = (frame->pts == AV_NOPTS_VALUE) ? -1 : frame->pts;
 
-      if (data_buffer_1 != frame->data[0]) {
-        qDebug() << data_buffer_1 << frame->data[0];
-        delete [] data_buffer_1;
-        delete [] data_buffer_2;
-      }
+      texture->setData(QOpenGLTexture::RGBA,
+                          pixel_type,
+                          pixels);
 
       glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
 
       ret = true;
     } else {
+      texture_frame = -1;
       qCritical() << "Failed to retrieve frame for clip" << name();
     }
 
@@ -616,6 +678,24 @@ bool Clip::Retrieve()
   return ret;
 }
 
+AVFrame *Clip::find_queued_frame(long playhead)
+{
+  // same lookup as Cacher::Cache()
+  int64_t target_pts = seconds_to_timestamp(this, playhead_to_clip_seconds(this, playhead));
+
+  for (int i=0;i<cacher.queue()->size();i++) {
+    AVFrame* f = cacher.queue()->at(i);
+
+    if (f->pts == target_pts) {
+      return f;
+    } else if (i > 0 && cacher.queue()->at(i-1)->pts < target_pts && f->pts > target_pts) {
+      return cacher.queue()->at(i-1);
+    }
+  }
+
+  return nullptr;
+}
+
 bool Clip::UsesCacher()
 {
   return track() >= 0 || (media() != nullptr && media()->get_type() == MEDIA_TYPE_FOOTAGE);
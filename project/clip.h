@@ -29,6 +29,7 @@
 #include <QOpenGLTexture>
 
 #include "rendering/cacher.h"
+#include "rendering/imageeffectstage.h"
 
 #include "project/effect.h"
 #include "project/transition.h"
@@ -141,6 +142,10 @@ public:
 
   bool UsesCacher();
 
+  // proxy switching (see rendering/proxypolicy.h)
+  bool UsingProxy();
+  void SetUseProxy(bool use_proxy);
+
   // temporary variables
   int load_id;
   bool undeletable;
@@ -153,9 +158,21 @@ public:
   // video playback variables
   QOpenGLFramebufferObject** fbo;
   QOpenGLTexture* texture;
-  long texture_frame;
+
+  // timestamp of the frame in texture, or -1 if it isn't known
+  int64_t texture_frame;
+
+  // for nested sequences, compose_sequence() keeps the nest's last output in fbo[3] and reuses it while the nested
+  // frame, the nest's content version (see Sequence::content_version) and the playback state stay the same
+  bool nest_cache_valid;
+  long nest_cache_frame;
+  quint64 nest_cache_version;
+  int nest_cache_state;
 
 private:
+  // tell the sequence's ClipIndex that this clip's position changed
+  void invalidate_index();
+
   // timeline variables (should be copied in copy())
   bool enabled_;
   long clip_in_;
@@ -173,9 +190,19 @@ private:
   Cacher cacher;
   long cacher_frame;
 
+  // image effects (e.g. Frei0r) applied to frames before they're uploaded in Retrieve()
+  ImageEffectStage image_effects;
+
+  // the frame Retrieve() last uploaded, used to tell if playback is moving forward one frame at a time
+  long last_retrieved_frame;
+
+  // find the frame in the cacher's queue Cacher::Cache() would retrieve for this playhead, queue must be locked
+  AVFrame* find_queued_frame(long playhead);
+
   QVector<Marker> markers;
   QColor color_;
   bool open_;
+  bool use_proxy_;
 };
 
 #endif // CLIP_H
@@ -0,0 +1,356 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "clipindex.h"
+
+#include <algorithm>
+
+#include "project/sequence.h"
+
+ClipIndex::ClipIndex(Sequence *s) :
+  sequence_(s),
+  clip_count_(0),
+  dirty_(true)
+{}
+
+ClipIndex::Track::Track() :
+  max_length(0)
+{}
+
+void ClipIndex::invalidate() {
+  QMutexLocker locker(&lock_);
+  dirty_ = true;
+}
+
+void ClipIndex::invalidate_clip(Clip *c) {
+  QMutexLocker locker(&lock_);
+  if (!dirty_) {
+    dirty_clips_.insert(c);
+  }
+}
+
+QVector<int> ClipIndex::ClipsInRange(long start, long end, bool video, bool audio) {
+  QVector<int> result;
+
+  QMutexLocker locker(&lock_);
+
+  update();
+
+  QMap<int, Track>::const_iterator i;
+  for (i=tracks_.constBegin();i!=tracks_.constEnd();i++) {
+    if ((i.key() < 0) ? video : audio) {
+      query_track(i.value(), start, end, result);
+    }
+  }
+
+  return result;
+}
+
+QVector<int> ClipIndex::ClipsOnTrackInRange(int track, long start, long end) {
+  QVector<int> result;
+
+  QMutexLocker locker(&lock_);
+
+  update();
+
+  QMap<int, Track>::const_iterator i = tracks_.constFind(track);
+  if (i != tracks_.constEnd()) {
+    query_track(i.value(), start, end, result);
+  }
+
+  return result;
+}
+
+QVector<int> ClipIndex::ClipsAt(long frame, bool video, bool audio) {
+  return ClipsInRange(frame, frame + 1, video, audio);
+}
+
+long ClipIndex::NextEditPoint(long frame) {
+  QMutexLocker locker(&lock_);
+
+  update();
+
+  QMap<long, int>::const_iterator it = edit_points_.upperBound(frame);
+  if (it == edit_points_.constEnd()) {
+    return -1;
+  }
+  return it.key();
+}
+
+long ClipIndex::PreviousEditPoint(long frame) {
+  QMutexLocker locker(&lock_);
+
+  update();
+
+  QMap<long, int>::const_iterator it = edit_points_.lowerBound(frame);
+  if (it == edit_points_.constBegin()) {
+    return -1;
+  }
+  return (--it).key();
+}
+
+bool ClipIndex::GetSnapPoint(long frame, long range, long *point) {
+  QMutexLocker locker(&lock_);
+
+  update();
+
+  bool found = false;
+  long closest = 0;
+
+  const QMap<long, int>* sets[] = {&edit_points_, &transition_points_};
+  for (int i=0;i<2;i++) {
+    const QMap<long, int>& set = *sets[i];
+
+    // the closest point is either the first one at/after `frame` or the one right before it
+    QMap<long, int>::const_iterator it = set.lowerBound(frame);
+    if (it != set.constEnd()
+        && it.key() - frame <= range
+        && (!found || it.key() - frame < qAbs(closest - frame))) {
+      closest = it.key();
+      found = true;
+    }
+    if (it != set.constBegin()) {
+      it--;
+      if (frame - it.key() <= range
+          && (!found || frame - it.key() < qAbs(closest - frame))) {
+        closest = it.key();
+        found = true;
+      }
+    }
+  }
+
+  if (found) {
+    *point = closest;
+  }
+
+  return found;
+}
+
+long ClipIndex::EndFrame() {
+  QMutexLocker locker(&lock_);
+
+  update();
+
+  if (out_points_.isEmpty()) {
+    return 0;
+  }
+
+  // getEndFrame() has never returned a negative frame
+  return qMax(0L, out_points_.lastKey());
+}
+
+void ClipIndex::GetTrackLimits(int *video_tracks, int *audio_tracks) {
+  QMutexLocker locker(&lock_);
+
+  update();
+
+  int vt = 0;
+  int at = 0;
+
+  // tracks are sorted, but may be left empty after clips were moved off of them
+  QMap<int, Track>::const_iterator i;
+  for (i=tracks_.constBegin();i!=tracks_.constEnd() && i.key() < 0;i++) {
+    if (!i.value().entries.isEmpty()) {
+      vt = i.key();
+      break;
+    }
+  }
+
+  i = tracks_.constEnd();
+  while (i != tracks_.constBegin()) {
+    i--;
+    if (i.key() < 0) {
+      break;
+    }
+    if (!i.value().entries.isEmpty()) {
+      at = i.key();
+      break;
+    }
+  }
+
+  if (video_tracks != nullptr) *video_tracks = vt;
+  if (audio_tracks != nullptr) *audio_tracks = at;
+}
+
+void ClipIndex::update() {
+  if (dirty_ || clip_count_ != sequence_->clips.size()) {
+    rebuild();
+    return;
+  }
+
+  QSet<Clip*>::const_iterator i;
+  for (i=dirty_clips_.constBegin();i!=dirty_clips_.constEnd();i++) {
+    QHash<Clip*, Record>::iterator r = records_.find(*i);
+
+    // ignore clips that were never part of this sequence
+    if (r == records_.end()) {
+      continue;
+    }
+
+    int index = r.value().index;
+    remove_record(r.value());
+
+    // the clip may have been deleted, only dereference it if it's still where it was indexed
+    if (index < sequence_->clips.size() && sequence_->clips.at(index).get() == *i) {
+      create_record(*i, index, r.value());
+      add_record(r.value());
+    } else {
+      records_.erase(r);
+    }
+  }
+
+  dirty_clips_.clear();
+}
+
+void ClipIndex::rebuild() {
+  tracks_.clear();
+  records_.clear();
+  edit_points_.clear();
+  transition_points_.clear();
+  out_points_.clear();
+
+  for (int i=0;i<sequence_->clips.size();i++) {
+    Clip* c = sequence_->clips.at(i).get();
+    if (c != nullptr) {
+      Record& r = records_[c];
+      create_record(c, i, r);
+
+      // append and sort everything once below rather than inserting each entry in place
+      Track& t = tracks_[r.track];
+      t.entries.append(r.entry);
+      t.max_length = qMax(t.max_length, r.entry.out - r.entry.in);
+
+      multiset_insert(edit_points_, r.in);
+      multiset_insert(edit_points_, r.out);
+      multiset_insert(out_points_, r.out);
+      for (int j=0;j<r.transition_points.size();j++) {
+        multiset_insert(transition_points_, r.transition_points.at(j));
+      }
+    }
+  }
+
+  QMap<int, Track>::iterator i;
+  for (i=tracks_.begin();i!=tracks_.end();i++) {
+    std::stable_sort(i.value().entries.begin(), i.value().entries.end(), entry_less_than);
+  }
+
+  dirty_clips_.clear();
+  clip_count_ = sequence_->clips.size();
+  dirty_ = false;
+}
+
+void ClipIndex::create_record(Clip *c, int index, Record &r) {
+  r.index = index;
+  r.track = c->track();
+  r.entry.in = c->timeline_in(true);
+  r.entry.out = c->timeline_out(true);
+  r.entry.clip = index;
+  r.in = c->timeline_in();
+  r.out = c->timeline_out();
+
+  r.transition_points.clear();
+  if (c->opening_transition != nullptr) {
+    r.transition_points.append(r.in + c->opening_transition->get_true_length());
+  }
+  if (c->closing_transition != nullptr) {
+    r.transition_points.append(r.out - c->closing_transition->get_true_length());
+  }
+}
+
+void ClipIndex::add_record(const Record &r) {
+  Track& t = tracks_[r.track];
+
+  QVector<Entry>::iterator pos = std::upper_bound(t.entries.begin(), t.entries.end(), r.entry, entry_less_than);
+  t.entries.insert(pos, r.entry);
+  t.max_length = qMax(t.max_length, r.entry.out - r.entry.in);
+
+  multiset_insert(edit_points_, r.in);
+  multiset_insert(edit_points_, r.out);
+  multiset_insert(out_points_, r.out);
+  for (int i=0;i<r.transition_points.size();i++) {
+    multiset_insert(transition_points_, r.transition_points.at(i));
+  }
+}
+
+void ClipIndex::remove_record(const Record &r) {
+  Track& t = tracks_[r.track];
+
+  // find the clip among the entries with the same in point
+  QVector<Entry>::iterator it = std::lower_bound(t.entries.begin(), t.entries.end(), r.entry, entry_less_than);
+  while (it != t.entries.end() && it->in == r.entry.in) {
+    if (it->clip == r.entry.clip) {
+      t.entries.erase(it);
+      break;
+    }
+    it++;
+  }
+
+  multiset_remove(edit_points_, r.in);
+  multiset_remove(edit_points_, r.out);
+  multiset_remove(out_points_, r.out);
+  for (int i=0;i<r.transition_points.size();i++) {
+    multiset_remove(transition_points_, r.transition_points.at(i));
+  }
+}
+
+bool ClipIndex::entry_less_than(const Entry &a, const Entry &b) {
+  return a.in < b.in;
+}
+
+void ClipIndex::multiset_insert(QMap<long, int> &set, long value) {
+  set[value]++;
+}
+
+void ClipIndex::multiset_remove(QMap<long, int> &set, long value) {
+  QMap<long, int>::iterator it = set.find(value);
+  if (it != set.end() && --it.value() == 0) {
+    set.erase(it);
+  }
+}
+
+void ClipIndex::query_track(const Track &t, long start, long end, QVector<int> &result) {
+  // no clip is longer than max_length, so nothing that starts before this can reach `start`
+  long earliest_in = start - t.max_length;
+
+  int first = 0;
+  int last = t.entries.size();
+
+  // binary search for the first entry that could still overlap
+  while (first < last) {
+    int mid = (first + last) / 2;
+    if (t.entries.at(mid).in <= earliest_in) {
+      first = mid + 1;
+    } else {
+      last = mid;
+    }
+  }
+
+  for (int i=first;i<t.entries.size();i++) {
+    const Entry& e = t.entries.at(i);
+
+    // entries are sorted by in point, so everything from here on starts after the range
+    if (e.in >= end) {
+      break;
+    }
+
+    if (e.out > start) {
+      result.append(e.clip);
+    }
+  }
+}
@@ -0,0 +1,191 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef CLIPINDEX_H
+#define CLIPINDEX_H
+
+#include <QMap>
+#include <QHash>
+#include <QSet>
+#include <QVector>
+#include <QMutex>
+
+class Sequence;
+class Clip;
+
+/**
+ * @brief The ClipIndex class
+ *
+ * Per-track lookup structure over a Sequence's `clips` array so that the renderer, snapping and the timeline don't
+ * need to walk every clip to find the few they're interested in.
+ *
+ * Each track keeps its clips sorted by their in point along with an upper bound on the length of its clips, which
+ * bounds how far back a range query has to look for clips that started earlier but still overlap. Extents include
+ * shared transitions (i.e. Clip::timeline_in(true) and Clip::timeline_out(true)).
+ *
+ * The index also keeps sorted multisets of clip in/out points, of the inner edges of transitions and of out points
+ * alone, which answer edit point, snapping and end frame queries without looking at the clips at all.
+ *
+ * Changes to a single clip (its position, track or transitions) are reported with invalidate_clip() and only that clip
+ * is moved within the index on the next query. Clip's setters, Transition::set_length() and the transition undo
+ * commands already do this. Changes to the `clips` array itself call invalidate(), which rebuilds everything on the
+ * next query. The size of `clips` is also checked on every query as a safety net for code that appends or removes
+ * clips directly. Queries are thread-safe since the render thread and the main thread both use them.
+ *
+ * The index holds no references to clips. It stores positions in `clips`, and Clip pointers are only used as lookup
+ * keys which are never dereferenced unless the clip is still at its recorded position, so deleted clips are freed as
+ * soon as the sequence lets go of them.
+ */
+class ClipIndex {
+public:
+  ClipIndex(Sequence* s);
+
+  /**
+   * @brief Mark the whole index as out of date
+   *
+   * Used when clips are added to or removed from the sequence. The rebuild is deferred until the next query.
+   */
+  void invalidate();
+
+  /**
+   * @brief Mark one clip as changed
+   *
+   * Cheap enough to call on every change, the clip is re-indexed on the next query. Clips that aren't part of the
+   * sequence (e.g. ones that haven't been added yet) are ignored.
+   */
+  void invalidate_clip(Clip* c);
+
+  /**
+   * @brief Get indices (into Sequence::clips) of clips that overlap [start, end)
+   *
+   * @param video
+   *
+   * Include clips on video tracks
+   *
+   * @param audio
+   *
+   * Include clips on audio tracks
+   *
+   * @return Clip indices, ordered by track and then by in point
+   */
+  QVector<int> ClipsInRange(long start, long end, bool video = true, bool audio = true);
+
+  /**
+   * @brief Get indices (into Sequence::clips) of clips on `track` that overlap [start, end), ordered by in point
+   */
+  QVector<int> ClipsOnTrackInRange(int track, long start, long end);
+
+  /**
+   * @brief Get indices (into Sequence::clips) of clips that cover `frame`
+   */
+  QVector<int> ClipsAt(long frame, bool video = true, bool audio = true);
+
+  /**
+   * @brief Returns the closest clip in or out point after `frame`, or -1 if there isn't one
+   */
+  long NextEditPoint(long frame);
+
+  /**
+   * @brief Returns the closest clip in or out point before `frame`, or -1 if there isn't one
+   */
+  long PreviousEditPoint(long frame);
+
+  /**
+   * @brief Find the clip in/out point or transition edge closest to `frame`
+   *
+   * @param range
+   *
+   * Maximum distance from `frame` a point can be at
+   *
+   * @param point
+   *
+   * Set to the point found, if any
+   *
+   * @return **TRUE** if a point was found within `range`
+   */
+  bool GetSnapPoint(long frame, long range, long* point);
+
+  /**
+   * @brief Returns the latest out point of all clips in the sequence (see Sequence::getEndFrame())
+   */
+  long EndFrame();
+
+  /**
+   * @brief Get the furthest video and audio tracks that have clips on them (see Sequence::getTrackLimits())
+   */
+  void GetTrackLimits(int* video_tracks, int* audio_tracks);
+
+private:
+  struct Entry {
+    long in;
+    long out;
+    int clip;
+  };
+
+  struct Track {
+    Track();
+
+    QVector<Entry> entries;
+
+    // no clip on this track is longer than this, it may be larger than the longest clip after edits
+    long max_length;
+  };
+
+  // what a clip contributed to the index when it was last indexed, so it can be taken out again
+  struct Record {
+    int index;
+    int track;
+    Entry entry;
+    long in;
+    long out;
+    QVector<long> transition_points;
+  };
+
+  // bring the index up to date, must be called with `lock_` held
+  void update();
+
+  void rebuild();
+  void create_record(Clip* c, int index, Record& r);
+  void add_record(const Record& r);
+  void remove_record(const Record& r);
+
+  void query_track(const Track& t, long start, long end, QVector<int>& result);
+
+  static bool entry_less_than(const Entry& a, const Entry& b);
+  static void multiset_insert(QMap<long, int>& set, long value);
+  static void multiset_remove(QMap<long, int>& set, long value);
+
+  Sequence* sequence_;
+
+  QMap<int, Track> tracks_;
+  QHash<Clip*, Record> records_;
+
+  // value -> count
+  QMap<long, int> edit_points_;
+  QMap<long, int> transition_points_;
+  QMap<long, int> out_points_;
+
+  QSet<Clip*> dirty_clips_;
+  int clip_count_;
+  bool dirty_;
+
+  QMutex lock_;
+};
+
+#endif // CLIPINDEX_H
@@ -1,5 +1,7 @@
 #include "comboaction.h"
 
+#include "project/undo.h"
+
 ComboAction::ComboAction() {}
 
 ComboAction::~ComboAction() {
@@ -38,3 +40,35 @@ bool ComboAction::hasActions()
 {
   return commands.size() > 0;
 }
+
+int ComboAction::id() const
+{
+  if (commands.size() == 1 && post_commands.isEmpty()) {
+    return commands.first()->id();
+  }
+  return -1;
+}
+
+bool ComboAction::mergeWith(const QUndoCommand *other)
+{
+  const ComboAction* other_ca = dynamic_cast<const ComboAction*>(other);
+
+  // id() already matched, but make sure the other one is also a ComboAction wrapping a single command
+  if (other_ca == nullptr || other_ca->commands.size() != 1 || !other_ca->post_commands.isEmpty()) {
+    return false;
+  }
+
+  return commands.first()->mergeWith(other_ca->commands.first());
+}
+
+qint64 ComboAction::memory_usage()
+{
+  qint64 usage = sizeof(ComboAction);
+  for (int i=0;i<commands.size();i++) {
+    usage += UndoHistory::command_memory_usage(commands.at(i));
+  }
+  for (int i=0;i<post_commands.size();i++) {
+    usage += UndoHistory::command_memory_usage(post_commands.at(i));
+  }
+  return usage;
+}
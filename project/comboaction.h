@@ -81,6 +81,23 @@ public:
      */
     bool hasActions();
 
+    /**
+     * @brief Returns the id() of the only action appended, or -1
+     *
+     * Lets a ComboAction wrapping a single mergeable command (e.g. EffectFieldUndo) be merged by the UndoHistory.
+     */
+    virtual int id() const override;
+
+    /**
+     * @brief Merge another ComboAction wrapping a single command into this one's
+     */
+    virtual bool mergeWith(const QUndoCommand* other) override;
+
+    /**
+     * @brief Returns the estimated number of bytes held by all actions appended
+     */
+    qint64 memory_usage();
+
 private:
     /**
      * @brief Internal array of QUndoCommand objects
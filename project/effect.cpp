@@ -26,6 +26,7 @@
 #include "ui/collapsiblewidget.h"
 #include "panels/project.h"
 #include "project/undo.h"
+#include "project/invalidation.h"
 #include "project/sequence.h"
 #include "project/clip.h"
 #include "panels/timeline.h"
@@ -38,6 +39,10 @@
 #include "io/math.h"
 #include "io/clipboard.h"
 #include "io/config.h"
+#include "io/binaryproject.h"
+#include "io/projectsnapshot.h"
+#include "rendering/shaderprogramcache.h"
+#include "rendering/shaderfusion.h"
 #include "transition.h"
 
 #include "effects/internal/transformeffect.h"
@@ -66,6 +71,7 @@
 #include <QMenu>
 #include <QApplication>
 #include <QFileDialog>
+#include <QDataStream>
 
 QVector<EffectMeta> effects;
 
@@ -119,27 +125,31 @@ Effect::Effect(Clip* c, const EffectMeta *em) :
 	enable_coords(false),
 	enable_superimpose(false),
 	enable_image(false),
-	glslProgram(nullptr),
 	texture(nullptr),
 	enable_always_update(false),
 	isOpen(false),
+	ui_layout(nullptr),
+	ui(nullptr),
+	enabled_(true),
 	bound(false),
-	iterations(1)
+	iterations(1),
+	fusible(false),
+	fused_stage(-1),
+	blur_type(EFFECT_BLUR_NONE),
+	blur_scale(1.0),
+	blur_size(nullptr),
+	blur_horizontal(nullptr),
+	blur_vertical(nullptr),
+	blur_angle(nullptr),
+	blur_direction_uniform(-1),
+	blur_taps_uniform(-1),
+	blur_offsets_uniform(-1),
+	blur_weights_uniform(-1)
 {
-	// set up base UI
-	container = new CollapsibleWidget();
-	connect(container->enabled_check, SIGNAL(clicked(bool)), this, SLOT(field_changed()));
-	ui = new QWidget(container);
-	ui_layout = new QGridLayout(ui);
-	ui_layout->setSpacing(4);
-	container->setContents(ui);
-
-	connect(container->title_bar, SIGNAL(customContextMenuRequested(const QPoint&)), this, SLOT(show_context_menu(const QPoint&)));
+	container = nullptr;
 
 	if (em != nullptr) {
-		// set up UI from effect file
-		container->setText(em->name);
-
+		// set up rows from effect file
 		if (!em->filename.isEmpty() && em->internal == -1) {
 			QFile effect_file(em->filename);
 			if (effect_file.open(QFile::ReadOnly)) {
@@ -299,8 +309,37 @@ Effect::Effect(Clip* c, const EffectMeta *em) :
 								fragPath = attr.value().toString();
 							} else if (attr.name() == "iterations") {
 								setIterations(attr.value().toInt());
+							} else if (attr.name() == "fusible") {
+								fusible = (attr.value() == "true");
+							}
+						}
+					} else if (reader.name() == "blur" && reader.isStartElement()) {
+						// fields are referenced by id, so this must come after the rows it uses
+						const QXmlStreamAttributes& attributes = reader.attributes();
+						for (int i=0;i<attributes.size();i++) {
+							const QXmlStreamAttribute& attr = attributes.at(i);
+							if (attr.name() == "type") {
+								if (attr.value() == "gaussian") {
+									blur_type = EFFECT_BLUR_GAUSSIAN;
+								} else if (attr.value() == "box") {
+									blur_type = EFFECT_BLUR_BOX;
+								}
+							} else if (attr.name() == "size") {
+								blur_size = find_field(attr.value().toString());
+							} else if (attr.name() == "scale") {
+								blur_scale = attr.value().toDouble();
+							} else if (attr.name() == "horizontal") {
+								blur_horizontal = find_field(attr.value().toString());
+							} else if (attr.name() == "vertical") {
+								blur_vertical = find_field(attr.value().toString());
+							} else if (attr.name() == "angle") {
+								blur_angle = find_field(attr.value().toString());
 							}
 						}
+						if (blur_size == nullptr) {
+							qCritical() << "Blur in effect file" << em->filename << "has no size field";
+							blur_type = EFFECT_BLUR_NONE;
+						}
 					}/* else if (reader.name() == "superimpose" && reader.isStartElement()) {
 						enable_superimpose = true;
 						const QXmlStreamAttributes& attributes = reader.attributes();
@@ -334,11 +373,13 @@ Effect::~Effect() {
 		close();
 	}
 
-	delete container;
-
+	// rows go first so fields can tell which of their widgets haven't been given to the container
 	for (int i=0;i<rows.size();i++) {
 		delete rows.at(i);
 	}
+
+	delete container;
+
 	for (int i=0;i<gizmos.size();i++) {
 		delete gizmos.at(i);
 	}
@@ -359,7 +400,8 @@ void Effect::copy_field_keyframes(EffectPtr e) {
 }
 
 EffectRow* Effect::add_row(const QString& name, bool savable, bool keyframable) {
-	EffectRow* row = new EffectRow(this, savable, ui_layout, name, rows.size(), keyframable);
+	EffectRow* row = new EffectRow(this, savable, name, rows.size(), keyframable);
+	if (ui_layout != nullptr) row->create_ui(ui_layout);
 	rows.append(row);
 	return row;
 }
@@ -389,10 +431,44 @@ int Effect::gizmo_count() {
 void Effect::refresh() {}
 
 void Effect::field_changed() {
-	panel_sequence_viewer->viewer_widget->frame_update();
+	// the viewer re-renders if this clip is under its playhead
+	olive::Invalidation.invalidate_effect(this);
 	panel_graph_editor->update_panel();
 }
 
+void Effect::create_ui() {
+	if (container != nullptr) {
+		return;
+	}
+
+	container = new CollapsibleWidget();
+	connect(container->enabled_check, SIGNAL(clicked(bool)), this, SLOT(enabled_check_changed(bool)));
+	ui = new QWidget(container);
+	ui_layout = new QGridLayout(ui);
+	ui_layout->setSpacing(4);
+	container->setContents(ui);
+	container->enabled_check->setChecked(enabled_);
+
+	connect(container->title_bar, SIGNAL(customContextMenuRequested(const QPoint&)), this, SLOT(show_context_menu(const QPoint&)));
+
+	if (meta != nullptr) {
+		container->setText(meta->name);
+	}
+
+	for (int i=0;i<rows.size();i++) {
+		rows.at(i)->create_ui(ui_layout);
+	}
+
+	custom_create_ui();
+}
+
+void Effect::custom_create_ui() {}
+
+void Effect::enabled_check_changed(bool e) {
+	enabled_ = e;
+	field_changed();
+}
+
 void Effect::show_context_menu(const QPoint& pos) {
 	if (meta->type == EFFECT_TYPE_EFFECT) {
         QMenu menu(olive::MainWindow);
@@ -524,11 +600,14 @@ int Effect::get_index_in_clip() {
 }
 
 bool Effect::is_enabled() {
-	return container->enabled_check->isChecked();
+	return enabled_;
 }
 
 void Effect::set_enabled(bool b) {
-	container->enabled_check->setChecked(b);
+	enabled_ = b;
+	if (container != nullptr) {
+		container->enabled_check->setChecked(b);
+	}
 }
 
 QVariant load_data_from_string(int type, const QString& string) {
@@ -545,20 +624,6 @@ QVariant load_data_from_string(int type, const QString& string) {
 	return QVariant();
 }
 
-QString save_data_to_string(int type, const QVariant& data) {
-	switch (type) {
-	case EFFECT_FIELD_DOUBLE: return QString::number(data.toDouble());
-	case EFFECT_FIELD_COLOR: return data.value<QColor>().name();
-	case EFFECT_FIELD_BOOL: return QString::number(data.toBool());
-	case EFFECT_FIELD_COMBO: return QString::number(data.toInt());
-	case EFFECT_FIELD_STRING:
-	case EFFECT_FIELD_FONT:
-	case EFFECT_FIELD_FILE:
-		return data.toString();
-	}
-	return QString();
-}
-
 void Effect::load(QXmlStreamReader& stream) {
 	int row_count = 0;
 
@@ -653,33 +718,132 @@ void Effect::load(QXmlStreamReader& stream) {
 void Effect::custom_load(QXmlStreamReader &) {}
 
 void Effect::save(QXmlStreamWriter& stream) {
-	stream.writeAttribute("name", meta->category + "/" + meta->name);
-	stream.writeAttribute("enabled", QString::number(is_enabled()));
+	olive::write_effect(stream, snapshot());
+}
+
+EffectSnapshot Effect::snapshot() {
+	EffectSnapshot s;
+	s.name = meta->category + "/" + meta->name;
+	s.enabled = is_enabled();
 
 	for (int i=0;i<rows.size();i++) {
 		EffectRow* row = rows.at(i);
 		if (row->savable) {
-			stream.writeStartElement("row"); // row
+			QVector<FieldSnapshot> fields(row->fieldCount());
 			for (int j=0;j<row->fieldCount();j++) {
 				EffectField* field = row->field(j);
-				stream.writeStartElement("field"); // field
-				stream.writeAttribute("id", field->id);
-				stream.writeAttribute("value", save_data_to_string(field->type, field->get_current_data()));
-				for (int k=0;k<field->keyframes.size();k++) {
-					const EffectKeyframe& key = field->keyframes.at(k);
-					stream.writeStartElement("key");
-					stream.writeAttribute("value", save_data_to_string(field->type, key.data));
-					stream.writeAttribute("frame", QString::number(key.time));
-					stream.writeAttribute("type", QString::number(key.type));
-					stream.writeAttribute("prehx", QString::number(key.pre_handle_x));
-					stream.writeAttribute("prehy", QString::number(key.pre_handle_y));
-					stream.writeAttribute("posthx", QString::number(key.post_handle_x));
-					stream.writeAttribute("posthy", QString::number(key.post_handle_y));
-					stream.writeEndElement(); // key
+				fields[j].id = field->id;
+				fields[j].type = field->type;
+				fields[j].value = field->get_current_data();
+				fields[j].keyframes = field->keyframes;
+			}
+			s.rows.append(fields);
+		}
+	}
+
+	return s;
+}
+
+QVariant load_data_from_stream(int type, BinaryReader& stream) {
+	switch (type) {
+	case EFFECT_FIELD_DOUBLE:
+	{
+		double d;
+		stream >> d;
+		return d;
+	}
+	case EFFECT_FIELD_COLOR:
+	{
+		quint32 rgba;
+		stream >> rgba;
+		return QColor::fromRgba(rgba);
+	}
+	case EFFECT_FIELD_BOOL:
+	{
+		bool b;
+		stream >> b;
+		return b;
+	}
+	case EFFECT_FIELD_COMBO:
+	{
+		qint32 i;
+		stream >> i;
+		return i;
+	}
+	case EFFECT_FIELD_STRING:
+	case EFFECT_FIELD_FONT:
+	case EFFECT_FIELD_FILE:
+		return stream.read_string();
+	}
+	return QVariant();
+}
+
+void Effect::load_binary(BinaryReader& stream) {
+	// name and enabled state were already read by LoadThread to create this effect
+	quint32 saved_row_count;
+	stream >> saved_row_count;
+
+	// only savable rows were saved, so match saved rows to those in order
+	int row_index = 0;
+	for (quint32 i=0;i<saved_row_count;i++) {
+		while (row_index < rows.size() && !rows.at(row_index)->savable) {
+			row_index++;
+		}
+		EffectRow* row = (row_index < rows.size()) ? rows.at(row_index) : nullptr;
+		row_index++;
+
+		if (row == nullptr) {
+			qCritical() << "Too many rows for effect" << id << ". Project might be corrupt.";
+		}
+
+		quint32 saved_field_count;
+		stream >> saved_field_count;
+
+		for (quint32 j=0;j<saved_field_count;j++) {
+			QString field_id = stream.read_string();
+
+			// match field using ID, falling back to its position
+			EffectField* field = nullptr;
+			if (row != nullptr) {
+				for (int k=0;k<row->fieldCount();k++) {
+					if (row->field(k)->id == field_id) {
+						field = row->field(k);
+						break;
+					}
+				}
+				if (field == nullptr && int(j) < row->fieldCount()) {
+					field = row->field(int(j));
+				}
+			}
+
+			qint32 field_type;
+			stream >> field_type;
+
+			QVariant value = load_data_from_stream(field_type, stream);
+			if (field != nullptr && field->type == field_type) {
+				field->set_current_data(value);
+			}
+
+			quint32 key_count;
+			stream >> key_count;
+
+			if (key_count > 0 && row != nullptr) {
+				row->setKeyframing(true);
+			}
+
+			for (quint32 k=0;k<key_count;k++) {
+				EffectKeyframe key;
+				qint64 time;
+				qint32 key_type;
+				key.data = load_data_from_stream(field_type, stream);
+				stream >> time >> key_type >> key.pre_handle_x >> key.pre_handle_y >> key.post_handle_x >> key.post_handle_y;
+				key.time = time;
+				key.type = key_type;
+
+				if (field != nullptr && field->type == field_type) {
+					field->keyframes.append(key);
 				}
-				stream.writeEndElement(); // field
 			}
-			stream.writeEndElement(); // row
 		}
 	}
 }
@@ -778,31 +942,14 @@ void Effect::open() {
 		if (QOpenGLContext::currentContext() == nullptr) {
 			qWarning() << "No current context to create a shader program for - will retry next repaint";
 		} else {
-			glslProgram = new QOpenGLShaderProgram();
-			validate_meta_path();
-			bool glsl_compiled = true;
-			if (!vertPath.isEmpty()) {
-				if (glslProgram->addShaderFromSourceFile(QOpenGLShader::Vertex, meta->path + "/" + vertPath)) {
-					qInfo() << "Vertex shader added successfully";
-				} else {
-					glsl_compiled = false;
-					qWarning() << "Vertex shader could not be added";
-				}
-			}
-			if (!fragPath.isEmpty()) {
-				if (glslProgram->addShaderFromSourceFile(QOpenGLShader::Fragment, meta->path + "/" + fragPath)) {
-					qInfo() << "Fragment shader added successfully";
-				} else {
-					glsl_compiled = false;
-					qWarning() << "Fragment shader could not be added";
-				}
-			}
-			if (glsl_compiled) {
-				if (glslProgram->link()) {
-					qInfo() << "Shader program linked successfully";
-				} else {
-					qWarning() << "Shader program failed to link";
-				}
+			glslProgram = olive::shader_program_cache.Get(get_vert_path(), get_frag_path());
+
+			if (glslProgram->isLinked()) {
+				resolve_uniforms(glslProgram, QString(), uniforms);
+				blur_direction_uniform = glslProgram->uniformLocation("blur_direction");
+				blur_taps_uniform = glslProgram->uniformLocation("blur_taps");
+				blur_offsets_uniform = glslProgram->uniformLocation("blur_offsets");
+				blur_weights_uniform = glslProgram->uniformLocation("blur_weights");
 			}
 			isOpen = true;
 		}
@@ -816,15 +963,71 @@ void Effect::close() {
 		qWarning() << "Tried to close an effect that was already closed";
 	}
 	delete_texture();
-	if (glslProgram != nullptr) {
-		delete glslProgram;
-		glslProgram = nullptr;
-	}
+
+	// the program belongs to the shader program cache
+	glslProgram = nullptr;
+
 	isOpen = false;
 }
 
 bool Effect::is_glsl_linked() {
-	return glslProgram != nullptr && glslProgram->isLinked();
+	return !glslProgram.isNull() && glslProgram->isLinked();
+}
+
+QString Effect::get_vert_path() {
+	validate_meta_path();
+	return vertPath.isEmpty() ? QString() : meta->path + "/" + vertPath;
+}
+
+QString Effect::get_frag_path() {
+	validate_meta_path();
+	return fragPath.isEmpty() ? QString() : meta->path + "/" + fragPath;
+}
+
+bool Effect::can_fuse() {
+	// fused stages run once each, reading and writing a single pixel
+	return fusible
+			&& enable_shader
+			&& !enable_coords
+			&& !enable_superimpose
+			&& blur_type == EFFECT_BLUR_NONE
+			&& iterations == 1
+			&& isOpen
+			&& is_glsl_linked();
+}
+
+void Effect::process_fused_shader(QOpenGLShaderProgram *program, int stage, double timecode) {
+	if (fused_program != program || fused_stage != stage) {
+		resolve_uniforms(program, fused_stage_prefix(stage), fused_uniforms);
+		fused_program = program;
+		fused_stage = stage;
+	}
+	set_uniforms(program, fused_uniforms, timecode, 0);
+}
+
+bool Effect::hash_stage(QCryptographicHash &hash, double timecode) {
+	// effects that update constantly depend on more than their fields
+	if (enable_always_update) {
+		return false;
+	}
+
+	QByteArray state;
+	QDataStream stream(&state, QIODevice::WriteOnly);
+	if (meta != nullptr) {
+		stream << meta->name;
+	}
+	stream << is_enabled() << timecode;
+	for (int i=0;i<rows.size();i++) {
+		EffectRow* row = rows.at(i);
+		for (int j=0;j<row->fieldCount();j++) {
+			EffectField* field = row->field(j);
+			field->validate_keyframe_data(timecode);
+			stream << field->get_current_data();
+		}
+	}
+	hash.addData(state);
+
+	return true;
 }
 
 void Effect::startEffect() {
@@ -834,7 +1037,7 @@ void Effect::startEffect() {
 	}
 	if (olive::CurrentRuntimeConfig.shaders_are_enabled
 			&& enable_shader
-			&& glslProgram->isLinked()) {
+			&& is_glsl_linked()) {
 		bound = glslProgram->bind();
 	}
 }
@@ -862,22 +1065,66 @@ EffectPtr Effect::copy(Clip *c) {
 }
 
 void Effect::process_shader(double timecode, GLTextureCoords&, int iteration) {
-  glslProgram->setUniformValue("resolution", parent_clip->media_width(), parent_clip->media_height());
-	glslProgram->setUniformValue("time", GLfloat(timecode));
-	glslProgram->setUniformValue("iteration", iteration);
+	set_uniforms(glslProgram, uniforms, timecode, iteration);
+
+	if (blur_type != EFFECT_BLUR_NONE) {
+		// the number of passes depends on the blur size, so decide them all before the first one
+		if (iteration == 0) {
+			plan_blur(timecode);
+		}
+		if (iteration < blur_passes.size()) {
+			const BlurPass& pass = blur_passes.at(iteration);
+			glslProgram->setUniformValue(blur_direction_uniform, pass.direction[0], pass.direction[1]);
+			glslProgram->setUniformValue(blur_taps_uniform, pass.tap_count);
+			glslProgram->setUniformValueArray(blur_offsets_uniform, pass.offsets, kBlurMaxTaps, 1);
+			glslProgram->setUniformValueArray(blur_weights_uniform, pass.weights, kBlurMaxTaps, 1);
+		} else {
+			// nothing to blur, pass the image through
+			GLfloat offset = 0.0f;
+			GLfloat weight = 1.0f;
+			glslProgram->setUniformValue(blur_direction_uniform, 1.0f, 0.0f);
+			glslProgram->setUniformValue(blur_taps_uniform, 1);
+			glslProgram->setUniformValueArray(blur_offsets_uniform, &offset, 1, 1);
+			glslProgram->setUniformValueArray(blur_weights_uniform, &weight, 1, 1);
+		}
+	}
+}
+
+void Effect::resolve_uniforms(QOpenGLShaderProgram *program, const QString &prefix, EffectUniforms &locations) {
+	locations.resolution = program->uniformLocation(prefix + "resolution");
+	locations.time = program->uniformLocation(prefix + "time");
+	locations.iteration = program->uniformLocation(prefix + "iteration");
 
+	// in the same order set_uniforms() sets them
+	locations.fields.clear();
 	for (int i=0;i<rows.size();i++) {
 		EffectRow* row = rows.at(i);
 		for (int j=0;j<row->fieldCount();j++) {
 			EffectField* field = row->field(j);
-			if (!field->id.isEmpty()) {
+			locations.fields.append(field->id.isEmpty() ? -1 : program->uniformLocation(prefix + field->id));
+		}
+	}
+}
+
+void Effect::set_uniforms(QOpenGLShaderProgram *program, const EffectUniforms &locations, double timecode, int iteration) {
+	program->setUniformValue(locations.resolution, GLfloat(parent_clip->media_width()), GLfloat(parent_clip->media_height()));
+	program->setUniformValue(locations.time, GLfloat(timecode));
+	program->setUniformValue(locations.iteration, iteration);
+
+	int uniform_index = 0;
+	for (int i=0;i<rows.size();i++) {
+		EffectRow* row = rows.at(i);
+		for (int j=0;j<row->fieldCount();j++) {
+			EffectField* field = row->field(j);
+			int location = locations.fields.value(uniform_index++, -1);
+			if (location != -1) {
 				switch (field->type) {
 				case EFFECT_FIELD_DOUBLE:
-					glslProgram->setUniformValue(field->id.toUtf8().constData(), GLfloat(field->get_double_value(timecode)));
+					program->setUniformValue(location, GLfloat(field->get_double_value(timecode)));
 					break;
 				case EFFECT_FIELD_COLOR:
-					glslProgram->setUniformValue(
-								field->id.toUtf8().constData(),
+					program->setUniformValue(
+								location,
 								GLfloat(field->get_color_value(timecode).redF()),
 								GLfloat(field->get_color_value(timecode).greenF()),
 								GLfloat(field->get_color_value(timecode).blueF())
@@ -885,10 +1132,10 @@ void Effect::process_shader(double timecode, GLTextureCoords&, int iteration) {
 					break;
 				case EFFECT_FIELD_STRING: break; // can you even send a string to a uniform value?
 				case EFFECT_FIELD_BOOL:
-					glslProgram->setUniformValue(field->id.toUtf8().constData(), field->get_bool_value(timecode));
+					program->setUniformValue(location, field->get_bool_value(timecode));
 					break;
 				case EFFECT_FIELD_COMBO:
-					glslProgram->setUniformValue(field->id.toUtf8().constData(), field->get_combo_index(timecode));
+					program->setUniformValue(location, field->get_combo_index(timecode));
 					break;
 				case EFFECT_FIELD_FONT: break; // can you even send a string to a uniform value?
 				case EFFECT_FIELD_FILE: break; // can you even send a string to a uniform value?
@@ -898,22 +1145,78 @@ void Effect::process_shader(double timecode, GLTextureCoords&, int iteration) {
 	}
 }
 
+EffectField* Effect::find_field(const QString &id) {
+	for (int i=0;i<rows.size();i++) {
+		EffectRow* row = rows.at(i);
+		for (int j=0;j<row->fieldCount();j++) {
+			if (row->field(j)->id == id) {
+				return row->field(j);
+			}
+		}
+	}
+	return nullptr;
+}
+
+void Effect::plan_blur(double timecode) {
+	blur_passes.clear();
+
+	double size = blur_size->get_double_value(timecode) * blur_scale;
+
+	if (blur_angle != nullptr) {
+		double radians = qDegreesToRadians(blur_angle->get_double_value(timecode));
+		if (blur_type == EFFECT_BLUR_GAUSSIAN) {
+			plan_gaussian_blur(blur_passes, size, qCos(radians), qSin(radians));
+		} else {
+			plan_box_blur(blur_passes, size, qCos(radians), qSin(radians));
+		}
+	} else {
+		// separable, horizontal passes followed by vertical ones
+		for (int i=0;i<2;i++) {
+			EffectField* toggle = (i == 0) ? blur_horizontal : blur_vertical;
+			if (toggle == nullptr || toggle->get_bool_value(timecode)) {
+				if (blur_type == EFFECT_BLUR_GAUSSIAN) {
+					plan_gaussian_blur(blur_passes, size, 1 - i, i);
+				} else {
+					plan_box_blur(blur_passes, size, 1 - i, i);
+				}
+			}
+		}
+	}
+
+	// always run at least one pass so the image still gets drawn
+	setIterations(qMax(1, blur_passes.size()));
+}
+
 void Effect::process_coords(double, GLTextureCoords&, int) {}
 
 GLuint Effect::process_superimpose(double timecode) {
-	bool dimensions_changed = false;
 	bool redrew_image = false;
 
-  int width = parent_clip->media_width();
-  int height = parent_clip->media_height();
+	int width = parent_clip->media_width();
+	int height = parent_clip->media_height();
 
-	if (width != img.width() || height != img.height()) {
-		img = QImage(width, height, QImage::Format_RGBA8888_Premultiplied);
-		dimensions_changed = true;
-	}
+	bool frame_changed = (width != superimpose_frame_size.width() || height != superimpose_frame_size.height());
+
+	if (valueHasChanged(timecode) || frame_changed || enable_always_update) {
+		superimpose_frame_size = QSize(width, height);
 
-	if (valueHasChanged(timecode) || dimensions_changed || enable_always_update) {
-		redraw(timecode);
+		// only paint and upload the part of the frame with something in it
+		QRect bounds = superimpose_bounds(timecode).intersected(QRect(0, 0, width, height));
+		bool empty = bounds.isEmpty();
+		if (empty) {
+			bounds = QRect(0, 0, 1, 1);
+		}
+		superimpose_rect = bounds;
+
+		if (img.size() != bounds.size()) {
+			img = QImage(bounds.size(), QImage::Format_RGBA8888_Premultiplied);
+		}
+
+		if (empty) {
+			img.fill(Qt::transparent);
+		} else {
+			redraw(timecode);
+		}
 		redrew_image = true;
 	}
 
@@ -937,6 +1240,14 @@ GLuint Effect::process_superimpose(double timecode) {
 	return texture->textureId();
 }
 
+const QRect &Effect::get_superimpose_rect() {
+	return superimpose_rect;
+}
+
+QRect Effect::superimpose_bounds(double) {
+	return QRect(0, 0, parent_clip->media_width(), parent_clip->media_height());
+}
+
 void Effect::process_audio(double, double, quint8*, int, int) {}
 
 void Effect::gizmo_draw(double, GLTextureCoords &) {}
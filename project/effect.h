@@ -28,6 +28,7 @@
 #include <QColor>
 #include <QOpenGLFunctions>
 #include <QOpenGLShaderProgram>
+#include <QPointer>
 #include <QOpenGLTexture>
 #include <QMutex>
 #include <QThread>
@@ -38,12 +39,16 @@
 #include <QMouseEvent>
 #include <QXmlStreamReader>
 #include <QXmlStreamWriter>
+#include <QCryptographicHash>
 #include <random>
 
+#include "rendering/blurkernel.h"
 #include "ui/collapsiblewidget.h"
 #include "ui/checkboxex.h"
 
 class Clip;
+class BinaryReader;
+struct EffectSnapshot;
 
 class Effect;
 using EffectPtr = std::shared_ptr<Effect>;
@@ -94,6 +99,20 @@ enum EffectInternal {
   EFFECT_INTERNAL_COUNT
 };
 
+enum EffectBlurType {
+  EFFECT_BLUR_NONE,
+  EFFECT_BLUR_GAUSSIAN,
+  EFFECT_BLUR_BOX
+};
+
+// locations of an effect's uniforms in a shader program
+struct EffectUniforms {
+  int resolution;
+  int time;
+  int iteration;
+  QVector<int> fields;
+};
+
 enum EffectBlendMode {
   BLEND_MODE_ADD,
   BLEND_MODE_AVERAGE,
@@ -159,6 +178,9 @@ struct GLTextureCoords {
 
 const EffectMeta* get_meta_from_name(const QString& input);
 
+// reads a field value of an EffectFieldType from a binary project
+QVariant load_data_from_stream(int type, BinaryReader& stream);
+
 qint16 mix_audio_sample(qint16 a, qint16 b);
 
 #include "effectfield.h"
@@ -174,8 +196,19 @@ public:
   const EffectMeta* meta;
   int id;
   QString name;
+
+  // Effect Controls UI, nullptr until create_ui() is called
   CollapsibleWidget* container;
 
+  /**
+   * @brief Create this effect's Effect Controls UI if it hasn't been created yet
+   *
+   * Effects are created as plain data (rows and fields hold their own values) so that loading a project doesn't build
+   * widgets for every effect in it. The UI is only built once the effect is actually shown. Must be called from the
+   * main thread.
+   */
+  void create_ui();
+
   EffectRow* add_row(const QString &name, bool savable = true, bool keyframable = true);
   EffectRow* row(int i);
   int row_count();
@@ -194,7 +227,17 @@ public:
 
   virtual void load(QXmlStreamReader& stream);
   virtual void custom_load(QXmlStreamReader& stream);
-  virtual void save(QXmlStreamWriter& stream);
+  void save(QXmlStreamWriter& stream);
+
+  // binary project loading (see io/binaryproject.h), mirrors load()
+  virtual void load_binary(BinaryReader& stream);
+
+  /**
+   * @brief Copy everything that gets saved about this effect into plain data
+   *
+   * Used by both save() and project saving (see projectsnapshot.h), which writes the snapshot on another thread.
+   */
+  virtual EffectSnapshot snapshot();
 
   void load_from_string(const QByteArray &s);
   QByteArray save_to_string();
@@ -204,6 +247,21 @@ public:
   void open();
   void close();
   bool is_glsl_linked();
+
+  // full paths to the effect's shaders
+  QString get_vert_path();
+  QString get_frag_path();
+
+  // returns true if this effect can currently be drawn as a stage of a fused shader (see shaderfusion.h)
+  bool can_fuse();
+
+  // sets this effect's uniforms in a fused program, stage is its index in the list of fused shaders
+  void process_fused_shader(QOpenGLShaderProgram* program, int stage, double timecode);
+
+  // adds everything this effect's output depends on at timecode to `hash` (see EffectStageCache), returns false if
+  // its output can't be reused
+  bool hash_stage(QCryptographicHash& hash, double timecode);
+
   virtual void startEffect();
   virtual void endEffect();
 
@@ -221,6 +279,9 @@ public:
   virtual void process_shader(double timecode, GLTextureCoords&, int iteration);
   virtual void process_coords(double timecode, GLTextureCoords& coords, int data);
   virtual GLuint process_superimpose(double timecode);
+
+  // area of the frame (in pixels from the top left) the texture from process_superimpose() covers
+  const QRect& get_superimpose_rect();
   virtual void process_audio(double timecode_start, double timecode_end, quint8* samples, int nb_bytes, int channel_count);
 
   virtual void gizmo_draw(double timecode, GLTextureCoords& coords);
@@ -242,6 +303,7 @@ public:
 public slots:
   void field_changed();
 private slots:
+  void enabled_check_changed(bool e);
   void show_context_menu(const QPoint&);
   void delete_self();
   void move_up();
@@ -249,34 +311,73 @@ private slots:
   void save_to_file();
   void load_from_file();
 protected:
-  // glsl effect
-  QOpenGLShaderProgram* glslProgram;
+  // glsl effect, the program is shared with other effects using the same shaders (see ShaderProgramCache)
+  QPointer<QOpenGLShaderProgram> glslProgram;
   QString vertPath;
   QString fragPath;
 
-  // superimpose effect
+  // superimpose effect, img covers superimpose_rect of the frame
   QImage img;
   QOpenGLTexture* texture;
+  QRect superimpose_rect;
+
+  // bounding box of the superimpose effect's content in frame pixels, only this area is redrawn and uploaded
+  virtual QRect superimpose_bounds(double timecode);
 
   // enable effect to update constantly
   bool enable_always_update;
+
+  // called at the end of create_ui() for effects that need to customize their widgets
+  virtual void custom_create_ui();
+
+  // releases superimpose textures when the effect closes, effects with their own GL resources free them here too
+  virtual void delete_texture();
+
+  // returns true if any field changed since the last call
+  bool valueHasChanged(double timecode);
 private:
   // superimpose effect
   QString script;
+  QSize superimpose_frame_size;
 
   bool isOpen;
   QVector<EffectRow*> rows;
   QVector<EffectGizmo*> gizmos;
   QGridLayout* ui_layout;
   QWidget* ui;
+  bool enabled_;
   bool bound;
   int iterations;
 
+  // uniform locations in glslProgram, resolved when the effect is opened rather than by name every frame
+  EffectUniforms uniforms;
+  void resolve_uniforms(QOpenGLShaderProgram* program, const QString& prefix, EffectUniforms& locations);
+  void set_uniforms(QOpenGLShaderProgram* program, const EffectUniforms& locations, double timecode, int iteration);
+
+  // effect file marked the shader as fusible, and the fused program and stage fused_uniforms were resolved for
+  bool fusible;
+  QPointer<QOpenGLShaderProgram> fused_program;
+  int fused_stage;
+  EffectUniforms fused_uniforms;
+
+  // blur set up by an effect file's <blur> element, run as one shader iteration per pass (see blurkernel.h)
+  int blur_type;
+  double blur_scale;
+  EffectField* blur_size;
+  EffectField* blur_horizontal;
+  EffectField* blur_vertical;
+  EffectField* blur_angle;
+  QVector<BlurPass> blur_passes;
+  int blur_direction_uniform;
+  int blur_taps_uniform;
+  int blur_offsets_uniform;
+  int blur_weights_uniform;
+  EffectField* find_field(const QString& id);
+  void plan_blur(double timecode);
+
   // superimpose functions
   virtual void redraw(double timecode);
-  bool valueHasChanged(double timecode);
   QVector<QVariant> cachedValues;
-  void delete_texture();
   int get_index_in_clip();
   void validate_meta_path();
 };
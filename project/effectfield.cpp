@@ -41,18 +41,76 @@
 
 #include <QDateTime>
 #include <QtMath>
+#include <QFontDatabase>
+#include <QSignalBlocker>
 
 #include "debug.h"
 
+namespace {
+	// the first font family is what a freshly created FontCombobox would select
+	QString default_font_family() {
+		static QString family = QFontDatabase().families().value(0);
+		return family;
+	}
+}
+
 EffectField::EffectField(EffectRow *parent, int t, const QString &i) :
 	parent_row(parent),
 	type(t),
-	id(i)
+	id(i),
+	ui_element(nullptr),
+	enabled_(true),
+	double_default_(0),
+	double_set_(false),
+	double_min_enabled_(false),
+	double_min_(0),
+	double_max_enabled_(false),
+	double_max_(0),
+	double_display_type_(LABELSLIDER_NORMAL),
+	double_frame_rate_(30)
 {
 	switch (t) {
+	case EFFECT_FIELD_DOUBLE:
+		data_ = 0.0;
+		break;
+	case EFFECT_FIELD_COLOR:
+		data_ = QColor(Qt::white);
+		break;
+	case EFFECT_FIELD_STRING:
+	case EFFECT_FIELD_FILE:
+		data_ = QString();
+		break;
+	case EFFECT_FIELD_BOOL:
+		data_ = false;
+		break;
+	case EFFECT_FIELD_COMBO:
+		// no items yet, becomes 0 once the first item is added
+		data_ = -1;
+		break;
+	case EFFECT_FIELD_FONT:
+		data_ = default_font_family();
+		break;
+	}
+	previous_data_ = data_;
+}
+
+EffectField::~EffectField() {
+	// widgets that were placed in the Effect Controls are owned (and deleted) by the effect's container
+	if (ui_element != nullptr && ui_element->parent() == nullptr) {
+		delete ui_element;
+	}
+}
+
+void EffectField::create_ui_element() {
+	switch (type) {
 	case EFFECT_FIELD_DOUBLE:
 	{
 		LabelSlider* ls = new LabelSlider();
+		ls->set_display_type(double_display_type_);
+		ls->set_frame_rate(double_frame_rate_);
+		if (double_min_enabled_) ls->set_minimum_value(double_min_);
+		if (double_max_enabled_) ls->set_maximum_value(double_max_);
+		ls->set_default_value(double_default_);
 		ui_element = ls;
 		connect(ls, SIGNAL(valueChanged()), this, SLOT(ui_element_change()));
 		connect(ls, SIGNAL(clicked()), this, SIGNAL(clicked()));
@@ -82,12 +140,14 @@ EffectField::EffectField(EffectRow *parent, int t, const QString &i) :
 		CheckboxEx* cb = new CheckboxEx();
 		ui_element = cb;
 		connect(cb, SIGNAL(clicked(bool)), this, SLOT(ui_element_change()));
-		connect(cb, SIGNAL(toggled(bool)), this, SIGNAL(toggled(bool)));
 	}
 		break;
 	case EFFECT_FIELD_COMBO:
 	{
 		ComboBoxEx* cb = new ComboBoxEx();
+		for (int i=0;i<combo_names_.size();i++) {
+			cb->addItem(combo_names_.at(i), combo_data_.at(i));
+		}
 		ui_element = cb;
 		connect(cb, SIGNAL(activated(int)), this, SLOT(ui_element_change()));
 	}
@@ -107,9 +167,74 @@ EffectField::EffectField(EffectRow *parent, int t, const QString &i) :
 	}
 		break;
 	}
+
+	update_ui_element();
+	ui_element->setEnabled(enabled_);
+}
+
+void EffectField::update_ui_element() {
+	if (ui_element == nullptr) {
+		return;
+	}
+
+	switch (type) {
+	case EFFECT_FIELD_DOUBLE:
+		// before a value is set, the slider shows (and alt+click returns to) the default value
+		if (double_set_) static_cast<LabelSlider*>(ui_element)->set_value(data_.toDouble(), false);
+		break;
+	case EFFECT_FIELD_COLOR:
+		static_cast<ColorButton*>(ui_element)->set_color(data_.value<QColor>());
+		break;
+	case EFFECT_FIELD_STRING:
+		static_cast<TextEditEx*>(ui_element)->setPlainTextEx(data_.toString());
+		break;
+	case EFFECT_FIELD_BOOL:
+		static_cast<QCheckBox*>(ui_element)->setChecked(data_.toBool());
+		break;
+	case EFFECT_FIELD_COMBO:
+		static_cast<ComboBoxEx*>(ui_element)->setCurrentIndexEx(data_.toInt());
+		break;
+	case EFFECT_FIELD_FONT:
+		static_cast<FontCombobox*>(ui_element)->setCurrentTextEx(data_.toString());
+		break;
+	case EFFECT_FIELD_FILE:
+	{
+		// the chooser signals a change for any new filename, only user changes should create undo commands
+		QSignalBlocker blocker(ui_element);
+		static_cast<EmbeddedFileChooser*>(ui_element)->setFilename(data_.toString());
+	}
+		break;
+	}
 }
 
-EffectField::~EffectField() {}
+void EffectField::set_data_internal(const QVariant &data) {
+	bool toggle = false;
+
+	switch (type) {
+	case EFFECT_FIELD_DOUBLE:
+	{
+		double v = data.toDouble();
+		if (double_min_enabled_ && v < double_min_) {
+			v = double_min_;
+		} else if (double_max_enabled_ && v > double_max_) {
+			v = double_max_;
+		}
+		data_ = v;
+		double_set_ = true;
+	}
+		break;
+	case EFFECT_FIELD_BOOL:
+		toggle = (data_.toBool() != data.toBool());
+		data_ = data.toBool();
+		break;
+	default:
+		data_ = data;
+	}
+
+	if (toggle) {
+		emit toggled(data_.toBool());
+	}
+}
 
 double EffectField::get_validated_keyframe_handle(int key, bool post) {
 	int comp_key = -1;
@@ -158,11 +283,18 @@ double EffectField::get_validated_keyframe_handle(int key, bool post) {
 }
 
 QVariant EffectField::get_previous_data() {
+	if (type == EFFECT_FIELD_BOOL) {
+		return !data_.toBool();
+	}
+
+	if (ui_element == nullptr) {
+		return previous_data_;
+	}
+
 	switch (type) {
 	case EFFECT_FIELD_DOUBLE: return static_cast<LabelSlider*>(ui_element)->getPreviousValue();
 	case EFFECT_FIELD_COLOR: return static_cast<ColorButton*>(ui_element)->getPreviousValue();
 	case EFFECT_FIELD_STRING: return static_cast<TextEditEx*>(ui_element)->getPreviousValue();
-	case EFFECT_FIELD_BOOL: return !static_cast<QCheckBox*>(ui_element)->isChecked();
 	case EFFECT_FIELD_COMBO: return static_cast<ComboBoxEx*>(ui_element)->getPreviousIndex();
 	case EFFECT_FIELD_FONT: return static_cast<FontCombobox*>(ui_element)->getPreviousValue();
 	case EFFECT_FIELD_FILE: return static_cast<EmbeddedFileChooser*>(ui_element)->getPreviousValue();
@@ -171,16 +303,14 @@ QVariant EffectField::get_previous_data() {
 }
 
 QVariant EffectField::get_current_data() {
-	switch (type) {
-	case EFFECT_FIELD_DOUBLE: return static_cast<LabelSlider*>(ui_element)->value();
-	case EFFECT_FIELD_COLOR: return static_cast<ColorButton*>(ui_element)->get_color();
-	case EFFECT_FIELD_STRING: return static_cast<TextEditEx*>(ui_element)->getPlainTextEx();
-	case EFFECT_FIELD_BOOL: return static_cast<QCheckBox*>(ui_element)->isChecked();
-	case EFFECT_FIELD_COMBO: return static_cast<ComboBoxEx*>(ui_element)->currentIndex();
-	case EFFECT_FIELD_FONT: return static_cast<FontCombobox*>(ui_element)->currentText();
-	case EFFECT_FIELD_FILE: return static_cast<EmbeddedFileChooser*>(ui_element)->getFilename();
+	return data_;
+}
+
+void EffectField::set_previous_data() {
+	previous_data_ = data_;
+	if (type == EFFECT_FIELD_DOUBLE && ui_element != nullptr) {
+		static_cast<LabelSlider*>(ui_element)->set_previous_value();
 	}
-	return QVariant();
 }
 
 double EffectField::frameToTimecode(long frame) {
@@ -192,15 +322,8 @@ long EffectField::timecodeToFrame(double timecode) {
 }
 
 void EffectField::set_current_data(const QVariant& data) {
-	switch (type) {
-	case EFFECT_FIELD_DOUBLE: return static_cast<LabelSlider*>(ui_element)->set_value(data.toDouble(), false);
-	case EFFECT_FIELD_COLOR: return static_cast<ColorButton*>(ui_element)->set_color(data.value<QColor>());
-	case EFFECT_FIELD_STRING: return static_cast<TextEditEx*>(ui_element)->setPlainTextEx(data.toString());
-	case EFFECT_FIELD_BOOL: return static_cast<QCheckBox*>(ui_element)->setChecked(data.toBool());
-	case EFFECT_FIELD_COMBO: return static_cast<ComboBoxEx*>(ui_element)->setCurrentIndexEx(data.toInt());
-	case EFFECT_FIELD_FONT: return static_cast<FontCombobox*>(ui_element)->setCurrentTextEx(data.toString());
-	case EFFECT_FIELD_FILE: return static_cast<EmbeddedFileChooser*>(ui_element)->setFilename(data.toString());
-	}
+	set_data_internal(data);
+	update_ui_element();
 }
 
 void EffectField::get_keyframe_data(double timecode, int &before, int &after, double &progress) {
@@ -290,7 +413,7 @@ QVariant EffectField::validate_keyframe_data(double timecode, bool async) {
 			if (async) {
 				return value;
 			}
-			static_cast<LabelSlider*>(ui_element)->set_value(value, false);
+			set_current_data(value);
 		}
 			break;
 		case EFFECT_FIELD_COLOR:
@@ -306,38 +429,38 @@ QVariant EffectField::validate_keyframe_data(double timecode, bool async) {
 			if (async) {
 				return value;
 			}
-			static_cast<ColorButton*>(ui_element)->set_color(value);
+			set_current_data(value);
 		}
 			break;
 		case EFFECT_FIELD_STRING:
 			if (async) {
 				return before_data;
 			}
-			static_cast<TextEditEx*>(ui_element)->setPlainTextEx(before_data.toString());
+			set_current_data(before_data);
 			break;
 		case EFFECT_FIELD_BOOL:
 			if (async) {
 				return before_data;
 			}
-			static_cast<QCheckBox*>(ui_element)->setChecked(before_data.toBool());
+			set_current_data(before_data);
 			break;
 		case EFFECT_FIELD_COMBO:
 			if (async) {
 				return before_data;
 			}
-			static_cast<ComboBoxEx*>(ui_element)->setCurrentIndexEx(before_data.toInt());
+			set_current_data(before_data);
 			break;
 		case EFFECT_FIELD_FONT:
 			if (async) {
 				return before_data;
 			}
-			static_cast<FontCombobox*>(ui_element)->setCurrentTextEx(before_data.toString());
+			set_current_data(before_data);
 			break;
 		case EFFECT_FIELD_FILE:
 			if (async) {
 				return before_data;
 			}
-			static_cast<EmbeddedFileChooser*>(ui_element)->setFilename(before_data.toString());
+			set_current_data(before_data);
 			break;
 		}
 	}
@@ -345,7 +468,20 @@ QVariant EffectField::validate_keyframe_data(double timecode, bool async) {
 }
 
 void EffectField::ui_element_change() {
-	bool dragging_double = (type == EFFECT_FIELD_DOUBLE && static_cast<LabelSlider*>(ui_element)->is_dragging());
+	// pull the value the user entered into the field
+	if (ui_element != nullptr) {
+		switch (type) {
+		case EFFECT_FIELD_DOUBLE: set_data_internal(static_cast<LabelSlider*>(ui_element)->value()); break;
+		case EFFECT_FIELD_COLOR: set_data_internal(static_cast<ColorButton*>(ui_element)->get_color()); break;
+		case EFFECT_FIELD_STRING: set_data_internal(static_cast<TextEditEx*>(ui_element)->getPlainTextEx()); break;
+		case EFFECT_FIELD_BOOL: set_data_internal(static_cast<QCheckBox*>(ui_element)->isChecked()); break;
+		case EFFECT_FIELD_COMBO: set_data_internal(static_cast<ComboBoxEx*>(ui_element)->currentIndex()); break;
+		case EFFECT_FIELD_FONT: set_data_internal(static_cast<FontCombobox*>(ui_element)->currentText()); break;
+		case EFFECT_FIELD_FILE: set_data_internal(static_cast<EmbeddedFileChooser*>(ui_element)->getFilename()); break;
+		}
+	}
+
+	bool dragging_double = (type == EFFECT_FIELD_DOUBLE && ui_element != nullptr && static_cast<LabelSlider*>(ui_element)->is_dragging());
 	ComboAction* ca = nullptr;
 	if (!dragging_double) ca = new ComboAction();
 	make_key_from_change(ca);
@@ -363,15 +499,25 @@ void EffectField::make_key_from_change(ComboAction* ca) {
 }
 
 QWidget* EffectField::get_ui_element() {
+	if (ui_element == nullptr) {
+		create_ui_element();
+	}
 	return ui_element;
 }
 
+bool EffectField::has_ui_element() {
+	return ui_element != nullptr;
+}
+
 bool EffectField::is_enabled() {
-	return ui_element->isEnabled();
+	return enabled_;
 }
 
 void EffectField::set_enabled(bool e) {
-	ui_element->setEnabled(e);
+	enabled_ = e;
+	if (ui_element != nullptr) {
+		ui_element->setEnabled(e);
+	}
 }
 
 double EffectField::get_double_value(double timecode, bool async) {
@@ -379,27 +525,68 @@ double EffectField::get_double_value(double timecode, bool async) {
 		return validate_keyframe_data(timecode, true).toDouble();
 	}
 	validate_keyframe_data(timecode);
-	return static_cast<LabelSlider*>(ui_element)->value();
+	return data_.toDouble();
 }
 
 void EffectField::set_double_value(double v) {
-	static_cast<LabelSlider*>(ui_element)->set_value(v, false);
+	set_current_data(v);
 }
 
 void EffectField::set_double_default_value(double v) {
-	static_cast<LabelSlider*>(ui_element)->set_default_value(v);
+	double_default_ = v;
+	if (ui_element != nullptr) {
+		static_cast<LabelSlider*>(ui_element)->set_default_value(v);
+	}
+
+	// like LabelSlider, the default only becomes the value if no value has been set yet
+	if (!double_set_) {
+		set_data_internal(v);
+		double_set_ = false;
+	}
 }
 
 void EffectField::set_double_minimum_value(double v) {
-	static_cast<LabelSlider*>(ui_element)->set_minimum_value(v);
+	double_min_ = v;
+	double_min_enabled_ = true;
+	if (ui_element != nullptr) {
+		static_cast<LabelSlider*>(ui_element)->set_minimum_value(v);
+	}
 }
 
 void EffectField::set_double_maximum_value(double v) {
-	static_cast<LabelSlider*>(ui_element)->set_maximum_value(v);
+	double_max_ = v;
+	double_max_enabled_ = true;
+	if (ui_element != nullptr) {
+		static_cast<LabelSlider*>(ui_element)->set_maximum_value(v);
+	}
+}
+
+void EffectField::set_double_display_type(int type) {
+	double_display_type_ = type;
+	if (ui_element != nullptr) {
+		static_cast<LabelSlider*>(ui_element)->set_display_type(type);
+	}
+}
+
+void EffectField::set_double_frame_rate(double rate) {
+	double_frame_rate_ = rate;
+	if (ui_element != nullptr) {
+		static_cast<LabelSlider*>(ui_element)->set_frame_rate(rate);
+	}
 }
 
 void EffectField::add_combo_item(const QString& name, const QVariant& data) {
-	static_cast<ComboBoxEx*>(ui_element)->addItem(name, data);
+	combo_names_.append(name);
+	combo_data_.append(data);
+	if (ui_element != nullptr) {
+		static_cast<ComboBoxEx*>(ui_element)->addItem(name, data);
+	}
+
+	// a combobox selects its first item as soon as it's added
+	if (data_.toInt() < 0) {
+		data_ = 0;
+		previous_data_ = data_;
+	}
 }
 
 int EffectField::get_combo_index(double timecode, bool async) {
@@ -407,25 +594,28 @@ int EffectField::get_combo_index(double timecode, bool async) {
 		return validate_keyframe_data(timecode, true).toInt();
 	}
 	validate_keyframe_data(timecode);
-	return static_cast<ComboBoxEx*>(ui_element)->currentIndex();
+	return data_.toInt();
 }
 
 QVariant EffectField::get_combo_data(double timecode) {
 	validate_keyframe_data(timecode);
-	return static_cast<ComboBoxEx*>(ui_element)->currentData();
+	return combo_data_.value(data_.toInt());
 }
 
 QString EffectField::get_combo_string(double timecode) {
 	validate_keyframe_data(timecode);
-	return static_cast<ComboBoxEx*>(ui_element)->currentText();
+	return combo_names_.value(data_.toInt());
 }
 
 void EffectField::set_combo_index(int index) {
-	static_cast<ComboBoxEx*>(ui_element)->setCurrentIndexEx(index);
+	set_current_data(index);
 }
 
 void EffectField::set_combo_string(const QString& s) {
-	static_cast<ComboBoxEx*>(ui_element)->setCurrentTextEx(s);
+	int index = combo_names_.indexOf(s);
+	if (index > -1) {
+		set_current_data(index);
+	}
 }
 
 bool EffectField::get_bool_value(double timecode, bool async) {
@@ -433,11 +623,11 @@ bool EffectField::get_bool_value(double timecode, bool async) {
 		return validate_keyframe_data(timecode, true).toBool();
 	}
 	validate_keyframe_data(timecode);
-	return static_cast<QCheckBox*>(ui_element)->isChecked();
+	return data_.toBool();
 }
 
 void EffectField::set_bool_value(bool b) {
-	return static_cast<QCheckBox*>(ui_element)->setChecked(b);
+	set_current_data(b);
 }
 
 QString EffectField::get_string_value(double timecode, bool async) {
@@ -445,11 +635,11 @@ QString EffectField::get_string_value(double timecode, bool async) {
 		return validate_keyframe_data(timecode, true).toString();
 	}
 	validate_keyframe_data(timecode);
-	return static_cast<TextEditEx*>(ui_element)->getPlainTextEx();
+	return data_.toString();
 }
 
 void EffectField::set_string_value(const QString& s) {
-	static_cast<TextEditEx*>(ui_element)->setPlainTextEx(s);
+	set_current_data(s);
 }
 
 QString EffectField::get_font_name(double timecode, bool async) {
@@ -457,11 +647,11 @@ QString EffectField::get_font_name(double timecode, bool async) {
 		return validate_keyframe_data(timecode, true).toString();
 	}
 	validate_keyframe_data(timecode);
-	return static_cast<FontCombobox*>(ui_element)->currentText();
+	return data_.toString();
 }
 
 void EffectField::set_font_name(const QString& s) {
-	static_cast<FontCombobox*>(ui_element)->setCurrentText(s);
+	set_current_data(s);
 }
 
 QColor EffectField::get_color_value(double timecode, bool async) {
@@ -469,11 +659,11 @@ QColor EffectField::get_color_value(double timecode, bool async) {
 		return validate_keyframe_data(timecode, true).value<QColor>();
 	}
 	validate_keyframe_data(timecode);
-	return static_cast<ColorButton*>(ui_element)->get_color();
+	return data_.value<QColor>();
 }
 
 void EffectField::set_color_value(QColor color) {
-	static_cast<ColorButton*>(ui_element)->set_color(color);
+	set_current_data(color);
 }
 
 QString EffectField::get_filename(double timecode, bool async) {
@@ -481,9 +671,9 @@ QString EffectField::get_filename(double timecode, bool async) {
 		return validate_keyframe_data(timecode, true).toString();
 	}
 	validate_keyframe_data(timecode);
-	return static_cast<EmbeddedFileChooser*>(ui_element)->getFilename();
+	return data_.toString();
 }
 
 void EffectField::set_filename(const QString &s) {
-	static_cast<EmbeddedFileChooser*>(ui_element)->setFilename(s);
+	set_current_data(s);
 }
@@ -88,17 +88,55 @@ public:
 	QString get_filename(double timecode, bool async = false);
 	void set_filename(const QString& s);
 
+	// LabelSlider display settings, only used by EFFECT_FIELD_DOUBLE
+	void set_double_display_type(int type);
+	void set_double_frame_rate(double rate);
+
+	// stores the current value as the one an undo command will revert to (e.g. before a gizmo drag)
+	void set_previous_data();
+
+	/**
+	 * @brief Get this field's UI widget, creating it if it doesn't exist yet
+	 *
+	 * Fields hold their values themselves and only create a widget when the Effect Controls panel first shows them,
+	 * so effects that are never looked at (e.g. on clips in sequences that aren't open) never create any widgets.
+	 * Must only be called from the main thread.
+	 */
 	QWidget* get_ui_element();
+	bool has_ui_element();
 	bool is_enabled();
 	void set_enabled(bool e);
 	QVector<EffectKeyframe> keyframes;
-	QWidget* ui_element;
 
 	void make_key_from_change(ComboAction* ca);
 public slots:
 	void ui_element_change();
 private:
 	bool hasKeyframes();
+	void create_ui_element();
+	void set_data_internal(const QVariant& data);
+	void update_ui_element();
+
+	QWidget* ui_element;
+
+	// current value, kept regardless of whether a widget exists
+	QVariant data_;
+	QVariant previous_data_;
+	bool enabled_;
+
+	// EFFECT_FIELD_DOUBLE settings
+	double double_default_;
+	bool double_set_;
+	bool double_min_enabled_;
+	double double_min_;
+	bool double_max_enabled_;
+	double double_max_;
+	int double_display_type_;
+	double double_frame_rate_;
+
+	// EFFECT_FIELD_COMBO items
+	QVector<QString> combo_names_;
+	QVector<QVariant> combo_data_;
 signals:
 	void changed();
 	void toggled(bool);
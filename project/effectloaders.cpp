@@ -22,6 +22,7 @@
 
 #include "project/effect.h"
 #include "project/transition.h"
+#include "project/effectregistrycache.h"
 #include "io/path.h"
 #include "panels/panels.h"
 #include "panels/effectcontrols.h"
@@ -130,16 +131,27 @@ void load_internal_effects() {
 	effects.append(em);
 }
 
-void load_shader_effects() {
+void load_shader_effects(EffectRegistryCache& cache) {
 	QList<QString> effects_paths = get_effects_paths();
 
 	for (int h=0;h<effects_paths.size();h++) {
 		const QString& effects_path = effects_paths.at(h);
 		QDir effects_dir(effects_path);
 		if (effects_dir.exists()) {
-			QList<QString> entries = effects_dir.entryList(QStringList("*.xml"), QDir::Files);
+			QStringList entries;
+			QStringList subdirs;
+			cache.ListDir(effects_path, QStringList("*.xml"), entries, subdirs);
 			for (int i=0;i<entries.size();i++) {
-				QFile file(effects_path + "/" + entries.at(i));
+				QString file_path = effects_path + "/" + entries.at(i);
+
+				// skip parsing XML that hasn't changed since the last startup
+				QVector<EffectMeta> found;
+				if (cache.Find(file_path, found)) {
+					effects.append(found);
+					continue;
+				}
+
+				QFile file(file_path);
 				if (!file.open(QIODevice::ReadOnly)) {
 					qCritical() << "Could not open" << entries.at(i);
 					return;
@@ -167,7 +179,7 @@ void load_shader_effects() {
 							em.filename = file.fileName();
 							em.path = effects_path;
 							em.internal = -1;
-							effects.append(em);
+							found.append(em);
 						} else {
 							qCritical() << "Invalid effect found in" << entries.at(i);
 						}
@@ -177,6 +189,9 @@ void load_shader_effects() {
 				}
 
 				file.close();
+
+				effects.append(found);
+				cache.Store(file_path, found);
 			}
 		}
 	}
@@ -189,15 +204,28 @@ void init_effects() {
 }
 
 #ifndef NOFREI0R
-void load_frei0r_effects_worker(const QString& dir, EffectMeta& em, QVector<QString>& loaded_names) {
+void load_frei0r_effects_worker(const QString& dir, EffectMeta& em, QVector<QString>& loaded_names, EffectRegistryCache& cache) {
 	QDir search_dir(dir);
 	if (search_dir.exists()) {
-		QList<QString> entry_list = search_dir.entryList(LibFilter(), QDir::AllDirs | QDir::Files | QDir::NoDotAndDotDot);
+		QStringList file_list;
+		QStringList subdir_list;
+		cache.ListDir(dir, LibFilter(), file_list, subdir_list);
+
+		// visit files and subdirectories in name order like a plain directory listing would
+		QStringList entry_list = file_list + subdir_list;
+		entry_list.sort(Qt::CaseInsensitive);
+
 		for (int j=0;j<entry_list.size();j++) {
 			QString entry_path = search_dir.filePath(entry_list.at(j));
-			if (QFileInfo(entry_path).isDir()) {
-				load_frei0r_effects_worker(entry_path, em, loaded_names);
-			} else {
+			if (subdir_list.contains(entry_list.at(j))) {
+				load_frei0r_effects_worker(entry_path, em, loaded_names, cache);
+				continue;
+			}
+
+			// only load libraries that are new or have changed since the last startup. Frei0rEffect loads the library
+			// again once the effect is actually used.
+			QVector<EffectMeta> found;
+			if (!cache.Find(entry_path, found)) {
 				ModulePtr effect = LibLoad(entry_path);
 				if (effect != nullptr) {
 					f0rGetPluginInfo get_info_func = reinterpret_cast<f0rGetPluginInfo>(LibAddress(effect, "f0r_get_plugin_info"));
@@ -205,29 +233,34 @@ void load_frei0r_effects_worker(const QString& dir, EffectMeta& em, QVector<QStr
 						f0r_plugin_info_t info;
 						get_info_func(&info);
 
-						if (!loaded_names.contains(info.name)
-								&& info.plugin_type == F0R_PLUGIN_TYPE_FILTER
+						if (info.plugin_type == F0R_PLUGIN_TYPE_FILTER
 								&& info.color_model == F0R_COLOR_MODEL_RGBA8888) {
 							em.name = info.name;
 							em.path = dir;
 							em.filename = entry_list.at(j);
 							em.tooltip = QString("%1\n%2\n%3\n%4").arg(em.name, info.author, info.explanation, em.filename);
 
-							loaded_names.append(em.name);
-
-							effects.append(em);
+							found.append(em);
 						}
 //                        qDebug() << "Found:" << info.name << "by" << info.author;
 					}
 					LibClose(effect);
 				}
-//                qDebug() << search_dir.filePath(entry_list.at(j));
+				cache.Store(entry_path, found);
+			}
+
+			// the first plugin found with a given name wins
+			for (int k=0;k<found.size();k++) {
+				if (!loaded_names.contains(found.at(k).name)) {
+					loaded_names.append(found.at(k).name);
+					effects.append(found.at(k));
+				}
 			}
 		}
 	}
 }
 
-void load_frei0r_effects() {
+void load_frei0r_effects(EffectRegistryCache& cache) {
 	QList<QString> effect_dirs = get_effects_paths();
 
 	// add defined paths for frei0r plugins on unix
@@ -250,7 +283,7 @@ void load_frei0r_effects() {
 	em.internal = EFFECT_INTERNAL_FREI0R;
 
 	for (int i=0;i<effect_dirs.size();i++) {
-		load_frei0r_effects_worker(effect_dirs.at(i), em, loaded_names);
+		load_frei0r_effects_worker(effect_dirs.at(i), em, loaded_names, cache);
 	}
 }
 #endif
@@ -261,11 +294,17 @@ EffectInit::EffectInit() {
 
 void EffectInit::run() {
 	qInfo() << "Initializing effects...";
+
+	EffectRegistryCache cache;
+	cache.Load();
+
 	load_internal_effects();
-	load_shader_effects();
+	load_shader_effects(cache);
 #ifndef NOFREI0R
-	load_frei0r_effects();
+	load_frei0r_effects(cache);
 #endif
 	panel_effect_controls->effects_loaded.unlock();
+
+	cache.Save();
 	qInfo() << "Finished initializing effects";
 }
@@ -0,0 +1,170 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "effectregistrycache.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDataStream>
+#include <QDebug>
+
+#include "io/path.h"
+
+// identifies the cache file, bump the version if its layout or what the loaders store in it changes
+const quint32 kRegistryCacheMagic = 0x4f454652; // "OEFR"
+const quint32 kRegistryCacheVersion = 1;
+
+QDataStream& operator<<(QDataStream& stream, const EffectMeta& em) {
+  return stream << em.name << em.category << em.filename << em.path << em.tooltip
+                << qint32(em.internal) << qint32(em.type) << qint32(em.subtype);
+}
+
+QDataStream& operator>>(QDataStream& stream, EffectMeta& em) {
+  qint32 internal, type, subtype;
+  stream >> em.name >> em.category >> em.filename >> em.path >> em.tooltip >> internal >> type >> subtype;
+  em.internal = internal;
+  em.type = type;
+  em.subtype = subtype;
+  return stream;
+}
+
+void EffectRegistryCache::Load()
+{
+  QFile f(cache_filename());
+  if (!f.open(QFile::ReadOnly)) {
+    return;
+  }
+
+  QDataStream stream(&f);
+
+  quint32 magic, version;
+  stream >> magic >> version;
+  if (magic != kRegistryCacheMagic || version != kRegistryCacheVersion) {
+    return;
+  }
+
+  qint32 dir_count;
+  stream >> dir_count;
+  for (int i=0;i<dir_count && stream.status() == QDataStream::Ok;i++) {
+    QString key;
+    CachedDir dir;
+    stream >> key >> dir.modified >> dir.files >> dir.subdirs;
+    dirs_.insert(key, dir);
+  }
+
+  qint32 file_count;
+  stream >> file_count;
+  for (int i=0;i<file_count && stream.status() == QDataStream::Ok;i++) {
+    QString path;
+    CachedFile file;
+    stream >> path >> file.modified >> file.size >> file.effects;
+    files_.insert(path, file);
+  }
+
+  if (stream.status() != QDataStream::Ok) {
+    qWarning() << "Effect registry cache is corrupt, all effects will be scanned";
+    dirs_.clear();
+    files_.clear();
+  }
+}
+
+void EffectRegistryCache::Save()
+{
+  QDir(get_data_path()).mkpath(".");
+
+  QFile f(cache_filename());
+  if (!f.open(QFile::WriteOnly)) {
+    qWarning() << "Failed to write effect registry cache to" << f.fileName();
+    return;
+  }
+
+  QDataStream stream(&f);
+  stream << kRegistryCacheMagic << kRegistryCacheVersion;
+
+  stream << qint32(used_dirs_.size());
+  for (QHash<QString, CachedDir>::const_iterator i=used_dirs_.constBegin();i!=used_dirs_.constEnd();i++) {
+    stream << i.key() << i.value().modified << i.value().files << i.value().subdirs;
+  }
+
+  stream << qint32(used_files_.size());
+  for (QHash<QString, CachedFile>::const_iterator i=used_files_.constBegin();i!=used_files_.constEnd();i++) {
+    stream << i.key() << i.value().modified << i.value().size << i.value().effects;
+  }
+}
+
+void EffectRegistryCache::ListDir(const QString &dir, const QStringList &filters, QStringList &files, QStringList &subdirs)
+{
+  // the same directory may be listed by several loaders with different filters
+  QString key = dir + "|" + filters.join(";");
+  qint64 modified = QFileInfo(dir).lastModified().toMSecsSinceEpoch();
+
+  QHash<QString, CachedDir>::const_iterator cached = dirs_.constFind(key);
+  if (cached != dirs_.constEnd() && cached.value().modified == modified) {
+    files = cached.value().files;
+    subdirs = cached.value().subdirs;
+    used_dirs_.insert(key, cached.value());
+    return;
+  }
+
+  QDir search_dir(dir);
+  files = search_dir.entryList(filters, QDir::Files);
+  subdirs = search_dir.entryList(QDir::AllDirs | QDir::NoDotAndDotDot);
+
+  CachedDir listing;
+  listing.modified = modified;
+  listing.files = files;
+  listing.subdirs = subdirs;
+  used_dirs_.insert(key, listing);
+}
+
+bool EffectRegistryCache::Find(const QString &path, QVector<EffectMeta> &found)
+{
+  QHash<QString, CachedFile>::const_iterator cached = files_.constFind(path);
+  if (cached == files_.constEnd()) {
+    return false;
+  }
+
+  QFileInfo info(path);
+  if (cached.value().modified != info.lastModified().toMSecsSinceEpoch()
+      || cached.value().size != info.size()) {
+    return false;
+  }
+
+  found = cached.value().effects;
+  used_files_.insert(path, cached.value());
+  return true;
+}
+
+void EffectRegistryCache::Store(const QString &path, const QVector<EffectMeta> &found)
+{
+  QFileInfo info(path);
+
+  CachedFile file;
+  file.modified = info.lastModified().toMSecsSinceEpoch();
+  file.size = info.size();
+  file.effects = found;
+  used_files_.insert(path, file);
+}
+
+QString EffectRegistryCache::cache_filename()
+{
+  return get_data_dir().filePath("effectregistry");
+}
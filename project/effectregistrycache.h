@@ -0,0 +1,102 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef EFFECTREGISTRYCACHE_H
+#define EFFECTREGISTRYCACHE_H
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+
+#include "project/effect.h"
+
+/**
+ * @brief The EffectRegistryCache class
+ *
+ * Remembers what the effect loaders found in every effect directory and file on the last startup so unchanged ones
+ * don't need to be scanned again. Most importantly this avoids loading every Frei0r library just to read its plugin
+ * info, which can take several seconds on systems with large Frei0r installs.
+ *
+ * A directory's listing is reused as long as its modification time hasn't changed. A file's effects are reused as
+ * long as its modification time and size haven't changed, which includes files that turned out not to contain a
+ * usable effect. Only directories and files that were looked up during this run are saved, so removed ones drop out of
+ * the cache automatically.
+ *
+ * Only used by the effect loading thread (see init_effects()), so it isn't thread-safe.
+ */
+class EffectRegistryCache {
+public:
+  /**
+   * @brief Read the cache from disk, an unreadable or outdated cache file is ignored
+   */
+  void Load();
+
+  /**
+   * @brief Write everything looked up since Load() to disk
+   */
+  void Save();
+
+  /**
+   * @brief List the files matching `filters` and the subdirectories of a directory
+   *
+   * Uses the cached listing if the directory hasn't been modified since it was made.
+   */
+  void ListDir(const QString& dir, const QStringList& filters, QStringList& files, QStringList& subdirs);
+
+  /**
+   * @brief Get the effects found in a file the last time it was scanned
+   *
+   * @return
+   *
+   * **TRUE** if the file is in the cache and hasn't changed, in which case `found` is set (possibly to an empty list).
+   * **FALSE** if the file needs to be scanned and its results passed to Store().
+   */
+  bool Find(const QString& path, QVector<EffectMeta>& found);
+
+  /**
+   * @brief Store the effects found by scanning a file
+   */
+  void Store(const QString& path, const QVector<EffectMeta>& found);
+
+private:
+  struct CachedDir {
+    qint64 modified;
+    QStringList files;
+    QStringList subdirs;
+  };
+
+  struct CachedFile {
+    qint64 modified;
+    qint64 size;
+    QVector<EffectMeta> effects;
+  };
+
+  QString cache_filename();
+
+  // what was loaded from disk
+  QHash<QString, CachedDir> dirs_;
+  QHash<QString, CachedFile> files_;
+
+  // what was looked up this run and will be saved
+  QHash<QString, CachedDir> used_dirs_;
+  QHash<QString, CachedFile> used_files_;
+};
+
+#endif // EFFECTREGISTRYCACHE_H
@@ -36,43 +36,71 @@
 #include "ui/keyframenavigator.h"
 #include "ui/clickablelabel.h"
 
-EffectRow::EffectRow(Effect *parent, bool save, QGridLayout *uilayout, const QString &n, int row, bool keyframable) :
+EffectRow::EffectRow(Effect *parent, bool save, const QString &n, int row, bool keyframable) :
+	label(nullptr),
 	parent_effect(parent),
 	savable(save),
 	keyframing(false),
-	ui(uilayout),
+	keyframable(keyframable),
+	ui(nullptr),
 	name(n),
 	ui_row(row),
+	keyframe_nav(nullptr),
 	just_made_unsafe_keyframe(false)
-{
-	label = new ClickableLabel(name + ":");
+{}
+
+EffectRow::~EffectRow() {
+	for (int i=0;i<fields.size();i++) {
+		delete fields.at(i);
+	}
+
+	// custom widgets are owned by the effect's UI once it's been created
+	if (ui == nullptr) {
+		for (int i=0;i<widgets.size();i++) {
+			delete widgets.at(i);
+		}
+	}
+}
+
+void EffectRow::create_ui(QGridLayout *uilayout) {
+	if (ui != nullptr) {
+		return;
+	}
 
-	ui->addWidget(label, row, 0);
+	ui = uilayout;
 
-	column_count = 1;
+	label = new ClickableLabel(name + ":");
+
+	ui->addWidget(label, ui_row, 0);
 
-	keyframe_nav = nullptr;
 	if (parent_effect->meta != nullptr
 			&& parent_effect->meta->type != EFFECT_TYPE_TRANSITION
 			&& keyframable) {
 		connect(label, SIGNAL(clicked()), this, SLOT(focus_row()));
 
 		keyframe_nav = new KeyframeNavigator();
+		keyframe_nav->enable_keyframes(keyframing);
 		connect(keyframe_nav, SIGNAL(goto_previous_key()), this, SLOT(goto_previous_key()));
 		connect(keyframe_nav, SIGNAL(toggle_key()), this, SLOT(toggle_key()));
 		connect(keyframe_nav, SIGNAL(goto_next_key()), this, SLOT(goto_next_key()));
 		connect(keyframe_nav, SIGNAL(keyframe_enabled_changed(bool)), this, SLOT(set_keyframe_enabled(bool)));
 		connect(keyframe_nav, SIGNAL(clicked()), this, SLOT(focus_row()));
-		ui->addWidget(keyframe_nav, row, 6);
+		ui->addWidget(keyframe_nav, ui_row, 6);
 	}
-}
 
-EffectRow::~EffectRow() {
-	for (int i=0;i<fields.size();i++) {
-		delete fields.at(i);
+	for (int i=0;i<cells.size();i++) {
+		add_cell_to_ui(i);
 	}
 }
 
+void EffectRow::add_cell_to_ui(int cell) {
+	const Cell& c = cells.at(cell);
+	QWidget* element = (c.field != nullptr) ? c.field->get_ui_element() : c.widget;
+
+	// columns are assigned in the order fields and widgets were added, starting after the label
+	ui->addWidget(element, ui_row, cell + 1, 1, c.colspan);
+}
+
 bool EffectRow::isKeyframing() {
 	return keyframing;
 }
@@ -180,17 +208,27 @@ EffectField* EffectRow::add_field(int type, const QString& id, int colspan) {
 	EffectField* field = new EffectField(this, type, id);
 	if (parent_effect->meta->type != EFFECT_TYPE_TRANSITION) connect(field, SIGNAL(clicked()), this, SLOT(focus_row()));
 	fields.append(field);
-	QWidget* element = field->get_ui_element();
-	ui->addWidget(element, ui_row, column_count, 1, colspan);
-	column_count++;
+
+	Cell c;
+	c.field = field;
+	c.widget = nullptr;
+	c.colspan = colspan;
+	cells.append(c);
+	if (ui != nullptr) add_cell_to_ui(cells.size() - 1);
+
 	connect(field, SIGNAL(changed()), parent_effect, SLOT(field_changed()));
 	return field;
 }
 
 void EffectRow::add_widget(QWidget* w) {
 	widgets.append(w);
-	ui->addWidget(w, ui_row, column_count);
-	column_count++;
+
+	Cell c;
+	c.field = nullptr;
+	c.widget = w;
+	c.colspan = 1;
+	cells.append(c);
+	if (ui != nullptr) add_cell_to_ui(cells.size() - 1);
 }
 
 void EffectRow::set_keyframe_now(ComboAction* ca) {
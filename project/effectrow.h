@@ -37,8 +37,16 @@ class ClickableLabel;
 class EffectRow : public QObject {
 	Q_OBJECT
 public:
-	EffectRow(Effect* parent, bool save, QGridLayout* uilayout, const QString& n, int row, bool keyframable = true);
+	EffectRow(Effect* parent, bool save, const QString& n, int row, bool keyframable = true);
 	~EffectRow();
+
+	/**
+	 * @brief Create this row's widgets and add them to the effect's layout
+	 *
+	 * Called by Effect::create_ui() the first time the effect is shown in the Effect Controls panel. Until then the
+	 * row and its fields only hold data. `label` is nullptr before this is called.
+	 */
+	void create_ui(QGridLayout* uilayout);
 	EffectField* add_field(int type, const QString &id, int colspan = 1);
 	void add_widget(QWidget *w);
 	EffectField* field(int i);
@@ -60,21 +68,30 @@ public slots:
 private slots:
 	void set_keyframe_enabled(bool);
 private:
+	void add_cell_to_ui(int cell);
+
 	bool keyframing;
+	bool keyframable;
 	QGridLayout* ui;
 	QString name;
 	int ui_row;
 	QVector<EffectField*> fields;
 	QVector<QWidget*> widgets;
 
+	// grid cells in column order, each is either a field or a custom widget
+	struct Cell {
+		EffectField* field;
+		QWidget* widget;
+		int colspan;
+	};
+	QVector<Cell> cells;
+
 	KeyframeNavigator* keyframe_nav;
 
 	bool just_made_unsafe_keyframe;
 	QVector<int> unsafe_keys;
 	QVector<QVariant> unsafe_old_data;
 	QVector<bool> key_is_new;
-
-	int column_count;
 };
 
 #endif // EFFECTROW_H
@@ -23,6 +23,7 @@
 #include <QDebug>
 #include <QtMath>
 #include <QPainter>
+#include <QAtomicInt>
 #include "io/previewgenerator.h"
 
 #include "project/clip.h"
@@ -36,6 +37,8 @@ Footage::Footage() {
   speed = (1.0);
   alpha_is_premultiplied = (false);
   proxy = (false);
+  source_decode_time = -1;
+  proxy_decode_time = -1;
   start_number = 0;
 
 	ready_lock.lock();
@@ -61,6 +64,36 @@ long Footage::get_length_in_frames(double frame_rate) {
 	return 0;
 }
 
+void Footage::record_decode_time(bool from_proxy, double msecs) {
+  decode_time_lock.lock();
+
+  double& average = from_proxy ? proxy_decode_time : source_decode_time;
+
+  // exponential moving average so the estimate follows changes (e.g. other footage competing for the CPU) without
+  // jumping on a single slow frame
+  if (average < 0) {
+    average = msecs;
+  } else {
+    average += (msecs - average) * 0.1;
+  }
+
+  decode_time_lock.unlock();
+}
+
+double Footage::get_decode_time(bool from_proxy) {
+  decode_time_lock.lock();
+  double average = from_proxy ? proxy_decode_time : source_decode_time;
+  decode_time_lock.unlock();
+  return average;
+}
+
+void Footage::reset_decode_times() {
+  decode_time_lock.lock();
+  source_decode_time = -1;
+  proxy_decode_time = -1;
+  decode_time_lock.unlock();
+}
+
 FootageStream* Footage::get_stream_from_file_index(bool video, int index) {
 	if (video) {
 		for (int i=0;i<video_tracks.size();i++) {
@@ -91,3 +124,8 @@ void FootageStream::make_square_thumb() {
 	p.end();
 	video_preview_square = QIcon(pixmap);
 }
+
+void FootageStream::audio_preview_changed() {
+	static QAtomicInt generation_counter;
+	audio_preview_generation = generation_counter.fetchAndAddRelaxed(1) + 1;
+}
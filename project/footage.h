@@ -64,7 +64,13 @@ struct FootageStream {
   QImage video_preview;
   QIcon video_preview_square;
   QVector<char> audio_preview;
+
+  // unique ID of the current audio_preview, changed by audio_preview_changed() whenever it's loaded or rebuilt so
+  // cached waveform tiles are never reused for different audio (even if a freed stream's address is reused)
+  int audio_preview_generation;
+
   void make_square_thumb();
+  void audio_preview_changed();
 };
 
 struct Footage {
@@ -88,6 +94,12 @@ struct Footage {
   bool proxy;
   QString proxy_path;
 
+  // average time in milliseconds to decode one frame from the source file/proxy, measured by the Cacher during
+  // playback and used by ProxyPolicy to decide which to play (negative if not measured yet)
+  double source_decode_time;
+  double proxy_decode_time;
+  QMutex decode_time_lock;
+
   // thumbnail/waveform generation
   PreviewGenerator* preview_gen;
   QMutex ready_lock;
@@ -103,6 +115,9 @@ struct Footage {
   // functions
   long get_length_in_frames(double frame_rate);
   FootageStream *get_stream_from_file_index(bool video, int index);
+  void record_decode_time(bool from_proxy, double msecs);
+  double get_decode_time(bool from_proxy);
+  void reset_decode_times();
   void reset();
 };
 
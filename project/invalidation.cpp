@@ -0,0 +1,140 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "invalidation.h"
+
+#include <algorithm>
+
+#include "project/sequence.h"
+#include "project/clip.h"
+#include "project/effect.h"
+#include "project/effectrow.h"
+#include "project/effectfield.h"
+
+InvalidationBus olive::Invalidation;
+
+static bool region_matches(const InvalidatedRegion& r, Sequence* s, bool video, bool audio) {
+  if (r.sequence != s) {
+    return false;
+  }
+
+  return r.track == olive::kAllTracks
+      || (video && r.track < 0)
+      || (audio && r.track >= 0);
+}
+
+bool InvalidatedRegion::contains(Sequence *s, long frame, bool video, bool audio) const {
+  return region_matches(*this, s, video, audio) && frame >= in && frame < out;
+}
+
+bool InvalidatedRegion::overlaps(Sequence *s, long range_in, long range_out, bool video, bool audio) const {
+  return region_matches(*this, s, video, audio) && range_in < out && range_out > in;
+}
+
+static bool region_less_than(const InvalidatedRegion& a, const InvalidatedRegion& b) {
+  if (a.sequence != b.sequence) {
+    return a.sequence < b.sequence;
+  }
+  if (a.track != b.track) {
+    return a.track < b.track;
+  }
+  return a.in < b.in;
+}
+
+InvalidationBus::InvalidationBus() :
+  flush_queued_(false)
+{}
+
+void InvalidationBus::invalidate(Sequence *s, long in, long out, int track) {
+  if (s == nullptr || out <= in) {
+    return;
+  }
+
+  // updated immediately rather than on flush so renderers never reuse stale nested output in between. Versions are
+  // drawn from one counter so the newest version anywhere in a tree of nested sequences is always the latest change.
+  static quint64 version_counter = 0;
+  s->content_version = ++version_counter;
+
+  InvalidatedRegion r;
+  r.sequence = s;
+  r.in = in;
+  r.out = out;
+  r.track = track;
+  pending_.append(r);
+
+  if (!flush_queued_) {
+    flush_queued_ = true;
+    QMetaObject::invokeMethod(this, "deferred_flush", Qt::QueuedConnection);
+  }
+}
+
+void InvalidationBus::invalidate_clip(Clip *c) {
+  if (c != nullptr) {
+    invalidate(c->sequence.get(), c->timeline_in(true), c->timeline_out(true), c->track());
+  }
+}
+
+void InvalidationBus::invalidate_effect(Effect *e) {
+  if (e != nullptr) {
+    invalidate_clip(e->parent_clip);
+  }
+}
+
+void InvalidationBus::invalidate_field(EffectField *f) {
+  if (f != nullptr && f->parent_row != nullptr) {
+    invalidate_effect(f->parent_row->parent_effect);
+  }
+}
+
+void InvalidationBus::invalidate_sequence(Sequence *s) {
+  invalidate(s, LONG_MIN, LONG_MAX, olive::kAllTracks);
+}
+
+void InvalidationBus::flush() {
+  if (pending_.isEmpty()) {
+    return;
+  }
+
+  QVector<InvalidatedRegion> regions = pending_;
+  pending_.clear();
+
+  std::sort(regions.begin(), regions.end(), region_less_than);
+
+  // merge overlapping or touching regions of the same sequence and track
+  QVector<InvalidatedRegion> merged;
+  merged.reserve(regions.size());
+  for (int i=0;i<regions.size();i++) {
+    const InvalidatedRegion& r = regions.at(i);
+    if (!merged.isEmpty()
+        && merged.last().sequence == r.sequence
+        && merged.last().track == r.track
+        && r.in <= merged.last().out) {
+      merged.last().out = qMax(merged.last().out, r.out);
+    } else {
+      merged.append(r);
+    }
+  }
+
+  emit regions_invalidated(merged);
+}
+
+void InvalidationBus::deferred_flush() {
+  flush_queued_ = false;
+  flush();
+}
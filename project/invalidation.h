@@ -0,0 +1,167 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef INVALIDATION_H
+#define INVALIDATION_H
+
+#include <QObject>
+#include <QVector>
+#include <climits>
+
+class Sequence;
+class Clip;
+class Effect;
+class EffectField;
+
+namespace olive {
+  /**
+   * @brief Track value for an InvalidatedRegion that covers every track of its sequence
+   */
+  const int kAllTracks = INT_MIN;
+}
+
+/**
+ * @brief A time range of a sequence whose rendered output may have changed
+ */
+struct InvalidatedRegion {
+  Sequence* sequence;
+
+  /** First frame of the region */
+  long in;
+
+  /** Frame after the last frame of the region (LONG_MAX for "until the end of the sequence") */
+  long out;
+
+  /** Track the change was on, or olive::kAllTracks if it affects the whole frame */
+  int track;
+
+  /**
+   * @brief Returns **TRUE** if this region contains a frame of a sequence
+   *
+   * @param video
+   *
+   * Count regions on video tracks
+   *
+   * @param audio
+   *
+   * Count regions on audio tracks
+   */
+  bool contains(Sequence* s, long frame, bool video = true, bool audio = true) const;
+
+  /**
+   * @brief Returns **TRUE** if this region overlaps the range [range_in, range_out) of a sequence
+   */
+  bool overlaps(Sequence* s, long range_in, long range_out, bool video = true, bool audio = true) const;
+};
+
+/**
+ * @brief The InvalidationBus class
+ *
+ * Central place that edits report what they changed to, so everything that displays or caches rendered output can
+ * refresh only the parts that are actually affected instead of starting over after every edit.
+ *
+ * Undo commands report their regions automatically when they're done or undone (see
+ * OliveAction::invalidate_regions(), which falls back to the whole active sequence for commands that don't know
+ * better), and direct edits that bypass the undo stack (dragging field values, keyframes or gizmos) report the clip
+ * they changed.
+ *
+ * Reports are collected and coalesced, then delivered all at once through regions_invalidated() when control returns
+ * to the event loop, so a command touching hundreds of clips results in a single notification. Must only be used from
+ * the main thread. Listeners that are used by other threads need to do their own locking.
+ */
+class InvalidationBus : public QObject {
+  Q_OBJECT
+public:
+  InvalidationBus();
+
+  /**
+   * @brief Report a changed range of a sequence
+   *
+   * @param s
+   *
+   * Sequence the change happened in. Reports for nullptr are ignored.
+   *
+   * @param in
+   *
+   * First changed frame
+   *
+   * @param out
+   *
+   * Frame after the last changed frame
+   *
+   * @param track
+   *
+   * Track the change was on, or olive::kAllTracks
+   */
+  void invalidate(Sequence* s, long in, long out, int track = olive::kAllTracks);
+
+  /**
+   * @brief Report that everything a clip renders (including its transitions) may have changed
+   *
+   * Call before and after moving a clip to cover both its old and new position.
+   */
+  void invalidate_clip(Clip* c);
+
+  /**
+   * @brief Report that everything an effect renders may have changed
+   */
+  void invalidate_effect(Effect* e);
+
+  /**
+   * @brief Report that everything an effect field affects may have changed
+   */
+  void invalidate_field(EffectField* f);
+
+  /**
+   * @brief Report that the whole sequence may have changed
+   */
+  void invalidate_sequence(Sequence* s);
+
+  /**
+   * @brief Deliver any pending reports immediately rather than waiting for the event loop
+   */
+  void flush();
+
+signals:
+  /**
+   * @brief Emitted with the coalesced regions that were reported since the last emission
+   *
+   * Regions are sorted by sequence, track and in point, and overlapping regions of the same sequence and track are
+   * merged.
+   */
+  void regions_invalidated(const QVector<InvalidatedRegion>& regions);
+
+private slots:
+  void deferred_flush();
+
+private:
+  QVector<InvalidatedRegion> pending_;
+
+  // set when a deferred flush has been queued on the event loop
+  bool flush_queued_;
+};
+
+namespace olive {
+  /**
+   * @brief Global invalidation bus
+   */
+  extern InvalidationBus Invalidation;
+}
+
+#endif // INVALIDATION_H
@@ -21,20 +21,51 @@
 #include "sequence.h"
 
 #include <QCoreApplication>
+#include <algorithm>
 
 #include "debug.h"
 
-Sequence::Sequence() {
+Sequence::Sequence() :
+  clip_index(this)
+{
   playhead = 0;
   using_workarea = false;
   workarea_in = 0;
   workarea_out = 0;
   wrapper_sequence = false;
+  half_float = false;
+  deferred_end_frame = 0;
+  content_version = 0;
 }
 
 Sequence::~Sequence() {}
 
+void Sequence::load_deferred() {
+  if (deferred_loader != nullptr) {
+    // clear the loader first so this sequence counts as loaded while its clips are created
+    std::shared_ptr<SequenceLoader> loader = deferred_loader;
+    deferred_loader.reset();
+    loader->load(shared_from_this());
+  }
+
+  // nested sequences have to be loaded before this one can be shown
+  for (int i=0;i<clips.size();i++) {
+    Clip* c = clips.at(i).get();
+    if (c != nullptr
+        && c->media() != nullptr
+        && c->media()->get_type() == MEDIA_TYPE_SEQUENCE) {
+      c->media()->to_sequence()->load_deferred();
+    }
+  }
+}
+
+bool Sequence::is_deferred() {
+  return (deferred_loader != nullptr);
+}
+
 SequencePtr Sequence::copy() {
+  load_deferred();
+
   SequencePtr s(new Sequence());
   s->name = QCoreApplication::translate("Sequence", "%1 (copy)").arg(name);
   s->width = width;
@@ -42,6 +73,7 @@ SequencePtr Sequence::copy() {
   s->frame_rate = frame_rate;
   s->audio_frequency = audio_frequency;
   s->audio_layout = audio_layout;
+  s->half_float = half_float;
 
   // deep copy all of the sequence's clips
   s->clips.resize(clips.size());
@@ -63,14 +95,11 @@ SequencePtr Sequence::copy() {
 }
 
 long Sequence::getEndFrame() {
-  long end = 0;
-  for (int j=0;j<clips.size();j++) {
-    ClipPtr c = clips.at(j);
-    if (c != nullptr && c->timeline_out() > end) {
-      end = c->timeline_out();
-    }
+  if (is_deferred()) {
+    return deferred_end_frame;
   }
-  return end;
+
+  return clip_index.EndFrame();
 }
 
 void Sequence::RefreshClips(Media *m) {
@@ -89,11 +118,9 @@ QVector<Clip *> Sequence::SelectedClips()
 {
   QVector<Clip*> selected_clips;
 
-  for (int i=0;i<clips.size();i++) {
-    Clip* c = clips.at(i).get();
-    if (c != nullptr && IsClipSelected(c, true)) {
-      selected_clips.append(c);
-    }
+  QVector<int> selected_indexes = SelectedClipIndexes();
+  for (int i=0;i<selected_indexes.size();i++) {
+    selected_clips.append(clips.at(selected_indexes.at(i)).get());
   }
 
   return selected_clips;
@@ -103,13 +130,25 @@ QVector<int> Sequence::SelectedClipIndexes()
 {
   QVector<int> selected_clips;
 
-  for (int i=0;i<clips.size();i++) {
-    Clip* c = clips.at(i).get();
-    if (c != nullptr && IsClipSelected(c, true)) {
-      selected_clips.append(i);
+  // only clips that overlap a selection can be inside it
+  for (int i=0;i<selections.size();i++) {
+    const Selection& s = selections.at(i);
+    QVector<int> candidates = clip_index.ClipsOnTrackInRange(s.track, s.in, s.out);
+
+    for (int j=0;j<candidates.size();j++) {
+      int index = candidates.at(j);
+      if (index < clips.size()
+          && clips.at(index) != nullptr
+          && !selected_clips.contains(index)
+          && IsClipSelected(clips.at(index).get(), true)) {
+        selected_clips.append(index);
+      }
     }
   }
 
+  // keep the same order as `clips`
+  std::sort(selected_clips.begin(), selected_clips.end());
+
   return selected_clips;
 }
 
@@ -117,11 +156,11 @@ Effect *Sequence::GetSelectedGizmo()
 {
   Effect* gizmo_ptr = nullptr;
 
-  for (int i=0;i<clips.size();i++) {
-    Clip* c = clips.at(i).get();
-    if (c != nullptr
-        && c->IsActiveAt(playhead)
-        && IsClipSelected(c, true)) {
+  QVector<Clip*> selected_clips = SelectedClips();
+
+  for (int i=0;i<selected_clips.size();i++) {
+    Clip* c = selected_clips.at(i);
+    if (c->IsActiveAt(playhead)) {
       // This clip is selected and currently active - we'll use this for gizmos
 
       if (!c->effects.isEmpty()) {
@@ -137,7 +176,7 @@ Effect *Sequence::GetSelectedGizmo()
             if (gizmo_ptr == nullptr) {
               gizmo_ptr = e;
             }
-            if (e->container->selected) {
+            if (e->container != nullptr && e->container->selected) {
               gizmo_ptr = e;
               break;
             }
@@ -173,20 +212,7 @@ bool Sequence::IsClipSelected(Clip *clip, bool containing)
 }
 
 void Sequence::getTrackLimits(int* video_tracks, int* audio_tracks) {
-  int vt = 0;
-  int at = 0;
-  for (int j=0;j<clips.size();j++) {
-    ClipPtr c = clips.at(j);
-    if (c != nullptr) {
-      if (c->track() < 0 && c->track() < vt) { // video clip
-        vt = c->track();
-      } else if (c->track() > at) {
-        at = c->track();
-      }
-    }
-  }
-  if (video_tracks != nullptr) *video_tracks = vt;
-  if (audio_tracks != nullptr) *audio_tracks = at;
+  clip_index.GetTrackLimits(video_tracks, audio_tracks);
 }
 
 // static variable for the currently active sequence
@@ -28,12 +28,60 @@
 #include "project/marker.h"
 #include "project/transition.h"
 #include "project/selection.h"
+#include "project/clipindex.h"
 
-class Sequence {
+class DeferredClips;
+
+/**
+ * @brief The SequenceLoader class
+ *
+ * Builds the clips of a sequence that was loaded from a project file without them (see Sequence::load_deferred()).
+ */
+class SequenceLoader {
+public:
+  virtual ~SequenceLoader() {}
+  virtual void load(SequencePtr s) = 0;
+
+  /**
+   * @brief Returns **TRUE** if any of the unloaded clips use this footage or sequence
+   */
+  virtual bool uses_media(Media* m) = 0;
+
+  /**
+   * @brief Get the unloaded clips in a form that can be saved without loading them (see SequenceSnapshot::deferred)
+   *
+   * Save IDs of all media in the project must already be assigned.
+   */
+  virtual std::shared_ptr<DeferredClips> snapshot() = 0;
+};
+
+class Sequence : public std::enable_shared_from_this<Sequence> {
 public:
   Sequence();
   ~Sequence();
   SequencePtr copy();
+
+  /**
+   * @brief Build this sequence's clips if they haven't been loaded yet
+   *
+   * Project loading may leave sequences that aren't open in their serialized form, in which case `clips` is empty and
+   * `deferred_loader` holds the data to build them from. This loads them along with any nested sequences they use.
+   * Anything that reads the clips of a sequence that isn't the active one (or nested in it) should call this first.
+   * Saving doesn't need to (see SequenceLoader::snapshot()). Must be called from the main thread since it creates
+   * effects.
+   */
+  void load_deferred();
+
+  /**
+   * @brief Returns **TRUE** if this sequence's clips haven't been loaded yet
+   */
+  bool is_deferred();
+
+  std::shared_ptr<SequenceLoader> deferred_loader;
+
+  // end frame of a deferred sequence as saved in the project, returned by getEndFrame() until the clips are loaded
+  long deferred_end_frame;
+
   QString name;
   void getTrackLimits(int* video_tracks, int* audio_tracks);
   long getEndFrame();
@@ -43,6 +91,9 @@ public:
   int audio_frequency;
   int audio_layout;
 
+  // composite in 16-bit floating point rather than 8 bits per component, see get_compositing_format()
+  bool half_float;
+
   void RefreshClips(Media* m = nullptr);
   QVector<Clip*> SelectedClips();
   QVector<int> SelectedClipIndexes();
@@ -65,6 +116,18 @@ public:
 
   QVector<Marker> markers;
   QVector<ClipPtr> clips;
+
+  // per-track lookup of `clips`, see ClipIndex for when it needs to be invalidated
+  ClipIndex clip_index;
+
+  // set to a new, ever increasing value by InvalidationBus whenever anything in this sequence changes, lets renderers
+  // of sequences nesting this one tell if output they cached is still current
+  quint64 content_version;
+
+  // clips compose_sequence() found active last time it ran, so it can close them once they aren't. Held weakly so
+  // that clips deleted from the sequence are freed (and closed by their destructor) straight away.
+  QVector<std::weak_ptr<Clip> > last_active_video_clips;
+  QVector<std::weak_ptr<Clip> > last_active_audio_clips;
 };
 
 using SequencePtr = std::shared_ptr<Sequence>;
@@ -26,6 +26,7 @@
 #include "debug.h"
 
 #include "io/clipboard.h"
+#include "io/projectsnapshot.h"
 
 #include "effects/internal/crossdissolvetransition.h"
 #include "effects/internal/linearfadetransition.h"
@@ -50,23 +51,31 @@ Transition::Transition(Clip *c, Clip *s, const EffectMeta* em) :
   length_field->set_double_default_value(30);
   length_field->set_double_minimum_value(0);
 
-  LabelSlider* length_ui_ele = static_cast<LabelSlider*>(length_field->ui_element);
-  length_ui_ele->set_display_type(LABELSLIDER_FRAMENUMBER);
-  length_ui_ele->set_frame_rate(parent_clip->sequence == nullptr ? parent_clip->cached_frame_rate() : parent_clip->sequence->frame_rate);
+  length_field->set_double_display_type(LABELSLIDER_FRAMENUMBER);
+  length_field->set_double_frame_rate(parent_clip->sequence == nullptr ? parent_clip->cached_frame_rate() : parent_clip->sequence->frame_rate);
 }
 
 TransitionPtr Transition::copy(Clip *c, Clip *s) {
   return Transition::Create(c, s, meta, length);
 }
 
-void Transition::save(QXmlStreamWriter &stream) {
-  stream.writeAttribute("length", QString::number(get_true_length()));
-  Effect::save(stream);
+EffectSnapshot Transition::snapshot() {
+  EffectSnapshot s = Effect::snapshot();
+  s.length = get_true_length();
+  return s;
 }
 
 void Transition::set_length(long l) {
   length = l;
   length_field->set_double_value(l);
+
+  // transitions extend and split their clips, so the sequence's clip index has to be updated
+  if (parent_clip != nullptr && parent_clip->sequence != nullptr) {
+    parent_clip->sequence->clip_index.invalidate_clip(parent_clip);
+    if (secondary_clip != nullptr) {
+      parent_clip->sequence->clip_index.invalidate_clip(secondary_clip);
+    }
+  }
 }
 
 long Transition::get_true_length() {
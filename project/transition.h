@@ -48,7 +48,7 @@ public:
   virtual TransitionPtr copy(Clip* c, Clip* s);
   Clip* secondary_clip;
 
-  virtual void save(QXmlStreamWriter& stream) override;
+  virtual EffectSnapshot snapshot() override;
 
   void set_length(long l);
   long get_true_length();
@@ -24,6 +24,8 @@
 #include <QMessageBox>
 #include <QCheckBox>
 #include <QXmlStreamWriter>
+#include <QDateTime>
+#include <QHash>
 
 #include "project/clip.h"
 #include "project/sequence.h"
@@ -47,8 +49,157 @@
 #include "project/media.h"
 #include "debug.h"
 #include "oliveglobal.h"
+#include "io/config.h"
+#include "project/invalidation.h"
 
-QUndoStack olive::UndoStack;
+UndoHistory olive::UndoStack;
+
+// QUndoCommand::id() used by commands that support merging
+const int kUndoIdEffectField = 1;
+
+// consecutive EffectFieldUndo commands on the same field made within this many milliseconds are merged
+const qint64 kEffectFieldUndoMergeInterval = 1000;
+
+static qint64 variant_memory_usage(const QVariant& v) {
+  switch (v.type()) {
+  case QVariant::String:
+    return v.toString().size() * qint64(sizeof(QChar));
+  case QVariant::ByteArray:
+    return v.toByteArray().size();
+  default:
+    return 0;
+  }
+}
+
+static qint64 effect_memory_usage(Effect* e) {
+  qint64 usage = sizeof(Effect);
+  for (int i=0;i<e->row_count();i++) {
+    EffectRow* row = e->row(i);
+    for (int j=0;j<row->fieldCount();j++) {
+      EffectField* field = row->field(j);
+      usage += sizeof(EffectField) + variant_memory_usage(field->get_current_data());
+      usage += field->keyframes.size() * qint64(sizeof(EffectKeyframe));
+    }
+  }
+  return usage;
+}
+
+static qint64 clip_memory_usage(Clip* c) {
+  qint64 usage = sizeof(Clip);
+  for (int i=0;i<c->effects.size();i++) {
+    usage += effect_memory_usage(c->effects.at(i).get());
+  }
+  return usage;
+}
+
+UndoHistory::UndoHistory() :
+  index_(0),
+  total_cost_(0)
+{}
+
+UndoHistory::~UndoHistory() {
+  clear();
+}
+
+void UndoHistory::push(QUndoCommand *cmd) {
+  cmd->redo();
+
+  // anything that could have been redone is gone now
+  while (commands_.size() > index_) {
+    total_cost_ -= costs_.last();
+    delete commands_.takeLast();
+    costs_.removeLast();
+  }
+
+  // try merging into the previous command
+  if (index_ > 0
+      && cmd->id() != -1
+      && commands_.at(index_-1)->id() == cmd->id()
+      && commands_.at(index_-1)->mergeWith(cmd)) {
+    delete cmd;
+    update_cost(index_-1);
+  } else {
+    commands_.append(cmd);
+    costs_.append(0);
+    index_++;
+    update_cost(index_-1);
+  }
+
+  enforce_limit();
+}
+
+void UndoHistory::undo() {
+  if (canUndo()) {
+    index_--;
+    commands_.at(index_)->undo();
+    update_cost(index_);
+  }
+}
+
+void UndoHistory::redo() {
+  if (canRedo()) {
+    commands_.at(index_)->redo();
+    update_cost(index_);
+    index_++;
+    enforce_limit();
+  }
+}
+
+void UndoHistory::clear() {
+  qDeleteAll(commands_);
+  commands_.clear();
+  costs_.clear();
+  index_ = 0;
+  total_cost_ = 0;
+}
+
+bool UndoHistory::canUndo() {
+  return index_ > 0;
+}
+
+bool UndoHistory::canRedo() {
+  return index_ < commands_.size();
+}
+
+qint64 UndoHistory::memory_usage() {
+  return total_cost_;
+}
+
+qint64 UndoHistory::command_memory_usage(QUndoCommand *cmd) {
+  OliveAction* action = dynamic_cast<OliveAction*>(cmd);
+  if (action != nullptr) {
+    return action->memory_usage();
+  }
+
+  ComboAction* ca = dynamic_cast<ComboAction*>(cmd);
+  if (ca != nullptr) {
+    return ca->memory_usage();
+  }
+
+  return sizeof(QUndoCommand);
+}
+
+void UndoHistory::update_cost(int index) {
+  qint64 cost = command_memory_usage(commands_.at(index));
+  total_cost_ += cost - costs_.at(index);
+  costs_[index] = cost;
+}
+
+void UndoHistory::enforce_limit() {
+  qint64 limit = qint64(olive::CurrentConfig.undo_memory_limit) * 1024 * 1024;
+
+  // a limit of 0 means unlimited, and the most recent command is always kept so it can still be undone
+  if (limit <= 0) {
+    return;
+  }
+
+  while (total_cost_ > limit && index_ > 1) {
+    total_cost_ -= costs_.first();
+    delete commands_.takeFirst();
+    costs_.removeFirst();
+    index_--;
+  }
+}
 
 MoveClipAction::MoveClipAction(Clip *c, long iin, long iout, long iclip_in, int itrack, bool irelative) {
   clip = c;
@@ -94,6 +245,10 @@ void MoveClipAction::doRedo() {
   }
 }
 
+void MoveClipAction::invalidate_regions() {
+  olive::Invalidation.invalidate_clip(clip);
+}
+
 DeleteClipAction::DeleteClipAction(SequencePtr s, int clip) {
   seq = s;
   index = clip;
@@ -103,9 +258,18 @@ DeleteClipAction::DeleteClipAction(SequencePtr s, int clip) {
 
 DeleteClipAction::~DeleteClipAction() {}
 
+qint64 DeleteClipAction::memory_usage() {
+  qint64 usage = sizeof(DeleteClipAction) + (linkClipIndex.size() + linkLinkIndex.size()) * qint64(sizeof(int));
+  if (ref != nullptr) {
+    usage += clip_memory_usage(ref.get());
+  }
+  return usage;
+}
+
 void DeleteClipAction::doUndo() {
   // restore ref to clip
   seq->clips[index] = ref;
+  seq->clip_index.invalidate();
 
   // restore links to this clip
   for (int i=linkClipIndex.size()-1;i>=0;i--) {
@@ -122,6 +286,7 @@ void DeleteClipAction::doRedo() {
     ref->Close(true);
   }
   seq->clips[index] = nullptr;
+  seq->clip_index.invalidate_clip(ref.get());
 
   // delete link to this clip
   linkClipIndex.clear();
@@ -140,6 +305,10 @@ void DeleteClipAction::doRedo() {
   }
 }
 
+void DeleteClipAction::invalidate_regions() {
+  olive::Invalidation.invalidate_clip((ref != nullptr) ? ref.get() : seq->clips.at(index).get());
+}
+
 ChangeSequenceAction::ChangeSequenceAction(SequencePtr s) {
   new_sequence = s;
 }
@@ -192,6 +361,10 @@ void SetTimelineInOutCommand::doRedo() {
   }
 }
 
+void SetTimelineInOutCommand::invalidate_regions() {
+  // the workarea doesn't affect rendered frames
+}
+
 AddEffectCommand::AddEffectCommand(Clip* c, EffectPtr e, const EffectMeta *m, int insert_pos) {
   clip = c;
   ref = e;
@@ -200,6 +373,14 @@ AddEffectCommand::AddEffectCommand(Clip* c, EffectPtr e, const EffectMeta *m, in
   done = false;
 }
 
+qint64 AddEffectCommand::memory_usage() {
+  qint64 usage = sizeof(AddEffectCommand);
+  if (ref != nullptr) {
+    usage += effect_memory_usage(ref.get());
+  }
+  return usage;
+}
+
 void AddEffectCommand::doUndo() {
   clip->effects.last()->close();
   if (pos < 0) {
@@ -222,6 +403,21 @@ void AddEffectCommand::doRedo() {
   done = true;
 }
 
+void AddEffectCommand::invalidate_regions() {
+  olive::Invalidation.invalidate_clip(clip);
+}
+
+// transitions change how far their clips extend and where they can be snapped to, so the sequence's ClipIndex needs
+// to know about them
+static void invalidate_clip_index(Clip* open, Clip* close) {
+  if (open != nullptr && open->sequence != nullptr) {
+    open->sequence->clip_index.invalidate_clip(open);
+  }
+  if (close != nullptr && close->sequence != nullptr) {
+    close->sequence->clip_index.invalidate_clip(close);
+  }
+}
+
 AddTransitionCommand::AddTransitionCommand(Clip* iopen,
                                            Clip* iclose,
                                            TransitionPtr copy,
@@ -243,6 +439,8 @@ void AddTransitionCommand::doUndo() {
   if (close_ != nullptr)  {
     close_->closing_transition = old_close_transition_;
   }
+
+  invalidate_clip_index(open_, close_);
 }
 
 void AddTransitionCommand::doRedo() {
@@ -281,6 +479,13 @@ void AddTransitionCommand::doRedo() {
   if (length_ > 0) {
     new_transition_ref_->set_length(length_);
   }
+
+  invalidate_clip_index(open_, close_);
+}
+
+void AddTransitionCommand::invalidate_regions() {
+  olive::Invalidation.invalidate_clip(open_);
+  olive::Invalidation.invalidate_clip(close_);
 }
 
 ModifyTransitionCommand::ModifyTransitionCommand(TransitionPtr t, long ilength) {
@@ -298,6 +503,11 @@ void ModifyTransitionCommand::doRedo() {
   transition_ref_->set_length(new_length_);
 }
 
+void ModifyTransitionCommand::invalidate_regions() {
+  olive::Invalidation.invalidate_clip(transition_ref_->get_opened_clip());
+  olive::Invalidation.invalidate_clip(transition_ref_->get_closed_clip());
+}
+
 DeleteTransitionCommand::DeleteTransitionCommand(TransitionPtr t) {
   transition_ref_ = t;
 }
@@ -310,6 +520,8 @@ void DeleteTransitionCommand::doUndo() {
   if (closed_clip_ != nullptr) {
     closed_clip_->closing_transition = transition_ref_;
   }
+
+  invalidate_clip_index(opened_clip_, closed_clip_);
 }
 
 void DeleteTransitionCommand::doRedo() {
@@ -323,6 +535,13 @@ void DeleteTransitionCommand::doRedo() {
   if (closed_clip_ != nullptr) {
     closed_clip_->closing_transition = nullptr;
   }
+
+  invalidate_clip_index(opened_clip_, closed_clip_);
+}
+
+void DeleteTransitionCommand::invalidate_regions() {
+  olive::Invalidation.invalidate_clip(transition_ref_->get_opened_clip());
+  olive::Invalidation.invalidate_clip(transition_ref_->get_closed_clip());
 }
 
 NewSequenceCommand::NewSequenceCommand(Media *s, Media* iparent) {
@@ -349,6 +568,10 @@ void NewSequenceCommand::doRedo() {
   done = true;
 }
 
+void NewSequenceCommand::invalidate_regions() {
+  // project items don't affect rendered frames
+}
+
 AddMediaCommand::AddMediaCommand(Media* iitem, Media *iparent) {
   item = iitem;
   parent = iparent;
@@ -373,6 +596,10 @@ void AddMediaCommand::doRedo() {
   done = true;
 }
 
+void AddMediaCommand::invalidate_regions() {
+  // project items don't affect rendered frames
+}
+
 DeleteMediaCommand::DeleteMediaCommand(Media* i) {
   item = i;
   parent = i->parentItem();
@@ -397,6 +624,10 @@ void DeleteMediaCommand::doRedo() {
   done = true;
 }
 
+void DeleteMediaCommand::invalidate_regions() {
+  // project items don't affect rendered frames (clips using them are deleted by their own commands)
+}
+
 AddClipCommand::AddClipCommand(SequencePtr s, QVector<ClipPtr>& add) {
   link_offset_ = 0;
   seq = s;
@@ -405,6 +636,16 @@ AddClipCommand::AddClipCommand(SequencePtr s, QVector<ClipPtr>& add) {
 
 AddClipCommand::~AddClipCommand() {}
 
+qint64 AddClipCommand::memory_usage() {
+  qint64 usage = sizeof(AddClipCommand);
+  for (int i=0;i<clips.size();i++) {
+    if (clips.at(i) != nullptr) {
+      usage += clip_memory_usage(clips.at(i).get());
+    }
+  }
+  return usage;
+}
+
 void AddClipCommand::doUndo() {
   // clear effects panel
   panel_effect_controls->clear_effects(true);
@@ -431,6 +672,8 @@ void AddClipCommand::doUndo() {
     seq->clips.removeLast();
   }
 
+  seq->clip_index.invalidate();
+
 }
 
 void AddClipCommand::doRedo() {
@@ -449,6 +692,14 @@ void AddClipCommand::doRedo() {
 
     seq->clips.append(original);
   }
+
+  seq->clip_index.invalidate();
+}
+
+void AddClipCommand::invalidate_regions() {
+  for (int i=0;i<clips.size();i++) {
+    olive::Invalidation.invalidate_clip(clips.at(i).get());
+  }
 }
 
 LinkCommand::LinkCommand() {
@@ -484,6 +735,10 @@ void LinkCommand::doRedo() {
   }
 }
 
+void LinkCommand::invalidate_regions() {
+  // links don't affect rendered frames
+}
+
 CheckboxCommand::CheckboxCommand(QCheckBox* b) {
   box = b;
   checked = box->isChecked();
@@ -594,6 +849,14 @@ EffectDeleteCommand::EffectDeleteCommand() {
 
 EffectDeleteCommand::~EffectDeleteCommand() {}
 
+qint64 EffectDeleteCommand::memory_usage() {
+  qint64 usage = sizeof(EffectDeleteCommand) + (clips.size() + fx.size()) * qint64(sizeof(int));
+  for (int i=0;i<deleted_objects.size();i++) {
+    usage += effect_memory_usage(deleted_objects.at(i).get());
+  }
+  return usage;
+}
+
 void EffectDeleteCommand::doUndo() {
   for (int i=0;i<clips.size();i++) {
     Clip* c = clips.at(i);
@@ -618,6 +881,12 @@ void EffectDeleteCommand::doRedo() {
   done = true;
 }
 
+void EffectDeleteCommand::invalidate_regions() {
+  for (int i=0;i<clips.size();i++) {
+    olive::Invalidation.invalidate_clip(clips.at(i));
+  }
+}
+
 MediaMove::MediaMove() {}
 
 void MediaMove::doUndo() {
@@ -637,6 +906,10 @@ void MediaMove::doRedo() {
   }
 }
 
+void MediaMove::invalidate_regions() {
+  // project items don't affect rendered frames
+}
+
 MediaRename::MediaRename(Media* iitem, QString ito) {
   item = iitem;
   from = iitem->get_name();
@@ -652,6 +925,10 @@ void MediaRename::doRedo() {
   item->set_name(to);
 }
 
+void MediaRename::invalidate_regions() {
+  // project items don't affect rendered frames
+}
+
 KeyframeDelete::KeyframeDelete(EffectField *ifield, int iindex) {
   field = ifield;
   index = iindex;
@@ -666,12 +943,18 @@ void KeyframeDelete::doRedo() {
   field->keyframes.removeAt(index);
 }
 
+void KeyframeDelete::invalidate_regions() {
+  olive::Invalidation.invalidate_field(field);
+}
+
 EffectFieldUndo::EffectFieldUndo(EffectField* f) {
   field = f;
   done = true;
 
   old_val = field->get_previous_data();
   new_val = field->get_current_data();
+
+  timestamp = QDateTime::currentMSecsSinceEpoch();
 }
 
 void EffectFieldUndo::doUndo() {
@@ -686,6 +969,34 @@ void EffectFieldUndo::doRedo() {
   }
 }
 
+void EffectFieldUndo::invalidate_regions() {
+  olive::Invalidation.invalidate_field(field);
+}
+
+int EffectFieldUndo::id() const {
+  return kUndoIdEffectField;
+}
+
+bool EffectFieldUndo::mergeWith(const QUndoCommand *other) {
+  const EffectFieldUndo* other_undo = dynamic_cast<const EffectFieldUndo*>(other);
+
+  if (other_undo == nullptr
+      || other_undo->field != field
+      || other_undo->timestamp - timestamp > kEffectFieldUndoMergeInterval) {
+    return false;
+  }
+
+  // keep our old value so undoing goes back to before the first change
+  new_val = other_undo->new_val;
+  timestamp = other_undo->timestamp;
+
+  return true;
+}
+
+qint64 EffectFieldUndo::memory_usage() {
+  return sizeof(EffectFieldUndo) + variant_memory_usage(old_val) + variant_memory_usage(new_val);
+}
+
 SetClipProperty::SetClipProperty(SetClipPropertyType type) : type_(type)
 {}
 
@@ -758,6 +1069,12 @@ void SetClipProperty::doRedo() {
   panel_sequence_viewer->viewer_widget->frame_update();
 }
 
+void SetClipProperty::invalidate_regions() {
+  for (int i=0;i<clips_.size();i++) {
+    olive::Invalidation.invalidate_clip(clips_.at(i));
+  }
+}
+
 AddMarkerAction::AddMarkerAction(QVector<Marker>* m, long t, QString n) {
   active_array = m;
   time = t;
@@ -793,6 +1110,10 @@ void AddMarkerAction::doRedo() {
   }
 }
 
+void AddMarkerAction::invalidate_regions() {
+  // markers don't affect rendered frames
+}
+
 MoveMarkerAction::MoveMarkerAction(Marker* m, long o, long n) {
   marker = m;
   old_time = o;
@@ -808,6 +1129,10 @@ void MoveMarkerAction::doRedo() {
   marker->frame = new_time;
 }
 
+void MoveMarkerAction::invalidate_regions() {
+  // markers don't affect rendered frames
+}
+
 DeleteMarkerAction::DeleteMarkerAction(QVector<Marker> *m) {
   active_array = m;
   sorted = false;
@@ -836,6 +1161,10 @@ void DeleteMarkerAction::doRedo() {
   sorted = true;
 }
 
+void DeleteMarkerAction::invalidate_regions() {
+  // markers don't affect rendered frames
+}
+
 SetSpeedAction::SetSpeedAction(Clip* c, double speed) {
   clip = c;
   old_speed = c->speed().value;
@@ -858,6 +1187,10 @@ void SetSpeedAction::doRedo() {
   clip->set_speed(cs);
 }
 
+void SetSpeedAction::invalidate_regions() {
+  olive::Invalidation.invalidate_clip(clip);
+}
+
 SetBool::SetBool(bool* b, bool setting) {
   boolean = b;
   old_setting = *b;
@@ -889,6 +1222,10 @@ void SetSelectionsCommand::doRedo() {
   }
 }
 
+void SetSelectionsCommand::invalidate_regions() {
+  // selections don't affect rendered frames
+}
+
 EditSequenceCommand::EditSequenceCommand(Media* i, SequencePtr s) {
   item = i;
   seq = s;
@@ -898,6 +1235,7 @@ EditSequenceCommand::EditSequenceCommand(Media* i, SequencePtr s) {
   old_frame_rate = s->frame_rate;
   old_audio_frequency = s->audio_frequency;
   old_audio_layout = s->audio_layout;
+  old_half_float = s->half_float;
 }
 
 void EditSequenceCommand::doUndo() {
@@ -907,6 +1245,7 @@ void EditSequenceCommand::doUndo() {
   seq->frame_rate = old_frame_rate;
   seq->audio_frequency = old_audio_frequency;
   seq->audio_layout = old_audio_layout;
+  seq->half_float = old_half_float;
   update();
 }
 
@@ -917,6 +1256,7 @@ void EditSequenceCommand::doRedo() {
   seq->frame_rate = frame_rate;
   seq->audio_frequency = audio_frequency;
   seq->audio_layout = audio_layout;
+  seq->half_float = half_float;
   update();
 }
 
@@ -925,7 +1265,15 @@ void EditSequenceCommand::update() {
   item->set_sequence(seq);
 
   for (int i=0;i<seq->clips.size();i++) {
-    if (seq->clips.at(i) != nullptr) seq->clips.at(i)->refresh();
+    Clip* c = seq->clips.at(i).get();
+    if (c != nullptr) {
+      c->refresh();
+
+      // footage is decoded at a bit depth that depends on the compositing precision, reopen it with the new one
+      if (half_float != old_half_float && c->track() < 0 && c->IsOpen()) {
+        c->Close(true);
+      }
+    }
   }
 
   if (olive::ActiveSequence == seq) {
@@ -983,6 +1331,10 @@ void UpdateFootageTooltip::doRedo() {
   item->update_tooltip();
 }
 
+void UpdateFootageTooltip::invalidate_regions() {
+  // tooltips don't affect rendered frames
+}
+
 MoveEffectCommand::MoveEffectCommand() {}
 
 void MoveEffectCommand::doUndo() {
@@ -994,6 +1346,10 @@ void MoveEffectCommand::doRedo() {
   clip->effects.move(from, to);
 }
 
+void MoveEffectCommand::invalidate_regions() {
+  olive::Invalidation.invalidate_clip(clip);
+}
+
 RemoveClipsFromClipboard::RemoveClipsFromClipboard(int index) {
   pos = index;
   done = false;
@@ -1012,6 +1368,10 @@ void RemoveClipsFromClipboard::doRedo() {
   done = true;
 }
 
+void RemoveClipsFromClipboard::invalidate_regions() {
+  // the clipboard doesn't affect rendered frames
+}
+
 RenameClipCommand::RenameClipCommand(Clip *clip, QString new_name)
 {
   clip_ = clip;
@@ -1027,6 +1387,10 @@ void RenameClipCommand::doRedo() {
   clip_->set_name(new_name_);
 }
 
+void RenameClipCommand::invalidate_regions() {
+  // clip names don't affect rendered frames
+}
+
 SetPointer::SetPointer(void **pointer, void *data) {
   p = pointer;
   new_data = data;
@@ -1054,11 +1418,21 @@ RippleAction::RippleAction(SequencePtr is, long ipoint, long ilength, const QVec
   point = ipoint;
   length = ilength;
   ignore = iignore;
+  ca = nullptr;
 }
 
 void RippleAction::doUndo() {
   ca->undo();
   delete ca;
+  ca = nullptr;
+}
+
+qint64 RippleAction::memory_usage() {
+  qint64 usage = sizeof(RippleAction) + ignore.size() * qint64(sizeof(int));
+  if (ca != nullptr) {
+    usage += ca->memory_usage();
+  }
+  return usage;
 }
 
 void RippleAction::doRedo() {
@@ -1076,6 +1450,11 @@ void RippleAction::doRedo() {
   ca->redo();
 }
 
+void RippleAction::invalidate_regions() {
+  // everything after the ripple point moves
+  olive::Invalidation.invalidate(s.get(), point, LONG_MAX);
+}
+
 SetDouble::SetDouble(double* pointer, double old_value, double new_value) {
   p = pointer;
   oldval = old_value;
@@ -1140,6 +1519,10 @@ void KeyframeFieldSet::doRedo() {
   done = true;
 }
 
+void KeyframeFieldSet::invalidate_regions() {
+  olive::Invalidation.invalidate_field(field);
+}
+
 SetKeyframing::SetKeyframing(EffectRow *irow, bool ib) {
   row = irow;
   b = ib;
@@ -1153,6 +1536,10 @@ void SetKeyframing::doRedo() {
   row->setKeyframing(b);
 }
 
+void SetKeyframing::invalidate_regions() {
+  olive::Invalidation.invalidate_effect(row->parent_effect);
+}
+
 RefreshClips::RefreshClips(Media *m) {
   media = m;
 }
@@ -1190,17 +1577,139 @@ SetEffectData::SetEffectData(EffectPtr e, const QByteArray &s) {
 }
 
 void SetEffectData::doUndo() {
-  effect->load_from_string(old_data);
+  effect->load_from_string(old_data.Apply(data));
 
   old_data.clear();
 }
 
 void SetEffectData::doRedo() {
-  old_data = effect->save_to_string();
+  old_data = ByteDelta::Create(data, effect->save_to_string());
 
   effect->load_from_string(data);
 }
 
+void SetEffectData::invalidate_regions() {
+  olive::Invalidation.invalidate_effect(effect.get());
+}
+
+qint64 SetEffectData::memory_usage() {
+  return sizeof(SetEffectData) + data.size() + old_data.memory_usage();
+}
+
+ByteDelta::ByteDelta() {}
+
+// splits data into tokens ending at '>' or a newline, returned as start offsets (with data.size() appended at the end)
+static QVector<int> tokenize_for_delta(const QByteArray& data) {
+  QVector<int> starts;
+  starts.append(0);
+  for (int i=0;i<data.size();i++) {
+    if (data.at(i) == '>' || data.at(i) == '\n') {
+      starts.append(i+1);
+    }
+  }
+  if (starts.last() != data.size()) {
+    starts.append(data.size());
+  }
+  return starts;
+}
+
+ByteDelta ByteDelta::Create(const QByteArray &base, const QByteArray &target) {
+  ByteDelta delta;
+
+  QVector<int> base_tokens = tokenize_for_delta(base);
+  QVector<int> target_tokens = tokenize_for_delta(target);
+
+  // index every token of the base array by its content
+  QHash<QByteArray, QVector<int> > base_lookup;
+  for (int i=0;i<base_tokens.size()-1;i++) {
+    base_lookup[base.mid(base_tokens.at(i), base_tokens.at(i+1) - base_tokens.at(i))].append(i);
+  }
+
+  // the base token we expect to match next if the arrays are still in sync
+  int next_base = 0;
+
+  for (int i=0;i<target_tokens.size()-1;i++) {
+    int offset = target_tokens.at(i);
+    int length = target_tokens.at(i+1) - offset;
+    QByteArray token = target.mid(offset, length);
+
+    int match = -1;
+
+    if (next_base < base_tokens.size()-1
+        && base_tokens.at(next_base+1) - base_tokens.at(next_base) == length
+        && base.mid(base_tokens.at(next_base), length) == token) {
+      match = next_base;
+    } else {
+      QHash<QByteArray, QVector<int> >::const_iterator it = base_lookup.constFind(token);
+      if (it != base_lookup.constEnd()) {
+        // prefer the first occurrence after where we are, so runs of tokens keep being copied in order
+        const QVector<int>& candidates = it.value();
+        match = candidates.first();
+        for (int j=0;j<candidates.size();j++) {
+          if (candidates.at(j) >= next_base) {
+            match = candidates.at(j);
+            break;
+          }
+        }
+      }
+    }
+
+    if (match > -1) {
+      int base_offset = base_tokens.at(match);
+
+      if (!delta.ops_.isEmpty()
+          && delta.ops_.last().data.isEmpty()
+          && delta.ops_.last().offset + delta.ops_.last().length == base_offset) {
+        delta.ops_.last().length += length;
+      } else {
+        Op op;
+        op.offset = base_offset;
+        op.length = length;
+        delta.ops_.append(op);
+      }
+
+      next_base = match + 1;
+    } else {
+      if (!delta.ops_.isEmpty() && !delta.ops_.last().data.isEmpty()) {
+        delta.ops_.last().data.append(token);
+      } else {
+        Op op;
+        op.offset = 0;
+        op.length = 0;
+        op.data = token;
+        delta.ops_.append(op);
+      }
+    }
+  }
+
+  return delta;
+}
+
+QByteArray ByteDelta::Apply(const QByteArray &base) const {
+  QByteArray result;
+  for (int i=0;i<ops_.size();i++) {
+    const Op& op = ops_.at(i);
+    if (op.data.isEmpty()) {
+      result.append(base.constData() + op.offset, op.length);
+    } else {
+      result.append(op.data);
+    }
+  }
+  return result;
+}
+
+void ByteDelta::clear() {
+  ops_.clear();
+}
+
+qint64 ByteDelta::memory_usage() const {
+  qint64 usage = sizeof(ByteDelta) + ops_.size() * qint64(sizeof(Op));
+  for (int i=0;i<ops_.size();i++) {
+    usage += ops_.at(i).data.size();
+  }
+  return usage;
+}
+
 OliveAction::OliveAction(bool iset_window_modified) {
   set_window_modified = iset_window_modified;
 }
@@ -1208,15 +1717,27 @@ OliveAction::OliveAction(bool iset_window_modified) {
 OliveAction::~OliveAction() {}
 
 void OliveAction::undo() {
+  invalidate_regions();
   doUndo();
+  invalidate_regions();
 
   if (set_window_modified) {
     olive::MainWindow->setWindowModified(old_window_modified);
   }
 }
 
+void OliveAction::invalidate_regions() {
+  olive::Invalidation.invalidate_sequence(olive::ActiveSequence.get());
+}
+
+qint64 OliveAction::memory_usage() {
+  return sizeof(OliveAction);
+}
+
 void OliveAction::redo() {
+  invalidate_regions();
   doRedo();
+  invalidate_regions();
 
   if (set_window_modified) {
 
@@ -35,8 +35,54 @@
 #include <QVariant>
 #include <QModelIndex>
 
+/**
+ * @brief The UndoHistory class
+ *
+ * Undo stack that keeps its history within Config::undo_memory_limit. Works like QUndoStack (including merging
+ * commands with matching id() through QUndoCommand::mergeWith()), but also estimates how much memory each command
+ * holds on to (see command_memory_usage()) and deletes the oldest commands once the total goes over the limit.
+ */
+class UndoHistory {
+public:
+  UndoHistory();
+  ~UndoHistory();
+
+  /**
+   * @brief Run a command and add it to the history, taking ownership of it
+   */
+  void push(QUndoCommand* cmd);
+
+  void undo();
+  void redo();
+  void clear();
+
+  bool canUndo();
+  bool canRedo();
+
+  /**
+   * @brief Returns the estimated number of bytes held by all commands in the history
+   */
+  qint64 memory_usage();
+
+  /**
+   * @brief Returns the estimated number of bytes held by a command (and any commands it contains)
+   */
+  static qint64 command_memory_usage(QUndoCommand* cmd);
+private:
+  // update a command's cost after it was done/undone since commands may hold different data in either state
+  void update_cost(int index);
+
+  // delete the oldest commands until the history fits Config::undo_memory_limit again
+  void enforce_limit();
+
+  QVector<QUndoCommand*> commands_;
+  QVector<qint64> costs_;
+  int index_;
+  qint64 total_cost_;
+};
+
 namespace olive {
-extern QUndoStack UndoStack;
+extern UndoHistory UndoStack;
 }
 
 class OliveAction : public QUndoCommand {
@@ -49,6 +95,23 @@ public:
 
   virtual void doUndo() = 0;
   virtual void doRedo() = 0;
+
+  /**
+   * @brief Estimate how many bytes this action holds on to
+   *
+   * Used by UndoHistory to keep the undo history within its memory limit. The default covers actions that only hold
+   * a few values, actions holding clips, effects or serialized data override it.
+   */
+  virtual qint64 memory_usage();
+
+  /**
+   * @brief Report what this action changes to olive::Invalidation
+   *
+   * Called both before and after the action is done or undone, so reporting what the action touches in the current
+   * state covers both where things were and where they end up. The default reports the whole active sequence. Actions
+   * that know exactly what they change, or that don't change rendered output at all, override it.
+   */
+  virtual void invalidate_regions();
 private:
   /**
      * @brief Setting whether to change the windowModified state of MainWindow
@@ -66,6 +129,7 @@ public:
   MoveClipAction(Clip* c, long iin, long iout, long iclip_in, int itrack, bool irelative);
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
 private:
   Clip* clip;
 
@@ -87,6 +151,8 @@ public:
   RippleAction(SequencePtr is, long ipoint, long ilength, const QVector<int>& iignore);
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
+  virtual qint64 memory_usage() override;
 private:
   SequencePtr s;
   long point;
@@ -101,6 +167,8 @@ public:
   virtual ~DeleteClipAction() override;
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
+  virtual qint64 memory_usage() override;
 private:
   SequencePtr seq;
   ClipPtr ref;
@@ -128,6 +196,8 @@ public:
   AddEffectCommand(Clip* c, EffectPtr e, const EffectMeta* m, int insert_pos = -1);
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
+  virtual qint64 memory_usage() override;
 private:
   Clip* clip;
   const EffectMeta* meta;
@@ -141,6 +211,7 @@ public:
   AddTransitionCommand(Clip* iopen, Clip* iclose, TransitionPtr copy, const EffectMeta* itransition, int ilength);
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
 private:
   Clip* open_;
   Clip* close_;
@@ -157,6 +228,7 @@ public:
   ModifyTransitionCommand(TransitionPtr t, long ilength);
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
 private:
   TransitionPtr transition_ref_;
   long new_length_;
@@ -168,6 +240,7 @@ public:
   DeleteTransitionCommand(TransitionPtr t);
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
 private:
   TransitionPtr transition_ref_;
   Clip* opened_clip_;
@@ -179,6 +252,7 @@ public:
   SetTimelineInOutCommand(SequencePtr s, bool enabled, long in, long out);
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
 private:
   SequencePtr seq;
 
@@ -197,6 +271,7 @@ public:
   virtual ~NewSequenceCommand() override;
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
 private:
   Media* seq;
   Media* parent;
@@ -209,6 +284,7 @@ public:
   virtual ~AddMediaCommand() override;
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
 private:
   Media* item;
   Media* parent;
@@ -221,6 +297,7 @@ public:
   virtual ~DeleteMediaCommand() override;
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
 private:
   Media* item;
   Media* parent;
@@ -233,6 +310,8 @@ public:
   virtual ~AddClipCommand() override;
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
+  virtual qint64 memory_usage() override;
 private:
   SequencePtr seq;
   QVector<ClipPtr> clips;
@@ -244,6 +323,7 @@ public:
   LinkCommand();
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
   SequencePtr s;
   QVector<int> clips;
   bool link;
@@ -295,6 +375,8 @@ public:
   virtual ~EffectDeleteCommand() override;
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
+  virtual qint64 memory_usage() override;
   QVector<Clip*> clips;
   QVector<int> fx;
 private:
@@ -309,6 +391,7 @@ public:
   Media* to;
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
 private:
   QVector<Media*> froms;
 };
@@ -318,6 +401,7 @@ public:
   MediaRename(Media* iitem, QString to);
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
 private:
   Media* item;
   QString from;
@@ -329,6 +413,7 @@ public:
   KeyframeDelete(EffectField* ifield, int iindex);
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
 private:
   EffectField* field;
   int index;
@@ -343,6 +428,7 @@ public:
   KeyframeFieldSet(EffectField* ifield, int ii);
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
 private:
   EffectField* field;
   int index;
@@ -350,16 +436,29 @@ private:
   bool done;
 };
 
+/**
+ * @brief Undo command for a change to an EffectField's value
+ *
+ * Consecutive changes to the same field (e.g. dragging a slider a few times or typing into a text field) made within a
+ * second of each other are merged into one command, so each of them doesn't need its own undo step.
+ */
 class EffectFieldUndo : public OliveAction {
 public:
   EffectFieldUndo(EffectField* field);
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
+  virtual int id() const override;
+  virtual bool mergeWith(const QUndoCommand* other) override;
+  virtual qint64 memory_usage() override;
 private:
   EffectField* field;
   QVariant old_val;
   QVariant new_val;
   bool done;
+
+  // when the last change merged into this command was made
+  qint64 timestamp;
 };
 
 enum SetClipPropertyType {
@@ -374,6 +473,7 @@ public:
   SetClipProperty(SetClipPropertyType type);
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
   void AddSetting(QVector<Clip *> clips, bool setting);
   void AddSetting(Clip *c, bool setting);
 private:
@@ -389,6 +489,7 @@ public:
   AddMarkerAction(QVector<Marker>* m, long t, QString n);
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
 private:
   QVector<Marker>* active_array;
   long time;
@@ -402,6 +503,7 @@ public:
   MoveMarkerAction(Marker* m, long o, long n);
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
 private:
   Marker* marker;
   long old_time;
@@ -413,6 +515,7 @@ public:
   DeleteMarkerAction(QVector<Marker>* m);
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
   QVector<int> markers;
 private:
   QVector<Marker>* active_array;
@@ -425,6 +528,7 @@ public:
   SetSpeedAction(Clip* c, double speed);
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
 private:
   Clip* clip;
   double old_speed;
@@ -447,6 +551,7 @@ public:
   SetSelectionsCommand(SequencePtr s);
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
   QVector<Selection> old_data;
   QVector<Selection> new_data;
 private:
@@ -467,6 +572,7 @@ public:
   double frame_rate;
   int audio_frequency;
   int audio_layout;
+  bool half_float;
 private:
   Media* item;
   SequencePtr seq;
@@ -477,6 +583,7 @@ private:
   double old_frame_rate;
   int old_audio_frequency;
   int old_audio_layout;
+  bool old_half_float;
 };
 
 class SetInt : public OliveAction {
@@ -534,6 +641,7 @@ public:
   UpdateFootageTooltip(Media* i);
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
 private:
   Media* item;
 };
@@ -543,6 +651,7 @@ public:
   MoveEffectCommand();
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
   Clip* clip;
   int from;
   int to;
@@ -554,6 +663,7 @@ public:
   virtual ~RemoveClipsFromClipboard() override;
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
 private:
   int pos;
   ClipPtr clip;
@@ -565,6 +675,7 @@ public:
   RenameClipCommand(Clip* clip, QString new_name);
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
 private:
   QString old_name_;
   QString new_name_;
@@ -605,6 +716,7 @@ public:
   SetKeyframing(EffectRow* irow, bool ib);
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
 private:
   EffectRow* row;
   bool b;
@@ -625,15 +737,58 @@ public:
   virtual void doRedo() override;
 };
 
+/**
+ * @brief Compact encoding of a QByteArray as its differences to another one
+ *
+ * Undo commands that keep two serializations of the same object (e.g. an effect's settings before and after a change)
+ * store one of them in full and the other as a ByteDelta against it. The data is split into tokens (ending at '>' or
+ * a newline, which suits the XML effects are serialized to) and the delta copies runs of tokens that already exist
+ * in the base array, only storing tokens that don't.
+ */
+class ByteDelta {
+public:
+  ByteDelta();
+
+  /**
+   * @brief Create the delta that turns `base` into `target`
+   */
+  static ByteDelta Create(const QByteArray& base, const QByteArray& target);
+
+  /**
+   * @brief Rebuild the target array from the same `base` the delta was created with
+   */
+  QByteArray Apply(const QByteArray& base) const;
+
+  void clear();
+
+  /**
+   * @brief Returns the estimated number of bytes the delta takes up
+   */
+  qint64 memory_usage() const;
+private:
+  // copies `length` bytes from the base array at `offset` if `data` is empty, inserts `data` otherwise
+  struct Op {
+    int offset;
+    int length;
+    QByteArray data;
+  };
+
+  QVector<Op> ops_;
+};
+
 class SetEffectData : public OliveAction {
 public:
   SetEffectData(EffectPtr e, const QByteArray &s);
   virtual void doUndo() override;
   virtual void doRedo() override;
+  virtual void invalidate_regions() override;
+  virtual qint64 memory_usage() override;
 private:
   EffectPtr effect;
   QByteArray data;
-  QByteArray old_data;
+
+  // the effect's settings from before the command was done, stored as a delta against `data`
+  ByteDelta old_data;
 };
 
 #endif // UNDO_H
@@ -58,6 +58,10 @@ qint64 audio_ibuffer_read = 0;
 long audio_ibuffer_frame = 0;
 double audio_ibuffer_timecode = 0;
 
+// total bytes sent to the audio device and the total at the last clear_audio_ibuffer()
+qint64 audio_bytes_sent = 0;
+qint64 audio_bytes_sent_at_clear = 0;
+
 AudioSenderThread* audio_thread = nullptr;
 
 bool is_audio_device_set() {
@@ -147,10 +151,27 @@ void clear_audio_ibuffer() {
   audio_write_lock.lock();
   memset(audio_ibuffer, 0, audio_ibuffer_size);
   audio_ibuffer_read = 0;
+  audio_bytes_sent_at_clear = audio_bytes_sent;
   audio_write_lock.unlock();
   if (audio_thread != nullptr) audio_thread->lock.unlock();
 }
 
+double get_audio_playback_seconds() {
+  if (!audio_device_set) {
+    return 0;
+  }
+
+  audio_thread->lock.lock();
+  qint64 sent = audio_bytes_sent - audio_bytes_sent_at_clear;
+  audio_thread->lock.unlock();
+
+  const QAudioFormat& format = audio_output->format();
+  qint64 queued = audio_output->bufferSize() - audio_output->bytesFree();
+  int bytes_per_second = format.sampleRate() * format.channelCount() * (format.sampleSize() / 8);
+
+  return double(sent - queued) / double(bytes_per_second);
+}
+
 int current_audio_freq() {
   return audio_rendering ? olive::ActiveSequence->audio_frequency : audio_output->format().sampleRate();
 }
@@ -188,7 +209,11 @@ void AudioSenderThread::run() {
     cond.wait(&lock);
     if (close) {
       break;
-    } else if (panel_sequence_viewer->playing || panel_footage_viewer->playing || audio_scrub) {
+    } else if ((panel_sequence_viewer->playing && !panel_sequence_viewer->WaitingForPlayWake())
+               || (panel_footage_viewer->playing && !panel_footage_viewer->WaitingForPlayWake())
+               || audio_scrub) {
+      // audio starts once the viewer is ready to show frames (see Viewer::play_wake()) so the playback clock, which
+      // follows the audio, starts with it
       int written_bytes = 0;
 
       int adjusted_read_index = audio_ibuffer_read%audio_ibuffer_size;
@@ -213,6 +238,8 @@ int AudioSenderThread::send_audio_to_output(qint64 offset, int max) {
   qint64 audio_ibuffer_limit = audio_ibuffer_read + actual_write;
 
   if (actual_write > 0) {
+    audio_bytes_sent += actual_write;
+
     // average values and send to audio monitor
     int channels = audio_output->format().channelCount();
     qint64 lim = offset + actual_write;
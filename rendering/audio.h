@@ -64,6 +64,18 @@ extern bool recording;
 extern bool audio_rendering;
 void clear_audio_ibuffer();
 
+/**
+ * @brief Get how much of the audio sent since the last clear_audio_ibuffer() the device has actually played
+ *
+ * Accounts for audio still queued in the device's buffer. Negative while the device is still playing audio queued
+ * before the buffer was cleared. Used as the playback clock (see PlaybackClock).
+ *
+ * @return
+ *
+ * Position in seconds
+ */
+double get_audio_playback_seconds();
+
 int current_audio_freq();
 
 bool is_audio_device_set();
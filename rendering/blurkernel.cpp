@@ -0,0 +1,158 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "blurkernel.h"
+
+#include <QtMath>
+
+// the first Gaussian pass samples every texel (folded in pairs), reaching 3 sigma needs at most this many on each side
+const int kBlurFoldedReach = kBlurMaxTaps - 2;
+
+// sparse passes take one sample per step on each side out to 3 sigma
+const int kBlurSparseReach = (kBlurMaxTaps - 1) / 2;
+
+// passes left to run that would add less than this fraction of the blur's deviation are skipped
+const double kBlurNegligible = 0.25;
+
+static BlurPass new_pass(double dir_x, double dir_y) {
+  BlurPass pass;
+  pass.direction[0] = GLfloat(dir_x);
+  pass.direction[1] = GLfloat(dir_y);
+  pass.tap_count = 0;
+  return pass;
+}
+
+static void add_tap(BlurPass& pass, double offset, double weight) {
+  pass.offsets[pass.tap_count] = GLfloat(offset);
+  pass.weights[pass.tap_count] = GLfloat(weight);
+  pass.tap_count++;
+}
+
+static void normalize_pass(BlurPass& pass) {
+  double sum = 0;
+  for (int i=0;i<pass.tap_count;i++) {
+    sum += pass.weights[i];
+  }
+  for (int i=0;i<pass.tap_count;i++) {
+    pass.weights[i] = GLfloat(pass.weights[i] / sum);
+  }
+}
+
+static double gaussian(double x, double sigma) {
+  return qExp(-0.5 * (x * x) / (sigma * sigma));
+}
+
+// a Gaussian over every texel, with each pair of neighboring texels read with one bilinear sample
+static BlurPass folded_gaussian_pass(double sigma, double dir_x, double dir_y) {
+  BlurPass pass = new_pass(dir_x, dir_y);
+
+  int reach = qMin(qCeil(sigma * 3.0), kBlurFoldedReach);
+
+  add_tap(pass, 0.0, 1.0);
+  for (int i=1;i<=reach;i+=2) {
+    double w1 = gaussian(i, sigma);
+    double w2 = (i + 1 <= reach) ? gaussian(i + 1, sigma) : 0.0;
+    double offset = (i * w1 + (i + 1) * w2) / (w1 + w2);
+    add_tap(pass, -offset, w1 + w2);
+    add_tap(pass, offset, w1 + w2);
+  }
+
+  normalize_pass(pass);
+  return pass;
+}
+
+// a Gaussian sampled every `step` pixels, only accurate on an image already blurred by at least `step`
+static BlurPass sparse_gaussian_pass(double sigma, double step, double dir_x, double dir_y) {
+  BlurPass pass = new_pass(dir_x, dir_y);
+
+  int reach = qMin(qCeil(sigma * 3.0 / step), kBlurSparseReach);
+
+  add_tap(pass, 0.0, 1.0);
+  for (int i=1;i<=reach;i++) {
+    double w = gaussian(i * step, sigma);
+    add_tap(pass, -i * step, w);
+    add_tap(pass, i * step, w);
+  }
+
+  normalize_pass(pass);
+  return pass;
+}
+
+void plan_gaussian_blur(QVector<BlurPass>& passes, double sigma, double dir_x, double dir_y) {
+  double target = sigma * sigma;
+  double applied = 0.0;
+
+  while (true) {
+    double remaining = qSqrt(qMax(0.0, target - applied));
+    double current = qSqrt(applied);
+
+    if (applied == 0.0) {
+      if (remaining < kBlurNegligible) {
+        break;
+      }
+
+      // largest blur a folded pass can reach 3 sigma with
+      double pass_sigma = qMin(remaining, kBlurFoldedReach / 3.0);
+      passes.append(folded_gaussian_pass(pass_sigma, dir_x, dir_y));
+      applied += pass_sigma * pass_sigma;
+    } else {
+      if (remaining < current * kBlurNegligible) {
+        break;
+      }
+
+      // step by the blur applied so far, which is as far as samples can be spread without aliasing
+      double pass_sigma = qMin(remaining, current * kBlurSparseReach / 3.0);
+      passes.append(sparse_gaussian_pass(pass_sigma, current, dir_x, dir_y));
+      applied += pass_sigma * pass_sigma;
+    }
+  }
+}
+
+void plan_box_blur(QVector<BlurPass>& passes, double width, double dir_x, double dir_y) {
+  if (width < 1.0) {
+    return;
+  }
+
+  // exact box, each sample sits between two texels to average them
+  int half_width = qMin(qCeil(width * 0.5), kBlurMaxTaps);
+  BlurPass first = new_pass(dir_x, dir_y);
+  for (int i=0;i<half_width;i++) {
+    add_tap(first, -half_width + 0.5 + 2 * i, 1.0);
+  }
+  normalize_pass(first);
+  passes.append(first);
+
+  double current = 2 * half_width;
+
+  // average copies of the box so far, spread evenly so together they span the wider box
+  while (width > current * 1.01) {
+    double copies = qMin(width / current, double(kBlurMaxTaps));
+    int taps = qCeil(copies);
+    double spacing = current * (copies - 1.0) / (taps - 1);
+
+    BlurPass pass = new_pass(dir_x, dir_y);
+    for (int i=0;i<taps;i++) {
+      add_tap(pass, (i - (taps - 1) * 0.5) * spacing, 1.0);
+    }
+    normalize_pass(pass);
+    passes.append(pass);
+
+    current *= copies;
+  }
+}
@@ -0,0 +1,80 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef BLURKERNEL_H
+#define BLURKERNEL_H
+
+#include <QOpenGLFunctions>
+#include <QVector>
+
+// maximum number of samples a blur pass can take, must match the array sizes in effects/blur.frag
+const int kBlurMaxTaps = 16;
+
+/**
+ * @brief One pass of a blur, run by effects/blur.frag
+ *
+ * Each output pixel is the weighted sum of tap_count bilinear samples along a line. Offsets are in pixels along
+ * direction (a unit vector).
+ */
+struct BlurPass {
+  GLfloat direction[2];
+  int tap_count;
+  GLfloat offsets[kBlurMaxTaps];
+  GLfloat weights[kBlurMaxTaps];
+};
+
+/**
+ * @brief Append the passes of a one dimensional Gaussian blur to a pass list
+ *
+ * Small blurs are one pass with neighboring texels folded into single bilinear samples. Larger blurs are split
+ * into several Gaussians whose variances add up to sigma squared, each sampled sparsely at a spacing matching the
+ * blur already applied, so the number of passes grows with the logarithm of sigma rather than the number of
+ * samples growing with sigma.
+ *
+ * @param passes
+ *
+ * List to append to. Nothing is appended if the blur is too small to be visible.
+ *
+ * @param sigma
+ *
+ * Standard deviation in pixels
+ *
+ * @param dir_x, dir_y
+ *
+ * Unit vector to blur along
+ */
+void plan_gaussian_blur(QVector<BlurPass>& passes, double sigma, double dir_x, double dir_y);
+
+/**
+ * @brief Append the passes of a one dimensional box blur to a pass list
+ *
+ * The first pass is an exact box of up to 2 * kBlurMaxTaps pixels. Wider boxes are built up from further passes
+ * that each average up to kBlurMaxTaps copies of the previous result, multiplying its width.
+ *
+ * @param width
+ *
+ * Total width of the box in pixels
+ *
+ * @param dir_x, dir_y
+ *
+ * Unit vector to blur along
+ */
+void plan_box_blur(QVector<BlurPass>& passes, double width, double dir_x, double dir_y);
+
+#endif // BLURKERNEL_H
@@ -25,6 +25,7 @@
 #include <QOpenGLFramebufferObject>
 #include <QtMath>
 #include <QAudioOutput>
+#include <QElapsedTimer>
 #include <math.h>
 
 #include "project/projectelements.h"
@@ -38,6 +39,7 @@
 //#define AUDIOWARNINGS
 
 const AVPixelFormat kDestPixFmt = AV_PIX_FMT_RGBA;
+const AVPixelFormat kDestDeepPixFmt = AV_PIX_FMT_RGBA64;
 const AVSampleFormat kDestSampleFmt = AV_SAMPLE_FMT_S16;
 
 double bytes_to_seconds(int nb_bytes, int nb_channels, int sample_rate) {
@@ -803,7 +805,9 @@ void Cacher::WakeMainThread()
 Cacher::Cacher(Clip* c) :
   clip(c),
   frame_(nullptr),
-  pkt(nullptr)
+  pkt(nullptr),
+  using_proxy_(false),
+  dest_pix_fmt_(kDestPixFmt)
 {}
 
 void Cacher::OpenWorker() {
@@ -838,10 +842,12 @@ void Cacher::OpenWorker() {
     // byte array for retriving raw bytes from QString URL
     QByteArray ba;
 
-    // do we have a proxy?
-    if (m->proxy
-        && !m->proxy_path.isEmpty()
-        && QFileInfo::exists(m->proxy_path)) {
+    // should we use the proxy? (decided by the ProxyPolicy in compose_sequence())
+    using_proxy_ = (clip->UsingProxy()
+                    && !m->proxy_path.isEmpty()
+                    && QFileInfo::exists(m->proxy_path));
+
+    if (using_proxy_) {
       ba = m->proxy_path.toUtf8();
     } else {
       ba = m->url.toUtf8();
@@ -935,7 +941,16 @@ void Cacher::OpenWorker() {
         last_filter = yadif_filter;
       }
 
-      const char* chosen_format = av_get_pix_fmt_name(kDestPixFmt);
+      // keep the extra precision of deep sources if the sequence can make use of it
+      dest_pix_fmt_ = kDestPixFmt;
+      const AVPixFmtDescriptor* src_desc = av_pix_fmt_desc_get(static_cast<AVPixelFormat>(stream->codecpar->format));
+      if (clip->sequence->half_float
+          && src_desc != nullptr
+          && src_desc->comp[0].depth > 8) {
+        dest_pix_fmt_ = kDestDeepPixFmt;
+      }
+
+      const char* chosen_format = av_get_pix_fmt_name(dest_pix_fmt_);
       snprintf(filter_args, sizeof(filter_args), "pix_fmts=%s", chosen_format);
 
       AVFilterContext* format_conv;
@@ -1259,6 +1274,11 @@ AVRational Cacher::media_time_base()
   return stream->time_base;
 }
 
+AVPixelFormat Cacher::media_pixel_format()
+{
+  return dest_pix_fmt_;
+}
+
 ClipQueue *Cacher::queue()
 {
   return &queue_;
@@ -1311,6 +1331,10 @@ int Cacher::RetrieveFrameAndProcess(AVFrame **f)
   // error codes from FFmpeg
   int retrieve_code, read_code, send_code;
 
+  // time how long this frame takes so ProxyPolicy knows how expensive this file is to play
+  QElapsedTimer decode_timer;
+  decode_timer.start();
+
   // frame for FFmpeg to decode into
   *f = av_frame_alloc();
 
@@ -1347,5 +1371,10 @@ int Cacher::RetrieveFrameAndProcess(AVFrame **f)
   if (read_code == AVERROR_EOF) {
     return AVERROR_EOF;
   }
+
+  if (retrieve_code >= 0) {
+    clip->media()->to_footage()->record_decode_time(using_proxy_, decode_timer.nsecsElapsed() * 0.000001);
+  }
+
   return retrieve_code;
 }
@@ -245,6 +245,17 @@ public:
    */
   AVRational media_time_base();
 
+  /**
+   * @brief Retrieve the pixel format of the frames this cacher outputs
+   *
+   * Usually AV_PIX_FMT_RGBA. If the Sequence composites in 16-bit floating point (see Sequence::half_float) and the
+   * source has more than 8 bits per component, frames are converted to AV_PIX_FMT_RGBA64 instead so the extra
+   * precision survives until the upload.
+   *
+   * Only call after the thread has been opened by Open().
+   */
+  AVPixelFormat media_pixel_format();
+
   /**
    * @brief Get cacher queue object
    *
@@ -320,6 +331,18 @@ private:
    */
   bool scrubbing_;
 
+  /**
+   * @brief Set by OpenWorker() to **TRUE** if the proxy was opened rather than the source file
+   *
+   * Used to attribute measured decode times to the right file (see Footage::record_decode_time()).
+   */
+  bool using_proxy_;
+
+  /**
+   * @brief Pixel format video frames are converted to, see media_pixel_format()
+   */
+  AVPixelFormat dest_pix_fmt_;
+
   /**
    * @brief Current Sequence playback speed set by Cache()
    */
@@ -0,0 +1,118 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "compositingbenchmark.h"
+
+#include <QOffscreenSurface>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions>
+#include <QElapsedTimer>
+
+#include "rendering/renderfunctions.h"
+
+// number of layers blended per format, after a few untimed ones to let the driver settle
+const int kBenchmarkWarmupPasses = 10;
+const int kBenchmarkPasses = 200;
+
+// composite kBenchmarkPasses layers into framebuffers of `internal_format` and return layers per second
+double benchmark_format(QOpenGLContext* ctx, int width, int height, GLenum internal_format) {
+  QOpenGLFramebufferObjectFormat format;
+  format.setInternalTextureFormat(internal_format);
+
+  QOpenGLFramebufferObject layer(width, height, format);
+  QOpenGLFramebufferObject composite(width, height, format);
+
+  if (!layer.isValid() || !composite.isValid()) {
+    return 0;
+  }
+
+  glViewport(0, 0, width, height);
+  glMatrixMode(GL_PROJECTION);
+  glLoadIdentity();
+  glOrtho(0, 1, 0, 1, -1, 1);
+  glMatrixMode(GL_MODELVIEW);
+  glLoadIdentity();
+
+  // semi-transparent premultiplied layer so every pass actually has to blend
+  layer.bind();
+  glClearColor(0.25f, 0.25f, 0.25f, 0.5f);
+  glClear(GL_COLOR_BUFFER_BIT);
+  layer.release();
+
+  composite.bind();
+  glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+  glClear(GL_COLOR_BUFFER_BIT);
+  glBindTexture(GL_TEXTURE_2D, layer.texture());
+
+  QElapsedTimer timer;
+
+  for (int i=0;i<kBenchmarkWarmupPasses+kBenchmarkPasses;i++) {
+    if (i == kBenchmarkWarmupPasses) {
+      glFinish();
+      timer.start();
+    }
+    glDrawArrays(GL_TRIANGLE_FAN, 0, 4);
+  }
+
+  glFinish();
+  qint64 elapsed = timer.nsecsElapsed();
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+  composite.release();
+
+  return (elapsed > 0) ? kBenchmarkPasses * 1000000000.0 / elapsed : 0;
+}
+
+CompositingBenchmarkResult run_compositing_benchmark(int width, int height) {
+  CompositingBenchmarkResult result;
+  result.rgba8_rate = 0;
+  result.rgba16f_rate = 0;
+
+  QOffscreenSurface surface;
+  surface.create();
+
+  QOpenGLContext ctx;
+  if (!ctx.create() || !ctx.makeCurrent(&surface)) {
+    return result;
+  }
+
+  GLuint quad_buffer = create_quad_buffer(&ctx);
+  bind_quad_buffer(&ctx, quad_buffer);
+
+  glEnable(GL_TEXTURE_2D);
+  glEnable(GL_BLEND);
+  glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+  result.rgba8_rate = benchmark_format(&ctx, width, height, GL_RGBA8);
+
+  // only test floating point if the context would actually composite in it
+  if (supports_float_textures(&ctx)) {
+    result.rgba16f_rate = benchmark_format(&ctx, width, height, GL_RGBA16F);
+  }
+
+  glDisable(GL_BLEND);
+  glDisable(GL_TEXTURE_2D);
+
+  release_quad_buffer(&ctx);
+  ctx.functions()->glDeleteBuffers(1, &quad_buffer);
+
+  ctx.doneCurrent();
+
+  return result;
+}
@@ -0,0 +1,57 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef COMPOSITINGBENCHMARK_H
+#define COMPOSITINGBENCHMARK_H
+
+#include <QOpenGLContext>
+
+/**
+ * @brief Result of run_compositing_benchmark()
+ */
+struct CompositingBenchmarkResult {
+  /**
+   * @brief Layers composited per second in GL_RGBA8 framebuffers
+   */
+  double rgba8_rate;
+
+  /**
+   * @brief Layers composited per second in GL_RGBA16F framebuffers, 0 if they aren't supported
+   */
+  double rgba16f_rate;
+};
+
+/**
+ * @brief Measure how fast layers can be composited in 8-bit and 16-bit floating point framebuffers
+ *
+ * Blends a full-frame layer over another repeatedly the same way compose_sequence() does, once with each format, in
+ * a temporary OpenGL context. Used to decide whether Sequence::half_float is worth enabling on this machine. Blocks
+ * until done, which usually takes well under a second.
+ *
+ * @param width
+ *
+ * Frame width to test with, usually the Sequence's
+ *
+ * @param height
+ *
+ * Frame height to test with, usually the Sequence's
+ */
+CompositingBenchmarkResult run_compositing_benchmark(int width, int height);
+
+#endif // COMPOSITINGBENCHMARK_H
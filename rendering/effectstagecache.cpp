@@ -0,0 +1,138 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "effectstagecache.h"
+
+#include "io/config.h"
+
+EffectStageCache::EffectStageCache() :
+  size_(0)
+{}
+
+EffectStageCache::~EffectStageCache()
+{
+  Clear();
+}
+
+GLuint EffectStageCache::Find(Clip *c, int stage, const QByteArray &key)
+{
+  for (int i=entries_.size()-1;i>=0;i--) {
+    const Entry& entry = entries_.at(i);
+    if (entry.clip == c && entry.stage == stage) {
+      if (entry.key != key) {
+        return 0;
+      }
+
+      // move to the back as the most recently used
+      GLuint texture = entry.fbo->texture();
+      entries_.append(entries_.takeAt(i));
+      return texture;
+    }
+  }
+
+  return 0;
+}
+
+QOpenGLFramebufferObject *EffectStageCache::Store(Clip *c,
+                                                  int stage,
+                                                  const QByteArray &key,
+                                                  int width,
+                                                  int height,
+                                                  GLenum internal_format)
+{
+  qint64 limit = qint64(olive::CurrentConfig.effect_cache_size) * 1024 * 1024;
+  qint64 size = entry_size(width, height, internal_format);
+
+  QOpenGLFramebufferObject* fbo = nullptr;
+
+  // an older output of this stage is replaced, its framebuffer can be reused if it's the right size
+  for (int i=0;i<entries_.size();i++) {
+    if (entries_.at(i).clip == c && entries_.at(i).stage == stage) {
+      Entry old = entries_.takeAt(i);
+      size_ -= entry_size(old.fbo);
+      if (fbo_matches(old.fbo, width, height, internal_format)) {
+        fbo = old.fbo;
+      } else {
+        delete old.fbo;
+      }
+      break;
+    }
+  }
+
+  if (size > limit) {
+    delete fbo;
+    return nullptr;
+  }
+
+  // make room, reusing the first framebuffer of the right size that's evicted
+  while (size_ + size > limit) {
+    Entry old = entries_.takeFirst();
+    size_ -= entry_size(old.fbo);
+    if (fbo == nullptr && fbo_matches(old.fbo, width, height, internal_format)) {
+      fbo = old.fbo;
+    } else {
+      delete old.fbo;
+    }
+  }
+
+  if (fbo == nullptr) {
+    QOpenGLFramebufferObjectFormat format;
+    format.setInternalTextureFormat(internal_format);
+    fbo = new QOpenGLFramebufferObject(width, height, format);
+  }
+
+  Entry entry;
+  entry.clip = c;
+  entry.stage = stage;
+  entry.key = key;
+  entry.fbo = fbo;
+  entries_.append(entry);
+
+  size_ += size;
+
+  return fbo;
+}
+
+void EffectStageCache::Clear()
+{
+  for (int i=0;i<entries_.size();i++) {
+    delete entries_.at(i).fbo;
+  }
+  entries_.clear();
+  size_ = 0;
+}
+
+qint64 EffectStageCache::entry_size(QOpenGLFramebufferObject *fbo)
+{
+  return entry_size(fbo->width(), fbo->height(), fbo->format().internalTextureFormat());
+}
+
+qint64 EffectStageCache::entry_size(int width, int height, GLenum internal_format)
+{
+  // 4 components of 1 byte (RGBA8) or 2 bytes (RGBA16F)
+  qint64 bytes_per_pixel = (internal_format == GL_RGBA16F) ? 8 : 4;
+  return qint64(width) * qint64(height) * bytes_per_pixel;
+}
+
+bool EffectStageCache::fbo_matches(QOpenGLFramebufferObject *fbo, int width, int height, GLenum internal_format)
+{
+  return fbo->width() == width
+      && fbo->height() == height
+      && fbo->format().internalTextureFormat() == internal_format;
+}
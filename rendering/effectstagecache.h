@@ -0,0 +1,95 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef EFFECTSTAGECACHE_H
+#define EFFECTSTAGECACHE_H
+
+#include <QOpenGLFramebufferObject>
+#include <QByteArray>
+#include <QVector>
+
+class Clip;
+
+/**
+ * @brief The EffectStageCache class
+ *
+ * Keeps what a clip looked like after each of its effects ("stages") so compose_sequence() can skip every effect
+ * whose input and parameters haven't changed since the clip was last drawn, e.g. all the other layers of a paused
+ * composition while one clip's effect is being adjusted.
+ *
+ * A stage is found by its clip, the number of effects applied and a key covering the clip's input frame and the state
+ * of every effect up to that stage (see Effect::hash_stage()), so an output can never be reused once anything that
+ * went into it has changed. Stored outputs take at most Config::effect_cache_size megabytes of video memory, the
+ * least recently used ones are destroyed to make room.
+ *
+ * Belongs to one OpenGL context (the RenderThread's) and must only be used while it's current.
+ */
+class EffectStageCache {
+public:
+  EffectStageCache();
+  ~EffectStageCache();
+
+  /**
+   * @brief Get the texture of a stored stage
+   *
+   * @return
+   *
+   * The stage's texture, or 0 if the stage isn't stored with this key
+   */
+  GLuint Find(Clip* c, int stage, const QByteArray& key);
+
+  /**
+   * @brief Get a framebuffer to store a stage's output in
+   *
+   * Replaces what was stored for the same stage of this clip. The caller draws the output into the returned
+   * framebuffer, its contents are undefined until then.
+   *
+   * @return
+   *
+   * The framebuffer, or nullptr if the output doesn't fit in the cache
+   */
+  QOpenGLFramebufferObject* Store(Clip* c, int stage, const QByteArray& key, int width, int height, GLenum internal_format);
+
+  /**
+   * @brief Destroy all stored outputs
+   */
+  void Clear();
+
+private:
+  struct Entry {
+    // only compared, never dereferenced, since the clip may have been deleted since
+    Clip* clip;
+    int stage;
+    QByteArray key;
+    QOpenGLFramebufferObject* fbo;
+  };
+
+  static qint64 entry_size(QOpenGLFramebufferObject* fbo);
+  static qint64 entry_size(int width, int height, GLenum internal_format);
+
+  static bool fbo_matches(QOpenGLFramebufferObject* fbo, int width, int height, GLenum internal_format);
+
+  // least recently used first
+  QVector<Entry> entries_;
+
+  // video memory used by entries_ in bytes
+  qint64 size_;
+};
+
+#endif // EFFECTSTAGECACHE_H
@@ -18,7 +18,7 @@ bool FramebufferObject::IsCreated()
   return ctx_ != nullptr;
 }
 
-void FramebufferObject::Create(QOpenGLContext *ctx, int width, int height)
+void FramebufferObject::Create(QOpenGLContext *ctx, int width, int height, GLenum internal_format)
 {
   // free any previous textures
   Destroy();
@@ -40,7 +40,7 @@ void FramebufferObject::Create(QOpenGLContext *ctx, int width, int height)
 
   // allocate storage for texture
   ctx->functions()->glTexImage2D(
-        GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr
+        GL_TEXTURE_2D, 0, GLint(internal_format), width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr
         );
 
   // set texture filtering to bilinear
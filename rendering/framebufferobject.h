@@ -10,7 +10,8 @@ public:
   ~FramebufferObject();
 
   bool IsCreated();
-  void Create(QOpenGLContext* ctx, int width, int height);
+  // internal_format is GL_RGBA8 or GL_RGBA16F, see get_compositing_format()
+  void Create(QOpenGLContext* ctx, int width, int height, GLenum internal_format = GL_RGBA8);
   void Destroy();
 
   const GLuint& buffer();
@@ -0,0 +1,68 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "framebufferpool.h"
+
+// free framebuffers kept beyond this are destroyed, oldest first
+const int kMaximumFreeFramebuffers = 8;
+
+FramebufferPool::FramebufferPool() {}
+
+FramebufferPool::~FramebufferPool()
+{
+  Clear();
+}
+
+QOpenGLFramebufferObject *FramebufferPool::Take(int width, int height, GLenum internal_format)
+{
+  for (int i=free_.size()-1;i>=0;i--) {
+    QOpenGLFramebufferObject* fbo = free_.at(i);
+    if (fbo->width() == width
+        && fbo->height() == height
+        && fbo->format().internalTextureFormat() == internal_format) {
+      free_.removeAt(i);
+      return fbo;
+    }
+  }
+
+  QOpenGLFramebufferObjectFormat format;
+  format.setInternalTextureFormat(internal_format);
+  return new QOpenGLFramebufferObject(width, height, format);
+}
+
+void FramebufferPool::Release(QOpenGLFramebufferObject *fbo)
+{
+  if (fbo == nullptr) {
+    return;
+  }
+
+  free_.append(fbo);
+
+  if (free_.size() > kMaximumFreeFramebuffers) {
+    delete free_.takeFirst();
+  }
+}
+
+void FramebufferPool::Clear()
+{
+  for (int i=0;i<free_.size();i++) {
+    delete free_.at(i);
+  }
+  free_.clear();
+}
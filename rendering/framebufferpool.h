@@ -0,0 +1,59 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef FRAMEBUFFERPOOL_H
+#define FRAMEBUFFERPOOL_H
+
+#include <QOpenGLFramebufferObject>
+#include <QVector>
+
+/**
+ * @brief The FramebufferPool class
+ *
+ * Holds framebuffers compose_sequence() has finished with so the next clip can reuse them rather than every clip
+ * keeping its own working buffers alive for as long as it's open. Belongs to one OpenGL context (the RenderThread's)
+ * and must only be used while it's current.
+ */
+class FramebufferPool {
+public:
+  FramebufferPool();
+  ~FramebufferPool();
+
+  /**
+   * @brief Get a framebuffer of this size and internal format, reusing a free one if there is one
+   *
+   * The contents of the returned framebuffer are undefined.
+   */
+  QOpenGLFramebufferObject* Take(int width, int height, GLenum internal_format);
+
+  /**
+   * @brief Return a framebuffer from Take() to the pool
+   */
+  void Release(QOpenGLFramebufferObject* fbo);
+
+  /**
+   * @brief Destroy all free framebuffers
+   */
+  void Clear();
+
+private:
+  QVector<QOpenGLFramebufferObject*> free_;
+};
+
+#endif // FRAMEBUFFERPOOL_H
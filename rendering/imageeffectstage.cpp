@@ -0,0 +1,207 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "imageeffectstage.h"
+
+#include <QThreadPool>
+#include <QRunnable>
+
+#include "project/clip.h"
+#include "project/sequence.h"
+#include "project/effect.h"
+
+/**
+ * @brief Runs ImageEffectStage::RunPrepared() on the thread pool
+ */
+class ImageEffectJob : public QRunnable {
+public:
+  ImageEffectJob(ImageEffectStage* stage) :
+    stage_(stage)
+  {}
+
+  virtual void run() override {
+    stage_->RunPrepared();
+  }
+
+private:
+  ImageEffectStage* stage_;
+};
+
+ImageEffectStage::Result::Result() :
+  valid(false),
+  frame(nullptr),
+  pts(AV_NOPTS_VALUE),
+  timecode(0),
+  version(0),
+  result_index(0)
+{}
+
+bool ImageEffectStage::Result::matches(AVFrame *f, double t, quint64 v)
+{
+  return valid && frame == f && pts == f->pts && qFuzzyCompare(timecode, t) && version == v;
+}
+
+ImageEffectStage::ImageEffectStage(Clip *c) :
+  clip_(c),
+  preparing_(false)
+{}
+
+ImageEffectStage::~ImageEffectStage()
+{
+  Reset();
+}
+
+bool ImageEffectStage::IsActive()
+{
+  for (int i=0;i<clip_->effects.size();i++) {
+    Effect* e = clip_->effects.at(i).get();
+    if (e->enable_image && e->is_enabled()) {
+      return true;
+    }
+  }
+  return false;
+}
+
+const uint8_t *ImageEffectStage::Process(AVFrame *frame, double timecode)
+{
+  quint64 version = content_version();
+
+  // e.g. redrawing while paused
+  if (current_.matches(frame, timecode, version)) {
+    return reinterpret_cast<const uint8_t*>(current_.buffers[current_.result_index].constData());
+  }
+
+  lock_.lock();
+
+  while (preparing_) {
+    done_.wait(&lock_);
+  }
+
+  bool was_prepared = prepared_.matches(frame, timecode, version);
+
+  if (was_prepared) {
+    // swapping keeps both sets of buffers allocated for the next frames
+    qSwap(current_, prepared_);
+    prepared_.valid = false;
+  }
+
+  lock_.unlock();
+
+  if (!was_prepared) {
+    load(current_, frame, timecode, version);
+    run_effects(current_);
+    current_.valid = true;
+  }
+
+  return reinterpret_cast<const uint8_t*>(current_.buffers[current_.result_index].constData());
+}
+
+void ImageEffectStage::Prepare(AVFrame *frame, double timecode)
+{
+  quint64 version = content_version();
+
+  QMutexLocker locker(&lock_);
+
+  if (preparing_ || prepared_.matches(frame, timecode, version)) {
+    return;
+  }
+
+  load(prepared_, frame, timecode, version);
+
+  preparing_ = true;
+
+  QThreadPool::globalInstance()->start(new ImageEffectJob(this));
+}
+
+void ImageEffectStage::Reset()
+{
+  lock_.lock();
+
+  while (preparing_) {
+    done_.wait(&lock_);
+  }
+
+  prepared_.valid = false;
+  current_.valid = false;
+
+  lock_.unlock();
+}
+
+void ImageEffectStage::RunPrepared()
+{
+  // nothing else touches prepared_ while preparing_ is set
+  run_effects(prepared_);
+
+  lock_.lock();
+  prepared_.valid = true;
+  preparing_ = false;
+  done_.wakeAll();
+  lock_.unlock();
+}
+
+void ImageEffectStage::load(Result &r, AVFrame *frame, double timecode, quint64 version)
+{
+  // image effects work on 8-bit RGBA, deep frames (see Cacher::media_pixel_format()) are reduced to it. The row
+  // length in pixels stays the same so the result can be uploaded with the frame's GL_UNPACK_ROW_LENGTH.
+  bool deep = (frame->format == AV_PIX_FMT_RGBA64);
+  int frame_size = (deep ? frame->linesize[0]/2 : frame->linesize[0])*frame->height;
+
+  // resize() only reallocates if the frame size changed
+  r.buffers[0].resize(frame_size);
+  r.buffers[1].resize(frame_size);
+
+  if (deep) {
+    const uint16_t* src = reinterpret_cast<const uint16_t*>(frame->data[0]);
+    uint8_t* dst = reinterpret_cast<uint8_t*>(r.buffers[0].data());
+    for (int i=0;i<frame_size;i++) {
+      dst[i] = uint8_t(src[i] >> 8);
+    }
+  } else {
+    memcpy(r.buffers[0].data(), frame->data[0], size_t(frame_size));
+  }
+
+  r.valid = false;
+  r.frame = frame;
+  r.pts = frame->pts;
+  r.timecode = timecode;
+  r.version = version;
+  r.result_index = 0;
+}
+
+void ImageEffectStage::run_effects(Result &r)
+{
+  int frame_size = r.buffers[0].size();
+
+  for (int i=0;i<clip_->effects.size();i++) {
+    Effect* e = clip_->effects.at(i).get();
+    if (e->enable_image && e->is_enabled()) {
+      e->process_image(r.timecode,
+                       reinterpret_cast<uint8_t*>(r.buffers[r.result_index].data()),
+                       reinterpret_cast<uint8_t*>(r.buffers[!r.result_index].data()),
+                       frame_size);
+
+      r.result_index = !r.result_index;
+    }
+  }
+}
+
+quint64 ImageEffectStage::content_version()
+{
+  return (clip_->sequence != nullptr) ? clip_->sequence->content_version : 0;
+}
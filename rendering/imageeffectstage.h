@@ -0,0 +1,132 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef IMAGEEFFECTSTAGE_H
+#define IMAGEEFFECTSTAGE_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QWaitCondition>
+
+extern "C" {
+#include <libavformat/avformat.h>
+}
+
+class Clip;
+
+/**
+ * @brief The ImageEffectStage class
+ *
+ * Runs a clip's CPU image effects (those with Effect::enable_image, e.g. Frei0r) on decoded frames before they're
+ * uploaded.
+ *
+ * During playback, Clip::Retrieve() hands the frame it expects to need next to Prepare(), which processes it on
+ * QThreadPool::globalInstance() while the current frame is composited. Process() then only has to wait for that result.
+ * Image effects of different clips run in parallel this way, and mostly off the render thread. Frames that weren't
+ * prepared (seeking, scrubbing, or an edit since they were prepared) are processed on the calling thread as before.
+ *
+ * Working buffers are kept between frames rather than allocated for each one. A clip's image effects only ever run
+ * on one thread at a time.
+ */
+class ImageEffectStage {
+public:
+  ImageEffectStage(Clip* c);
+  ~ImageEffectStage();
+
+  /**
+   * @brief Returns **TRUE** if the clip has any enabled image effects
+   */
+  bool IsActive();
+
+  /**
+   * @brief Get a frame with the clip's image effects applied
+   *
+   * Must be called with the clip's frame queue locked so the frame can't be freed.
+   *
+   * @param frame
+   *
+   * Decoded RGBA frame
+   *
+   * @param timecode
+   *
+   * Clip time to render the effects at (see get_timecode())
+   *
+   * @return
+   *
+   * Pixels with the same layout as `frame`, valid until the next call to Process()
+   */
+  const uint8_t* Process(AVFrame* frame, double timecode);
+
+  /**
+   * @brief Start processing a frame on the thread pool for a later Process() call
+   *
+   * Must be called with the clip's frame queue locked. The frame's pixels are copied before this returns. Does nothing
+   * if a frame is already being prepared.
+   */
+  void Prepare(AVFrame* frame, double timecode);
+
+  /**
+   * @brief Wait for a frame being prepared and discard any results
+   *
+   * Called when the clip closes so the effects aren't running while they're closed.
+   */
+  void Reset();
+
+  /**
+   * @brief Process the prepared frame, run by the thread pool
+   */
+  void RunPrepared();
+
+private:
+  // result of running the image effects on one frame, see matches()
+  struct Result {
+    Result();
+
+    bool matches(AVFrame* frame, double timecode, quint64 version);
+
+    bool valid;
+    const AVFrame* frame;
+    int64_t pts;
+    double timecode;
+    quint64 version;
+
+    // ping-pong buffers, result_index is the one holding the output
+    QByteArray buffers[2];
+    int result_index;
+  };
+
+  // copy the frame into the result's buffers and run the effects on it
+  void load(Result& r, AVFrame* frame, double timecode, quint64 version);
+  void run_effects(Result& r);
+
+  quint64 content_version();
+
+  Clip* clip_;
+
+  // the frame returned by the last Process() and the one being prepared
+  Result current_;
+  Result prepared_;
+
+  // protects prepared_, and whether it's being processed
+  QMutex lock_;
+  QWaitCondition done_;
+  bool preparing_;
+};
+
+#endif // IMAGEEFFECTSTAGE_H
@@ -0,0 +1,190 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "ociolutcache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QFileInfo>
+#include <QFile>
+#include <QDateTime>
+#include <QDebug>
+
+#ifdef OLIVE_OCIO
+#include <OpenColorIO/OpenColorIO.h>
+namespace OCIO = OCIO_NAMESPACE;
+#endif
+
+#include "io/config.h"
+#include "io/path.h"
+
+OCIOLutCache olive::ocio_lut_cache;
+
+// identifies LUT files on disk, bump the version if the file layout or the baking changes
+const quint32 kLutFileMagic = 0x4f4c5554; // "OLUT"
+const quint32 kLutFileVersion = 1;
+
+OCIODisplaySettings OCIODisplaySettings::FromConfig()
+{
+  OCIODisplaySettings settings;
+  settings.config_path = olive::CurrentConfig.ocio_config_path;
+  settings.input_space = olive::CurrentConfig.ocio_input_space;
+  settings.display = olive::CurrentConfig.ocio_display;
+  settings.view = olive::CurrentConfig.ocio_view;
+  return settings;
+}
+
+QByteArray OCIODisplaySettings::key() const
+{
+  QCryptographicHash hash(QCryptographicHash::Md5);
+
+  // an empty path means the config pointed to by $OCIO
+  QString path = config_path.isEmpty() ? QString::fromLocal8Bit(qgetenv("OCIO")) : config_path;
+  QFileInfo config_info(path);
+
+  hash.addData(config_info.absoluteFilePath().toUtf8());
+  hash.addData(QByteArray::number(config_info.lastModified().toMSecsSinceEpoch()));
+  hash.addData(QByteArray::number(config_info.size()));
+  hash.addData(input_space.toUtf8());
+  hash.addData("\n");
+  hash.addData(display.toUtf8());
+  hash.addData("\n");
+  hash.addData(view.toUtf8());
+  hash.addData(QByteArray::number(LUT3D_EDGE_SIZE));
+
+  return hash.result().toHex();
+}
+
+bool OCIOLutCache::Get(const OCIODisplaySettings &settings, OCIOLut &lut)
+{
+  QByteArray key = settings.key();
+
+  QMutexLocker locker(&lock_);
+
+  if (luts_.contains(key)) {
+    lut = luts_.value(key);
+    return true;
+  }
+
+  if (!load(key, lut)) {
+    if (!bake(settings, lut)) {
+      return false;
+    }
+    save(key, lut);
+  }
+
+  luts_.insert(key, lut);
+
+  return true;
+}
+
+void OCIOLutCache::Clear()
+{
+  QMutexLocker locker(&lock_);
+
+  luts_.clear();
+  cache_dir().removeRecursively();
+}
+
+bool OCIOLutCache::bake(const OCIODisplaySettings &settings, OCIOLut &lut)
+{
+#ifdef OLIVE_OCIO
+  try {
+    OCIO::ConstConfigRcPtr config;
+    if (settings.config_path.isEmpty()) {
+      config = OCIO::GetCurrentConfig();
+    } else {
+      config = OCIO::Config::CreateFromFile(settings.config_path.toUtf8().constData());
+    }
+
+    QByteArray input_space = settings.input_space.isEmpty() ?
+          QByteArray(OCIO::ROLE_SCENE_LINEAR) : settings.input_space.toUtf8();
+    QByteArray display = settings.display.isEmpty() ?
+          QByteArray(config->getDefaultDisplay()) : settings.display.toUtf8();
+    QByteArray view = settings.view.isEmpty() ?
+          QByteArray(config->getDefaultView(display.constData())) : settings.view.toUtf8();
+
+    OCIO::DisplayTransformRcPtr transform = OCIO::DisplayTransform::Create();
+    transform->setInputColorSpaceName(input_space.constData());
+    transform->setDisplay(display.constData());
+    transform->setView(view.constData());
+
+    OCIO::ConstProcessorRcPtr processor = config->getProcessor(transform);
+
+    OCIO::GpuShaderDesc shader_desc;
+    shader_desc.setLanguage(OCIO::GPU_LANGUAGE_GLSL_1_0);
+    shader_desc.setFunctionName("OCIODisplay");
+    shader_desc.setLut3DEdgeLen(LUT3D_EDGE_SIZE);
+
+    lut.data.resize(NUM_3D_ENTRIES);
+    processor->getGpuLut3D(lut.data.data(), shader_desc);
+    lut.shader_text = processor->getGpuShaderText(shader_desc);
+
+    return true;
+  } catch (OCIO::Exception& e) {
+    qWarning() << "Failed to bake OpenColorIO display transform:" << e.what();
+  }
+#else
+  Q_UNUSED(settings)
+  Q_UNUSED(lut)
+#endif
+
+  return false;
+}
+
+bool OCIOLutCache::load(const QByteArray &key, OCIOLut &lut)
+{
+  QFile f(cache_dir().filePath(QString::fromLatin1(key)));
+  if (!f.open(QFile::ReadOnly)) {
+    return false;
+  }
+
+  QDataStream stream(&f);
+  stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+
+  quint32 magic, version;
+  stream >> magic >> version;
+  if (magic != kLutFileMagic || version != kLutFileVersion) {
+    return false;
+  }
+
+  stream >> lut.shader_text >> lut.data;
+
+  return (stream.status() == QDataStream::Ok && lut.data.size() == NUM_3D_ENTRIES);
+}
+
+void OCIOLutCache::save(const QByteArray &key, const OCIOLut &lut)
+{
+  cache_dir().mkpath(".");
+
+  QFile f(cache_dir().filePath(QString::fromLatin1(key)));
+  if (!f.open(QFile::WriteOnly)) {
+    qWarning() << "Failed to write OpenColorIO LUT to" << f.fileName();
+    return;
+  }
+
+  QDataStream stream(&f);
+  stream.setFloatingPointPrecision(QDataStream::SinglePrecision);
+  stream << kLutFileMagic << kLutFileVersion << lut.shader_text << lut.data;
+}
+
+QDir OCIOLutCache::cache_dir()
+{
+  return QDir(get_data_dir().filePath("previews/ocio"));
+}
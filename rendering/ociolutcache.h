@@ -0,0 +1,112 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef OCIOLUTCACHE_H
+#define OCIOLUTCACHE_H
+
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include <QMutex>
+#include <QDir>
+
+// edge length of the 3D LUT the display transform is baked into
+const int LUT3D_EDGE_SIZE = 32;
+
+// number of floats in a baked LUT (RGB for every entry)
+const int NUM_3D_ENTRIES = 3*LUT3D_EDGE_SIZE*LUT3D_EDGE_SIZE*LUT3D_EDGE_SIZE;
+
+/**
+ * @brief OpenColorIO display transform settings, see Config::ocio_config_path
+ */
+struct OCIODisplaySettings {
+  /**
+   * @brief Get the settings currently set in olive::CurrentConfig
+   */
+  static OCIODisplaySettings FromConfig();
+
+  /**
+   * @brief Get a hash uniquely identifying the LUT these settings bake to
+   *
+   * Covers the config file (including when it was last modified) and the names of the color spaces, so a changed
+   * config file is baked again rather than read from the disk cache.
+   */
+  QByteArray key() const;
+
+  // empty values mean the $OCIO config, the scene_linear role and the config's default display and view
+  QString config_path;
+  QString input_space;
+  QString display;
+  QString view;
+};
+
+/**
+ * @brief A display transform baked into a 3D LUT
+ */
+struct OCIOLut {
+  // LUT3D_EDGE_SIZE^3 RGB entries, red changing fastest, ready to upload to a GL_TEXTURE_3D
+  QVector<float> data;
+
+  // GLSL defining `vec4 OCIODisplay(vec4 color, sampler3D lut)` which applies the LUT
+  QByteArray shader_text;
+};
+
+/**
+ * @brief The OCIOLutCache class
+ *
+ * Bakes OpenColorIO display transforms into 3D LUTs so the renderer can apply them with a single texture lookup per
+ * pixel. Building an OpenColorIO processor can take a long time with large configs, so every baked LUT is kept in
+ * memory and written to disk, and only baked again when the settings or the config file change.
+ *
+ * Thread-safe.
+ */
+class OCIOLutCache {
+public:
+  /**
+   * @brief Get the LUT for a set of display settings, baking it if it isn't cached
+   *
+   * @return
+   *
+   * **TRUE** if `lut` was set. **FALSE** if the transform couldn't be baked, e.g. because the config or one of the
+   * color spaces doesn't exist, or Olive was built without OpenColorIO.
+   */
+  bool Get(const OCIODisplaySettings& settings, OCIOLut& lut);
+
+  /**
+   * @brief Remove all LUTs from memory and disk
+   */
+  void Clear();
+
+private:
+  bool bake(const OCIODisplaySettings& settings, OCIOLut& lut);
+  bool load(const QByteArray& key, OCIOLut& lut);
+  void save(const QByteArray& key, const OCIOLut& lut);
+
+  QDir cache_dir();
+
+  QHash<QByteArray, OCIOLut> luts_;
+  QMutex lock_;
+};
+
+namespace olive {
+  extern OCIOLutCache ocio_lut_cache;
+}
+
+#endif // OCIOLUTCACHE_H
@@ -0,0 +1,65 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "playbackclock.h"
+
+#include <QDateTime>
+#include <QtMath>
+
+#include "rendering/audio.h"
+
+PlaybackClock::PlaybackClock() :
+  start_frame_(0),
+  frame_rate_(1.0),
+  speed_(1),
+  start_msecs_(0),
+  audio_slaved_(false)
+{}
+
+void PlaybackClock::Start(long frame, double frame_rate, int speed) {
+  start_frame_ = frame;
+  frame_rate_ = frame_rate;
+  speed_ = speed;
+  start_msecs_ = QDateTime::currentMSecsSinceEpoch();
+
+  // audio is only played back in real time at normal speed
+  audio_slaved_ = (speed == 1 && is_audio_device_set());
+}
+
+long PlaybackClock::GetFrame() {
+  return start_frame_ + qFloor(ElapsedSeconds() * frame_rate_ * speed_);
+}
+
+int PlaybackClock::GetMsecsUntil(long frame) {
+  double due = double(frame - start_frame_) / (frame_rate_ * speed_);
+  return qMax(0, qCeil((due - ElapsedSeconds()) * 1000.0));
+}
+
+bool PlaybackClock::IsAudioSlaved() {
+  return audio_slaved_;
+}
+
+double PlaybackClock::ElapsedSeconds() {
+  if (audio_slaved_) {
+    // negative until the device has played everything queued before playback started
+    return qMax(0.0, get_audio_playback_seconds());
+  }
+
+  return double(QDateTime::currentMSecsSinceEpoch() - start_msecs_) * 0.001;
+}
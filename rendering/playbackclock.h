@@ -0,0 +1,81 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef PLAYBACKCLOCK_H
+#define PLAYBACKCLOCK_H
+
+#include <QtGlobal>
+
+/**
+ * @brief The PlaybackClock class
+ *
+ * Decides which frame should be on screen during playback.
+ *
+ * At normal speed with an audio device available, the clock is slaved to the audio device's position (see
+ * get_audio_playback_seconds()), so video holds sync with what's actually being heard even when rendering or the
+ * system is under load. It holds at the start frame until the device starts playing the new audio. At other speeds
+ * (or without audio) it falls back to the system clock.
+ */
+class PlaybackClock {
+public:
+  PlaybackClock();
+
+  /**
+   * @brief Start the clock
+   *
+   * @param frame
+   *
+   * Frame playback starts from
+   *
+   * @param frame_rate
+   *
+   * Frame rate of the sequence being played
+   *
+   * @param speed
+   *
+   * Playback speed multiplier (negative for reverse playback)
+   */
+  void Start(long frame, double frame_rate, int speed);
+
+  /**
+   * @brief Get the frame that should currently be on screen
+   */
+  long GetFrame();
+
+  /**
+   * @brief Get the number of milliseconds until a frame is due, or 0 if it's due now or overdue
+   */
+  int GetMsecsUntil(long frame);
+
+  /**
+   * @brief Returns **TRUE** if the clock is following the audio device rather than the system clock
+   */
+  bool IsAudioSlaved();
+
+private:
+  double ElapsedSeconds();
+
+  long start_frame_;
+  double frame_rate_;
+  int speed_;
+  qint64 start_msecs_;
+  bool audio_slaved_;
+};
+
+#endif // PLAYBACKCLOCK_H
@@ -0,0 +1,92 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#include "proxypolicy.h"
+
+#include <QFileInfo>
+#include <QtMath>
+
+#include "project/clip.h"
+#include "project/footage.h"
+#include "project/sequence.h"
+#include "project/media.h"
+#include "io/config.h"
+
+// fraction of a frame's duration that decoding the source may take before the automatic mode considers it too slow
+// to play in real time (the rest is left for effects, other clips and the upload to the GPU)
+const double kDecodeBudgetRatio = 0.5;
+
+ProxyPolicy default_proxy_policy;
+ProxyPolicy* current_proxy_policy = &default_proxy_policy;
+
+ProxyPolicy::~ProxyPolicy() {}
+
+bool ProxyPolicy::UseProxy(Clip *c, olive::PlaybackState state)
+{
+  // switching files interrupts the audio stream, so audio always uses the proxy if there is one
+  if (c->track() >= 0 || olive::CurrentConfig.proxy_switching == olive::PROXY_SWITCH_ALWAYS) {
+    return true;
+  }
+
+  if (state != olive::kPlaybackPlaying && state != olive::kPlaybackScrubbing) {
+    return false;
+  }
+
+  if (olive::CurrentConfig.proxy_switching == olive::PROXY_SWITCH_PLAYBACK) {
+    return true;
+  }
+
+  // automatic mode - only use the proxy if the source file is too slow to decode in real time
+  double source_decode_time = c->media()->to_footage()->get_decode_time(false);
+
+  // if the source hasn't been measured yet, play it until the cacher has timed it rather than guessing
+  if (source_decode_time < 0) {
+    return false;
+  }
+
+  // the cacher decodes every frame of the footage, so the budget depends on whichever frame rate is higher
+  double frame_rate = c->sequence->frame_rate;
+  const FootageStream* ms = c->media_stream();
+  if (ms != nullptr && !ms->infinite_length) {
+    frame_rate = qMax(frame_rate, ms->video_frame_rate * c->media()->to_footage()->speed * c->speed().value);
+  }
+
+  return source_decode_time > (1000.0 / frame_rate) * kDecodeBudgetRatio;
+}
+
+ProxyPolicy* olive::GetProxyPolicy() {
+  return current_proxy_policy;
+}
+
+void olive::SetProxyPolicy(ProxyPolicy *policy) {
+  current_proxy_policy = (policy == nullptr) ? &default_proxy_policy : policy;
+}
+
+bool olive::ProxyAvailable(Clip *c) {
+  if (c->media() == nullptr || c->media()->get_type() != MEDIA_TYPE_FOOTAGE) {
+    return false;
+  }
+
+  FootagePtr m = c->media()->to_footage();
+
+  return m->proxy
+      && !m->proxy_path.isEmpty()
+      && QFileInfo::exists(m->proxy_path);
+}
@@ -0,0 +1,101 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+
+#ifndef PROXYPOLICY_H
+#define PROXYPOLICY_H
+
+class Clip;
+
+namespace olive {
+  /**
+   * @brief The PlaybackState enum
+   *
+   * What the playback engine is currently rendering frames for. ProxyPolicy uses this to trade quality for speed
+   * only when the user won't be looking at a single frame for long.
+   */
+  enum PlaybackState {
+    /** Rendering a still frame while the viewer is paused */
+    kPlaybackPaused,
+
+    /** Rendering frames in quick succession as the user drags the playhead or steps through frames */
+    kPlaybackScrubbing,
+
+    /** Rendering frames for real-time playback */
+    kPlaybackPlaying,
+
+    /** Rendering frames for export (or saving a frame), where quality always matters more than speed */
+    kPlaybackExporting
+  };
+}
+
+/**
+ * @brief The ProxyPolicy class
+ *
+ * Decides whether a clip should be decoded from its footage's proxy or its original source file. compose_sequence()
+ * asks the current policy about every footage clip it renders and switches the clip over (see Clip::SetUseProxy())
+ * whenever the answer changes, so proxies can be used while playing without affecting paused frames or export.
+ *
+ * The default implementation responds to Config::proxy_switching and the per-footage decode times measured by each
+ * Cacher (see Footage::get_decode_time()). Subclass it and install it with olive::SetProxyPolicy() to customize.
+ */
+class ProxyPolicy {
+public:
+  virtual ~ProxyPolicy();
+
+  /**
+   * @brief Decide whether a clip should use its footage's proxy
+   *
+   * Called from the rendering thread, so implementations must be thread-safe.
+   *
+   * @param c
+   *
+   * The footage clip about to be rendered
+   *
+   * @param state
+   *
+   * What the clip is being rendered for
+   *
+   * @return
+   *
+   * **TRUE** if the proxy should be used. Ignored if the footage doesn't have a proxy available.
+   */
+  virtual bool UseProxy(Clip* c, olive::PlaybackState state);
+};
+
+namespace olive {
+  /**
+   * @brief Get the policy compose_sequence() uses to choose between proxies and source files
+   */
+  ProxyPolicy* GetProxyPolicy();
+
+  /**
+   * @brief Replace the current proxy policy
+   *
+   * Ownership is not transferred. Set to `nullptr` to restore the default policy.
+   */
+  void SetProxyPolicy(ProxyPolicy* policy);
+
+  /**
+   * @brief Returns **TRUE** if a clip's footage has a finished proxy file that can be opened
+   */
+  bool ProxyAvailable(Clip* c);
+}
+
+#endif // PROXYPOLICY_H
@@ -0,0 +1,253 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "rampreview.h"
+
+#include "project/clip.h"
+#include "rendering/rendercache.h"
+#include "io/config.h"
+
+RamPreview olive::ram_preview;
+
+RamPreview::RamPreview() :
+  in_(0),
+  divider_(1),
+  frame_count_(0)
+{
+  connect(&olive::Invalidation,
+          SIGNAL(regions_invalidated(const QVector<InvalidatedRegion>&)),
+          this,
+          SLOT(regions_invalidated(const QVector<InvalidatedRegion>&)));
+}
+
+long RamPreview::Begin(SequencePtr s, long in, long out) {
+  int divider = qMax(1, olive::CurrentConfig.ram_preview_divider);
+  QSize size = frame_size(s.get(), divider);
+
+  qint64 frame_bytes = qint64(size.width()) * qint64(size.height()) * 4;
+  qint64 limit = qint64(olive::CurrentConfig.ram_preview_size) * 1024 * 1024;
+  long count = qMax(0L, qMin(out - in, long(limit / frame_bytes)));
+
+  lock_.lock();
+
+  if (sequence_.lock() != s
+      || in_ != in
+      || divider_ != divider
+      || size_ != size) {
+    frames_.clear();
+    frame_count_ = 0;
+  }
+
+  sequence_ = s;
+  in_ = in;
+  divider_ = divider;
+  size_ = size;
+
+  // drop frames that no longer fit
+  for (int i=int(count);i<frames_.size();i++) {
+    if (!frames_.at(i).isNull()) {
+      frame_count_--;
+    }
+  }
+  frames_.resize(int(count));
+
+  lock_.unlock();
+
+  emit cached_frames_changed();
+
+  return in + count;
+}
+
+void RamPreview::SetFrame(long frame, const uchar *pixels) {
+  SequencePtr s = sequence_.lock();
+  if (s == nullptr) {
+    return;
+  }
+
+  lock_.lock();
+  QSize size = size_;
+  int index = int(frame - in_);
+  bool in_range = (index >= 0 && index < frames_.size());
+  lock_.unlock();
+
+  if (!in_range) {
+    return;
+  }
+
+  // scale outside of the lock so the viewer can keep drawing frames meanwhile
+  QImage source(pixels, s->width, s->height, QImage::Format_RGBA8888);
+  QImage image;
+  if (size != source.size()) {
+    image = source.scaled(size, Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
+  } else {
+    image = source.copy();
+  }
+
+  lock_.lock();
+  if (index < frames_.size() && size == size_) {
+    if (frames_.at(index).isNull()) {
+      frame_count_++;
+    }
+    frames_[index] = image;
+  }
+  lock_.unlock();
+
+  emit cached_frames_changed();
+}
+
+bool RamPreview::HasFrame(Sequence *s, long frame) {
+  QImage image;
+  return GetFrame(s, frame, image);
+}
+
+bool RamPreview::GetFrame(Sequence *s, long frame, QImage &image) {
+  QMutexLocker locker(&lock_);
+
+  if (frame_count_ == 0 || sequence_.lock().get() != s) {
+    return false;
+  }
+
+  long index = frame - in_;
+  if (index < 0 || index >= frames_.size() || frames_.at(int(index)).isNull()) {
+    return false;
+  }
+
+  image = frames_.at(int(index));
+  return true;
+}
+
+QVector<QPair<long, long> > RamPreview::GetCachedRanges(Sequence *s, long start, long end) {
+  QMutexLocker locker(&lock_);
+
+  QVector<QPair<long, long> > ranges;
+
+  if (frame_count_ == 0 || sequence_.lock().get() != s) {
+    return ranges;
+  }
+
+  long first = qMax(start, in_);
+  long last = qMin(end, in_ + frames_.size());
+  for (long frame=first;frame<last;frame++) {
+    if (frames_.at(int(frame - in_)).isNull()) {
+      continue;
+    }
+
+    if (!ranges.isEmpty() && ranges.last().second == frame) {
+      ranges.last().second++;
+    } else {
+      ranges.append(QPair<long, long>(frame, frame + 1));
+    }
+  }
+
+  return ranges;
+}
+
+bool RamPreview::HasFrames(Sequence *s) {
+  QMutexLocker locker(&lock_);
+
+  return frame_count_ > 0 && sequence_.lock().get() == s;
+}
+
+void RamPreview::Clear() {
+  lock_.lock();
+  frames_.clear();
+  frame_count_ = 0;
+  sequence_.reset();
+  lock_.unlock();
+
+  emit cached_frames_changed();
+}
+
+void RamPreview::regions_invalidated(const QVector<InvalidatedRegion> &regions) {
+  QMutexLocker locker(&lock_);
+
+  if (frame_count_ == 0) {
+    return;
+  }
+
+  SequencePtr s = sequence_.lock();
+  if (s == nullptr) {
+    // sequence has been deleted, free its frames
+    frames_.clear();
+    frame_count_ = 0;
+    locker.unlock();
+    emit cached_frames_changed();
+    return;
+  }
+
+  bool changed = false;
+
+  for (int i=0;i<regions.size();i++) {
+    const InvalidatedRegion& r = regions.at(i);
+
+    // audio is played live, so it doesn't affect buffered frames
+    if (r.track >= 0) {
+      continue;
+    }
+
+    QVector<QPair<long, long> > dropped;
+
+    if (r.sequence == s.get()) {
+      dropped.append(QPair<long, long>(r.in, r.out));
+    } else {
+      // the region may be in a sequence nested in this one, in which case the nesting clips have changed
+      for (int j=0;j<s->clips.size();j++) {
+        Clip* c = s->clips.at(j).get();
+        if (c != nullptr && c->track() < 0 && RenderCache::clip_nests_sequence(c, r.sequence, 0)) {
+          dropped.append(QPair<long, long>(c->timeline_in(true), c->timeline_out(true)));
+        }
+      }
+    }
+
+    for (int j=0;j<dropped.size();j++) {
+      long first = qMax(dropped.at(j).first, in_);
+      long last = qMin(dropped.at(j).second, in_ + frames_.size());
+      for (long frame=first;frame<last;frame++) {
+        QImage& image = frames_[int(frame - in_)];
+        if (!image.isNull()) {
+          image = QImage();
+          frame_count_--;
+          changed = true;
+        }
+      }
+    }
+  }
+
+  locker.unlock();
+
+  if (changed) {
+    emit cached_frames_changed();
+  }
+}
+
+QSize RamPreview::frame_size(Sequence *s, int divider) {
+  return QSize(qMax(1, s->width / divider), qMax(1, s->height / divider));
+}
+
+RamPreviewThread::RamPreviewThread(SequencePtr s, long start, long end) :
+  RangeRenderThread(s, start, end)
+{}
+
+bool RamPreviewThread::skip_frame(long frame) {
+  return olive::ram_preview.HasFrame(seq_.get(), frame);
+}
+
+void RamPreviewThread::frame_rendered(long frame, const uchar *pixels) {
+  olive::ram_preview.SetFrame(frame, pixels);
+}
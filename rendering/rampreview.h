@@ -0,0 +1,151 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef RAMPREVIEW_H
+#define RAMPREVIEW_H
+
+#include <QObject>
+#include <QVector>
+#include <QImage>
+#include <QMutex>
+
+#include "project/sequence.h"
+#include "project/invalidation.h"
+#include "rendering/rangerenderthread.h"
+
+/**
+ * @brief The RamPreview class
+ *
+ * Bounded in-memory buffer of composed frames for one range of one sequence, filled by RamPreviewThread. While the
+ * sequence viewer is playing, frames in the buffer are drawn directly instead of being rendered, so complex sections
+ * play back at exact frame timing alongside the live audio.
+ *
+ * Frames are stored at the sequence's resolution divided by Config::ram_preview_divider, and the buffer never holds
+ * more than Config::ram_preview_size megabytes. Frames are dropped for any video region reported to
+ * olive::Invalidation.
+ *
+ * Frames are written by the filling thread and read by the main thread, so every function is thread-safe.
+ */
+class RamPreview : public QObject {
+  Q_OBJECT
+public:
+  RamPreview();
+
+  /**
+   * @brief Prepare the buffer to hold a range of a sequence
+   *
+   * Frames already buffered for the same sequence, in point and resolution are kept.
+   *
+   * @return
+   *
+   * The end (exclusive) of the range that fits in memory, which may be before `out`
+   */
+  long Begin(SequencePtr s, long in, long out);
+
+  /**
+   * @brief Store a rendered frame
+   *
+   * @param pixels
+   *
+   * RGBA pixels at the sequence's full resolution, rows bottom to top as read by glReadPixels()
+   */
+  void SetFrame(long frame, const uchar* pixels);
+
+  /**
+   * @brief Returns **TRUE** if a frame of a sequence is in the buffer
+   */
+  bool HasFrame(Sequence* s, long frame);
+
+  /**
+   * @brief Get a buffered frame
+   *
+   * @param image
+   *
+   * Set to the frame (rows bottom to top) if it's buffered. QImage is implicitly shared so this doesn't copy pixels.
+   *
+   * @return
+   *
+   * **TRUE** if the frame was buffered
+   */
+  bool GetFrame(Sequence* s, long frame, QImage& image);
+
+  /**
+   * @brief Get buffered frame ranges of a sequence within [start, end) as pairs of in (inclusive) and out (exclusive)
+   */
+  QVector<QPair<long, long> > GetCachedRanges(Sequence* s, long start, long end);
+
+  /**
+   * @brief Returns **TRUE** if any frames of a sequence are buffered
+   */
+  bool HasFrames(Sequence* s);
+
+  /**
+   * @brief Free every buffered frame
+   */
+  void Clear();
+
+signals:
+  /**
+   * @brief Emitted (from any thread) when frames are added to or dropped from the buffer
+   */
+  void cached_frames_changed();
+
+private slots:
+  void regions_invalidated(const QVector<InvalidatedRegion>& regions);
+
+private:
+  // size of a buffered frame of `s` at `divider`
+  static QSize frame_size(Sequence* s, int divider);
+
+  std::weak_ptr<Sequence> sequence_;
+  long in_;
+  int divider_;
+
+  // size of the buffered frames
+  QSize size_;
+
+  // frames from in_ onwards, null images haven't been rendered yet
+  QVector<QImage> frames_;
+  int frame_count_;
+
+  QMutex lock_;
+};
+
+/**
+ * @brief The RamPreviewThread class
+ *
+ * Renders a range of a sequence into the RamPreview, skipping frames that are already buffered.
+ */
+class RamPreviewThread : public RangeRenderThread {
+public:
+  RamPreviewThread(SequencePtr s, long start, long end);
+
+protected:
+  virtual bool skip_frame(long frame) override;
+  virtual void frame_rendered(long frame, const uchar* pixels) override;
+};
+
+namespace olive {
+  /**
+   * @brief Global RAM preview buffer
+   */
+  extern RamPreview ram_preview;
+}
+
+#endif // RAMPREVIEW_H
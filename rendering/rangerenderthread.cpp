@@ -0,0 +1,75 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "rangerenderthread.h"
+
+#include "rendering/renderthread.h"
+#include "panels/panels.h"
+#include "ui/viewerwidget.h"
+
+RangeRenderThread::RangeRenderThread(SequencePtr s, long start, long end) :
+  seq_(s),
+  start_(start),
+  end_(end),
+  cancelled_(false)
+{}
+
+void RangeRenderThread::run() {
+  RenderThread* renderer = panel_sequence_viewer->viewer_widget->get_renderer();
+  disconnect(renderer, SIGNAL(ready()), panel_sequence_viewer->viewer_widget, SLOT(queue_repaint()));
+  connect(renderer, SIGNAL(ready()), this, SLOT(wake()));
+
+  QByteArray pixels(seq_->width * seq_->height * 4, 0);
+
+  mutex_.lock();
+
+  for (long frame=start_;frame<end_ && !cancelled_;frame++) {
+    seq_->playhead = frame;
+
+    if (!skip_frame(frame)) {
+      do {
+        renderer->start_render(nullptr, seq_, olive::kPlaybackExporting, nullptr, pixels.data());
+        wait_cond_.wait(&mutex_);
+      } while (renderer->did_texture_fail() && !cancelled_);
+
+      if (cancelled_) {
+        break;
+      }
+
+      frame_rendered(frame, reinterpret_cast<const uchar*>(pixels.constData()));
+    }
+
+    emit progress_changed(qRound(double(frame - start_ + 1) / double(end_ - start_) * 100.0));
+  }
+
+  mutex_.unlock();
+
+  disconnect(renderer, SIGNAL(ready()), this, SLOT(wake()));
+  connect(renderer, SIGNAL(ready()), panel_sequence_viewer->viewer_widget, SLOT(queue_repaint()));
+}
+
+void RangeRenderThread::cancel() {
+  cancelled_ = true;
+}
+
+void RangeRenderThread::wake() {
+  mutex_.lock();
+  wait_cond_.wakeAll();
+  mutex_.unlock();
+}
@@ -0,0 +1,95 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef RANGERENDERTHREAD_H
+#define RANGERENDERTHREAD_H
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include "project/sequence.h"
+
+/**
+ * @brief The RangeRenderThread class
+ *
+ * Base class for threads that render every frame of a range of a sequence into CPU memory (e.g. RamPreviewThread).
+ * Works like ExportThread: it steps the sequence's playhead through the range and uses the sequence viewer's
+ * RenderThread to render each frame, so the sequence mustn't be edited while it runs.
+ */
+class RangeRenderThread : public QThread {
+  Q_OBJECT
+public:
+  /**
+   * @brief RangeRenderThread Constructor
+   *
+   * @param s
+   *
+   * Sequence to render
+   *
+   * @param start
+   *
+   * First frame to render
+   *
+   * @param end
+   *
+   * Frame to stop rendering at (exclusive)
+   */
+  RangeRenderThread(SequencePtr s, long start, long end);
+  virtual void run() override;
+
+signals:
+  void progress_changed(int value);
+
+public slots:
+  /**
+   * @brief Stop rendering after the current frame
+   */
+  void cancel();
+
+protected:
+  /**
+   * @brief Called before rendering each frame
+   *
+   * @return
+   *
+   * **TRUE** if this frame doesn't need rendering (e.g. it's already cached) and should be skipped
+   */
+  virtual bool skip_frame(long frame) = 0;
+
+  /**
+   * @brief Called with the RGBA pixels (seq->width by seq->height, rows bottom to top) of every rendered frame
+   */
+  virtual void frame_rendered(long frame, const uchar* pixels) = 0;
+
+  SequencePtr seq_;
+  long start_;
+  long end_;
+
+private slots:
+  void wake();
+
+private:
+  bool cancelled_;
+
+  QMutex mutex_;
+  QWaitCondition wait_cond_;
+};
+
+#endif // RANGERENDERTHREAD_H
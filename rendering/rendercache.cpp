@@ -0,0 +1,592 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "rendercache.h"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <algorithm>
+
+#include "project/clip.h"
+#include "project/footage.h"
+#include "project/media.h"
+#include "rendering/renderfunctions.h"
+#include "rendering/renderthread.h"
+#include "rendering/ociolutcache.h"
+#include "rendering/audio.h"
+#include "panels/panels.h"
+#include "ui/viewerwidget.h"
+#include "io/config.h"
+#include "io/path.h"
+
+RenderCache olive::render_cache;
+
+// nested sequences deeper than this aren't followed when invalidating parent sequences
+const int kMaxNestDepth = 16;
+
+// rendered frames RenderCacheThread can hold in memory while they wait to be written
+const int kMaxQueuedWrites = 4;
+
+// how long RenderCacheThread waits (in milliseconds) before trying again while the RenderThread is busy elsewhere
+const int kRenderRetryInterval = 100;
+
+// cached frames RenderCacheThread skips before giving the event loop a turn
+const int kMaxSkippedFrames = 50;
+
+template<typename T>
+static void hash_value(QCryptographicHash& hash, const T& value) {
+  hash.addData(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+RenderCache::RenderCache() :
+  disk_usage_(-1)
+{
+  connect(&olive::Invalidation,
+          SIGNAL(regions_invalidated(const QVector<InvalidatedRegion>&)),
+          this,
+          SLOT(regions_invalidated(const QVector<InvalidatedRegion>&)));
+}
+
+QByteArray RenderCache::GetFrameKey(Sequence *s, long frame) {
+  QCryptographicHash hash(QCryptographicHash::Md5);
+
+  hash_value(hash, s->width);
+  hash_value(hash, s->height);
+  hash_value(hash, s->frame_rate);
+
+  // cached frames have the display transform applied
+  if (olive::CurrentConfig.enable_color_management) {
+    hash.addData(OCIODisplaySettings::FromConfig().key());
+  }
+
+  // clips are hashed in the same order compose_sequence() draws them
+  QVector<int> candidates = s->clip_index.ClipsInRange(frame, frame + 1, true, false);
+  std::sort(candidates.begin(), candidates.end());
+
+  for (int i=0;i<candidates.size();i++) {
+    Clip* c = s->clips.at(candidates.at(i)).get();
+    if (c != nullptr
+        && c->enabled()
+        && frame >= c->timeline_in(true)
+        && frame < c->timeline_out(true)) {
+      add_clip_to_hash(hash, c, frame);
+    }
+  }
+
+  return hash.result().toHex();
+}
+
+void RenderCache::add_clip_to_hash(QCryptographicHash &hash, Clip *c, long frame) {
+  hash_value(hash, c->track());
+
+  // where the frame is within the clip (and its transitions)
+  hash_value(hash, frame - c->timeline_in(true));
+  hash_value(hash, c->timeline_out(true) - frame);
+  hash_value(hash, c->timeline_in() - c->timeline_in(true));
+  hash_value(hash, c->clip_in(true));
+
+  hash_value(hash, c->speed().value);
+  hash_value(hash, c->reversed());
+  hash_value(hash, c->autoscaled());
+
+  Media* m = c->media();
+  if (m != nullptr) {
+    hash_value(hash, m->get_type());
+
+    if (m->get_type() == MEDIA_TYPE_FOOTAGE) {
+      FootagePtr f = m->to_footage();
+
+      hash.addData(f->url.toUtf8());
+      hash_value(hash, QFileInfo(f->url).lastModified().toMSecsSinceEpoch());
+      hash_value(hash, c->media_stream_index());
+      hash_value(hash, f->speed);
+      hash_value(hash, f->alpha_is_premultiplied);
+      hash_value(hash, f->start_number);
+
+      FootageStream* ms = c->media_stream();
+      if (ms != nullptr) {
+        hash_value(hash, ms->video_interlacing);
+        hash_value(hash, ms->video_frame_rate);
+      }
+    } else if (m->get_type() == MEDIA_TYPE_SEQUENCE) {
+      Sequence* nested = m->to_sequence().get();
+
+      // same frame mapping compose_sequence() uses for nests
+      long nested_frame = rescale_frame_number(frame + c->clip_in(true) - c->timeline_in(true),
+                                               c->sequence->frame_rate,
+                                               nested->frame_rate);
+
+      hash.addData(GetFrameKey(nested, nested_frame));
+    }
+  }
+
+  if (c->opening_transition != nullptr) {
+    hash_value(hash, c->opening_transition->get_length());
+    hash.addData(c->opening_transition->save_to_string());
+  }
+
+  if (c->closing_transition != nullptr) {
+    hash_value(hash, c->closing_transition->get_length());
+    hash.addData(c->closing_transition->save_to_string());
+  }
+
+  for (int i=0;i<c->effects.size();i++) {
+    hash.addData(c->effects.at(i)->save_to_string());
+  }
+}
+
+bool RenderCache::Load(const QByteArray &key, int width, int height, uchar *pixels) {
+  QFile f(frame_filename(key));
+  if (!f.open(QFile::ReadOnly)) {
+    return false;
+  }
+
+  QByteArray data = qUncompress(f.readAll());
+  f.close();
+
+  if (data.size() != width * height * 4) {
+    return false;
+  }
+
+  memcpy(pixels, data.constData(), size_t(data.size()));
+
+  return true;
+}
+
+bool RenderCache::Write(const QByteArray &key, int width, int height, const uchar *pixels) {
+  // favor speed over size, these are written while rendering and read back during playback
+  QByteArray data = qCompress(pixels, width * height * 4, 1);
+
+  cache_dir().mkpath(".");
+
+  QFile f(frame_filename(key));
+  if (!f.open(QFile::WriteOnly)) {
+    return false;
+  }
+  f.write(data);
+  f.close();
+
+  lock_.lock();
+  if (disk_usage_ >= 0) {
+    disk_usage_ += data.size();
+  }
+  lock_.unlock();
+
+  enforce_limit();
+
+  return true;
+}
+
+bool RenderCache::Contains(SequencePtr s, long frame, const QByteArray &key) {
+  if (!QFileInfo::exists(frame_filename(key))) {
+    return false;
+  }
+
+  mark_rendered(s, frame, key);
+
+  emit rendered_ranges_changed();
+
+  return true;
+}
+
+bool RenderCache::HasRenderedFrames(Sequence *s) {
+  QMutexLocker locker(&lock_);
+
+  QHash<Sequence*, RenderedFrames>::const_iterator it = rendered_.constFind(s);
+  return it != rendered_.constEnd() && !it.value().frames.isEmpty();
+}
+
+bool RenderCache::IsRendered(Sequence *s, long frame) {
+  QMutexLocker locker(&lock_);
+
+  QHash<Sequence*, RenderedFrames>::const_iterator it = rendered_.constFind(s);
+  return it != rendered_.constEnd() && it.value().frames.contains(frame);
+}
+
+QVector<QPair<long, long> > RenderCache::GetRenderedRanges(Sequence *s, long start, long end) {
+  QMutexLocker locker(&lock_);
+
+  QVector<QPair<long, long> > ranges;
+
+  QHash<Sequence*, RenderedFrames>::const_iterator it = rendered_.constFind(s);
+  if (it == rendered_.constEnd()) {
+    return ranges;
+  }
+
+  const QMap<long, QByteArray>& frames = it.value().frames;
+  QMap<long, QByteArray>::const_iterator f = frames.lowerBound(start);
+  while (f != frames.constEnd() && f.key() < end) {
+    if (!ranges.isEmpty() && ranges.last().second == f.key()) {
+      ranges.last().second++;
+    } else {
+      ranges.append(QPair<long, long>(f.key(), f.key() + 1));
+    }
+    f++;
+  }
+
+  return ranges;
+}
+
+void RenderCache::Clear() {
+  lock_.lock();
+  rendered_.clear();
+  cache_dir().removeRecursively();
+  disk_usage_ = 0;
+  lock_.unlock();
+
+  emit rendered_ranges_changed();
+}
+
+void RenderCache::regions_invalidated(const QVector<InvalidatedRegion> &regions) {
+  QMutexLocker locker(&lock_);
+
+  if (rendered_.isEmpty()) {
+    return;
+  }
+
+  bool changed = false;
+
+  for (int i=0;i<regions.size();i++) {
+    const InvalidatedRegion& r = regions.at(i);
+
+    // audio doesn't affect rendered frames
+    if (r.track >= 0) {
+      continue;
+    }
+
+    QHash<Sequence*, RenderedFrames>::iterator it = rendered_.begin();
+    while (it != rendered_.end()) {
+      SequencePtr s = it.value().sequence.lock();
+
+      if (s == nullptr) {
+        // sequence has been deleted
+        it = rendered_.erase(it);
+        changed = true;
+        continue;
+      }
+
+      QMap<long, QByteArray>& frames = it.value().frames;
+
+      if (s.get() == r.sequence) {
+        QMap<long, QByteArray>::iterator f = frames.lowerBound(r.in);
+        while (f != frames.end() && f.key() < r.out) {
+          f = frames.erase(f);
+          changed = true;
+        }
+      } else {
+        // the region may be in a sequence nested in this one, in which case the nesting clips have changed
+        for (int j=0;j<s->clips.size();j++) {
+          Clip* c = s->clips.at(j).get();
+          if (c != nullptr && c->track() < 0 && clip_nests_sequence(c, r.sequence, 0)) {
+            QMap<long, QByteArray>::iterator f = frames.lowerBound(c->timeline_in(true));
+            while (f != frames.end() && f.key() < c->timeline_out(true)) {
+              f = frames.erase(f);
+              changed = true;
+            }
+          }
+        }
+      }
+
+      it++;
+    }
+  }
+
+  locker.unlock();
+
+  if (changed) {
+    emit rendered_ranges_changed();
+  }
+}
+
+QDir RenderCache::cache_dir() {
+  return QDir(get_data_dir().filePath("previews/render"));
+}
+
+QString RenderCache::frame_filename(const QByteArray &key) {
+  return cache_dir().filePath(QString::fromLatin1(key));
+}
+
+void RenderCache::mark_rendered(SequencePtr s, long frame, const QByteArray &key) {
+  QMutexLocker locker(&lock_);
+
+  RenderedFrames& rendered = rendered_[s.get()];
+
+  // a new sequence may have been allocated where a deleted one used to be
+  if (rendered.sequence.lock() != s) {
+    rendered.sequence = s;
+    rendered.frames.clear();
+  }
+
+  rendered.frames.insert(frame, key);
+}
+
+void RenderCache::enforce_limit() {
+  qint64 limit = qint64(olive::CurrentConfig.render_cache_size) * 1024 * 1024;
+
+  QMutexLocker locker(&lock_);
+
+  QDir dir = cache_dir();
+
+  if (disk_usage_ < 0) {
+    // first time we've needed to know, scan what's already there from previous sessions
+    disk_usage_ = 0;
+    QFileInfoList files = dir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot);
+    for (int i=0;i<files.size();i++) {
+      disk_usage_ += files.at(i).size();
+    }
+  }
+
+  if (disk_usage_ <= limit) {
+    return;
+  }
+
+  // delete the oldest frames until we're comfortably under the limit so this doesn't run on every frame
+  QSet<QByteArray> removed;
+  QFileInfoList files = dir.entryInfoList(QDir::Files | QDir::NoDotAndDotDot, QDir::Time | QDir::Reversed);
+  for (int i=0;i<files.size() && disk_usage_ > limit - limit/10;i++) {
+    if (QFile::remove(files.at(i).absoluteFilePath())) {
+      disk_usage_ -= files.at(i).size();
+      removed.insert(files.at(i).fileName().toLatin1());
+    }
+  }
+
+  QHash<Sequence*, RenderedFrames>::iterator it;
+  for (it=rendered_.begin();it!=rendered_.end();it++) {
+    QMap<long, QByteArray>::iterator f = it.value().frames.begin();
+    while (f != it.value().frames.end()) {
+      if (removed.contains(f.value())) {
+        f = it.value().frames.erase(f);
+      } else {
+        f++;
+      }
+    }
+  }
+}
+
+bool RenderCache::clip_nests_sequence(Clip *c, Sequence *child, int depth) {
+  if (depth > kMaxNestDepth
+      || c == nullptr
+      || c->media() == nullptr
+      || c->media()->get_type() != MEDIA_TYPE_SEQUENCE) {
+    return false;
+  }
+
+  SequencePtr nested = c->media()->to_sequence();
+
+  if (nested.get() == child) {
+    return true;
+  }
+
+  for (int i=0;i<nested->clips.size();i++) {
+    if (clip_nests_sequence(nested->clips.at(i).get(), child, depth + 1)) {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+RenderCacheThread::RenderCacheThread(SequencePtr s, long start, long end) :
+  seq_(s),
+  start_(start),
+  end_(end),
+  frame_(start),
+  width_(0),
+  height_(0),
+  rendering_(false),
+  progress_(-1),
+  done_(false)
+{
+  retry_timer_.setSingleShot(true);
+  connect(&retry_timer_, SIGNAL(timeout()), this, SLOT(render_next()));
+
+  connect(panel_sequence_viewer->viewer_widget->get_renderer(),
+          SIGNAL(background_ready(long,QByteArray)),
+          this,
+          SLOT(frame_rendered(long,QByteArray)));
+
+  // this object lives on the main thread, so these are queued to it
+  connect(this, SIGNAL(started()), this, SLOT(render_next()));
+  connect(this, SIGNAL(finished()), this, SLOT(thread_finished()));
+}
+
+void RenderCacheThread::run() {
+  mutex_.lock();
+
+  while (true) {
+    while (write_queue_.isEmpty() && !done_) {
+      wait_cond_.wait(&mutex_);
+    }
+
+    if (write_queue_.isEmpty()) {
+      break;
+    }
+
+    RenderedFrame f = write_queue_.takeFirst();
+
+    mutex_.unlock();
+
+    if (olive::render_cache.Write(f.key, f.width, f.height, reinterpret_cast<const uchar*>(f.pixels.constData()))) {
+      QMetaObject::invokeMethod(this,
+                                "frame_written",
+                                Qt::QueuedConnection,
+                                Q_ARG(long, f.frame),
+                                Q_ARG(QByteArray, f.key));
+    }
+
+    mutex_.lock();
+  }
+
+  mutex_.unlock();
+}
+
+void RenderCacheThread::cancel() {
+  stop_rendering();
+}
+
+void RenderCacheThread::render_next() {
+  if (rendering_ || done_) {
+    return;
+  }
+
+  SequencePtr s = seq_.lock();
+  if (s == nullptr) {
+    stop_rendering();
+    return;
+  }
+
+  // the RenderThread is needed for playback and exporting, and it can only render frames of the size it's showing
+  if (audio_rendering
+      || panel_sequence_viewer->playing
+      || panel_sequence_viewer->seq != s) {
+    retry_timer_.start(kRenderRetryInterval);
+    return;
+  }
+
+  // rendered frames are held in memory until they're written, so don't get too far ahead of the disk
+  mutex_.lock();
+  int queued_writes = write_queue_.size();
+  mutex_.unlock();
+
+  if (queued_writes >= kMaxQueuedWrites) {
+    retry_timer_.start(kRenderRetryInterval);
+    return;
+  }
+
+  // skip frames that are already cached, a few at a time so a long cached range doesn't stall the main thread
+  for (int i=0;frame_<end_;i++) {
+    if (i == kMaxSkippedFrames) {
+      retry_timer_.start(0);
+      return;
+    }
+
+    key_ = olive::render_cache.GetFrameKey(s.get(), frame_);
+    if (!olive::render_cache.Contains(s, frame_, key_)) {
+      break;
+    }
+
+    frame_++;
+  }
+
+  int progress = qRound(double(frame_ - start_) / double(end_ - start_) * 100.0);
+  if (progress != progress_) {
+    progress_ = progress;
+    emit progress_changed(progress);
+  }
+
+  if (frame_ >= end_) {
+    stop_rendering();
+    return;
+  }
+
+  width_ = s->width;
+  height_ = s->height;
+  rendering_ = true;
+
+  panel_sequence_viewer->viewer_widget->get_renderer()->start_render_background(s, frame_);
+}
+
+void RenderCacheThread::frame_rendered(long frame, QByteArray pixels) {
+  if (!rendering_ || frame != frame_) {
+    return;
+  }
+
+  rendering_ = false;
+
+  SequencePtr s = seq_.lock();
+  if (s == nullptr) {
+    stop_rendering();
+    return;
+  }
+
+  if (pixels.isEmpty()) {
+    // media wasn't ready or playback started, try this frame again in a bit
+    retry_timer_.start(kRenderRetryInterval);
+    return;
+  }
+
+  // only keep the frame if nothing that goes into it changed while it was rendering, otherwise it's rendered again
+  if (pixels.size() == width_ * height_ * 4
+      && olive::render_cache.GetFrameKey(s.get(), frame_) == key_) {
+    RenderedFrame f;
+    f.frame = frame_;
+    f.key = key_;
+    f.width = width_;
+    f.height = height_;
+    f.pixels = pixels;
+
+    mutex_.lock();
+    write_queue_.append(f);
+    wait_cond_.wakeAll();
+    mutex_.unlock();
+
+    frame_++;
+  }
+
+  render_next();
+}
+
+void RenderCacheThread::frame_written(long frame, QByteArray key) {
+  SequencePtr s = seq_.lock();
+
+  // the frame is only marked as rendered if it hasn't been edited since
+  if (s != nullptr && olive::render_cache.GetFrameKey(s.get(), frame) == key) {
+    olive::render_cache.Contains(s, frame, key);
+  }
+}
+
+void RenderCacheThread::thread_finished() {
+  emit render_finished();
+}
+
+void RenderCacheThread::stop_rendering() {
+  retry_timer_.stop();
+
+  if (rendering_) {
+    // a frame that has already started rendering is ignored in frame_rendered()
+    panel_sequence_viewer->viewer_widget->get_renderer()->cancel_background();
+    rendering_ = false;
+  }
+
+  mutex_.lock();
+  done_ = true;
+  wait_cond_.wakeAll();
+  mutex_.unlock();
+}
@@ -0,0 +1,256 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef RENDERCACHE_H
+#define RENDERCACHE_H
+
+#include <QObject>
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QTimer>
+#include <QHash>
+#include <QMap>
+#include <QSet>
+#include <QDir>
+#include <QCryptographicHash>
+
+#include "project/sequence.h"
+#include "project/invalidation.h"
+
+/**
+ * @brief The RenderCache class
+ *
+ * Disk-backed cache of fully composited sequence frames, filled by "Render Work Area" (see RenderCacheThread) and
+ * used by RenderThread to play back sections that are too heavy to compose in real time.
+ *
+ * Frames are stored as zlib-compressed RGBA pixels in a file named after a hash of everything that goes into the frame
+ * (see GetFrameKey()), so a cached frame can never be shown for a frame whose inputs have changed, and frames become
+ * valid again if an edit is undone. On top of that, the cache remembers which frames of each sequence have been
+ * rendered so the timeline header can show rendered ranges. These are dropped precisely for the time ranges reported
+ * to olive::Invalidation.
+ *
+ * Frame keys are computed from the same clip state compose_sequence() reads, so they can be computed on the rendering
+ * thread. Everything else is thread-safe.
+ */
+class RenderCache : public QObject {
+  Q_OBJECT
+public:
+  RenderCache();
+
+  /**
+   * @brief Get a hash of every input to a frame of a sequence
+   *
+   * Covers the sequence's dimensions and, for every video clip active at the frame, its source media, its position
+   * relative to the frame, its properties, its transitions and the serialized state of its effects. Nested sequences
+   * are hashed recursively at the corresponding frame.
+   */
+  QByteArray GetFrameKey(Sequence* s, long frame);
+
+  /**
+   * @brief Load a cached frame into a pixel buffer
+   *
+   * @param key
+   *
+   * Key of the frame from GetFrameKey()
+   *
+   * @param pixels
+   *
+   * Buffer of width*height*4 bytes to load RGBA pixels into (rows bottom to top, as read by glReadPixels())
+   *
+   * @return
+   *
+   * **TRUE** if the frame was in the cache and was loaded
+   */
+  bool Load(const QByteArray& key, int width, int height, uchar* pixels);
+
+  /**
+   * @brief Write a rendered frame to disk
+   *
+   * Doesn't mark the frame as rendered in any sequence, call Contains() for that once it's known the frame still has
+   * this key. Can be called from any thread.
+   *
+   * @return
+   *
+   * **TRUE** if the frame was written
+   */
+  bool Write(const QByteArray& key, int width, int height, const uchar* pixels);
+
+  /**
+   * @brief Returns **TRUE** if a frame with this key is on disk
+   *
+   * Also marks the frame as rendered if it is, since frames can become valid again after an undo.
+   */
+  bool Contains(SequencePtr s, long frame, const QByteArray& key);
+
+  /**
+   * @brief Returns **TRUE** if any frames of a sequence are marked as rendered
+   */
+  bool HasRenderedFrames(Sequence* s);
+
+  /**
+   * @brief Returns **TRUE** if a frame of a sequence is marked as rendered
+   *
+   * Only checks the in-memory marks, so it's cheap enough to call for every frame before computing its key.
+   */
+  bool IsRendered(Sequence* s, long frame);
+
+  /**
+   * @brief Get rendered frame ranges of a sequence within [start, end) as pairs of in (inclusive) and out (exclusive)
+   */
+  QVector<QPair<long, long> > GetRenderedRanges(Sequence* s, long start, long end);
+
+  /**
+   * @brief Delete every cached frame
+   */
+  void Clear();
+
+  /**
+   * @brief Returns **TRUE** if a clip nests `child`, directly or through other nested sequences
+   *
+   * Used to find which frames of a sequence change when a sequence nested in it is edited.
+   */
+  static bool clip_nests_sequence(Clip* c, Sequence* child, int depth);
+
+signals:
+  /**
+   * @brief Emitted (from any thread) when frames are marked as rendered or unrendered
+   */
+  void rendered_ranges_changed();
+
+private slots:
+  void regions_invalidated(const QVector<InvalidatedRegion>& regions);
+
+private:
+  QDir cache_dir();
+  QString frame_filename(const QByteArray& key);
+  void add_clip_to_hash(QCryptographicHash& hash, Clip* c, long frame);
+  void mark_rendered(SequencePtr s, long frame, const QByteArray& key);
+
+  // deletes the oldest frames once the cache is bigger than Config::render_cache_size
+  void enforce_limit();
+
+  struct RenderedFrames {
+    // weak so the cache never keeps a deleted sequence alive or touches it
+    std::weak_ptr<Sequence> sequence;
+
+    // rendered frames mapped to their keys
+    QMap<long, QByteArray> frames;
+  };
+
+  QHash<Sequence*, RenderedFrames> rendered_;
+
+  // bytes used on disk, -1 until the cache directory has been scanned
+  qint64 disk_usage_;
+
+  QMutex lock_;
+};
+
+/**
+ * @brief The RenderCacheThread class
+ *
+ * Renders a range of a sequence into the RenderCache in the background, skipping frames that are already cached.
+ *
+ * Frames are rendered one at a time by the sequence viewer's RenderThread whenever the viewer doesn't need it (see
+ * RenderThread::start_render_background()), then compressed and written to disk on this thread. The sequence can be
+ * played and edited in the meantime. A frame's key is computed before it's rendered and again once it's done, and it's
+ * only stored if both match, so frames that were edited while rendering are rendered again rather than cached under a
+ * stale key.
+ *
+ * Everything but the disk writes runs on the main thread, which is also where it must be created and cancelled from.
+ * The thread finishes once the range has been rendered (or rendering was cancelled) and every rendered frame has been
+ * written.
+ */
+class RenderCacheThread : public QThread {
+  Q_OBJECT
+public:
+  RenderCacheThread(SequencePtr s, long start, long end);
+  virtual void run() override;
+
+signals:
+  /**
+   * @brief Emitted on the main thread as frames are rendered, with the percentage of the range that's done
+   */
+  void progress_changed(int value);
+
+  /**
+   * @brief Emitted on the main thread once the thread has finished
+   *
+   * Unlike QThread::finished(), this is never emitted after the object has been deleted.
+   */
+  void render_finished();
+
+public slots:
+  /**
+   * @brief Stop rendering, frames that have already been rendered are still written
+   */
+  void cancel();
+
+private slots:
+  void render_next();
+  void frame_rendered(long frame, QByteArray pixels);
+  void frame_written(long frame, QByteArray key);
+  void thread_finished();
+
+private:
+  void stop_rendering();
+
+  struct RenderedFrame {
+    long frame;
+    QByteArray key;
+    int width;
+    int height;
+    QByteArray pixels;
+  };
+
+  // weak so deleting the sequence ends the render rather than keeping it alive
+  std::weak_ptr<Sequence> seq_;
+  long start_;
+  long end_;
+
+  // next frame to render and its key, computed right before it's requested
+  long frame_;
+  QByteArray key_;
+  int width_;
+  int height_;
+
+  // set while a frame is with the RenderThread
+  bool rendering_;
+
+  int progress_;
+
+  // polls for the RenderThread to become available, see render_next()
+  QTimer retry_timer_;
+
+  // frames waiting to be written, and whether more will be added, protected by mutex_
+  QList<RenderedFrame> write_queue_;
+  bool done_;
+
+  QMutex mutex_;
+  QWaitCondition wait_cond_;
+};
+
+namespace olive {
+  /**
+   * @brief Global render cache
+   */
+  extern RenderCache render_cache;
+}
+
+#endif // RENDERCACHE_H
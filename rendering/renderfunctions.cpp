@@ -28,11 +28,11 @@ extern "C" {
 #include <QApplication>
 #include <QDesktopWidget>
 #include <QDebug>
-
-#ifdef OLIVE_OCIO
-#include <OpenColorIO/OpenColorIO.h>
-namespace OCIO = OCIO_NAMESPACE;
-#endif
+#include <QtMath>
+#include <QCryptographicHash>
+#include <QSet>
+#include <QOpenGLExtraFunctions>
+#include <algorithm>
 
 #include "project/clip.h"
 #include "project/sequence.h"
@@ -44,6 +44,7 @@ namespace OCIO = OCIO_NAMESPACE;
 #include "ui/collapsiblewidget.h"
 
 #include "rendering/audio.h"
+#include "rendering/shaderprogramcache.h"
 
 #include "io/math.h"
 #include "io/config.h"
@@ -53,25 +54,87 @@ namespace OCIO = OCIO_NAMESPACE;
 
 const int kMaximumRetryCount = 10;
 
+// vertices in a quad buffer are stored as x, y, s, t
+const int kQuadVertexSize = 4;
+
+// offsets (in vertices) of the full-frame quad and the current clip's quad in a quad buffer
+const int kFullQuadOffset = 0;
+const int kClipQuadOffset = 4;
+
+GLuint create_quad_buffer(QOpenGLContext *ctx) {
+  const GLfloat full_quad[] = {
+    0, 0, 0, 0, // top left
+    1, 0, 1, 0, // top right
+    1, 1, 1, 1, // bottom right
+    0, 1, 0, 1 // bottom left
+  };
+
+  GLuint buffer;
+  ctx->functions()->glGenBuffers(1, &buffer);
+  ctx->functions()->glBindBuffer(GL_ARRAY_BUFFER, buffer);
+  ctx->functions()->glBufferData(GL_ARRAY_BUFFER,
+                                 (kClipQuadOffset + 4) * kQuadVertexSize * sizeof(GLfloat),
+                                 nullptr,
+                                 GL_DYNAMIC_DRAW);
+  ctx->functions()->glBufferSubData(GL_ARRAY_BUFFER,
+                                    kFullQuadOffset * kQuadVertexSize * sizeof(GLfloat),
+                                    sizeof(full_quad),
+                                    full_quad);
+  ctx->functions()->glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  return buffer;
+}
+
+void bind_quad_buffer(QOpenGLContext *ctx, GLuint buffer) {
+  ctx->functions()->glBindBuffer(GL_ARRAY_BUFFER, buffer);
+
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+
+  // array pointers are offsets into the bound buffer
+  glVertexPointer(2, GL_FLOAT, kQuadVertexSize * sizeof(GLfloat), nullptr);
+  glTexCoordPointer(2, GL_FLOAT, kQuadVertexSize * sizeof(GLfloat), reinterpret_cast<const GLvoid*>(2 * sizeof(GLfloat)));
+}
+
+void release_quad_buffer(QOpenGLContext *ctx) {
+  glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
+
+  ctx->functions()->glBindBuffer(GL_ARRAY_BUFFER, 0);
+}
+
 void full_blit() {
   glPushMatrix();
   glLoadIdentity();
   glOrtho(0, 1, 0, 1, -1, 1);
 
-  glBegin(GL_QUADS);
-  glTexCoord2f(0, 0); // top left
-  glVertex2f(0, 0); // top left
-  glTexCoord2f(1, 0); // top right
-  glVertex2f(1, 0); // top right
-  glTexCoord2f(1, 1); // bottom right
-  glVertex2f(1, 1); // bottom right
-  glTexCoord2f(0, 1); // bottom left
-  glVertex2f(0, 1); // bottom left
-  glEnd();
+  glDrawArrays(GL_TRIANGLE_FAN, kFullQuadOffset, 4);
 
   glPopMatrix();
 }
 
+// draw the clip's quad with the corners in `coords` using the current matrix
+void draw_clip_quad(QOpenGLContext* ctx, GLuint quad_buffer, const GLTextureCoords& coords) {
+  const GLfloat quad[] = {
+    GLfloat(coords.vertexTopLeftX), GLfloat(coords.vertexTopLeftY),
+    coords.textureTopLeftX, coords.textureTopLeftY, // top left
+    GLfloat(coords.vertexTopRightX), GLfloat(coords.vertexTopRightY),
+    coords.textureTopRightX, coords.textureTopRightY, // top right
+    GLfloat(coords.vertexBottomRightX), GLfloat(coords.vertexBottomRightY),
+    coords.textureBottomRightX, coords.textureBottomRightY, // bottom right
+    GLfloat(coords.vertexBottomLeftX), GLfloat(coords.vertexBottomLeftY),
+    coords.textureBottomLeftX, coords.textureBottomLeftY // bottom left
+  };
+
+  ctx->functions()->glBindBuffer(GL_ARRAY_BUFFER, quad_buffer);
+  ctx->functions()->glBufferSubData(GL_ARRAY_BUFFER,
+                                    kClipQuadOffset * kQuadVertexSize * sizeof(GLfloat),
+                                    sizeof(quad),
+                                    quad);
+
+  glDrawArrays(GL_TRIANGLE_FAN, kClipQuadOffset, 4);
+}
+
 void draw_clip(QOpenGLContext* ctx, GLuint fbo, GLuint texture, bool clear) {
   ctx->functions()->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, fbo);
 
@@ -106,6 +169,15 @@ GLuint draw_clip(QOpenGLFramebufferObject* fbo, GLuint texture, bool clear) {
   return fbo->texture();
 }
 
+// draw a texture covering `rect` of the frame (in pixels from the top left) over what's already in fbo
+GLuint draw_clip_rect(QOpenGLFramebufferObject* fbo, GLuint texture, const QRect& rect) {
+  // frame rows go up the framebuffer in the same order they go down an image, so the rect maps straight across
+  glViewport(rect.x(), rect.y(), rect.width(), rect.height());
+  GLuint result = draw_clip(fbo, texture, false);
+  glViewport(0, 0, fbo->width(), fbo->height());
+  return result;
+}
+
 void process_effect(Clip* c,
                     Effect* e,
                     double timecode,
@@ -131,22 +203,31 @@ void process_effect(Clip* c,
       if (e->enable_superimpose) {
         GLuint superimpose_texture = e->process_superimpose(timecode);
 
+        // superimpose textures may only cover the part of the frame the effect drew something in
+        const QRect& superimpose_rect = e->get_superimpose_rect();
+        bool full_frame = (superimpose_rect == QRect(0, 0, c->media_width(), c->media_height()));
+
         if (superimpose_texture == 0) {
           qWarning() << "Superimpose texture was nullptr, retrying...";
           texture_failed = true;
-        } else if (composite_texture == 0) {
+        } else if (composite_texture == 0 && full_frame) {
           // if there is no previous texture, just return the superimposes texture
           // UNLESS this is a shader-extended superimpose effect in which case,
           // we'll need to draw it below
           composite_texture = superimpose_texture;
         } else {
-          // if the source texture is not already a framebuffer texture,
-          // we'll need to make it one before drawing a superimpose effect on it
-          if (composite_texture != c->fbo[0]->texture() && composite_texture != c->fbo[1]->texture()) {
+          if (composite_texture == 0) {
+            // nothing underneath, start from a transparent frame
+            c->fbo[!fbo_switcher]->bind();
+            glClear(GL_COLOR_BUFFER_BIT);
+            c->fbo[!fbo_switcher]->release();
+          } else if (composite_texture != c->fbo[0]->texture() && composite_texture != c->fbo[1]->texture()) {
+            // if the source texture is not already a framebuffer texture,
+            // we'll need to make it one before drawing a superimpose effect on it
             draw_clip(c->fbo[!fbo_switcher], composite_texture, true);
           }
 
-          composite_texture = draw_clip(c->fbo[!fbo_switcher], superimpose_texture, false);
+          composite_texture = draw_clip_rect(c->fbo[!fbo_switcher], superimpose_texture, superimpose_rect);
         }
       }
       e->endEffect();
@@ -154,13 +235,175 @@ void process_effect(Clip* c,
   }
 }
 
+// draws a run of consecutive per-pixel effects starting at `start` in one pass with a fused shader (see
+// shaderfusion.h), returns how many effects were drawn or 0 if they should be processed one by one instead
+int process_fused_effects(Clip* c,
+                          int start,
+                          double timecode,
+                          GLuint& composite_texture,
+                          bool& fbo_switcher) {
+  if (!olive::CurrentRuntimeConfig.shaders_are_enabled || composite_texture == 0) {
+    return 0;
+  }
+
+  // gather effects that can be fused, disabled ones in between don't break the run
+  QVector<Effect*> stages;
+  QStringList frag_paths;
+  QString vert_path;
+  int end = start;
+  for (;end<c->effects.size();end++) {
+    Effect* e = c->effects.at(end).get();
+    if (!e->is_enabled()) {
+      continue;
+    }
+    if (!e->can_fuse() || (!stages.isEmpty() && e->get_vert_path() != vert_path)) {
+      break;
+    }
+    vert_path = e->get_vert_path();
+    frag_paths.append(e->get_frag_path());
+    stages.append(e);
+  }
+
+  // a single effect is drawn just as well by its own program
+  if (stages.size() < 2) {
+    return 0;
+  }
+
+  QOpenGLShaderProgram* program = olive::shader_program_cache.GetFused(vert_path, frag_paths);
+  if (!program->isLinked() || !program->bind()) {
+    return 0;
+  }
+
+  for (int i=0;i<stages.size();i++) {
+    stages.at(i)->process_fused_shader(program, i, timecode);
+  }
+  composite_texture = draw_clip(c->fbo[fbo_switcher], composite_texture, true);
+  fbo_switcher = !fbo_switcher;
+
+  program->release();
+
+  return end - start;
+}
+
+template<typename T>
+static void hash_value(QCryptographicHash& hash, const T& value) {
+  hash.addData(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+// returns a hash of the frame a clip's effects start from (see EffectStageCache), or an empty array if the frame
+// can't be identified or wasn't complete
+static QByteArray get_effect_input_key(Clip* c, double timecode) {
+  QCryptographicHash hash(QCryptographicHash::Md5);
+
+  hash_value(hash, c->media_width());
+  hash_value(hash, c->media_height());
+
+  Media* m = c->media();
+  if (m != nullptr) {
+    hash_value(hash, m->get_type());
+
+    if (m->get_type() == MEDIA_TYPE_FOOTAGE) {
+      if (c->texture == nullptr || c->texture_frame == -1) {
+        return QByteArray();
+      }
+
+      FootagePtr f = m->to_footage();
+      hash.addData(f->url.toUtf8());
+      hash_value(hash, c->media_stream_index());
+      hash_value(hash, c->UsingProxy());
+      hash_value(hash, f->alpha_is_premultiplied);
+      hash_value(hash, c->texture_frame);
+    } else if (m->get_type() == MEDIA_TYPE_SEQUENCE) {
+      // the nest cache is only valid if the nest's output is complete and current
+      if (!c->nest_cache_valid) {
+        return QByteArray();
+      }
+
+      hash_value(hash, c->nest_cache_frame);
+      hash_value(hash, c->nest_cache_version);
+      hash_value(hash, c->nest_cache_state);
+    }
+  }
+
+  // image effects are applied to footage frames before they're uploaded
+  for (int i=0;i<c->effects.size();i++) {
+    Effect* e = c->effects.at(i).get();
+    if (e->enable_image && !e->hash_stage(hash, timecode)) {
+      return QByteArray();
+    }
+  }
+
+  return hash.result();
+}
+
+// returns the newest content version in a sequence and any sequences nested in it, which changes whenever anything
+// that would show up in its output does (see Sequence::content_version)
+static quint64 get_nest_content_version(Sequence* s, int depth) {
+  quint64 version = s->content_version;
+
+  // guard against sequences that (indirectly) nest themselves
+  if (depth < 16) {
+    for (int i=0;i<s->clips.size();i++) {
+      Clip* c = s->clips.at(i).get();
+      if (c != nullptr
+          && c->media() != nullptr
+          && c->media()->get_type() == MEDIA_TYPE_SEQUENCE) {
+        version = qMax(version, get_nest_content_version(c->media()->to_sequence().get(), depth + 1));
+      }
+    }
+  }
+
+  return version;
+}
+
+// run the finished frame through the OpenColorIO display LUT in a single pass. A framebuffer can't be read from and
+// drawn to at the same time, so it's drawn into a backend buffer and copied back.
+void apply_display_transform(ComposeSequenceParams& params) {
+  int width = params.seq->width;
+  int height = params.seq->height;
+
+  glViewport(0, 0, width, height);
+  glDisable(GL_BLEND);
+
+  params.ctx->functions()->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, params.backend_buffer1);
+  glClear(GL_COLOR_BUFFER_BIT);
+
+  params.ctx->functions()->glActiveTexture(GL_TEXTURE0 + 1); // Texture unit 1
+  glBindTexture(GL_TEXTURE_3D, params.ocio_lut_texture);
+  params.ctx->functions()->glActiveTexture(GL_TEXTURE0 + 0); // Texture unit 0
+  glBindTexture(GL_TEXTURE_2D, params.main_attachment);
+
+  params.ocio_shader->bind();
+  params.ocio_shader->setUniformValue("tex1", 0);
+  params.ocio_shader->setUniformValue("tex2", 1);
+
+  full_blit();
+
+  params.ocio_shader->release();
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+  params.ctx->functions()->glActiveTexture(GL_TEXTURE0 + 1); // Texture unit 1
+  glBindTexture(GL_TEXTURE_3D, 0);
+  params.ctx->functions()->glActiveTexture(GL_TEXTURE0 + 0); // Texture unit 0
+
+  params.ctx->functions()->glBindFramebuffer(GL_READ_FRAMEBUFFER, params.backend_buffer1);
+  params.ctx->functions()->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, params.main_buffer);
+  params.ctx->extraFunctions()->glBlitFramebuffer(0, 0, width, height,
+                                                  0, 0, width, height,
+                                                  GL_COLOR_BUFFER_BIT,
+                                                  GL_NEAREST);
+  params.ctx->functions()->glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+
+  glEnable(GL_BLEND);
+}
+
 GLuint compose_sequence(ComposeSequenceParams &params) {
 //  qint64 time = QDateTime::currentMSecsSinceEpoch();
 
   GLuint final_fbo = params.main_buffer;
 
   SequencePtr s = params.seq;
-  long playhead = s->playhead;
+  long playhead = params.playhead;
 
   if (!params.nests.isEmpty()) {
     for (int i=0;i<params.nests.size();i++) {
@@ -180,10 +423,29 @@ GLuint compose_sequence(ComposeSequenceParams &params) {
 
   QVector<Clip*> current_clips;
 
+  // ask the clip index for clips near the playhead, using the same open/close buffers as Clip::IsActiveAt() which
+  // still makes the final decision below
+  QVector<int> candidates = s->clip_index.ClipsInRange(playhead - qCeil(s->frame_rate),
+                                                       playhead + qCeil(s->frame_rate*2),
+                                                       params.video,
+                                                       !params.video);
+
+  // the index orders by track, but clips are processed in the order they're stored in the sequence
+  std::sort(candidates.begin(), candidates.end());
+
+  QVector<std::weak_ptr<Clip> >& last_active_clips = params.video ? s->last_active_video_clips : s->last_active_audio_clips;
+  QVector<std::weak_ptr<Clip> > active_clips;
+  QSet<Clip*> active_clip_set;
+
   // loop through clips, find currently active, and sort by track
-  for (int i=0;i<s->clips.size();i++) {
+  for (int i=0;i<candidates.size();i++) {
+
+    // the sequence may have been edited since the index was queried
+    if (candidates.at(i) >= s->clips.size()) {
+      continue;
+    }
 
-    Clip* c = s->clips.at(i).get();
+    Clip* c = s->clips.at(candidates.at(i)).get();
 
     if (c != nullptr) {
 
@@ -206,6 +468,10 @@ GLuint compose_sequence(ComposeSequenceParams &params) {
               // does the media have a valid media stream source and is it active?
               if (ms != nullptr && c->IsActiveAt(playhead)) {
 
+                // switch between the proxy and source file if the proxy policy changed its mind
+                c->SetUseProxy(olive::ProxyAvailable(c)
+                               && olive::GetProxyPolicy()->UseProxy(c, params.playback_state));
+
                 // open if not open
                 if (!c->IsOpen()) {
                   c->Open();
@@ -244,6 +510,9 @@ GLuint compose_sequence(ComposeSequenceParams &params) {
 
         // if the clip is active, added it to "current_clips", sorted by track
         if (clip_is_active) {
+          active_clips.append(s->clips.at(candidates.at(i)));
+          active_clip_set.insert(c);
+
           bool added = false;
 
           // track sorting is only necessary for video clips
@@ -269,6 +538,16 @@ GLuint compose_sequence(ComposeSequenceParams &params) {
     }
   }
 
+  // close any clips that were active last time but weren't found near the playhead this time
+  for (int i=0;i<last_active_clips.size();i++) {
+    // clips that have been deleted since closed themselves when they were destroyed
+    ClipPtr c = last_active_clips.at(i).lock();
+    if (c != nullptr && !active_clip_set.contains(c.get()) && c->IsOpen()) {
+      c->Close(false);
+    }
+  }
+  last_active_clips = active_clips;
+
   if (params.video) {
     // set default coordinates based on the sequence, with 0 in the direct center
     glPushMatrix();
@@ -328,13 +607,14 @@ GLuint compose_sequence(ComposeSequenceParams &params) {
 
         // prepare framebuffers for backend drawing operations
         if (c->fbo == nullptr) {
-          // create 3 fbos for nested sequences, 2 for most clips
-          int fbo_count = (c->media() != nullptr && c->media()->get_type() == MEDIA_TYPE_SEQUENCE) ? 3 : 2;
+          // 4 fbos for nested sequences (the last one holds the cached nest output), 2 for most clips. Apart from the
+          // nest cache, they're only taken from the pool while the clip is being drawn.
+          int fbo_count = (c->media() != nullptr && c->media()->get_type() == MEDIA_TYPE_SEQUENCE) ? 4 : 2;
 
           c->fbo = new QOpenGLFramebufferObject* [size_t(fbo_count)];
 
           for (int j=0;j<fbo_count;j++) {
-            c->fbo[j] = new QOpenGLFramebufferObject(video_width, video_height);
+            c->fbo[j] = nullptr;
           }
         }
 
@@ -343,6 +623,26 @@ GLuint compose_sequence(ComposeSequenceParams &params) {
             && playhead < c->timeline_out(true)) {
           glPushMatrix();
 
+          // take working framebuffers from the pool, the nest cache is kept with the clip
+          bool is_nest = (c->media() != nullptr && c->media()->get_type() == MEDIA_TYPE_SEQUENCE);
+          int working_fbo_count = is_nest ? 3 : 2;
+          for (int j=0;j<working_fbo_count;j++) {
+            c->fbo[j] = params.fbo_pool->Take(video_width, video_height, params.internal_format);
+          }
+          if (is_nest
+              && c->fbo[3] != nullptr
+              && GLenum(c->fbo[3]->format().internalTextureFormat()) != params.internal_format) {
+            // compositing precision changed, the nest cache is stale anyway
+            delete c->fbo[3];
+            c->fbo[3] = nullptr;
+            c->nest_cache_valid = false;
+          }
+          if (is_nest && c->fbo[3] == nullptr) {
+            QOpenGLFramebufferObjectFormat nest_format;
+            nest_format.setInternalTextureFormat(params.internal_format);
+            c->fbo[3] = new QOpenGLFramebufferObject(video_width, video_height, nest_format);
+          }
+
           // simple bool for switching between the two framebuffers
           bool fbo_switcher = false;
 
@@ -351,18 +651,51 @@ GLuint compose_sequence(ComposeSequenceParams &params) {
           if (c->media() != nullptr) {
             if (c->media()->get_type() == MEDIA_TYPE_SEQUENCE) {
               // for a nested sequence, run this function again on that sequence and retrieve the texture
+              Sequence* nested = c->media()->to_sequence().get();
+
+              long nested_frame = rescale_frame_number(playhead + c->clip_in(true) - c->timeline_in(true),
+                                                       s->frame_rate,
+                                                       nested->frame_rate);
+              quint64 nested_version = get_nest_content_version(nested, 0);
+
+              if (c->nest_cache_valid
+                  && c->nest_cache_frame == nested_frame
+                  && c->nest_cache_version == nested_version
+                  && c->nest_cache_state == int(params.playback_state)) {
+
+                // nothing in the nest changed since it was last composed at this frame, reuse its output. fbo[3] is
+                // never drawn to by effects so the next write goes to fbo[0] as usual.
+                textureID = c->fbo[3]->texture();
+
+              } else {
+
+                bool texture_failed = params.texture_failed;
+                params.texture_failed = false;
+
+                // add nested sequence to nest list
+                params.nests.append(c);
+
+                // compose sequence
+                textureID = compose_sequence(params);
 
-              // add nested sequence to nest list
-              params.nests.append(c);
+                // remove sequence from nest list
+                params.nests.removeLast();
 
-              // compose sequence
-              textureID = compose_sequence(params);
+                // only keep complete frames, incomplete ones are redrawn once the footage is ready anyway
+                c->nest_cache_valid = !params.texture_failed;
+                if (c->nest_cache_valid) {
+                  glViewport(0, 0, video_width, video_height);
+                  textureID = draw_clip(c->fbo[3], textureID, true);
+                  c->nest_cache_frame = nested_frame;
+                  c->nest_cache_version = nested_version;
+                  c->nest_cache_state = int(params.playback_state);
+                }
 
-              // remove sequence from nest list
-              params.nests.removeLast();
+                params.texture_failed |= texture_failed;
 
-              // compose_sequence() would have written to this clip's fbo[0], so we switch to fbo[1]
-              fbo_switcher = true;
+                // compose_sequence() would have written to this clip's fbo[0], so we switch to fbo[1]
+                fbo_switcher = true;
+              }
             } else if (c->media()->get_type() == MEDIA_TYPE_FOOTAGE) {
 
               if (!c->media()->to_footage()->alpha_is_premultiplied) {
@@ -376,15 +709,6 @@ GLuint compose_sequence(ComposeSequenceParams &params) {
                 fbo_switcher = true;
               }
 
-#ifdef OLIVE_OCIO
-              // convert to linear colorspace
-              bool linear_convert = true;
-              if (linear_convert)
-              {
-
-              }
-#endif
-
             }
           }
 
@@ -415,15 +739,87 @@ GLuint compose_sequence(ComposeSequenceParams &params) {
           // get current sequence time in seconds (used for effects)
           double timecode = get_timecode(c, playhead);
 
+          // while paused, look for what the clip looked like after its effects the last time it was drawn.
+          // stage_keys[j] covers the clip's input and effects 0 to j, up to the first effect that can't be cached.
+          QVector<QByteArray> stage_keys;
+          int first_stage = 0;
+          if (params.effect_cache != nullptr
+              && params.playback_state == olive::kPlaybackPaused
+              && olive::CurrentConfig.effect_cache_size > 0) {
+            QByteArray key = get_effect_input_key(c, timecode);
+            if (!key.isEmpty()) {
+              for (int j=0;j<c->effects.size();j++) {
+                QCryptographicHash hash(QCryptographicHash::Md5);
+                hash.addData(key);
+                if (!c->effects.at(j)->hash_stage(hash, timecode)) {
+                  break;
+                }
+                key = hash.result();
+                stage_keys.append(key);
+              }
+            }
+
+            // start after the last stage that's still cached
+            for (int j=stage_keys.size();j>0;j--) {
+              GLuint cached_texture = params.effect_cache->Find(c, j, stage_keys.at(j-1));
+              if (cached_texture != 0) {
+                textureID = cached_texture;
+                first_stage = j;
+                break;
+              }
+            }
+          }
+
           // run through all of the clip's effects
-          for (int j=0;j<c->effects.size();j++) {
-            Effect* e = c->effects.at(j).get();
-            process_effect(c, e, timecode, coords, textureID, fbo_switcher, params.texture_failed, kTransitionNone);
+          int j = 0;
+          while (j < c->effects.size()) {
+            int effect_count = 1;
+
+            if (j < first_stage) {
+              // already drawn, but the coordinates the effect sets still need to be worked out
+              Effect* e = c->effects.at(j).get();
+              if (e->is_enabled() && e->enable_coords) {
+                e->process_coords(timecode, coords, kTransitionNone);
+              }
+            } else {
+              GLuint stage_input = textureID;
+              bool stage_failed = false;
+
+              // runs of color effects are drawn in one pass where possible
+              effect_count = process_fused_effects(c, j, timecode, textureID, fbo_switcher);
+              if (effect_count == 0) {
+                process_effect(c, c->effects.at(j).get(), timecode, coords, textureID, fbo_switcher, stage_failed, kTransitionNone);
+                effect_count = 1;
+              }
+
+              params.texture_failed |= stage_failed;
+
+              // keep the output if it's complete and the effects drew anything
+              if (j + effect_count <= stage_keys.size()
+                  && !stage_failed
+                  && textureID != 0
+                  && textureID != stage_input) {
+                QOpenGLFramebufferObject* cache_fbo = params.effect_cache->Store(c,
+                                                                                 j + effect_count,
+                                                                                 stage_keys.at(j + effect_count - 1),
+                                                                                 video_width,
+                                                                                 video_height,
+                                                                                 params.internal_format);
+                if (cache_fbo != nullptr) {
+                  draw_clip(cache_fbo, textureID, true);
+                }
+              }
+            }
 
-            if (e == params.gizmos) {
-              e->gizmo_draw(timecode, coords); // set correct gizmo coords
-              e->gizmo_world_to_screen(); // convert gizmo coords to screen coords
+            for (int k=j;k<j+effect_count;k++) {
+              Effect* e = c->effects.at(k).get();
+              if (e == params.gizmos) {
+                e->gizmo_draw(timecode, coords); // set correct gizmo coords
+                e->gizmo_world_to_screen(); // convert gizmo coords to screen coords
+              }
             }
+
+            j += effect_count;
           }
 
           // if the clip has an opening transition, process that now
@@ -448,102 +844,93 @@ GLuint compose_sequence(ComposeSequenceParams &params) {
             // set viewport to sequence size
             params.ctx->functions()->glViewport(0, 0, s->width, s->height);
 
+            // set texture filter to bilinear
+            glBindTexture(GL_TEXTURE_2D, textureID);
+            params.ctx->functions()->glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            params.ctx->functions()->glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+            glBindTexture(GL_TEXTURE_2D, 0);
 
+            if (coords.blendmode == BLEND_MODE_NORMAL || olive::CurrentRuntimeConfig.disable_blending) {
 
-            // == START RENDER CLIP IN CONTEXT OF SEQUENCE ==
+              // normal blending is premultiplied "over" compositing, which GL blending (set up above) already does.
+              // The clip is drawn straight onto the sequence buffer in one pass with its opacity applied through the
+              // vertex color rather than going through a backbuffer and the blending mode shader. This is also the
+              // pure GL fallback for GPUs that don't like the blending shader.
 
+              params.ctx->functions()->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, final_fbo);
 
+              glColor4f(coords.opacity, coords.opacity, coords.opacity, coords.opacity);
+
+              glBindTexture(GL_TEXTURE_2D, textureID);
+
+              draw_clip_quad(params.ctx, params.quad_buffer, coords);
+
+              glBindTexture(GL_TEXTURE_2D, 0);
+
+              glColor4f(1.0, 1.0, 1.0, 1.0);
+
+              params.ctx->functions()->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 
-            // use clip textures for nested sequences, otherwise use main frame buffers
-            GLuint back_buffer_1;
-            GLuint backend_tex_1;
-            GLuint backend_tex_2;
-            if (params.nests.size() > 0) {
-              back_buffer_1 = params.nests.last()->fbo[1]->handle();
-              backend_tex_1 = params.nests.last()->fbo[1]->texture();
-              backend_tex_2 = params.nests.last()->fbo[2]->texture();
             } else {
-              back_buffer_1 = params.backend_buffer1;
-              backend_tex_1 = params.backend_attachment1;
-              backend_tex_2 = params.backend_attachment2;
-            }
 
-            // render a backbuffer
-            params.ctx->functions()->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, back_buffer_1);
 
-            glClearColor(0.0, 0.0, 0.0, 0.0);
-            glClear(GL_COLOR_BUFFER_BIT);
 
-            // bind final clip texture
-            glBindTexture(GL_TEXTURE_2D, textureID);
+              // == START RENDER CLIP IN CONTEXT OF SEQUENCE ==
 
-            // set texture filter to bilinear
-            params.ctx->functions()->glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-            params.ctx->functions()->glTexParameterf(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
 
-            // draw clip on screen according to gl coordinates
-            glBegin(GL_QUADS);
 
-            glTexCoord2f(coords.textureTopLeftX, coords.textureTopLeftY); // top left
-            glVertex2f(coords.vertexTopLeftX, coords.vertexTopLeftY); // top left
-            glTexCoord2f(coords.textureTopRightX, coords.textureTopRightY); // top right
-            glVertex2f(coords.vertexTopRightX, coords.vertexTopRightY); // top right
-            glTexCoord2f(coords.textureBottomRightX, coords.textureBottomRightY); // bottom right
-            glVertex2f(coords.vertexBottomRightX, coords.vertexBottomRightY); // bottom right
-            glTexCoord2f(coords.textureBottomLeftX, coords.textureBottomLeftY); // bottom left
-            glVertex2f(coords.vertexBottomLeftX, coords.vertexBottomLeftY); // bottom left
+              // use clip textures for nested sequences, otherwise use main frame buffers
+              GLuint back_buffer_1;
+              GLuint backend_tex_1;
+              GLuint backend_tex_2;
+              if (params.nests.size() > 0) {
+                back_buffer_1 = params.nests.last()->fbo[1]->handle();
+                backend_tex_1 = params.nests.last()->fbo[1]->texture();
+                backend_tex_2 = params.nests.last()->fbo[2]->texture();
+              } else {
+                back_buffer_1 = params.backend_buffer1;
+                backend_tex_1 = params.backend_attachment1;
+                backend_tex_2 = params.backend_attachment2;
+              }
 
-            glEnd();
+              // render a backbuffer
+              params.ctx->functions()->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, back_buffer_1);
 
-            // release final clip texture
-            glBindTexture(GL_TEXTURE_2D, 0);
+              glClearColor(0.0, 0.0, 0.0, 0.0);
+              glClear(GL_COLOR_BUFFER_BIT);
 
-            params.ctx->functions()->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+              // draw clip on screen according to gl coordinates
+              glBindTexture(GL_TEXTURE_2D, textureID);
 
+              draw_clip_quad(params.ctx, params.quad_buffer, coords);
 
+              // release final clip texture
+              glBindTexture(GL_TEXTURE_2D, 0);
 
-            // == END RENDER CLIP IN CONTEXT OF SEQUENCE ==
+              params.ctx->functions()->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 
 
 
-            //
-            //
-            // PROCESS POST-SHADERS
-            //
-            //
+              // == END RENDER CLIP IN CONTEXT OF SEQUENCE ==
 
 
 
-            // copy front buffer to back buffer (only if we're using blending modes - which we usually will be)
-            if (!olive::CurrentRuntimeConfig.disable_blending) {
+              // copy front buffer to back buffer so the blending shader can read what's been composited so far
               if (params.nests.size() > 0) {
                 draw_clip(params.ctx, params.nests.last()->fbo[2]->handle(), params.nests.last()->fbo[0]->texture(), true);
               } else {
                 draw_clip(params.ctx, params.backend_buffer2, params.main_attachment, true);
               }
-            }
-
 
 
-            // == START FINAL DRAW ON SEQUENCE BUFFER ==
 
+              // == START FINAL DRAW ON SEQUENCE BUFFER ==
 
 
 
-            // bind front buffer as draw buffer
-            params.ctx->functions()->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, final_fbo);
+              // bind front buffer as draw buffer
+              params.ctx->functions()->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, final_fbo);
 
-            if (olive::CurrentRuntimeConfig.disable_blending) {
-              // some GPUs don't like the blending shader, so we provide a pure GL fallback here
-
-              params.ctx->functions()->glBindTexture(GL_TEXTURE_2D, backend_tex_1);
-
-              glColor4f(coords.opacity, coords.opacity, coords.opacity, coords.opacity);
-
-              full_blit();
-
-              params.ctx->functions()->glBindTexture(GL_TEXTURE_2D, 0);
-            } else {
               // load background texture into texture unit 0
               params.ctx->functions()->glActiveTexture(GL_TEXTURE0 + 0); // Texture unit 0
               params.ctx->functions()->glBindTexture(GL_TEXTURE_2D, backend_tex_2);
@@ -572,15 +959,14 @@ GLuint compose_sequence(ComposeSequenceParams &params) {
               // unbind texture from texture unit 0
               params.ctx->functions()->glActiveTexture(GL_TEXTURE0 + 0); // Texture unit 0
               params.ctx->functions()->glBindTexture(GL_TEXTURE_2D, 0);
-            }
 
-            // unbind framebuffer
-            params.ctx->functions()->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+              // unbind framebuffer
+              params.ctx->functions()->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
 
 
 
-
-            // == END FINAL DRAW ON SEQUENCE BUFFER ==
+              // == END FINAL DRAW ON SEQUENCE BUFFER ==
+            }
           }
 
           // prepare gizmos
@@ -594,6 +980,12 @@ GLuint compose_sequence(ComposeSequenceParams &params) {
           }
           */
 
+          // hand the working framebuffers back, nothing reads them once the clip has been drawn
+          for (int j=0;j<working_fbo_count;j++) {
+            params.fbo_pool->Release(c->fbo[j]);
+            c->fbo[j] = nullptr;
+          }
+
           glPopMatrix();
         }
       } else {
@@ -644,6 +1036,10 @@ GLuint compose_sequence(ComposeSequenceParams &params) {
 
   if (params.video) {
     glPopMatrix();
+
+    if (params.nests.isEmpty() && params.ocio_shader != nullptr) {
+      apply_display_transform(params);
+    }
   }
 
 //  qDebug() << "compose sequence took" << QDateTime::currentMSecsSinceEpoch() - time;
@@ -661,14 +1057,33 @@ void compose_audio(Viewer* viewer, SequencePtr seq, int playback_speed, bool wai
   params.viewer = viewer;
   params.ctx = nullptr;
   params.seq = seq;
+  params.playhead = seq->playhead;
   params.video = false;
   params.gizmos = nullptr;
   params.wait_for_mutexes = wait_for_mutexes;
   params.playback_speed = playback_speed;
+  params.playback_state = (viewer == nullptr) ? olive::kPlaybackExporting : viewer->playback_state();
   params.blend_mode_program = nullptr;
+  params.fbo_pool = nullptr;
+  params.effect_cache = nullptr;
+  params.internal_format = GL_RGBA8;
+  params.quad_buffer = 0;
+  params.ocio_shader = nullptr;
+  params.ocio_lut_texture = 0;
   compose_sequence(params);
 }
 
+GLenum get_compositing_format(QOpenGLContext *ctx, Sequence *s) {
+  if (s->half_float && supports_float_textures(ctx)) {
+    return GL_RGBA16F;
+  }
+  return GL_RGBA8;
+}
+
+bool supports_float_textures(QOpenGLContext *ctx) {
+  return (ctx->format().majorVersion() >= 3 || ctx->hasExtension("GL_ARB_texture_float"));
+}
+
 long rescale_frame_number(long framenumber, double source_frame_rate, double target_frame_rate) {
   return qRound((double(framenumber)/source_frame_rate)*target_frame_rate);
 }
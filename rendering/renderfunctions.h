@@ -29,6 +29,9 @@
 #include "project/effect.h"
 
 #include "panels/viewer.h"
+#include "rendering/proxypolicy.h"
+#include "rendering/framebufferpool.h"
+#include "rendering/effectstagecache.h"
 
 /**
  * @brief The ComposeSequenceParams struct
@@ -55,12 +58,16 @@ struct ComposeSequenceParams {
 
     /**
      * @brief The sequence to compose
-     *
-     * In addition to clips, sequences also contain the playhead position so compose_sequence() knows which frame
-     * to render.
      */
     SequencePtr seq;
 
+    /**
+     * @brief The frame of the sequence to compose
+     *
+     * Usually the sequence's playhead, but playback may render frames ahead of it.
+     */
+    long playhead;
+
     /**
      * @brief Array to store the nested sequence hierarchy
      *
@@ -130,6 +137,14 @@ struct ComposeSequenceParams {
      */
     int playback_speed;
 
+    /**
+     * @brief What this frame is being rendered for
+     *
+     * Passed to the current ProxyPolicy to decide whether each footage clip is decoded from its proxy or its source
+     * file.
+     */
+    olive::PlaybackState playback_state;
+
     /**
      * @brief Blending mode shader
      *
@@ -206,12 +221,47 @@ struct ComposeSequenceParams {
     GLuint backend_attachment2;
 
     /**
-     * @brief OpenGL shader containing OpenColorIO shader information
+     * @brief Pool clips take their working framebuffers from while they're drawn
+     *
+     * Used only for video rendering. Never accessed with audio rendering.
+     */
+    FramebufferPool* fbo_pool;
+
+    /**
+     * @brief Outputs of clips' effects kept from earlier frames, see EffectStageCache
+     *
+     * Used only for video rendering. Never accessed with audio rendering. Can be nullptr to always run every effect.
+     */
+    EffectStageCache* effect_cache;
+
+    /**
+     * @brief Internal format of the framebuffers used for compositing, see get_compositing_format()
+     *
+     * Used only for video rendering. Never accessed with audio rendering. Should match the format of
+     * `main_buffer`.
+     */
+    GLenum internal_format;
+
+    /**
+     * @brief Vertex buffer all quads are drawn from, see create_quad_buffer()
+     *
+     * Used only for video rendering. Never accessed with audio rendering.
+     *
+     * Must be bound as the vertex and texture coordinate array (see bind_quad_buffer()) before compose_sequence() is
+     * called.
+     */
+    GLuint quad_buffer;
+
+    /**
+     * @brief OpenGL shader applying the OpenColorIO display transform, see RenderThread::set_up_ocio()
+     *
+     * Used only for video rendering. Never accessed with audio rendering. If set, the finished frame is run through
+     * it once at the end of compose_sequence(). Set to nullptr if there's no display transform.
      */
     QOpenGLShaderProgram* ocio_shader;
 
     /**
-     * @brief OpenGL texture containing LUT obtained form OpenColorIO
+     * @brief OpenGL 3D texture containing the display transform LUT baked by OCIOLutCache
      */
     GLuint ocio_lut_texture;
 };
@@ -240,6 +290,40 @@ struct ComposeSequenceParams {
  */
 GLuint compose_sequence(ComposeSequenceParams &params);
 
+/**
+ * @brief Get the framebuffer format a Sequence should be composited in
+ *
+ * Returns GL_RGBA16F if the Sequence has Sequence::half_float set and the context supports rendering to floating
+ * point textures, or GL_RGBA8 otherwise. Must be called with `ctx` current.
+ */
+GLenum get_compositing_format(QOpenGLContext* ctx, Sequence* s);
+
+/**
+ * @brief Returns **TRUE** if floating point textures can be created and rendered to in `ctx`
+ */
+bool supports_float_textures(QOpenGLContext* ctx);
+
+/**
+ * @brief Create the vertex buffer compose_sequence() draws its quads from
+ *
+ * Holds a full-frame quad used for every framebuffer pass followed by space for the quad of the clip currently being
+ * drawn. Must be called with `ctx` current and deleted with glDeleteBuffers() once it's no longer needed.
+ */
+GLuint create_quad_buffer(QOpenGLContext* ctx);
+
+/**
+ * @brief Bind a buffer from create_quad_buffer() as the vertex and texture coordinate array
+ *
+ * Everything compose_sequence() draws comes from this buffer, so this only needs to be done once before it's called.
+ * Undo with release_quad_buffer().
+ */
+void bind_quad_buffer(QOpenGLContext* ctx, GLuint buffer);
+
+/**
+ * @brief Stop drawing from the buffer bound by bind_quad_buffer()
+ */
+void release_quad_buffer(QOpenGLContext* ctx);
+
 /**
  * @brief Convenience wrapper function for compose_sequence() to render audio
  *
@@ -25,12 +25,13 @@
 #include <QOpenGLFunctions>
 #include <QDateTime>
 #include <QDebug>
-#ifdef OLIVE_OCIO
-#include <OpenColorIO/OpenColorIO.h>
-namespace OCIO = OCIO_NAMESPACE;
-#endif
+#include <QFile>
+#include <QOpenGLExtraFunctions>
 
 #include "rendering/renderfunctions.h"
+#include "rendering/rendercache.h"
+#include "rendering/ociolutcache.h"
+#include "io/config.h"
 #include "project/sequence.h"
 
 RenderThread::RenderThread() :
@@ -39,13 +40,29 @@ RenderThread::RenderThread() :
   ctx(nullptr),
   blend_mode_program(nullptr),
   premultiply_program(nullptr),
+  quad_buffer(0),
+  ocio_lut_texture(0),
+  ocio_shader(nullptr),
   seq(nullptr),
+  playback_state(olive::kPlaybackPaused),
   tex_width(-1),
   tex_height(-1),
+  tex_format(GL_RGBA8),
   queued(false),
   texture_failed(false),
   running(true),
-  front_buffer_switcher(false)
+  front_buffer_switcher(false),
+  frame_(0),
+  rendering_frame_(0),
+  rendering_state_(olive::kPlaybackPaused),
+  rendering_pixels_(nullptr),
+  rendering_linesize_(0),
+  rendering_background_(false),
+  background_queued_(false),
+  background_frame_(0),
+  deferred_present_(false),
+  painting_(false),
+  pending_frame_(-1)
 {
   surface.create();
 }
@@ -58,39 +75,82 @@ void RenderThread::run() {
   wait_lock_.lock();
 
   while (running) {
-    if (!queued) {
+    if (!queued && !background_queued_) {
       wait_cond_.wait(&wait_lock_);
     }
     if (!running) {
       break;
     }
-    queued = false;
+    present_lock_.lock();
+
+    // frames for the viewer always go first
+    rendering_background_ = !queued;
+
+    if (rendering_background_) {
+      if (!background_queued_) {
+        present_lock_.unlock();
+        continue;
+      }
+
+      background_queued_ = false;
+      rendering_seq_ = background_seq_;
+      rendering_frame_ = background_frame_;
+      background_seq_ = nullptr;
+
+      // during playback, the buffer a background frame would be painted into holds the next frame to present
+      if (deferred_present_ || ctx == nullptr) {
+        present_lock_.unlock();
+        emit background_ready(rendering_frame_, QByteArray());
+        continue;
+      }
+
+      rendering_state_ = olive::kPlaybackExporting;
+      rendering_save_fn_.clear();
+    } else {
+      queued = false;
+      rendering_seq_ = seq;
+      rendering_frame_ = frame_;
+      rendering_state_ = playback_state;
+      rendering_save_fn_ = save_fn;
+      rendering_pixels_ = pixel_buffer;
+      rendering_linesize_ = pixel_buffer_linesize;
+    }
+
+    painting_ = true;
+    present_lock_.unlock();
 
     if (share_ctx != nullptr) {
       if (ctx != nullptr) {
         ctx->makeCurrent(&surface);
 
-        // if the sequence size has changed, we'll need to reinitialize the textures
-        if (seq->width != tex_width || seq->height != tex_height) {
+        // if the sequence size or precision has changed, we'll need to reinitialize the textures
+        GLenum seq_format = get_compositing_format(ctx, rendering_seq_.get());
+        if (rendering_seq_->width != tex_width
+            || rendering_seq_->height != tex_height
+            || seq_format != tex_format) {
           delete_buffers();
 
           // cache sequence values for future checks
-          tex_width = seq->width;
-          tex_height = seq->height;
+          tex_width = rendering_seq_->width;
+          tex_height = rendering_seq_->height;
+          tex_format = seq_format;
         }
 
         // create any buffers that don't yet exist
         if (!front_buffer_1.IsCreated()) {
-          front_buffer_1.Create(ctx, seq->width, seq->height);
+          front_buffer_1.Create(ctx, tex_width, tex_height, tex_format);
         }
         if (!front_buffer_2.IsCreated()) {
-          front_buffer_2.Create(ctx, seq->width, seq->height);
+          front_buffer_2.Create(ctx, tex_width, tex_height, tex_format);
         }
         if (!back_buffer_1.IsCreated()) {
-          back_buffer_1.Create(ctx, seq->width, seq->height);
+          back_buffer_1.Create(ctx, tex_width, tex_height, tex_format);
         }
         if (!back_buffer_2.IsCreated()) {
-          back_buffer_2.Create(ctx, seq->width, seq->height);
+          back_buffer_2.Create(ctx, tex_width, tex_height, tex_format);
+        }
+        if (quad_buffer == 0) {
+          quad_buffer = create_quad_buffer(ctx);
         }
 
         if (blend_mode_program == nullptr) {
@@ -108,14 +168,46 @@ void RenderThread::run() {
           premultiply_program->link();
         }
 
-        // draw frame
-        paint();
+        set_up_ocio();
+
+        if (rendering_background_) {
+
+          // background frames are read back into their own buffer and never shown. paint() draws into the front buffer
+          // that isn't on screen, and since it isn't swapped in, the viewer keeps showing what it was showing.
+          QByteArray pixels(tex_width * tex_height * 4, Qt::Uninitialized);
+          rendering_pixels_ = pixels.data();
+          rendering_linesize_ = 0;
+
+          bool failed = paint();
 
-        front_buffer_switcher = !front_buffer_switcher;
+          present_lock_.lock();
+          painting_ = false;
+          present_lock_.unlock();
+
+          emit background_ready(rendering_frame_, failed ? QByteArray() : pixels);
+
+          continue;
+        }
+
+        // draw frame
+        texture_failed = paint();
+
+        present_lock_.lock();
+        painting_ = false;
+        if (deferred_present_) {
+          pending_frame_ = rendering_frame_;
+        } else {
+          front_buffer_switcher = !front_buffer_switcher;
+        }
+        present_lock_.unlock();
 
         emit ready();
       }
     }
+
+    present_lock_.lock();
+    painting_ = false;
+    present_lock_.unlock();
   }
 
   delete_ctx();
@@ -137,18 +229,79 @@ const GLuint &RenderThread::get_texture()
 
 void RenderThread::set_up_ocio()
 {
+  OCIODisplaySettings settings = OCIODisplaySettings::FromConfig();
+  QByteArray key = olive::CurrentConfig.enable_color_management ? settings.key() : QByteArray();
+
+  // the LUT only needs to be uploaded again if the settings changed
+  if (key == ocio_key) {
+    return;
+  }
+
+  destroy_ocio();
+  ocio_key = key;
+
+  OCIOLut lut;
+  if (key.isEmpty() || !olive::ocio_lut_cache.Get(settings, lut)) {
+    return;
+  }
+
+  glGenTextures(1, &ocio_lut_texture);
+  glBindTexture(GL_TEXTURE_3D, ocio_lut_texture);
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_3D, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+  ctx->extraFunctions()->glTexImage3D(GL_TEXTURE_3D,
+                                      0,
+                                      supports_float_textures(ctx) ? GL_RGB16F : GL_RGB8,
+                                      LUT3D_EDGE_SIZE,
+                                      LUT3D_EDGE_SIZE,
+                                      LUT3D_EDGE_SIZE,
+                                      0,
+                                      GL_RGB,
+                                      GL_FLOAT,
+                                      lut.data.constData());
+  glBindTexture(GL_TEXTURE_3D, 0);
+
+  // OCIODisplay() has to be defined before it's used, so it goes straight after the #version line
+  QFile frag_file(":/internalshaders/ocio.frag");
+  frag_file.open(QFile::ReadOnly);
+  QByteArray frag_source = frag_file.readAll();
+  frag_source.insert(frag_source.indexOf('\n') + 1, lut.shader_text);
+
+  ocio_shader = new QOpenGLShaderProgram();
+  ocio_shader->addShaderFromSourceFile(QOpenGLShader::Vertex, ":/internalshaders/common.vert");
+  ocio_shader->addShaderFromSourceCode(QOpenGLShader::Fragment, frag_source);
+  if (!ocio_shader->link()) {
+    qWarning() << "Failed to compile OpenColorIO display shader";
+    destroy_ocio();
+  }
+}
+
+void RenderThread::destroy_ocio()
+{
+  delete ocio_shader;
+  ocio_shader = nullptr;
+
+  if (ocio_lut_texture != 0) {
+    glDeleteTextures(1, &ocio_lut_texture);
+    ocio_lut_texture = 0;
+  }
 }
 
-void RenderThread::paint() {
+bool RenderThread::paint() {
   // set up compose_sequence() parameters
   ComposeSequenceParams params;
   params.viewer = nullptr;
   params.ctx = ctx;
-  params.seq = seq;
+  params.seq = rendering_seq_;
+  params.playhead = rendering_frame_;
   params.video = true;
   params.texture_failed = false;
   params.wait_for_mutexes = true;
   params.playback_speed = 1;
+  params.playback_state = rendering_state_;
   params.blend_mode_program = blend_mode_program;
   params.premultiply_program = premultiply_program;
   params.backend_buffer1 = back_buffer_1.buffer();
@@ -157,10 +310,20 @@ void RenderThread::paint() {
   params.backend_attachment2 = back_buffer_2.texture();
   params.main_buffer = front_buffer_switcher ? front_buffer_1.buffer() : front_buffer_2.buffer();
   params.main_attachment = front_buffer_switcher ? front_buffer_1.texture() : front_buffer_2.texture();
-
-  // get currently selected gizmos
-  gizmos = seq->GetSelectedGizmo();
-  params.gizmos = gizmos;
+  params.fbo_pool = &fbo_pool;
+  params.effect_cache = &effect_cache;
+  params.internal_format = tex_format;
+  params.quad_buffer = quad_buffer;
+  params.ocio_shader = ocio_shader;
+  params.ocio_lut_texture = ocio_lut_texture;
+
+  // get currently selected gizmos, background frames aren't shown so they don't need any
+  if (rendering_background_) {
+    params.gizmos = nullptr;
+  } else {
+    gizmos = rendering_seq_->GetSelectedGizmo();
+    params.gizmos = gizmos;
+  }
 
   QMutex& active_mutex = front_buffer_switcher ? front_mutex1 : front_mutex2;
   active_mutex.lock();
@@ -179,30 +342,61 @@ void RenderThread::paint() {
   glEnable(GL_BLEND);
   glEnable(GL_DEPTH);
 
-  compose_sequence(params);
+  // during playback, frames that have been rendered with "Render Work Area" are uploaded from the render cache rather
+  // than composed live. Computing a frame's key is expensive, so it's only done for frames marked as rendered.
+  bool loaded_from_cache = false;
+  if (rendering_state_ == olive::kPlaybackPlaying
+      && rendering_save_fn_.isEmpty()
+      && rendering_pixels_ == nullptr
+      && olive::render_cache.IsRendered(rendering_seq_.get(), rendering_frame_)) {
+    cache_pixels.resize(tex_width * tex_height * 4);
+
+    QByteArray key = olive::render_cache.GetFrameKey(rendering_seq_.get(), rendering_frame_);
+    if (olive::render_cache.Load(key, tex_width, tex_height, reinterpret_cast<uchar*>(cache_pixels.data()))) {
+      glBindTexture(GL_TEXTURE_2D, params.main_attachment);
+      glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, tex_width, tex_height, GL_RGBA, GL_UNSIGNED_BYTE, cache_pixels.constData());
+      glBindTexture(GL_TEXTURE_2D, 0);
+      loaded_from_cache = true;
+    }
+  }
+
+  if (!loaded_from_cache) {
+    bind_quad_buffer(ctx, quad_buffer);
+
+    compose_sequence(params);
+
+    release_quad_buffer(ctx);
+  }
 
   // flush changes
   ctx->functions()->glFinish();
 
-  texture_failed = params.texture_failed;
-
   active_mutex.unlock();
 
-  if (!save_fn.isEmpty()) {
-    if (texture_failed) {
-      // texture failed, try again
-      queued = true;
+  if (!rendering_save_fn_.isEmpty()) {
+    if (params.texture_failed) {
+      // texture failed, try again unless something else has been requested in the meantime
+      present_lock_.lock();
+      if (!queued && save_fn == rendering_save_fn_) {
+        queued = true;
+      }
+      present_lock_.unlock();
     } else {
       ctx->functions()->glBindFramebuffer(GL_READ_FRAMEBUFFER, params.main_buffer);
       QImage img(tex_width, tex_height, QImage::Format_RGBA8888);
       glReadPixels(0, 0, tex_width, tex_height, GL_RGBA, GL_UNSIGNED_BYTE, img.bits());
-      img.save(save_fn);
+      img.save(rendering_save_fn_);
       ctx->functions()->glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
-      save_fn = "";
+
+      present_lock_.lock();
+      if (save_fn == rendering_save_fn_) {
+        save_fn.clear();
+      }
+      present_lock_.unlock();
     }
   }
 
-  if (pixel_buffer != nullptr) {
+  if (rendering_pixels_ != nullptr) {
 
     // set main framebuffer to the current read buffer
     ctx->functions()->glBindFramebuffer(GL_READ_FRAMEBUFFER, params.main_buffer);
@@ -210,16 +404,22 @@ void RenderThread::paint() {
     // store pixels in buffer
     glReadPixels(0,
                  0,
-                 pixel_buffer_linesize == 0 ? tex_width : pixel_buffer_linesize,
+                 rendering_linesize_ == 0 ? tex_width : rendering_linesize_,
                  tex_height,
                  GL_RGBA,
                  GL_UNSIGNED_BYTE,
-                 pixel_buffer);
+                 rendering_pixels_);
 
     // release current read buffer
     ctx->functions()->glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
 
-    pixel_buffer = nullptr;
+    rendering_pixels_ = nullptr;
+
+    present_lock_.lock();
+    if (!rendering_background_ && !queued) {
+      pixel_buffer = nullptr;
+    }
+    present_lock_.unlock();
   }
 
   glDisable(GL_DEPTH);
@@ -228,13 +428,78 @@ void RenderThread::paint() {
 
   // release
   ctx->functions()->glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+
+  return params.texture_failed;
 }
 
-void RenderThread::start_render(QOpenGLContext *share, SequencePtr s, const QString& save, GLvoid* pixels, int pixel_linesize, int idivider) {
+void RenderThread::start_render(QOpenGLContext *share, SequencePtr s, olive::PlaybackState state, const QString& save, GLvoid* pixels, int pixel_linesize, int idivider) {
   Q_UNUSED(idivider);
 
-  seq = s;
+  queue_render(share, s, s->playhead, state, save, pixels, pixel_linesize);
+}
+
+void RenderThread::start_render_frame(QOpenGLContext *share, SequencePtr s, long frame) {
+  queue_render(share, s, frame, olive::kPlaybackPlaying, nullptr, nullptr, 0);
+}
+
+void RenderThread::start_render_background(SequencePtr s, long frame) {
+  present_lock_.lock();
+  background_seq_ = s;
+  background_frame_ = frame;
+  background_queued_ = true;
+  present_lock_.unlock();
+
+  wait_cond_.wakeAll();
+}
+
+void RenderThread::cancel_background() {
+  present_lock_.lock();
+  background_queued_ = false;
+  background_seq_ = nullptr;
+  present_lock_.unlock();
+}
+
+void RenderThread::set_deferred_present(bool deferred) {
+  present_lock_.lock();
+  deferred_present_ = deferred;
+  present_lock_.unlock();
 
+  if (!deferred) {
+    present();
+  }
+}
+
+bool RenderThread::present() {
+  QMutexLocker locker(&present_lock_);
+
+  // a frame that's being painted over can't be shown
+  if (pending_frame_ < 0 || painting_) {
+    return false;
+  }
+
+  front_buffer_switcher = !front_buffer_switcher;
+  pending_frame_ = -1;
+
+  return true;
+}
+
+long RenderThread::pending_frame() {
+  QMutexLocker locker(&present_lock_);
+  return painting_ ? -1 : pending_frame_;
+}
+
+bool RenderThread::is_busy() {
+  QMutexLocker locker(&present_lock_);
+  return queued || painting_;
+}
+
+void RenderThread::queue_render(QOpenGLContext *share,
+                                SequencePtr s,
+                                long frame,
+                                olive::PlaybackState state,
+                                const QString &save,
+                                GLvoid *pixels,
+                                int pixel_linesize) {
   // stall any dependent actions
   texture_failed = true;
 
@@ -248,12 +513,19 @@ void RenderThread::start_render(QOpenGLContext *share, SequencePtr s, const QStr
     ctx->moveToThread(this);
   }
 
+  present_lock_.lock();
+  seq = s;
+  playback_state = state;
+  frame_ = frame;
   save_fn = save;
   pixel_buffer = pixels;
   pixel_buffer_linesize = pixel_linesize;
-
   queued = true;
 
+  // the pending frame's buffer is about to be painted over
+  pending_frame_ = -1;
+  present_lock_.unlock();
+
   wait_cond_.wakeAll();
 }
 
@@ -272,6 +544,14 @@ void RenderThread::delete_buffers() {
   front_buffer_2.Destroy();
   back_buffer_1.Destroy();
   back_buffer_2.Destroy();
+
+  fbo_pool.Clear();
+  effect_cache.Clear();
+
+  if (quad_buffer != 0) {
+    ctx->functions()->glDeleteBuffers(1, &quad_buffer);
+    quad_buffer = 0;
+  }
 }
 
 void RenderThread::delete_shaders() {
@@ -286,6 +566,8 @@ void RenderThread::delete_ctx() {
   if (ctx != nullptr) {
     delete_shaders();
     delete_buffers();
+    destroy_ocio();
+    ocio_key.clear();
   }
 
   delete ctx;
@@ -32,12 +32,9 @@
 #include "project/sequence.h"
 #include "project/effect.h"
 #include "rendering/framebufferobject.h"
-
-// copied from source code to OCIODisplay
-const int LUT3D_EDGE_SIZE = 32;
-
-// copied from source code to OCIODisplay, expanded from 3*LUT3D_EDGE_SIZE*LUT3D_EDGE_SIZE*LUT3D_EDGE_SIZE
-const int NUM_3D_ENTRIES = 98304;
+#include "rendering/framebufferpool.h"
+#include "rendering/effectstagecache.h"
+#include "rendering/proxypolicy.h"
 
 class RenderThread : public QThread {
   Q_OBJECT
@@ -50,22 +47,82 @@ public:
   const GLuint& get_texture();
 
   Effect* gizmos;
-  void paint();
+
+  // draws the requested frame, returns **TRUE** if it couldn't be drawn completely (see did_texture_fail())
+  bool paint();
   void start_render(QOpenGLContext* share,
                     SequencePtr s,
+                    olive::PlaybackState state,
                     const QString &save = nullptr,
                     GLvoid *pixels = nullptr,
                     int pixel_linesize = 0,
                     int idivider = 0);
+
+  /**
+   * @brief Render a specific frame of a sequence for playback, which may be ahead of its playhead
+   */
+  void start_render_frame(QOpenGLContext* share, SequencePtr s, long frame);
+
+  /**
+   * @brief Render a frame of a sequence in the background without showing it
+   *
+   * Background frames are only rendered while no other frame is requested and never during playback, so they don't
+   * hold up the viewer. background_ready() is emitted once the frame is done. A new request replaces one that hasn't
+   * started yet. Uses the context of the last start_render() call, so the viewer must have rendered something before.
+   */
+  void start_render_background(SequencePtr s, long frame);
+
+  /**
+   * @brief Drop a background frame that hasn't started rendering yet
+   */
+  void cancel_background();
+
   bool did_texture_fail();
   void cancel();
 
+  /**
+   * @brief Set whether finished frames are shown immediately or only once present() is called
+   *
+   * Playback presents frames itself so they can be rendered ahead of time and shown when they're due. While this is
+   * enabled, no new frame should be requested until the pending one has been presented, since it would be rendered
+   * into the same buffer. Disabling it presents any pending frame.
+   */
+  void set_deferred_present(bool deferred);
+
+  /**
+   * @brief Show the frame that was last rendered while presentation is deferred
+   *
+   * @return
+   *
+   * **TRUE** if there was a finished frame to present
+   */
+  bool present();
+
+  /**
+   * @brief Get the frame that has finished rendering and is waiting to be presented, or -1 if there isn't one
+   */
+  long pending_frame();
+
+  /**
+   * @brief Returns **TRUE** if a frame has been requested and hasn't finished rendering yet
+   */
+  bool is_busy();
 
 public slots:
   // cleanup functions
   void delete_ctx();
 signals:
   void ready();
+
+  /**
+   * @brief Emitted when a frame requested with start_render_background() has been rendered
+   *
+   * @param pixels
+   *
+   * RGBA pixels of the frame (rows bottom to top, as read by glReadPixels()), or empty if the frame couldn't be
+   * rendered yet (e.g. media wasn't ready or playback started) and should be requested again later
+   */
+  void background_ready(long frame, QByteArray pixels);
 private:
   // cleanup functions
   void delete_buffers();
@@ -74,6 +131,14 @@ private:
   void set_up_ocio();
   void destroy_ocio();
 
+  void queue_render(QOpenGLContext* share,
+                    SequencePtr s,
+                    long frame,
+                    olive::PlaybackState state,
+                    const QString &save,
+                    GLvoid *pixels,
+                    int pixel_linesize);
+
   FramebufferObject front_buffer_1;
   QMutex front_mutex1;
 
@@ -97,20 +162,61 @@ private:
   FramebufferObject back_buffer_1;
   FramebufferObject back_buffer_2;
 
-  float ocio_lut_data[NUM_3D_ENTRIES];
+  // working framebuffers for clips (see ComposeSequenceParams::fbo_pool)
+  FramebufferPool fbo_pool;
+
+  // outputs of clips' effects kept between frames (see ComposeSequenceParams::effect_cache)
+  EffectStageCache effect_cache;
+
+  // vertex buffer for everything compose_sequence() draws (see create_quad_buffer())
+  GLuint quad_buffer;
+
+  // display transform LUT and the shader applying it, see set_up_ocio()
   GLuint ocio_lut_texture;
   QOpenGLShaderProgram* ocio_shader;
 
+  // OCIODisplaySettings::key() of the current display transform, empty if there isn't one
+  QByteArray ocio_key;
+
   SequencePtr seq;
+  olive::PlaybackState playback_state;
   int divider;
   int tex_width;
   int tex_height;
+  GLenum tex_format;
   bool queued;
   bool texture_failed;
   bool running;
   QString save_fn;
   GLvoid *pixel_buffer;
   int pixel_buffer_linesize;
+
+  // buffer for frames loaded from the render cache
+  QByteArray cache_pixels;
+
+  // frame requested by the last start_render() and the frame currently being painted
+  long frame_;
+  long rendering_frame_;
+
+  // request being painted, copied from the request (or the background request) when painting starts so new requests
+  // can come in while painting
+  SequencePtr rendering_seq_;
+  olive::PlaybackState rendering_state_;
+  QString rendering_save_fn_;
+  GLvoid* rendering_pixels_;
+  int rendering_linesize_;
+  bool rendering_background_;
+
+  // request from start_render_background(), protected by present_lock_
+  bool background_queued_;
+  SequencePtr background_seq_;
+  long background_frame_;
+
+  // presentation state (see set_deferred_present()), protected by present_lock_
+  QMutex present_lock_;
+  bool deferred_present_;
+  bool painting_;
+  long pending_frame_;
 };
 
 #endif // RENDERTHREAD_H
@@ -0,0 +1,209 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "shaderfusion.h"
+
+#include <QFile>
+#include <QRegularExpression>
+#include <QSet>
+#include <QDebug>
+
+QString fused_stage_prefix(int stage) {
+  return QString("s%1_").arg(stage);
+}
+
+// remove comments so declarations and code can be picked apart with simple patterns
+static QString strip_comments(const QString& source) {
+  QString stripped(source);
+  stripped.remove(QRegularExpression("/\\*.*?\\*/", QRegularExpression::DotMatchesEverythingOption));
+  stripped.remove(QRegularExpression("//[^\\n]*"));
+  return stripped;
+}
+
+// add the names declared by one top-level statement (the text before its ';' or function body) to `names`
+static void collect_declared_names(QString statement, QSet<QString>& names) {
+  statement = statement.trimmed();
+
+  if (statement.isEmpty()
+      || statement.startsWith("precision")
+      || statement.startsWith("varying")
+      || QRegularExpression("^uniform\\s+((lowp|mediump|highp)\\s+)?sampler2D\\b").match(statement).hasMatch()) {
+    return;
+  }
+
+  // functions, either definitions or prototypes
+  QRegularExpressionMatch function = QRegularExpression("^[\\w\\s]*?(\\w+)\\s*\\(").match(statement);
+  if (function.hasMatch()) {
+    names.insert(function.captured(1));
+    return;
+  }
+
+  // variables, drop initializers and array sizes (taking out parentheses first so commas in them don't split)
+  QRegularExpression parentheses("\\([^()]*\\)");
+  while (statement.contains(parentheses)) {
+    statement.remove(parentheses);
+  }
+
+  QStringList declarators = statement.split(',');
+  for (int i=0;i<declarators.size();i++) {
+    QString declarator = declarators.at(i);
+    declarator = declarator.left(declarator.indexOf('=') > -1 ? declarator.indexOf('=') : declarator.size());
+    declarator = declarator.left(declarator.indexOf('[') > -1 ? declarator.indexOf('[') : declarator.size());
+
+    QRegularExpressionMatch name = QRegularExpression("(\\w+)\\s*$").match(declarator);
+    if (name.hasMatch()) {
+      names.insert(name.captured(1));
+    }
+  }
+}
+
+// find every name declared at the top level of a shader
+static QSet<QString> find_global_names(const QString& source) {
+  QSet<QString> names;
+
+  QStringList lines = source.split('\n');
+  QString code;
+
+  for (int i=0;i<lines.size();i++) {
+    QString line = lines.at(i).trimmed();
+    if (line.startsWith('#')) {
+      QRegularExpressionMatch define = QRegularExpression("^#\\s*define\\s+(\\w+)").match(line);
+      if (define.hasMatch()) {
+        names.insert(define.captured(1));
+      }
+    } else {
+      code.append(lines.at(i));
+      code.append('\n');
+    }
+  }
+
+  int depth = 0;
+  QString statement;
+  for (int i=0;i<code.size();i++) {
+    QChar c = code.at(i);
+    if (c == '{') {
+      if (depth == 0) {
+        collect_declared_names(statement, names);
+        statement.clear();
+      }
+      depth++;
+    } else if (c == '}') {
+      depth--;
+    } else if (depth == 0) {
+      if (c == ';') {
+        collect_declared_names(statement, names);
+        statement.clear();
+      } else {
+        statement.append(c);
+      }
+    }
+  }
+
+  return names;
+}
+
+// replace calls to texture2D() on `sampler` with `replacement`
+static void replace_texture_reads(QString& source, const QString& sampler, const QString& replacement) {
+  QRegularExpression call("\\btexture2D\\s*\\(\\s*" + QRegularExpression::escape(sampler) + "\\s*,");
+
+  QRegularExpressionMatch match = call.match(source);
+  while (match.hasMatch()) {
+    int start = match.capturedStart();
+
+    // find the call's closing parenthesis
+    int depth = 0;
+    int end = source.indexOf('(', start);
+    for (;end<source.size();end++) {
+      if (source.at(end) == '(') {
+        depth++;
+      } else if (source.at(end) == ')') {
+        depth--;
+        if (depth == 0) {
+          break;
+        }
+      }
+    }
+
+    source.replace(start, end - start + 1, replacement);
+
+    match = call.match(source, start + replacement.size());
+  }
+}
+
+QByteArray fuse_fragment_shaders(const QStringList& frag_paths) {
+  QString fused_globals;
+  QString fused_main;
+
+  for (int i=0;i<frag_paths.size();i++) {
+    QFile file(frag_paths.at(i));
+    if (!file.open(QFile::ReadOnly)) {
+      qWarning() << "Failed to open shader for fusing" << frag_paths.at(i);
+      return QByteArray();
+    }
+    QString source = strip_comments(QString::fromUtf8(file.readAll()));
+    file.close();
+
+    QString prefix = fused_stage_prefix(i);
+    QString input = prefix + "fused_input";
+    QString output = prefix + "fused_output";
+
+    source.remove(QRegularExpression("#\\s*version[^\\n]*"));
+
+    // prefix all globals, including main() and uniforms
+    QSet<QString> names = find_global_names(source);
+    for (QSet<QString>::const_iterator it=names.constBegin();it!=names.constEnd();it++) {
+      source.replace(QRegularExpression("(?<![\\.\\w])" + QRegularExpression::escape(*it) + "\\b"), prefix + *it);
+    }
+
+    // the input texture is read once by the fused main(), the stage reads the previous stage's result instead
+    QRegularExpression sampler_declaration("\\buniform\\s+(?:(?:lowp|mediump|highp)\\s+)?sampler2D\\s+(\\w+)\\s*;");
+    QRegularExpressionMatchIterator samplers = sampler_declaration.globalMatch(source);
+    while (samplers.hasNext()) {
+      replace_texture_reads(source, samplers.next().captured(1), input);
+    }
+    source.remove(sampler_declaration);
+
+    // vTexCoord is declared once for all stages
+    source.remove(QRegularExpression("\\bvarying\\s+[^;]*;"));
+
+    source.replace(QRegularExpression("\\bgl_FragColor\\b"), output);
+
+    // a discarded pixel would have been left transparent by the stage on its own, main() is void so it can return
+    source.replace(QRegularExpression("\\bdiscard\\s*;"), "{ " + output + " = vec4(0.0); return; }");
+
+    fused_globals.append(QString("\n// %1\nvec4 %2;\nvec4 %3;\n").arg(frag_paths.at(i), input, output));
+    fused_globals.append(source);
+    fused_globals.append('\n');
+
+    fused_main.append(QString("\t%1 = color;\n\t%2 = color;\n\t%3main();\n\tcolor = %2;\n").arg(input, output, prefix));
+  }
+
+  QString fused("#version 110\n"
+                "\n"
+                "uniform sampler2D fused_image;\n"
+                "varying vec2 vTexCoord;\n");
+  fused.append(fused_globals);
+  fused.append("\nvoid main(void) {\n"
+               "\tvec4 color = texture2D(fused_image, vTexCoord);\n");
+  fused.append(fused_main);
+  fused.append("\tgl_FragColor = color;\n"
+               "}\n");
+
+  return fused.toUtf8();
+}
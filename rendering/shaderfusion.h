@@ -0,0 +1,57 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef SHADERFUSION_H
+#define SHADERFUSION_H
+
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+
+/**
+ * @brief Get the prefix a fused shader's globals (uniforms included) are given in the fused program
+ *
+ * @param stage
+ *
+ * Index of the shader in the list given to fuse_fragment_shaders()
+ */
+QString fused_stage_prefix(int stage);
+
+/**
+ * @brief Generate one fragment shader that applies several per-pixel fragment shaders in order
+ *
+ * Each shader's main() becomes a function called by the fused main() with the previous one's output as its input,
+ * so a chain of color effects can be drawn in one pass instead of one pass each. Globals are prefixed with
+ * fused_stage_prefix() so shaders using the same names don't clash.
+ *
+ * Only shaders that work on one pixel at a time can be fused. They must be GLSL 1.10, read their input texture
+ * (a sampler2D uniform) only at vTexCoord and write their result to gl_FragColor. Effects declare that their shader
+ * fits with the "fusible" attribute of the <shader> element in their effect file.
+ *
+ * @param frag_paths
+ *
+ * Full paths to the fragment shaders in the order they're applied
+ *
+ * @return
+ *
+ * Source of the fused shader, or an empty array if a shader couldn't be read
+ */
+QByteArray fuse_fragment_shaders(const QStringList& frag_paths);
+
+#endif // SHADERFUSION_H
@@ -0,0 +1,152 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "shaderprogramcache.h"
+
+#include <QDebug>
+
+#include "rendering/shaderfusion.h"
+
+ShaderProgramCache olive::shader_program_cache;
+
+ShaderProgramCache::ShaderProgramCache() {}
+
+QOpenGLShaderProgram *ShaderProgramCache::Get(const QString &vert_path, const QString &frag_path)
+{
+  QMutexLocker locker(&lock_);
+
+  int index = GetContextIndex();
+
+  QString key = vert_path + "\n" + frag_path;
+
+  QOpenGLShaderProgram* program = contexts_.at(index).programs.value(key);
+
+  if (program == nullptr) {
+    program = new QOpenGLShaderProgram();
+
+    bool compiled = true;
+
+    // cacheable shaders are only compiled if no binary of the linked program was stored by an earlier session
+    if (!vert_path.isEmpty()
+        && !program->addCacheableShaderFromSourceFile(QOpenGLShader::Vertex, vert_path)) {
+      compiled = false;
+      qWarning() << "Vertex shader could not be added" << vert_path;
+    }
+
+    if (!frag_path.isEmpty()
+        && !program->addCacheableShaderFromSourceFile(QOpenGLShader::Fragment, frag_path)) {
+      compiled = false;
+      qWarning() << "Fragment shader could not be added" << frag_path;
+    }
+
+    if (compiled) {
+      if (program->link()) {
+        qInfo() << "Shader program linked successfully" << frag_path;
+      } else {
+        qWarning() << "Shader program failed to link" << frag_path;
+      }
+    }
+
+    contexts_[index].programs.insert(key, program);
+  }
+
+  return program;
+}
+
+QOpenGLShaderProgram *ShaderProgramCache::GetFused(const QString &vert_path, const QStringList &frag_paths)
+{
+  QMutexLocker locker(&lock_);
+
+  int index = GetContextIndex();
+
+  // the chain's signature, fused programs can't clash with regular ones since those only have one fragment shader
+  QString key = vert_path + "\n" + frag_paths.join("\n") + "\nfused";
+
+  QOpenGLShaderProgram* program = contexts_.at(index).programs.value(key);
+
+  if (program == nullptr) {
+    program = new QOpenGLShaderProgram();
+
+    QByteArray fused_source = fuse_fragment_shaders(frag_paths);
+
+    bool compiled = !fused_source.isEmpty();
+
+    if (compiled
+        && !vert_path.isEmpty()
+        && !program->addCacheableShaderFromSourceFile(QOpenGLShader::Vertex, vert_path)) {
+      compiled = false;
+      qWarning() << "Vertex shader could not be added" << vert_path;
+    }
+
+    if (compiled
+        && !program->addCacheableShaderFromSourceCode(QOpenGLShader::Fragment, fused_source)) {
+      compiled = false;
+      qWarning() << "Fused fragment shader could not be added" << frag_paths;
+    }
+
+    // a program that failed to link stays in the cache so the chain isn't retried every frame, callers fall back
+    // to running the effects separately
+    if (compiled) {
+      if (program->link()) {
+        qInfo() << "Fused shader program linked successfully" << frag_paths;
+      } else {
+        qWarning() << "Fused shader program failed to link" << frag_paths;
+      }
+    }
+
+    contexts_[index].programs.insert(key, program);
+  }
+
+  return program;
+}
+
+int ShaderProgramCache::GetContextIndex()
+{
+  QOpenGLContext* ctx = QOpenGLContext::currentContext();
+
+  for (int i=0;i<contexts_.size();i++) {
+    if (contexts_.at(i).ctx == ctx) {
+      return i;
+    }
+  }
+
+  ContextPrograms cp;
+  cp.ctx = ctx;
+  contexts_.append(cp);
+
+  // programs die with their context, forget about them then
+  connect(ctx, SIGNAL(aboutToBeDestroyed()), this, SLOT(context_destroyed()), Qt::DirectConnection);
+
+  return contexts_.size() - 1;
+}
+
+void ShaderProgramCache::context_destroyed()
+{
+  QOpenGLContext* ctx = static_cast<QOpenGLContext*>(sender());
+
+  QMutexLocker locker(&lock_);
+
+  for (int i=0;i<contexts_.size();i++) {
+    if (contexts_.at(i).ctx == ctx) {
+      qDeleteAll(contexts_.at(i).programs);
+      contexts_.removeAt(i);
+      break;
+    }
+  }
+}
@@ -0,0 +1,105 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef SHADERPROGRAMCACHE_H
+#define SHADERPROGRAMCACHE_H
+
+#include <QObject>
+#include <QMutex>
+#include <QHash>
+#include <QOpenGLContext>
+#include <QOpenGLShaderProgram>
+#include <QStringList>
+
+/**
+ * @brief The ShaderProgramCache class
+ *
+ * Shares linked shader programs between effects that use the same shader files, so every clip using an effect
+ * doesn't compile and link an identical program of its own. Programs are kept per OpenGL context rather than per
+ * share group since uniform values are program state, and render threads set them concurrently.
+ *
+ * Programs are compiled with QOpenGLShaderProgram's cacheable shaders, which stores linked program binaries on disk
+ * (through glProgramBinary() where the driver supports it) so later sessions skip compiling altogether.
+ */
+class ShaderProgramCache : public QObject {
+  Q_OBJECT
+public:
+  ShaderProgramCache();
+
+  /**
+   * @brief Get the program made of these shader files for the current context, creating it if it doesn't exist
+   *
+   * Must be called with an OpenGL context current. The program belongs to the cache and is destroyed along with the
+   * context, so it shouldn't be deleted or kept past the effect closing.
+   *
+   * @param vert_path
+   *
+   * Full path to the vertex shader, or empty if there isn't one
+   *
+   * @param frag_path
+   *
+   * Full path to the fragment shader, or empty if there isn't one
+   *
+   * @return
+   *
+   * The program, which may not be linked if the shaders failed to compile
+   */
+  QOpenGLShaderProgram* Get(const QString& vert_path, const QString& frag_path);
+
+  /**
+   * @brief Get a program running several per-pixel fragment shaders in one pass, creating it if it doesn't exist
+   *
+   * See fuse_fragment_shaders() for what the fragment shaders have to look like. Must be called with an OpenGL
+   * context current.
+   *
+   * @param vert_path
+   *
+   * Full path to the vertex shader shared by all of the effects
+   *
+   * @param frag_paths
+   *
+   * Full paths to the fragment shaders in the order they're applied
+   *
+   * @return
+   *
+   * The program, which may not be linked if the shaders couldn't be fused
+   */
+  QOpenGLShaderProgram* GetFused(const QString& vert_path, const QStringList& frag_paths);
+
+private slots:
+  void context_destroyed();
+
+private:
+  // find the current context's programs, adding an entry for it if there isn't one. lock_ must be held.
+  int GetContextIndex();
+
+  struct ContextPrograms {
+    QOpenGLContext* ctx;
+    QHash<QString, QOpenGLShaderProgram*> programs;
+  };
+
+  QVector<ContextPrograms> contexts_;
+  QMutex lock_;
+};
+
+namespace olive {
+  extern ShaderProgramCache shader_program_cache;
+}
+
+#endif // SHADERPROGRAMCACHE_H
@@ -0,0 +1,574 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#include "textrenderer.h"
+
+#include <QPainter>
+#include <QPainterPathStroker>
+#include <QFileInfo>
+#include <QtMath>
+#include <QDebug>
+
+#include "rendering/renderfunctions.h"
+#include "rendering/shaderprogramcache.h"
+#include "rendering/blurkernel.h"
+#include "io/path.h"
+
+// glyphs are rasterized at this many horizontal positions within a pixel so text doesn't look unevenly spaced
+const int kSubpixelSteps = 4;
+
+const int kInitialAtlasSize = 1024;
+
+// the first quad in the vertex buffer is a unit square, for blitting whole framebuffers with draw_full_quad()
+const int kFullQuadVertexCount = 6;
+
+// framebuffer sizes are rounded up to a multiple of this
+const int kBufferGranularity = 64;
+
+// vertices are stored as x, y, s, t to match bind_quad_buffer()
+const int kVertexSize = 4;
+
+TextRenderer::Style::Style() :
+  color(Qt::white),
+  background_color(Qt::transparent),
+  outline(false),
+  outline_width(0),
+  outline_color(Qt::black),
+  shadow(false),
+  shadow_color(Qt::black),
+  shadow_softness(0)
+{}
+
+static bool same_style(const TextRenderer::Style& a, const TextRenderer::Style& b) {
+  return a.color == b.color
+      && a.background_color == b.background_color
+      && a.outline == b.outline
+      && a.outline_width == b.outline_width
+      && a.outline_color == b.outline_color
+      && a.shadow == b.shadow
+      && a.shadow_offset == b.shadow_offset
+      && a.shadow_color == b.shadow_color
+      && qFuzzyCompare(1.0 + a.shadow_softness, 1.0 + b.shadow_softness);
+}
+
+static void set_premultiplied_color(const QColor& color) {
+  glColor4f(GLfloat(color.redF() * color.alphaF()),
+            GLfloat(color.greenF() * color.alphaF()),
+            GLfloat(color.blueF() * color.alphaF()),
+            GLfloat(color.alphaF()));
+}
+
+static int round_up_buffer_size(int size) {
+  return ((size + kBufferGranularity - 1) / kBufferGranularity) * kBufferGranularity;
+}
+
+static void draw_full_quad() {
+  glPushMatrix();
+  glLoadIdentity();
+  glOrtho(0, 1, 0, 1, -1, 1);
+  glDrawArrays(GL_TRIANGLES, 0, kFullQuadVertexCount);
+  glPopMatrix();
+}
+
+static QString find_effect_file(const QString& filename) {
+  QList<QString> effects_paths = get_effects_paths();
+  for (int i=0;i<effects_paths.size();i++) {
+    QString path = effects_paths.at(i) + "/" + filename;
+    if (QFileInfo::exists(path)) {
+      return path;
+    }
+  }
+  return QString();
+}
+
+TextRenderer::TextRenderer() :
+  layout_changed_(true),
+  atlas_(nullptr),
+  atlas_stale_(false),
+  atlas_size_(kInitialAtlasSize),
+  shelf_x_(0),
+  shelf_y_(0),
+  shelf_height_(0),
+  vertex_buffer_(QOpenGLBuffer::VertexBuffer),
+  built_outline_width_(0),
+  background_vertex_count_(0),
+  outline_vertex_start_(0),
+  outline_vertex_count_(0),
+  fill_vertex_start_(0),
+  fill_vertex_count_(0),
+  frame_width_(0),
+  frame_height_(0),
+  output_fbo_(nullptr)
+{
+  shadow_fbo_[0] = nullptr;
+  shadow_fbo_[1] = nullptr;
+}
+
+TextRenderer::~TextRenderer() {
+  Release();
+}
+
+void TextRenderer::SetFont(const QFont &font) {
+  QRawFont raw_font = QRawFont::fromFont(font);
+  if (raw_font != font_) {
+    font_ = raw_font;
+
+    // glyph indices belong to the font, so everything in the atlas is useless now
+    atlas_stale_ = true;
+    Clear();
+  }
+}
+
+void TextRenderer::Clear() {
+  glyphs_.clear();
+  background_ = QRectF();
+  layout_changed_ = true;
+}
+
+void TextRenderer::AddLine(const QString &text, qreal x, qreal baseline) {
+  QVector<quint32> indexes = font_.glyphIndexesForString(text);
+  QVector<QPointF> advances = font_.advancesForGlyphIndexes(indexes, QRawFont::KernedAdvances);
+
+  QPointF pen(x, baseline);
+  for (int i=0;i<indexes.size();i++) {
+    LineGlyph glyph;
+    glyph.index = indexes.at(i);
+    glyph.position = pen;
+    glyphs_.append(glyph);
+
+    pen += advances.at(i);
+  }
+
+  layout_changed_ = true;
+}
+
+void TextRenderer::SetBackground(const QRectF &rect) {
+  background_ = rect;
+  layout_changed_ = true;
+}
+
+GLuint TextRenderer::Render(QOpenGLContext *ctx, int width, int height, const Style &style) {
+  int outline_width = style.outline ? style.outline_width : 0;
+
+  bool layout_changed = (layout_changed_
+                         || atlas_ == nullptr
+                         || atlas_stale_
+                         || outline_width != built_outline_width_);
+
+  if (!layout_changed
+      && output_fbo_ != nullptr
+      && width == frame_width_
+      && height == frame_height_
+      && same_style(style, drawn_style_)) {
+    return output_fbo_->texture();
+  }
+
+  // compose_sequence() is drawing with its own buffer and viewport, restore them afterwards
+  GLint previous_buffer;
+  glGetIntegerv(GL_ARRAY_BUFFER_BINDING, &previous_buffer);
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+
+  if (atlas_ == nullptr || atlas_stale_) {
+    delete atlas_;
+    CreateAtlas();
+  }
+
+  if (!vertex_buffer_.isCreated()) {
+    vertex_buffer_.create();
+  }
+
+  if (layout_changed) {
+    // if the atlas filled up, start again with a bigger one
+    while (!BuildVertices(outline_width)) {
+      GLint max_size;
+      glGetIntegerv(GL_MAX_TEXTURE_SIZE, &max_size);
+      if (atlas_size_ * 2 > max_size) {
+        qWarning() << "Text is too large for the glyph atlas, some glyphs will be missing";
+        break;
+      }
+
+      atlas_size_ *= 2;
+      delete atlas_;
+      CreateAtlas();
+    }
+
+    layout_changed_ = false;
+    built_outline_width_ = outline_width;
+  }
+
+  frame_width_ = width;
+  frame_height_ = height;
+
+  bool draw_shadow = (style.shadow && fill_vertex_count_ > 0);
+
+  // only draw the part of the frame with something in it, the effect places the texture at rect_
+  QRectF bounds = content_bounds_;
+  if (draw_shadow) {
+    qreal margin = qCeil(style.shadow_softness * 3.0) + 1;
+    bounds = bounds.united(fill_bounds_.translated(style.shadow_offset).adjusted(-margin, -margin, margin, margin));
+  }
+  QRect frame_bounds = bounds.toAlignedRect().intersected(QRect(0, 0, width, height));
+  if (frame_bounds.isEmpty()) {
+    frame_bounds = QRect(0, 0, 1, 1);
+  }
+
+  // round the buffer size up so text that changes length doesn't reallocate the framebuffers every frame
+  QSize buffer_size(round_up_buffer_size(frame_bounds.width()), round_up_buffer_size(frame_bounds.height()));
+  rect_ = QRect(frame_bounds.topLeft(), buffer_size);
+
+  if (output_fbo_ == nullptr || output_fbo_->size() != buffer_size) {
+    delete output_fbo_;
+    output_fbo_ = new QOpenGLFramebufferObject(buffer_size);
+  }
+
+  bind_quad_buffer(ctx, vertex_buffer_.bufferId());
+  glViewport(0, 0, buffer_size.width(), buffer_size.height());
+
+  // frame pixels with y going down, so the first row of the texture is the top of the text like a QImage
+  glPushMatrix();
+  glLoadIdentity();
+  glOrtho(rect_.left(), rect_.left() + rect_.width(), rect_.top(), rect_.top() + rect_.height(), -1, 1);
+
+  QOpenGLFramebufferObject* shadow = nullptr;
+  if (draw_shadow) {
+    for (int i=0;i<2;i++) {
+      if (shadow_fbo_[i] == nullptr || shadow_fbo_[i]->size() != buffer_size) {
+        delete shadow_fbo_[i];
+        shadow_fbo_[i] = new QOpenGLFramebufferObject(buffer_size);
+      }
+    }
+
+    shadow_fbo_[0]->bind();
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    glBindTexture(GL_TEXTURE_2D, atlas_->textureId());
+    set_premultiplied_color(style.shadow_color);
+
+    glPushMatrix();
+    glTranslated(style.shadow_offset.x(), style.shadow_offset.y(), 0);
+    glDrawArrays(GL_TRIANGLES, fill_vertex_start_, fill_vertex_count_);
+    glPopMatrix();
+
+    shadow = (style.shadow_softness > 0) ? BlurShadow(style.shadow_softness) : shadow_fbo_[0];
+  }
+
+  output_fbo_->bind();
+  glClear(GL_COLOR_BUFFER_BIT);
+
+  glBindTexture(GL_TEXTURE_2D, atlas_->textureId());
+
+  if (background_vertex_count_ > 0) {
+    set_premultiplied_color(style.background_color);
+    glDrawArrays(GL_TRIANGLES, kFullQuadVertexCount, background_vertex_count_);
+  }
+
+  if (shadow != nullptr) {
+    glBindTexture(GL_TEXTURE_2D, shadow->texture());
+    glColor4f(1.0, 1.0, 1.0, 1.0);
+    draw_full_quad();
+    glBindTexture(GL_TEXTURE_2D, atlas_->textureId());
+  }
+
+  if (outline_vertex_count_ > 0) {
+    set_premultiplied_color(style.outline_color);
+    glDrawArrays(GL_TRIANGLES, outline_vertex_start_, outline_vertex_count_);
+  }
+
+  set_premultiplied_color(style.color);
+  glDrawArrays(GL_TRIANGLES, fill_vertex_start_, fill_vertex_count_);
+
+  output_fbo_->release();
+
+  glColor4f(1.0, 1.0, 1.0, 1.0);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  glPopMatrix();
+
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+  if (previous_buffer != 0) {
+    bind_quad_buffer(ctx, GLuint(previous_buffer));
+  } else {
+    release_quad_buffer(ctx);
+  }
+
+  drawn_style_ = style;
+
+  return output_fbo_->texture();
+}
+
+const QRect &TextRenderer::GetRect() {
+  return rect_;
+}
+
+void TextRenderer::Release() {
+  delete atlas_;
+  atlas_ = nullptr;
+  atlas_glyphs_.clear();
+
+  if (vertex_buffer_.isCreated()) {
+    vertex_buffer_.destroy();
+  }
+
+  delete output_fbo_;
+  output_fbo_ = nullptr;
+
+  for (int i=0;i<2;i++) {
+    delete shadow_fbo_[i];
+    shadow_fbo_[i] = nullptr;
+  }
+
+  layout_changed_ = true;
+}
+
+bool TextRenderer::GetGlyph(quint32 index, int subpixel, int outline_width, Glyph& glyph) {
+  quint64 key = quint64(index) | (quint64(subpixel) << 32) | (quint64(outline_width) << 40);
+
+  QHash<quint64, Glyph>::const_iterator it = atlas_glyphs_.constFind(key);
+  if (it != atlas_glyphs_.constEnd()) {
+    glyph = it.value();
+    return true;
+  }
+
+  QPainterPath path = font_.pathForGlyph(index);
+  path.translate(qreal(subpixel) / kSubpixelSteps, 0);
+
+  // outlines are drawn under the fill, so only the stroke itself is needed
+  if (outline_width > 0) {
+    QPainterPathStroker stroker;
+    stroker.setWidth(outline_width);
+    path = stroker.createStroke(path);
+  }
+
+  glyph.atlas_rect = QRect();
+  glyph.offset = QPoint();
+
+  if (!path.isEmpty()) {
+    // pad by a transparent pixel so filtering at the edges of the quad doesn't reach neighboring glyphs
+    QRect bounds = path.boundingRect().toAlignedRect().adjusted(-1, -1, 1, 1);
+
+    QPoint pos;
+    if (!PlaceInAtlas(bounds.size(), pos)) {
+      return false;
+    }
+
+    QImage image(bounds.size(), QImage::Format_RGBA8888_Premultiplied);
+    image.fill(Qt::transparent);
+
+    QPainter p(&image);
+    p.setRenderHint(QPainter::Antialiasing);
+    p.translate(-bounds.topLeft());
+    p.fillPath(path, Qt::white);
+    p.end();
+
+    glBindTexture(GL_TEXTURE_2D, atlas_->textureId());
+    glTexSubImage2D(GL_TEXTURE_2D, 0, pos.x(), pos.y(), image.width(), image.height(),
+                    GL_RGBA, GL_UNSIGNED_BYTE, image.constBits());
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    glyph.atlas_rect = QRect(pos, bounds.size());
+    glyph.offset = bounds.topLeft();
+  }
+
+  atlas_glyphs_.insert(key, glyph);
+  return true;
+}
+
+void TextRenderer::CreateAtlas() {
+  atlas_ = new QOpenGLTexture(QOpenGLTexture::Target2D);
+  atlas_->setSize(atlas_size_, atlas_size_);
+  atlas_->setFormat(QOpenGLTexture::RGBA8_UNorm);
+  atlas_->setMinMagFilters(QOpenGLTexture::Linear, QOpenGLTexture::Linear);
+  atlas_->setWrapMode(QOpenGLTexture::ClampToEdge);
+  atlas_->allocateStorage(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8);
+
+  // start out transparent so filtering around glyphs doesn't pick up uninitialized memory
+  QByteArray blank(atlas_size_ * atlas_size_ * 4, 0);
+  atlas_->setData(QOpenGLTexture::RGBA, QOpenGLTexture::UInt8, blank.constData());
+
+  atlas_glyphs_.clear();
+  atlas_stale_ = false;
+  shelf_x_ = 0;
+  shelf_y_ = 0;
+  shelf_height_ = 0;
+
+  // solid block for drawing untextured rectangles like the background without switching textures
+  QImage white(4, 4, QImage::Format_RGBA8888_Premultiplied);
+  white.fill(Qt::white);
+
+  QPoint pos;
+  PlaceInAtlas(white.size(), pos);
+  glBindTexture(GL_TEXTURE_2D, atlas_->textureId());
+  glTexSubImage2D(GL_TEXTURE_2D, 0, pos.x(), pos.y(), white.width(), white.height(),
+                  GL_RGBA, GL_UNSIGNED_BYTE, white.constBits());
+  glBindTexture(GL_TEXTURE_2D, 0);
+  white_texel_ = pos + QPoint(2, 2);
+
+  layout_changed_ = true;
+}
+
+bool TextRenderer::PlaceInAtlas(const QSize &size, QPoint &pos) {
+  // fill the atlas in rows ("shelves") as tall as the tallest image in them, with a pixel between images
+  if (shelf_x_ + size.width() > atlas_size_) {
+    shelf_y_ += shelf_height_ + 1;
+    shelf_x_ = 0;
+    shelf_height_ = 0;
+  }
+
+  if (size.width() > atlas_size_ || shelf_y_ + size.height() > atlas_size_) {
+    return false;
+  }
+
+  pos = QPoint(shelf_x_, shelf_y_);
+
+  shelf_x_ += size.width() + 1;
+  shelf_height_ = qMax(shelf_height_, size.height());
+
+  return true;
+}
+
+bool TextRenderer::BuildVertices(int outline_width) {
+  bool fit = true;
+
+  QVector<GLfloat> vertices;
+
+  AddQuad(vertices, QRectF(0, 0, 1, 1), QRectF(0, 0, 1, 1));
+
+  content_bounds_ = QRectF();
+  fill_bounds_ = QRectF();
+
+  background_vertex_count_ = 0;
+  if (!background_.isEmpty()) {
+    QPointF white(qreal(white_texel_.x()) / atlas_size_, qreal(white_texel_.y()) / atlas_size_);
+    AddQuad(vertices, background_, QRectF(white, white));
+    background_vertex_count_ = kFullQuadVertexCount;
+    content_bounds_ = background_;
+  }
+
+  // outline glyphs then fill glyphs
+  for (int pass=0;pass<2;pass++) {
+    int glyph_outline = (pass == 0) ? outline_width : 0;
+    int start = vertices.size() / kVertexSize;
+
+    if (pass == 1 || outline_width > 0) {
+      for (int i=0;i<glyphs_.size();i++) {
+        const LineGlyph& line_glyph = glyphs_.at(i);
+
+        qreal pen_x = qFloor(line_glyph.position.x());
+        int subpixel = qMin(int((line_glyph.position.x() - pen_x) * kSubpixelSteps), kSubpixelSteps - 1);
+        qreal pen_y = qRound(line_glyph.position.y());
+
+        Glyph glyph;
+        if (!GetGlyph(line_glyph.index, subpixel, glyph_outline, glyph)) {
+          fit = false;
+          continue;
+        }
+
+        if (!glyph.atlas_rect.isEmpty()) {
+          QRectF rect(pen_x + glyph.offset.x(), pen_y + glyph.offset.y(),
+                      glyph.atlas_rect.width(), glyph.atlas_rect.height());
+          QRectF tex_rect(qreal(glyph.atlas_rect.x()) / atlas_size_,
+                          qreal(glyph.atlas_rect.y()) / atlas_size_,
+                          qreal(glyph.atlas_rect.width()) / atlas_size_,
+                          qreal(glyph.atlas_rect.height()) / atlas_size_);
+          AddQuad(vertices, rect, tex_rect);
+
+          content_bounds_ = content_bounds_.united(rect);
+          if (pass == 1) {
+            fill_bounds_ = fill_bounds_.united(rect);
+          }
+        }
+      }
+    }
+
+    int count = vertices.size() / kVertexSize - start;
+    if (pass == 0) {
+      outline_vertex_start_ = start;
+      outline_vertex_count_ = count;
+    } else {
+      fill_vertex_start_ = start;
+      fill_vertex_count_ = count;
+    }
+  }
+
+  vertex_buffer_.bind();
+  vertex_buffer_.allocate(vertices.constData(), vertices.size() * int(sizeof(GLfloat)));
+  vertex_buffer_.release();
+
+  return fit;
+}
+
+void TextRenderer::AddQuad(QVector<GLfloat> &vertices, const QRectF &rect, const QRectF &tex_rect) {
+  const GLfloat quad[] = {
+    GLfloat(rect.left()), GLfloat(rect.top()), GLfloat(tex_rect.left()), GLfloat(tex_rect.top()),
+    GLfloat(rect.right()), GLfloat(rect.top()), GLfloat(tex_rect.right()), GLfloat(tex_rect.top()),
+    GLfloat(rect.right()), GLfloat(rect.bottom()), GLfloat(tex_rect.right()), GLfloat(tex_rect.bottom()),
+
+    GLfloat(rect.left()), GLfloat(rect.top()), GLfloat(tex_rect.left()), GLfloat(tex_rect.top()),
+    GLfloat(rect.right()), GLfloat(rect.bottom()), GLfloat(tex_rect.right()), GLfloat(tex_rect.bottom()),
+    GLfloat(rect.left()), GLfloat(rect.bottom()), GLfloat(tex_rect.left()), GLfloat(tex_rect.bottom())
+  };
+
+  for (int i=0;i<kFullQuadVertexCount*kVertexSize;i++) {
+    vertices.append(quad[i]);
+  }
+}
+
+QOpenGLFramebufferObject* TextRenderer::BlurShadow(double softness) {
+  QVector<BlurPass> passes;
+  plan_gaussian_blur(passes, softness, 1, 0);
+  plan_gaussian_blur(passes, softness, 0, 1);
+
+  if (passes.isEmpty()) {
+    return shadow_fbo_[0];
+  }
+
+  QOpenGLShaderProgram* program = olive::shader_program_cache.Get(find_effect_file("common.vert"),
+                                                                  find_effect_file("blur.frag"));
+  if (!program->isLinked() || !program->bind()) {
+    qWarning() << "Failed to bind blur shader, text shadow will be drawn without softness";
+    return shadow_fbo_[0];
+  }
+
+  program->setUniformValue("resolution", GLfloat(shadow_fbo_[0]->width()), GLfloat(shadow_fbo_[0]->height()));
+  glColor4f(1.0, 1.0, 1.0, 1.0);
+
+  // ping-pong between the two shadow buffers, one pass at a time
+  int current = 0;
+  for (int i=0;i<passes.size();i++) {
+    const BlurPass& pass = passes.at(i);
+
+    shadow_fbo_[!current]->bind();
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    program->setUniformValue("blur_direction", pass.direction[0], pass.direction[1]);
+    program->setUniformValue("blur_taps", pass.tap_count);
+    program->setUniformValueArray("blur_offsets", pass.offsets, kBlurMaxTaps, 1);
+    program->setUniformValueArray("blur_weights", pass.weights, kBlurMaxTaps, 1);
+
+    glBindTexture(GL_TEXTURE_2D, shadow_fbo_[current]->texture());
+    draw_full_quad();
+
+    current = !current;
+  }
+
+  program->release();
+
+  return shadow_fbo_[current];
+}
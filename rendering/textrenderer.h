@@ -0,0 +1,198 @@
+/***
+
+    Olive - Non-Linear Video Editor
+    Copyright (C) 2019  Olive Team
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+***/
+#ifndef TEXTRENDERER_H
+#define TEXTRENDERER_H
+
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLTexture>
+#include <QOpenGLBuffer>
+#include <QRawFont>
+#include <QHash>
+#include <QVector>
+#include <QColor>
+#include <QRectF>
+
+/**
+ * @brief The TextRenderer class
+ *
+ * Draws text for superimpose effects on the GPU instead of painting a whole frame with QPainter and uploading it.
+ * Glyphs are rasterized once into an atlas texture and drawn as textured quads. The quads are only rebuilt when the
+ * layout changes (see Clear() and AddLine()), so redrawing the same text with different colors or shadow settings
+ * is a handful of draw calls.
+ *
+ * Belongs to one OpenGL context. Everything except layout must be called with it current.
+ */
+class TextRenderer {
+public:
+  /**
+   * @brief Appearance of the text, applied when drawing rather than when laying out
+   */
+  struct Style {
+    Style();
+
+    QColor color;
+
+    // filled behind the text if its alpha isn't zero, set with SetBackground()
+    QColor background_color;
+
+    bool outline;
+    int outline_width;
+    QColor outline_color;
+
+    bool shadow;
+    QPointF shadow_offset;
+    QColor shadow_color;
+
+    // standard deviation of the shadow's Gaussian blur in pixels
+    double shadow_softness;
+  };
+
+  TextRenderer();
+
+  /**
+   * @brief Destroy GL resources, see Release()
+   */
+  ~TextRenderer();
+
+  /**
+   * @brief Set the font to lay text out with
+   *
+   * Changing it clears the layout and glyph atlas.
+   */
+  void SetFont(const QFont& font);
+
+  /**
+   * @brief Remove all lines and the background from the layout
+   */
+  void Clear();
+
+  /**
+   * @brief Add a line of text to the layout
+   *
+   * @param text
+   *
+   * Text to add, in the current font
+   *
+   * @param x, baseline
+   *
+   * Position of the line's origin in pixels from the top left of the frame
+   */
+  void AddLine(const QString& text, qreal x, qreal baseline);
+
+  /**
+   * @brief Set a rectangle (in pixels from the top left of the frame) to fill behind the text
+   */
+  void SetBackground(const QRectF& rect);
+
+  /**
+   * @brief Draw the layout into a texture
+   *
+   * Only the area of the frame the text (and its background and shadow) covers is drawn, see GetRect().
+   *
+   * @return
+   *
+   * Texture containing the drawn text with premultiplied alpha. It belongs to this object and stays valid until the
+   * next call to Render() or Release().
+   */
+  GLuint Render(QOpenGLContext* ctx, int width, int height, const Style& style);
+
+  /**
+   * @brief Get the area of the frame (in pixels from the top left) covered by the texture from the last Render()
+   */
+  const QRect& GetRect();
+
+  /**
+   * @brief Destroy the atlas, buffers and framebuffers
+   *
+   * They're created again the next time Render() is called.
+   */
+  void Release();
+
+private:
+  struct Glyph {
+    // where the glyph's image is in the atlas, empty for glyphs with nothing to draw
+    QRect atlas_rect;
+
+    // position of the image's top left relative to the pen position
+    QPoint offset;
+  };
+
+  struct LineGlyph {
+    quint32 index;
+    QPointF position;
+  };
+
+  // rasterize a glyph into the atlas if it isn't there already, returns **FALSE** if it doesn't fit
+  bool GetGlyph(quint32 index, int subpixel, int outline_width, Glyph& glyph);
+
+  // create an empty atlas of atlas_size_, reserving a white block for untextured fills
+  void CreateAtlas();
+
+  // find room for an image of this size in the atlas, returns **FALSE** if there isn't any
+  bool PlaceInAtlas(const QSize& size, QPoint& pos);
+
+  // upload the quads for the current layout, returns **FALSE** if the glyphs didn't fit in the atlas
+  bool BuildVertices(int outline_width);
+
+  // append a quad made of two triangles to the vertex list
+  void AddQuad(QVector<GLfloat>& vertices, const QRectF& rect, const QRectF& tex_rect);
+
+  // blur the shadow drawn into shadow_fbo_[0], returns the framebuffer holding the result
+  QOpenGLFramebufferObject* BlurShadow(double softness);
+
+  QRawFont font_;
+  QVector<LineGlyph> glyphs_;
+  QRectF background_;
+  bool layout_changed_;
+
+  // style of the texture in output_fbo_, which is reused as long as neither it nor the layout change
+  Style drawn_style_;
+
+  QOpenGLTexture* atlas_;
+  bool atlas_stale_;
+  int atlas_size_;
+  QHash<quint64, Glyph> atlas_glyphs_;
+  QPoint white_texel_;
+  int shelf_x_;
+  int shelf_y_;
+  int shelf_height_;
+
+  QOpenGLBuffer vertex_buffer_;
+  int built_outline_width_;
+  int background_vertex_count_;
+  int outline_vertex_start_;
+  int outline_vertex_count_;
+  int fill_vertex_start_;
+  int fill_vertex_count_;
+
+  // area covered by all quads, and by the fill quads alone (which the shadow is made from)
+  QRectF content_bounds_;
+  QRectF fill_bounds_;
+
+  int frame_width_;
+  int frame_height_;
+  QRect rect_;
+
+  QOpenGLFramebufferObject* output_fbo_;
+  QOpenGLFramebufferObject* shadow_fbo_[2];
+};
+
+#endif // TEXTRENDERER_H
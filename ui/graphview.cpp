@@ -33,6 +33,7 @@
 #include "project/sequence.h"
 #include "ui/keyframedrawing.h"
 #include "project/undo.h"
+#include "project/invalidation.h"
 #include "project/effect.h"
 #include "project/clip.h"
 #include "ui/rectangleselect.h"
@@ -382,6 +383,7 @@ void GraphView::mousePressEvent(QMouseEvent *event) {
       key.type = click_add_type;
       click_add_key = click_add_field->keyframes.size();
       click_add_field->keyframes.append(key);
+      olive::Invalidation.invalidate_field(click_add_field);
       update_ui(false);
       click_add_proc = true;
     } else {
@@ -480,6 +482,7 @@ void GraphView::mouseMoveEvent(QMouseEvent *event) {
     } else if (click_add_proc) {
       click_add_field->keyframes[click_add_key].time = get_value_x(event->pos().x());
       click_add_field->keyframes[click_add_key].data = get_value_y(event->pos().y());
+      olive::Invalidation.invalidate_field(click_add_field);
       update_ui(false);
     } else if (rect_select) {
       rect_select_w = event->pos().x() - rect_select_x;
@@ -522,6 +525,7 @@ void GraphView::mouseMoveEvent(QMouseEvent *event) {
           }
         }
         moved_keys = true;
+        olive::Invalidation.invalidate_effect(row->parent_effect);
         update_ui(false);
         break;
       case kBezierHandlePre:
@@ -558,6 +562,7 @@ void GraphView::mouseMoveEvent(QMouseEvent *event) {
         key.post_handle_y = new_post_handle_y;
 
         moved_keys = true;
+        olive::Invalidation.invalidate_effect(row->parent_effect);
         update_ui(false);
       }
         break;
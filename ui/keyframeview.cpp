@@ -28,6 +28,7 @@
 #include "panels/timeline.h"
 #include "ui/timelineheader.h"
 #include "project/undo.h"
+#include "project/invalidation.h"
 #include "panels/viewer.h"
 #include "ui/viewerwidget.h"
 #include "project/sequence.h"
@@ -115,7 +116,7 @@ void KeyframeView::paintEvent(QPaintEvent*) {
       ClipPtr c = olive::ActiveSequence->clips.at(panel_effect_controls->selected_clips.at(j));
       for (int i=0;i<c->effects.size();i++) {
         EffectPtr e = c->effects.at(i);
-        if (e->container->is_expanded()) {
+        if (e->container != nullptr && e->container->is_expanded()) {
           for (int j=0;j<e->row_count();j++) {
             EffectRow* row = e->row(j);
 
@@ -407,6 +408,7 @@ void KeyframeView::mouseMoveEvent(QMouseEvent* event) {
       for (int i=0;i<selected_keyframes.size();i++) {
         EffectField* field = selected_fields.at(i);
         field->keyframes[selected_keyframes.at(i)].time = old_key_vals.at(i) + frame_diff;
+        olive::Invalidation.invalidate_field(field);
       }
 
       last_frame_diff = frame_diff;
@@ -29,6 +29,8 @@
 #include "panels/viewer.h"
 #include "io/config.h"
 #include "ui/menuhelper.h"
+#include "rendering/rendercache.h"
+#include "rendering/rampreview.h"
 #include "debug.h"
 
 #include <QPainter>
@@ -46,6 +48,8 @@
 // used only if center_timeline_timecodes is FALSE
 #define TEXT_PADDING_FROM_LINE 4
 
+#define RENDER_BAR_HEIGHT 3
+
 bool center_scroll_to_playhead(QScrollBar* bar, double zoom, long playhead) {
 	// returns true is the scroll was changed, false if not
 	int target_scroll = qMin(bar->maximum(), qMax(0, getScreenPointFromFrame(zoom, playhead)-(bar->width()>>1)));
@@ -75,6 +79,10 @@ TimelineHeader::TimelineHeader(QWidget *parent) :
 
 	setContextMenuPolicy(Qt::CustomContextMenu);
 	connect(this, SIGNAL(customContextMenuRequested(const QPoint &)), this, SLOT(show_context_menu(const QPoint &)));
+
+	// the render cache and RAM preview may report changes from worker threads, so these connections are queued automatically
+	connect(&olive::render_cache, SIGNAL(rendered_ranges_changed()), this, SLOT(update()));
+	connect(&olive::ram_preview, SIGNAL(cached_frames_changed()), this, SLOT(update()));
 }
 
 void TimelineHeader::set_scroll(int s) {
@@ -413,6 +421,32 @@ void TimelineHeader::paintEvent(QPaintEvent*) {
 			i++;
 		}
 
+		// draw render cache status: red where the sequence has no cached frames, green where it does
+		if (olive::render_cache.HasRenderedFrames(viewer->seq.get())) {
+			int bar_y = height() - RENDER_BAR_HEIGHT;
+			int seq_end_x = getHeaderScreenPointFromFrame(viewer->seq->getEndFrame());
+			p.fillRect(QRect(0, bar_y, qMin(seq_end_x, width()), RENDER_BAR_HEIGHT), QColor(192, 0, 0));
+
+			QVector< QPair<long, long> > rendered = olive::render_cache.GetRenderedRanges(viewer->seq.get(),
+																						   getHeaderFrameFromScreenPoint(0),
+																						   getHeaderFrameFromScreenPoint(width())+1);
+			for (int j=0;j<rendered.size();j++) {
+				int range_in_x = getHeaderScreenPointFromFrame(rendered.at(j).first);
+				int range_out_x = getHeaderScreenPointFromFrame(rendered.at(j).second);
+				p.fillRect(QRect(range_in_x, bar_y, qMax(1, range_out_x-range_in_x), RENDER_BAR_HEIGHT), QColor(0, 192, 0));
+			}
+		}
+
+		// draw frames buffered in the RAM preview above the render cache status
+		QVector< QPair<long, long> > ram_cached = olive::ram_preview.GetCachedRanges(viewer->seq.get(),
+																					  getHeaderFrameFromScreenPoint(0),
+																					  getHeaderFrameFromScreenPoint(width())+1);
+		for (int j=0;j<ram_cached.size();j++) {
+			int range_in_x = getHeaderScreenPointFromFrame(ram_cached.at(j).first);
+			int range_out_x = getHeaderScreenPointFromFrame(ram_cached.at(j).second);
+			p.fillRect(QRect(range_in_x, height() - RENDER_BAR_HEIGHT*2, qMax(1, range_out_x-range_in_x), RENDER_BAR_HEIGHT), QColor(0, 128, 255));
+		}
+
 		// draw in/out selection
 		int in_x;
 		if (viewer->seq->using_workarea) {
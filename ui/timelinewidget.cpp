@@ -60,6 +60,8 @@
 #include <QToolTip>
 #include <QInputDialog>
 #include <QStatusBar>
+#include <QPixmapCache>
+#include <algorithm>
 
 #define MAX_TEXT_WIDTH 20
 #define TRANSITION_BETWEEN_RANGE 40
@@ -1513,6 +1515,11 @@ void TimelineWidget::mouseReleaseEvent(QMouseEvent *event) {
         delete ca;
       }
 
+      // ghosts and the selection rectangle aren't part of the sequence, so nothing else will redraw where they were
+      if (!panel_timeline->ghosts.isEmpty() || panel_timeline->rect_select_proc) {
+        panel_timeline->repaint_timeline();
+      }
+
       // destroy all ghosts
       panel_timeline->ghosts.clear();
 
@@ -2846,6 +2853,84 @@ void draw_waveform(ClipPtr clip, const FootageStream* ms, long media_length, QPa
   }
 }
 
+// waveforms are rendered in tiles of this width (in pixels) and kept in QPixmapCache, so repainting a clip only has to
+// go through its audio preview again when the zoom, its height, the clip or the preview itself changes
+const int kWaveformTileWidth = 256;
+
+static void draw_cached_waveform(ClipPtr clip,
+                                 const FootageStream* ms,
+                                 long media_length,
+                                 QPainter* p,
+                                 const QRect& clip_rect,
+                                 int waveform_start,
+                                 int waveform_limit,
+                                 double zoom) {
+  qreal dpr = p->device()->devicePixelRatioF();
+
+  // the waveform never extends past the end of the media, so the last tile of a clip may be narrower than the rest
+  int media_limit = qMin(clip_rect.width(), getScreenPointFromFrame(zoom, media_length - clip->clip_in()));
+
+  for (int tile_start=(waveform_start/kWaveformTileWidth)*kWaveformTileWidth;
+       tile_start<waveform_limit && tile_start<media_limit;
+       tile_start+=kWaveformTileWidth) {
+    int tile_end = qMin(tile_start + kWaveformTileWidth, media_limit);
+
+    QString key = QString("olive_waveform_%1_%2_%3_%4_%5_%6_%7_%8").arg(
+          QString::number(ms->audio_preview_generation),
+          QString::number(clip->clip_in()),
+          QString::number(clip->reversed()),
+          QString::number(media_length),
+          QString::number(zoom),
+          QString::number(clip_rect.height()),
+          QString::number(olive::CurrentConfig.rectified_waveforms),
+          QString::number(dpr))
+        + QString("_%1_%2").arg(tile_start).arg(tile_end);
+
+    QPixmap tile;
+    if (!QPixmapCache::find(key, &tile)) {
+      tile = QPixmap(qCeil((tile_end - tile_start) * dpr), qCeil(clip_rect.height() * dpr));
+      tile.setDevicePixelRatio(dpr);
+      tile.fill(Qt::transparent);
+
+      QPainter tile_painter(&tile);
+      tile_painter.setPen(p->pen());
+      draw_waveform(clip,
+                    ms,
+                    media_length,
+                    &tile_painter,
+                    QRect(-tile_start, 0, clip_rect.width(), clip_rect.height()),
+                    tile_start,
+                    tile_end,
+                    zoom);
+      tile_painter.end();
+
+      QPixmapCache::insert(key, tile);
+    }
+
+    p->drawPixmap(clip_rect.left() + tile_start, clip_rect.top(), tile);
+  }
+}
+
+// returns a footage stream's preview thumbnail scaled to the size it's drawn at on the timeline, cached in QPixmapCache
+static QPixmap get_cached_thumbnail(const FootageStream* ms, int width, int height, qreal dpr) {
+  QString key = QString("olive_thumbnail_%1_%2_%3_%4").arg(QString::number(ms->video_preview.cacheKey()),
+                                                           QString::number(width),
+                                                           QString::number(height),
+                                                           QString::number(dpr));
+
+  QPixmap thumb;
+  if (!QPixmapCache::find(key, &thumb)) {
+    thumb = QPixmap::fromImage(ms->video_preview.scaled(qRound(width * dpr),
+                                                        qRound(height * dpr),
+                                                        Qt::IgnoreAspectRatio,
+                                                        Qt::SmoothTransformation));
+    thumb.setDevicePixelRatio(dpr);
+    QPixmapCache::insert(key, thumb);
+  }
+
+  return thumb;
+}
+
 void draw_transition(QPainter& p, ClipPtr c, const QRect& clip_rect, QRect& text_rect, int transition_type) {
   TransitionPtr t = (transition_type == kTransitionOpening) ? c->opening_transition : c->closing_transition;
   if (t != nullptr) {
@@ -2896,21 +2981,15 @@ void draw_transition(QPainter& p, ClipPtr c, const QRect& clip_rect, QRect& text
 
 }
 
-void TimelineWidget::paintEvent(QPaintEvent*) {
+void TimelineWidget::paintEvent(QPaintEvent* event) {
   // Draw clips
   if (olive::ActiveSequence != nullptr) {
     QPainter p(this);
 
     // get widget width and height
-    int video_track_limit = 0;
-    int audio_track_limit = 0;
-    for (int i=0;i<olive::ActiveSequence->clips.size();i++) {
-      ClipPtr clip = olive::ActiveSequence->clips.at(i);
-      if (clip != nullptr) {
-        video_track_limit = qMin(video_track_limit, clip->track());
-        audio_track_limit = qMax(audio_track_limit, clip->track());
-      }
-    }
+    int video_track_limit;
+    int audio_track_limit;
+    olive::ActiveSequence->getTrackLimits(&video_track_limit, &audio_track_limit);
 
     // start by adding a track height worth of padding
     int panel_height = olive::timeline::kTrackDefaultHeight;
@@ -2931,7 +3010,20 @@ void TimelineWidget::paintEvent(QPaintEvent*) {
       scrollBar->setMaximum(qMax(0, panel_height - height()));
     }
 
-    for (int i=0;i<olive::ActiveSequence->clips.size();i++) {
+    // only clips that overlap the area being repainted need to be drawn (during playback that's usually just the
+    // strip around the playhead, see Timeline::repaint_playhead())
+    QVector<int> visible_clips = olive::ActiveSequence->clip_index.ClipsInRange(
+          panel_timeline->getTimelineFrameFromScreenPoint(event->rect().left()) - 1,
+          panel_timeline->getTimelineFrameFromScreenPoint(event->rect().right() + 1) + 1,
+          bottom_align,
+          !bottom_align
+          );
+
+    // draw in the same order as the sequence's clips
+    std::sort(visible_clips.begin(), visible_clips.end());
+
+    for (int k=0;k<visible_clips.size();k++) {
+      int i = visible_clips.at(k);
       ClipPtr clip = olive::ActiveSequence->clips.at(i);
       if (clip != nullptr && is_track_visible(clip->track())) {
         QRect clip_rect(panel_timeline->getTimelineScreenPointFromFrame(clip->timeline_in()), getScreenPointFromTrack(clip->track()), getScreenPointFromFrame(panel_timeline->zoom, clip->length()), panel_timeline->GetTrackHeight(clip->track()));
@@ -3012,17 +3104,18 @@ void TimelineWidget::paintEvent(QPaintEvent*) {
                       && thumb_y + thumb_height >= 0
                       && space_for_thumb > MAX_TEXT_WIDTH) {
                     int thumb_clip_width = qMin(thumb_width, space_for_thumb);
-                    p.drawImage(QRect(thumb_x,
-                                      clip_rect.y()+thumb_y,
-                                      thumb_clip_width,
-                                      thumb_height),
-                                ms->video_preview,
-                                QRect(0,
-                                      0,
-                                      qRound(thumb_clip_width*(double(ms->video_preview.width())/double(thumb_width))),
-                                      ms->video_preview.height()
-                                      )
-                                );
+                    QPixmap thumb = get_cached_thumbnail(ms, thumb_width, thumb_height, p.device()->devicePixelRatioF());
+                    p.drawPixmap(QRect(thumb_x,
+                                       clip_rect.y()+thumb_y,
+                                       thumb_clip_width,
+                                       thumb_height),
+                                 thumb,
+                                 QRect(0,
+                                       0,
+                                       qRound(thumb_clip_width*thumb.devicePixelRatioF()),
+                                       thumb.height()
+                                       )
+                                 );
                   }
                 }
                 if (clip->timeline_out() - clip->timeline_in() + clip->clip_in() > clip->media_length()) {
@@ -3043,7 +3136,7 @@ void TimelineWidget::paintEvent(QPaintEvent*) {
                   if (waveform_limit > 0) checkerboard_rect.setLeft(checkerboard_rect.left() + waveform_limit);
                 }
 
-                draw_waveform(clip, ms, media_length, &p, clip_rect, waveform_start, waveform_limit, panel_timeline->zoom);
+                draw_cached_waveform(clip, ms, media_length, &p, clip_rect, waveform_start, waveform_limit, panel_timeline->zoom);
               }
             }
             if (draw_checkerboard) {
@@ -3415,13 +3508,19 @@ int TimelineWidget::getScreenPointFromTrack(int track) {
 }
 
 int TimelineWidget::getClipIndexFromCoords(long frame, int track) {
-  for (int i=0;i<olive::ActiveSequence->clips.size();i++) {
-    ClipPtr c = olive::ActiveSequence->clips.at(i);
-    if (c != nullptr && c->track() == track && frame >= c->timeline_in() && frame < c->timeline_out()) {
-      return i;
+  int index = -1;
+
+  // the index also returns clips that only cover this frame with a shared transition, so check the clip's own range
+  QVector<int> candidates = olive::ActiveSequence->clip_index.ClipsOnTrackInRange(track, frame, frame + 1);
+  for (int i=0;i<candidates.size();i++) {
+    ClipPtr c = olive::ActiveSequence->clips.at(candidates.at(i));
+    if (frame >= c->timeline_in()
+        && frame < c->timeline_out()
+        && (index == -1 || candidates.at(i) < index)) {
+      index = candidates.at(i);
     }
   }
-  return -1;
+  return index;
 }
 
 void TimelineWidget::setScroll(int s) {
@@ -57,6 +57,7 @@ extern "C" {
 #include "ui/timelinewidget.h"
 #include "rendering/renderfunctions.h"
 #include "rendering/renderthread.h"
+#include "rendering/rampreview.h"
 #include "ui/viewerwindow.h"
 #include "mainwindow.h"
 
@@ -69,7 +70,9 @@ ViewerWidget::ViewerWidget(QWidget *parent) :
   gizmos(nullptr),
   selected_gizmo(nullptr),
   x_scroll(0),
-  y_scroll(0)
+  y_scroll(0),
+  ram_preview_frame_changed(false),
+  ram_preview_texture(0)
 {
   setMouseTracking(true);
   setFocusPolicy(Qt::ClickFocus);
@@ -83,6 +86,10 @@ ViewerWidget::ViewerWidget(QWidget *parent) :
   connect(renderer, SIGNAL(finished()), renderer, SLOT(deleteLater()));
 
   window = new ViewerWindow(this);
+
+  present_timer.setSingleShot(true);
+  present_timer.setTimerType(Qt::PreciseTimer);
+  connect(&present_timer, SIGNAL(timeout()), this, SLOT(present_due_frame()));
 }
 
 ViewerWidget::~ViewerWidget() {
@@ -168,12 +175,59 @@ void ViewerWidget::save_frame() {
       fn += selected_ext;
     }
 
-    renderer->start_render(context(), viewer->seq, fn);
+    renderer->start_render(context(), viewer->seq, olive::kPlaybackExporting, fn);
   }
 }
 
 void ViewerWidget::queue_repaint() {
-  update();
+  if (viewer->playing) {
+    schedule_playback_frame();
+  } else {
+    update();
+  }
+}
+
+void ViewerWidget::present_due_frame() {
+  if (viewer->playing) {
+    schedule_playback_frame();
+  }
+}
+
+void ViewerWidget::schedule_playback_frame() {
+  // ask the clock rather than the playhead, which is only updated on the viewer's next tick
+  long due = viewer->playback_clock.GetFrame();
+  int speed = viewer->get_playback_speed();
+
+  // a pending frame more than one frame ahead is left over from before the playhead jumped, so it's replaced
+  long pending = renderer->pending_frame();
+  if (pending >= 0 && (pending - due) / speed <= 1) {
+    int wait = viewer->playback_clock.GetMsecsUntil(pending);
+
+    if (wait > 0) {
+      // frame was rendered ahead of time, show it when it's due
+      present_timer.start(wait);
+      return;
+    }
+
+    // show the frame now, even if it's late, so playback always moves forward
+    if (renderer->present()) {
+      viewer->frame_presented(pending);
+      ram_preview_frame = QImage();
+      update();
+    }
+  }
+
+  // only one frame is rendered ahead since the renderer only has one buffer that isn't on screen
+  if (renderer->is_busy()) {
+    return;
+  }
+
+  // once caught up, render the next frame ahead of time. otherwise skip straight to the frame that's due, dropping the
+  // ones in between.
+  long next = (viewer->last_presented_frame() == due) ? due + speed : due;
+
+  doneCurrent();
+  renderer->start_render_frame(context(), viewer->seq, next);
 }
 
 void ViewerWidget::fullscreen_menu_action(QAction *action) {
@@ -226,9 +280,18 @@ void ViewerWidget::frame_update() {
     // send context to other thread for drawing
     if (waveform) {
       update();
+    } else if (viewer->playing
+               && olive::ram_preview.GetFrame(viewer->seq.get(), viewer->seq->playhead, ram_preview_frame)) {
+      // frame is already in the RAM preview, no need to render it
+      ram_preview_frame_changed = true;
+      viewer->frame_presented(viewer->seq->playhead);
+      update();
+    } else if (viewer->playing) {
+      schedule_playback_frame();
     } else {
+      ram_preview_frame = QImage();
       doneCurrent();
-      renderer->start_render(context(), viewer->seq);
+      renderer->start_render(context(), viewer->seq, viewer->playback_state());
     }
 
     // render the audio
@@ -255,6 +318,10 @@ void ViewerWidget::context_destroy() {
   if (viewer->seq != nullptr) {
     close_active_clips(viewer->seq);
   }
+  if (ram_preview_texture > 0) {
+    glDeleteTextures(1, &ram_preview_texture);
+    ram_preview_texture = 0;
+  }
   renderer->delete_ctx();
   doneCurrent();
 }
@@ -544,17 +611,47 @@ void ViewerWidget::draw_gizmos() {
   glColor4f(color[0], color[1], color[2], color[3]);
 }
 
+GLuint ViewerWidget::upload_ram_preview_frame() {
+  if (ram_preview_texture == 0) {
+    glGenTextures(1, &ram_preview_texture);
+    glBindTexture(GL_TEXTURE_2D, ram_preview_texture);
+
+    // RAM preview frames may be smaller than the sequence, so scale them up smoothly
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  } else {
+    glBindTexture(GL_TEXTURE_2D, ram_preview_texture);
+  }
+
+  if (ram_preview_frame_changed) {
+    // rows are stored bottom to top like the renderer's texture, so the same texture coordinates apply
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, ram_preview_frame.width(), ram_preview_frame.height(), 0,
+                 GL_RGBA, GL_UNSIGNED_BYTE, ram_preview_frame.constBits());
+    ram_preview_frame_changed = false;
+  }
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  return ram_preview_texture;
+}
+
 void ViewerWidget::paintGL() {
   if (waveform) {
     draw_waveform_func();
   } else {
-    const GLuint tex = renderer->get_texture();
+    GLuint tex = renderer->get_texture();
     QMutex* tex_lock = renderer->get_texture_mutex();
 
     tex_lock->lock();
 
     makeCurrent();
 
+    if (!ram_preview_frame.isNull()) {
+      tex = upload_ram_preview_frame();
+    }
+
     // clear to solid black
     glClearColor(0.0, 0.0, 0.0, 1.0);
     glClear(GL_COLOR_BUFFER_BIT);
@@ -619,7 +716,7 @@ void ViewerWidget::paintGL() {
 
     if (renderer->did_texture_fail() && !viewer->playing) {
       doneCurrent();
-      renderer->start_render(context(), viewer->seq);
+      renderer->start_render(context(), viewer->seq, viewer->playback_state());
     }
   }
 }
@@ -77,6 +77,8 @@ private:
   void draw_waveform_func();
   void draw_title_safe_area();
   void draw_gizmos();
+  GLuint upload_ram_preview_frame();
+  void schedule_playback_frame();
   EffectGizmo* get_gizmo_from_mouse(int x, int y);
   void move_gizmos(QMouseEvent *event, bool done);
   bool dragging;
@@ -91,12 +93,21 @@ private:
   ViewerWindow* window;
   double x_scroll;
   double y_scroll;
+
+  // frame from the RAM preview drawn instead of the renderer's output while playing, null if there isn't one
+  QImage ram_preview_frame;
+  bool ram_preview_frame_changed;
+  GLuint ram_preview_texture;
+
+  // shows a frame rendered ahead of time once it's due
+  QTimer present_timer;
 private slots:
   void context_destroy();
   void retry();
   void show_context_menu();
   void save_frame();
   void queue_repaint();
+  void present_due_frame();
   void fullscreen_menu_action(QAction* action);
   void set_fit_zoom();
   void set_custom_zoom();